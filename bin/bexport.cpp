@@ -0,0 +1,295 @@
+#include "columns.hpp"
+#include "eventsource.hpp"
+#include "eventtime.hpp"
+#include "getopt.hpp"
+
+#include <binlog/EntryStream.hpp>
+#include <binlog/EventStream.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr std::size_t g_batchBytes = std::size_t(64) << 20;
+
+void showHelp()
+{
+  std::cout <<
+    "bexport -- export binary logfiles to tables, one per event source\n"
+    "\n"
+    "Synopsis:\n"
+    "  bexport [-t csv|bin] [-j threads] filename outdir\n"
+    "\n"
+    "Examples:\n"
+    "  bexport logfile.blog export/"                      "\n"
+    "  bexport -t csv -j 4 logfile.blog export/"          "\n"
+    "\n"
+    "Arguments:\n"
+    "  filename       Path to a logfile. If '-', read from stdin\n"
+    "  outdir         Path to an existing directory, to write the tables to.\n"
+    "                 Existing files of the same name are overwritten\n"
+    "\n"
+    "Allowed options:\n"
+    "  -h             Show this help\n"
+    "  -t             Write only CSV (csv) or only binary columns (bin). Default: both\n"
+    "  -j             Number of threads converting events. Default: 1\n"
+    "\n"
+    "Output Format\n"
+    "  For each event source with at least one event, the following files are written:\n"
+    "\n"
+    "  source-<id>.schema \t Text: the source (severity, category, function, file,\n"
+    "                     \t line, format string, argument tags), followed by\n"
+    "                     \t the columns, one per line: '<index> <name> <type>'\n"
+    "  source-<id>.csv    \t CSV (RFC 4180) with a header row\n"
+    "  source-<id>.col<N> \t Binary: the values of column N, one after the other,\n"
+    "                     \t in native byte order\n"
+    "\n"
+    "  If a source id is redefined (e.g: concatenated logfiles), the events of the\n"
+    "  second definition are written to source-<id>-2.*, the third to source-<id>-3.*, ...\n"
+    "\n"
+    "  Columns: clock, time_ns (nanoseconds since epoch), writer_id, writer_name,\n"
+    "  then the flattened arguments: arg0, arg1, ..., elements of tuples and fields\n"
+    "  of structures get a column each, e.g: arg0.1, arg1.price.\n"
+    "  Column types: bool, char, i8, u8, i16, u16, i32, u32, i64, u64, f32, f64:\n"
+    "  fixed size, bool and char take a single byte. string: 32 bit length,\n"
+    "  followed by that many bytes. Strings get a string column, other arguments\n"
+    "  (sequences, variants, enums, ...) are converted to text, written as string.\n"
+    "\n"
+    "Report bugs to:\n"
+    "  https://github.com/Morgan-Stanley/binlog/issues\n";
+}
+
+// An event, copied out of the input, waiting for conversion
+struct Record
+{
+  std::uint64_t clockValue;
+  std::int64_t timeNs;
+  std::uint64_t writerId;
+  const std::string* writerName;
+  std::size_t argumentsOffset;
+  std::size_t argumentsSize;
+};
+
+// Events read, but not exported yet
+struct Batch
+{
+  std::string arguments;                     // argument bytes of every record
+  std::vector<std::vector<Record>> records;  // indexed by exporter
+
+  void clear()
+  {
+    arguments.clear();
+    for (std::vector<Record>& r : records) { r.clear(); }
+  }
+};
+
+// Export the records of every `threads`th exporter
+void exportRecords(const Batch& batch, std::vector<std::unique_ptr<ColumnExporter>>& exporters, std::size_t first, std::size_t threads)
+{
+  for (std::size_t i = first; i < batch.records.size(); i += threads)
+  {
+    for (const Record& r : batch.records[i])
+    {
+      const binlog::Range arguments(batch.arguments.data() + r.argumentsOffset, r.argumentsSize);
+      exporters[i]->add(ExportedEvent{r.clockValue, r.timeNs, r.writerId, r.writerName, arguments});
+    }
+  }
+}
+
+// Export the batch, using `threads` threads, each taking different exporters
+void exportBatch(const Batch& batch, std::vector<std::unique_ptr<ColumnExporter>>& exporters, std::size_t threads)
+{
+  if (threads <= 1)
+  {
+    exportRecords(batch, exporters, 0, 1);
+    return;
+  }
+
+  std::vector<std::exception_ptr> errors(threads);
+  std::vector<std::thread> workers;
+  for (std::size_t t = 0; t < threads; ++t)
+  {
+    workers.emplace_back([&batch, &exporters, &errors, t, threads]()
+    {
+      try
+      {
+        exportRecords(batch, exporters, t, threads);
+      }
+      catch (...)
+      {
+        errors[t] = std::current_exception();
+      }
+    });
+  }
+
+  for (std::thread& worker : workers) { worker.join(); }
+
+  for (const std::exception_ptr& error : errors)
+  {
+    if (error) { std::rethrow_exception(error); }
+  }
+}
+
+std::uint64_t exportEvents(std::istream& input, const std::string& outdir, int formats, std::size_t threads, std::vector<std::unique_ptr<ColumnExporter>>& exporters)
+{
+  binlog::IstreamEntryStream entryStream(input);
+  binlog::EventStream eventStream;
+
+  // source id -> the exporter of its last definition
+  struct SourceExporter
+  {
+    binlog::EventSource source;
+    std::size_t index;
+    std::size_t definitions; // of the same id, so far
+  };
+  std::unordered_map<std::uint64_t, SourceExporter> exporterIndex;
+  std::set<std::string> writerNames; // stable addresses, referenced by records
+  const std::string* writerName = nullptr; // consecutive events likely have the same writer
+  Batch batch;
+  std::uint64_t eventCount = 0;
+
+  while (const binlog::Event* event = eventStream.nextEvent(entryStream))
+  {
+    const binlog::EventSource& source = *event->source;
+    SourceExporter& se = exporterIndex[source.id];
+    if (se.definitions == 0 || ! sameDefinition(se.source, source))
+    {
+      // a redefined id gets a new exporter: its columns might be different
+      ++se.definitions;
+      std::string prefix = outdir + "/source-" + std::to_string(source.id);
+      if (se.definitions > 1) { prefix += "-" + std::to_string(se.definitions); }
+
+      exporters.emplace_back(new ColumnExporter(prefix, source, formats));
+      batch.records.emplace_back();
+      se.source = source;
+      se.index = exporters.size() - 1;
+    }
+
+    const binlog::WriterProp& writer = eventStream.writerProp();
+    if (writerName == nullptr || *writerName != writer.name)
+    {
+      writerName = &*writerNames.insert(writer.name).first;
+    }
+
+    binlog::Range arguments = event->arguments;
+    const std::size_t argumentsSize = arguments.size();
+    batch.records[se.index].push_back(Record{
+      event->clockValue,
+      eventNs(*event, eventStream.clockSync()),
+      writer.id,
+      writerName,
+      batch.arguments.size(),
+      argumentsSize
+    });
+    batch.arguments.append(arguments.view(argumentsSize), argumentsSize);
+    ++eventCount;
+
+    if (batch.arguments.size() >= g_batchBytes)
+    {
+      exportBatch(batch, exporters, threads);
+      batch.clear();
+    }
+  }
+
+  exportBatch(batch, exporters, threads);
+
+  for (std::unique_ptr<ColumnExporter>& exporter : exporters)
+  {
+    exporter->flush();
+  }
+
+  return eventCount;
+}
+
+} // namespace
+
+int main(int argc, /*const*/ char* argv[])
+{
+  int formats = ColumnExporter::Binary | ColumnExporter::Csv;
+  std::size_t threads = 1;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "t:j:h")) != -1) // NOLINT(concurrency-mt-unsafe)
+  {
+    switch (opt)
+    {
+    case 't':
+      if (std::string(optarg) == "csv") { formats = ColumnExporter::Csv; }
+      else if (std::string(optarg) == "bin") { formats = ColumnExporter::Binary; }
+      else
+      {
+        std::cerr << "[bexport] Invalid output type: '" << optarg << "', expected csv or bin\n";
+        return 1;
+      }
+      break;
+    case 'j':
+      try
+      {
+        threads = std::stoul(optarg);
+      }
+      catch (const std::exception&)
+      {
+        threads = 0;
+      }
+      if (threads == 0 || threads > 1024)
+      {
+        std::cerr << "[bexport] Invalid number of threads: '" << optarg << "'\n";
+        return 1;
+      }
+      break;
+    case 'h':
+      showHelp();
+      return 0;
+    default:
+      // getopt prints a useful error message by default (opterr is set)
+      showHelp();
+      return 1;
+    }
+  }
+
+  if (argc - optind != 2)
+  {
+    showHelp();
+    return 1;
+  }
+
+  const std::string inputPath = argv[optind];
+  const std::string outdir = argv[optind + 1];
+
+  std::ifstream inputFile;
+  if (inputPath != "-")
+  {
+    inputFile.open(inputPath, std::ios_base::in | std::ios_base::binary);
+  }
+  std::istream& input = (inputPath == "-") ? std::cin : inputFile;
+  if (! input)
+  {
+    std::cerr << "[bexport] Failed to open '" << inputPath << "' for reading\n";
+    return 2;
+  }
+
+  std::vector<std::unique_ptr<ColumnExporter>> exporters;
+  try
+  {
+    const std::uint64_t eventCount = exportEvents(input, outdir, formats, threads, exporters);
+    std::cerr << "[bexport] Exported " << eventCount << " events of "
+              << exporters.size() << " sources to '" << outdir << "'\n";
+  }
+  catch (const std::exception& ex)
+  {
+    std::cerr << "[bexport] Exception: " << ex.what() << "\n";
+    return 3;
+  }
+
+  return 0;
+}
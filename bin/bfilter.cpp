@@ -0,0 +1,203 @@
+#include "getopt.hpp"
+#include "rewrite.hpp"
+
+#include <binlog/EntryStream.hpp>
+#include <binlog/MergedEventStream.hpp>
+
+#include <binlog/detail/OstreamBuffer.hpp>
+
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::istream& openFile(const std::string& path, std::ifstream& file)
+{
+  if (path == "-")
+  {
+    return std::cin;
+  }
+
+  file.open(path, std::ios_base::in | std::ios_base::binary);
+  return file;
+}
+
+void showHelp()
+{
+  std::cout <<
+    "bfilter -- filter and merge binary logfiles, without converting them to text\n"
+    "\n"
+    "Synopsis:\n"
+    "  bfilter [-s severity] [-c category] [-f file] [-p format] [-w writer]\n"
+    "          [-b begin] [-e end] [-o output] filename...\n"
+    "\n"
+    "Examples:\n"
+    "  bfilter -c orders -o orders.blog shared.blog"                   "\n"
+    "  bfilter -s warning -b '2019-10-01 14:00' app.blog | bread"      "\n"
+    "  bfilter -o merged.blog app1.blog app2.blog app2.1.blog"         "\n"
+    "\n"
+    "Arguments:\n"
+    "  filename       Path to a logfile. If '-' or unspecified, read from stdin.\n"
+    "                 If multiple files are given, events are merged by time\n"
+    "  output         Path of the binary logfile to write. If '-' or unspecified,\n"
+    "                 write to stdout\n"
+    "\n"
+    "Allowed options:\n"
+    "  -h             Show this help\n"
+    "  -s             Select events of this severity or above:\n"
+    "                 trace, debug, info, warning, error or critical\n"
+    "  -c             Select events of this category\n"
+    "  -f             Select events of sources in files ending with this path\n"
+    "  -p             Select events of sources whose format string contains this string\n"
+    "  -w             Select events of the writer with this name\n"
+    "  -b             Select events not earlier than this time\n"
+    "  -e             Select events earlier than this time\n"
+    "  -o             Write the selected events to this file\n"
+    "\n"
+    "  Times are either nanoseconds since epoch (e.g: 1569939300000000000)\n"
+    "  or UTC date and time (e.g: '2019-10-01 14:15:00' or '2019-10-01T14:15:00.5').\n"
+    "  Every given selector must match for an event to be written.\n"
+    "\n"
+    "Notes:\n"
+    "  Event sources of the inputs are deduplicated and renumbered,\n"
+    "  only the sources of selected events are written. Event timestamps\n"
+    "  are written as nanoseconds since epoch. Merged inputs that are\n"
+    "  ordered by time produce an output that is ordered by time.\n"
+    "\n"
+    "Report bugs to:\n"
+    "  https://github.com/Morgan-Stanley/binlog/issues\n";
+}
+
+bool parseTimeOption(const char* str, std::int64_t& result)
+{
+  std::string time = str;
+  if (time.size() == 16) { time += ":00"; } // allow omitting the seconds
+  if (EventSelector::parseTime(time, result)) { return true; }
+
+  std::cerr << "[bfilter] Invalid time: '" << str << "', expected e.g: '2019-10-01 14:15:00'\n";
+  return false;
+}
+
+} // namespace
+
+int main(int argc, /*const*/ char* argv[])
+{
+  std::vector<std::string> inputPaths;
+  std::string outputPath = "-";
+  EventSelector selector;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "s:c:f:p:w:b:e:o:h")) != -1) // NOLINT(concurrency-mt-unsafe)
+  {
+    switch (opt)
+    {
+    case 's':
+      if (! EventSelector::parseSeverity(optarg, selector.minSeverity))
+      {
+        std::cerr << "[bfilter] Invalid severity: '" << optarg << "'\n";
+        return 1;
+      }
+      break;
+    case 'c':
+      selector.category = optarg;
+      break;
+    case 'f':
+      selector.file = optarg;
+      break;
+    case 'p':
+      selector.format = optarg;
+      break;
+    case 'w':
+      selector.writer = optarg;
+      break;
+    case 'b':
+      if (! parseTimeOption(optarg, selector.beginNs)) { return 1; }
+      break;
+    case 'e':
+      if (! parseTimeOption(optarg, selector.endNs)) { return 1; }
+      break;
+    case 'o':
+      outputPath = optarg;
+      break;
+    case 'h':
+      showHelp();
+      return 0;
+    default:
+      // getopt prints a useful error message by default (opterr is set)
+      showHelp();
+      return 1;
+    }
+  }
+
+  for (int i = optind; i < argc; ++i)
+  {
+    inputPaths.emplace_back(argv[i]);
+  }
+
+  if (inputPaths.empty())
+  {
+    inputPaths.emplace_back("-");
+  }
+
+  std::deque<std::ifstream> inputFiles;
+  std::deque<binlog::IstreamEntryStream> entryStreams;
+  binlog::MergedEventStream merged;
+  for (const std::string& inputPath : inputPaths)
+  {
+    inputFiles.emplace_back();
+    std::istream& input = openFile(inputPath, inputFiles.back());
+    if (! input)
+    {
+      std::cerr << "[bfilter] Failed to open '" << inputPath << "' for reading\n";
+      return 2;
+    }
+    entryStreams.emplace_back(input);
+    merged.addInput(entryStreams.back());
+  }
+
+  std::ofstream outputFile;
+  std::unique_ptr<binlog::detail::OstreamBuffer> output;
+  if (outputPath == "-")
+  {
+    // write stdout directly, bypassing std::cout
+    output.reset(new binlog::detail::OstreamBuffer(1));
+  }
+  else
+  {
+    outputFile.open(outputPath, std::ios_base::out | std::ios_base::binary);
+    if (! outputFile)
+    {
+      std::cerr << "[bfilter] Failed to open '" << outputPath << "' for writing\n";
+      return 2;
+    }
+    output.reset(new binlog::detail::OstreamBuffer(outputFile));
+  }
+
+  EventRewriter rewriter(*output, selector);
+  try
+  {
+    while (const binlog::Event* event = merged.nextEvent())
+    {
+      rewriter.write(merged.inputIndex(), *event, merged.writerProp(), merged.clockSync(), merged.time());
+    }
+  }
+  catch (const std::exception& ex)
+  {
+    output->flush();
+    std::cerr << "[bfilter] Exception: " << ex.what() << "\n";
+    return 3;
+  }
+
+  output->flush();
+  if (! output->good() || (outputFile.is_open() && ! outputFile.flush()))
+  {
+    std::cerr << "[bfilter] Failed to write output\n";
+    return 4;
+  }
+
+  return 0;
+}
@@ -1,9 +1,18 @@
+#include "eventtime.hpp"
 #include "getopt.hpp"
 #include "printers.hpp"
+#include "resync.hpp"
 
+#include <binlog/detail/OstreamBuffer.hpp>
+
+#include <cstdint>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <memory>
 #include <string>
+#include <vector>
 
 #define BINLOG_DEFAULT_FORMAT "%S %C [%d] %n %m (%G:%L)"
 #define BINLOG_DEFAULT_DATE_FORMAT "%Y-%m-%d %H:%M:%S.%N"
@@ -27,16 +36,27 @@ void showHelp()
     "bread -- convert binary logfiles to human readable text\n"
     "\n"
     "Synopsis:\n"
-    "  bread [-f format] [-d date-format] [-s] filename\n"
+    "  bread [-f format] [-d date-format] [-s] filename...\n"
+    "  bread [-f format] [-d date-format] -F filename\n"
+    "  bread [-f format] [-d date-format] -r [-m max-entry-size] filename\n"
+    "  bread -S [-g interval] [-m max-entry-size] filename\n"
+    "  bread -q source [-a argument] [-g group] filename\n"
     "\n"
     "Examples:\n"
     "  bread logfile.blog"                                 "\n"
     "  bread -f '%S %m (%G:%L)' logfile.blog"              "\n"
     "  zcat logfile.blog.gz | bread -f '%S %m (%G:%L)' -"  "\n"
-    "  tail -c +0 -F logfile.blog | bread"                 "\n"
+    "  bread -F logfile.blog"                              "\n"
+    "  bread app1.blog app2.blog app2.1.blog"              "\n"
+    "  bread -r recovered.blog"                            "\n"
+    "  bread -S logfile.blog"                              "\n"
+    "  bread -S -g 1m logfile.blog"                        "\n"
+    "  bread -q 'latency={}' -g 1m logfile.blog"           "\n"
+    "  bread -q order.cpp:42 -a 1 -g arg:0 logfile.blog"   "\n"
     "\n"
     "Arguments:\n"
-    "  filename       Path to a logfile. If '-' or unspecified, read from stdin\n"
+    "  filename       Path to a logfile. If '-' or unspecified, read from stdin.\n"
+    "                 If multiple files are given, events are merged by time\n"
     "  format         Arbitrary string with optional placeholders, see 'Event Format'\n"
     "  date-format    Arbitrary string with optional placeholders, see 'Date Format'\n"
     "\n"
@@ -45,6 +65,23 @@ void showHelp()
     "  -f             Set a custom format string to write events, see 'Event Format'\n"
     "  -d             Set a custom format string to write timestamps, see 'Date Format'\n"
     "  -s             Sort events by time\n"
+    "  -F             Follow the file: print events as they are written,\n"
+    "                 reopen the file if it is rotated. Stop by Ctrl-C\n"
+    "  -r             Recover from corrupt input: skip invalid entries,\n"
+    "                 continue with the next valid one. Skipped bytes are reported\n"
+    "  -m             Entries larger than this (in bytes) are considered to be corrupt\n"
+    "                 by -r and -S. Larger values make recovery slower.\n"
+    "                 Default: 16777215 (16 MiB - 1), maximum: 4294967295\n"
+    "  -S             Print statistics instead of events: count, bytes, rate (events/s)\n"
+    "                 and peak rate (most events in one second) per source and writer.\n"
+    "                 With -g, also print the rate over time, in intervals ('30s', '5m', '1h')\n"
+    "  -q             Aggregate an argument of the events of the selected sources:\n"
+    "                 print count, sum, min, max, mean and percentiles.\n"
+    "                 Sources are selected by 'file:line' (file is a path suffix)\n"
+    "                 or by a substring of the format string\n"
+    "  -a             Index of the aggregated argument, must be a number. Default: 0\n"
+    "  -g             Group the aggregated values by time ('30s', '5m', '1h')\n"
+    "                 or by an argument ('arg:2'). With -S, the rate interval\n"
     "\n"
     "Event Format\n"
     "  Log events are transformed to text by substituting placeholders"
@@ -94,13 +131,23 @@ void showHelp()
 
 int main(int argc, /*const*/ char* argv[])
 {
-  std::string inputPath = "-";
+  std::vector<std::string> inputPaths;
   std::string format = BINLOG_DEFAULT_FORMAT "\n";
   std::string dateFormat = BINLOG_DEFAULT_DATE_FORMAT;
   bool sorted = false;
+  bool follow = false;
+  bool recover = false;
+  bool statistics = false;
+  std::uint32_t maxEntrySize = ResyncEntryStream::defaultMaxEntrySize;
+  bool hasMaxEntrySize = false;
+  Query query;
+  bool hasQuery = false;
+  std::string group;
+  bool hasGroup = false;
+  std::int64_t statsIntervalSeconds = 0;
 
   int opt;
-  while ((opt = getopt(argc, argv, "f:d:sh")) != -1) // NOLINT(concurrency-mt-unsafe)
+  while ((opt = getopt(argc, argv, "f:d:sFrSm:q:a:g:h")) != -1) // NOLINT(concurrency-mt-unsafe)
   {
     switch (opt)
     {
@@ -114,6 +161,52 @@ int main(int argc, /*const*/ char* argv[])
     case 's':
       sorted = true;
       break;
+    case 'F':
+      follow = true;
+      break;
+    case 'r':
+      recover = true;
+      break;
+    case 'S':
+      statistics = true;
+      break;
+    case 'm':
+    {
+      unsigned long long size = 0;
+      try
+      {
+        size = std::stoull(optarg);
+      }
+      catch (const std::exception&) {}
+
+      if (size < sizeof(std::uint64_t) || size > std::numeric_limits<std::uint32_t>::max())
+      {
+        std::cerr << "[bread] Invalid maximum entry size: '" << optarg << "', expected a number in [8, 4294967295]\n";
+        return 1;
+      }
+      maxEntrySize = std::uint32_t(size);
+      hasMaxEntrySize = true;
+      break;
+    }
+    case 'q':
+      query.source = optarg;
+      hasQuery = true;
+      break;
+    case 'a':
+      try
+      {
+        query.argument = std::stoul(optarg);
+      }
+      catch (const std::exception&)
+      {
+        std::cerr << "[bread] Invalid argument index: '" << optarg << "'\n";
+        return 1;
+      }
+      break;
+    case 'g':
+      group = optarg; // parsed below, depending on the mode
+      hasGroup = true;
+      break;
     case 'h':
       showHelp();
       return 0;
@@ -124,37 +217,150 @@ int main(int argc, /*const*/ char* argv[])
     }
   }
 
-  if (optind < argc)
+  for (int i = optind; i < argc; ++i)
+  {
+    inputPaths.emplace_back(argv[i]);
+  }
+
+  if (inputPaths.empty())
   {
-    inputPath = argv[optind];
+    inputPaths.emplace_back("-");
   }
 
-  std::ifstream inputFile;
-  std::istream& input = openFile(inputPath, inputFile);
-  if (! input)
+  if (follow && (sorted || recover || inputPaths.size() != 1 || inputPaths.front() == "-"))
   {
-    std::cerr << "[bread] Failed to open '" << inputPath << "' for reading\n";
-    return 2;
+    std::cerr << "[bread] -F requires a single filename, and cannot be used with -s or -r\n";
+    return 1;
   }
 
-  std::ostream::sync_with_stdio(false);
+  if (hasQuery && (sorted || follow || recover || statistics || inputPaths.size() != 1))
+  {
+    std::cerr << "[bread] -q requires a single input, and cannot be used with -s, -F, -r or -S\n";
+    return 1;
+  }
+
+  if (statistics && (sorted || follow || recover || inputPaths.size() != 1))
+  {
+    std::cerr << "[bread] -S requires a single input, and cannot be used with -s, -F or -r\n";
+    return 1;
+  }
+
+  if (hasGroup && statistics && ! parseInterval(group, statsIntervalSeconds))
+  {
+    std::cerr << "[bread] Invalid interval: '" << group << "', expected e.g: 30s, 5m or 1h\n";
+    return 1;
+  }
+
+  if (hasGroup && ! statistics && ! query.parseGroup(group))
+  {
+    std::cerr << "[bread] Invalid group: '" << group << "', expected e.g: 30s, 5m, 1h or arg:2\n";
+    return 1;
+  }
+
+  if (hasMaxEntrySize && ! recover && ! statistics)
+  {
+    std::cerr << "[bread] -m requires -r or -S\n";
+    return 1;
+  }
+
+  if (recover && (sorted || inputPaths.size() != 1))
+  {
+    std::cerr << "[bread] -r requires a single input, and cannot be used with -s\n";
+    return 1;
+  }
+
+  // write stdout directly, bypassing std::cout
+  binlog::detail::OstreamBuffer output(1);
+
+  if (follow)
+  {
+    std::unique_ptr<FollowEntryStream> input;
+    try
+    {
+      input.reset(new FollowEntryStream(inputPaths.front()));
+    }
+    catch (const std::exception&)
+    {
+      std::cerr << "[bread] Failed to open '" << inputPaths.front() << "' for reading\n";
+      return 2;
+    }
+
+    try
+    {
+      printFollowedEvents(*input, output, format, dateFormat);
+    }
+    catch (const std::exception& ex)
+    {
+      output.flush();
+      std::cerr << "[bread] Exception: " << ex.what() << "\n";
+      return 3;
+    }
+
+    std::cerr << "[bread] Failed to write output\n";
+    return 4;
+  }
+
+  std::deque<std::ifstream> inputFiles;
+  std::vector<std::istream*> inputs;
+  for (const std::string& inputPath : inputPaths)
+  {
+    inputFiles.emplace_back();
+    std::istream& input = openFile(inputPath, inputFiles.back());
+    if (! input)
+    {
+      std::cerr << "[bread] Failed to open '" << inputPath << "' for reading\n";
+      return 2;
+    }
+    inputs.push_back(&input);
+  }
 
   try
   {
-    if (sorted)
+    if (hasQuery)
+    {
+      printQuery(*inputs.front(), output, query);
+    }
+    else if (statistics)
+    {
+      printStatistics(*inputs.front(), output, statsIntervalSeconds, maxEntrySize);
+    }
+    else if (recover)
     {
-      printSortedEvents(input, std::cout, format, dateFormat);
+      printRecoveredEvents(*inputs.front(), output, format, dateFormat, std::cerr, maxEntrySize);
+    }
+    else if (inputs.size() > 1)
+    {
+      if (sorted)
+      {
+        printSortedMergedEvents(inputs, output, format, dateFormat);
+      }
+      else
+      {
+        printMergedEvents(inputs, output, format, dateFormat);
+      }
+    }
+    else if (sorted)
+    {
+      printSortedEvents(*inputs.front(), output, format, dateFormat);
     }
     else
     {
-      printEvents(input, std::cout, format, dateFormat);
+      printEvents(*inputs.front(), output, format, dateFormat);
     }
   }
   catch (const std::exception& ex)
   {
+    output.flush();
     std::cerr << "[bread] Exception: " << ex.what() << "\n";
     return 3;
   }
 
+  output.flush();
+  if (! output.good())
+  {
+    std::cerr << "[bread] Failed to write output\n";
+    return 4;
+  }
+
   return 0;
 }
@@ -1,32 +1,21 @@
+#include "getopt.hpp"
+#include "recovery.hpp"
+
 #include <binlog/binlog.hpp>
 
 #include <binlog/TextOutputStream.hpp>
 
-#include <array>
-#include <cassert>
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
-#include <cstring>
+#include <exception>
 #include <fstream>
 #include <iostream>
-#include <limits>
-#include <type_traits>
-
-enum class BufferType
-{
-  Metadata = 0,
-  Data = 1,
-};
+#include <string>
+#include <thread>
 
 BINLOG_ADAPT_ENUM(BufferType, Data, Metadata)
 
-struct RecoveredBuffer
-{
-  BufferType type;
-  std::uintptr_t session;
-  std::vector<char> buffer;
-};
-
 namespace {
 
 void printLogs()
@@ -44,22 +33,36 @@ void showHelp()
     "brecovery -- extract unconsumed binlog data from a memory dump\n"
     "\n"
     "Synopsis:\n"
-    "  brecovery corefile [outputfile]\n"
+    "  brecovery [-j threads] [-p] corefile [outputfile]\n"
     "\n"
     "Arguments:\n"
-    "  corefile        Path to a corefile (memory dump)\n"
+    "  corefile        Path to a corefile (memory dump), or to a recovery file\n"
     "  outputfile      Path to write recovered data. If '-' or unspecified, read from stdin\n"
     "\n"
+    "Allowed options:\n"
+    "  -j <threads>    Number of threads to scan the corefile with, default: number of cores\n"
+    "  -p              Show progress while scanning\n"
+    "  -h              Show this help\n"
+    "\n"
     "Notes:\n"
     "  Recovery is done by looking for 'magic numbers' in the corefile,\n"
     "  and extracting structured data following those. Metadata and unconsumed data\n"
     "  are extracted from each session, and written to the output.\n"
+    "  The corefile is mapped to memory, and scanned in parallel. The output\n"
+    "  does not depend on the number of threads. If the corefile is an ELF core,\n"
+    "  only its writable, anonymous segments are scanned, and pointers are\n"
+    "  resolved by the virtual addresses of the segments.\n"
     "  The output is a valid binlog logfile (if it was not corrupted previously),\n"
     "  and can be read using bread:\n"
     "\n"
     "    $ brecovery app.core recovered.blog\n"
     "    $ bread recovered.blog\n"
     "\n"
+    "  If the Session was created with a binlog::RecoveryFile,\n"
+    "  the recovery file can be used instead of a corefile:\n"
+    "\n"
+    "    $ brecovery /dev/shm/app.blogrec recovered.blog\n"
+    "\n"
     "Report bugs to:\n"
     "  https://github.com/Morgan-Stanley/binlog/issues\n";
     ;
@@ -76,259 +79,142 @@ std::ostream& openFile(const std::string& path, std::ofstream& file)
   return file;
 }
 
-std::array<unsigned char, 8> toArray(std::uint64_t n)
+void showProgress(std::size_t scanned, std::size_t total)
 {
-  std::array<unsigned char, 8> result{};
-  memcpy(result.data(), &n, result.size());
-  return result;
+  const std::size_t mib = std::size_t(1) << 20;
+  const std::size_t percent = (total != 0) ? scanned * 100 / total : 100;
+  std::cerr << "\r[brecovery] Scanned " << scanned / mib << " / " << total / mib << " MiB (" << percent << "%)" << std::flush;
 }
 
-bool checkEntryBuffer(const std::vector<char>& buffer)
+void logCandidate(const RecoveryCandidate& candidate)
 {
-  binlog::Range range(buffer.data(), buffer.size());
-  try
+  const RecoveredBuffer& rb = candidate.result;
+  STDERR_INFO("Magic number found, read {} at offset={}", rb.type, candidate.offset);
+  if (candidate.recovered)
   {
-    while (range)
-    {
-      const std::uint32_t size = range.read<std::uint32_t>();
-      range.view(size);
-    }
+    if (! candidate.message.empty()) { STDERR_INFO("  {}", candidate.message); }
+    STDERR_INFO("  Recovered {} bytes of {} from session={}", rb.buffer.size(), rb.type, rb.session);
   }
-  catch (const std::runtime_error&)
+  else
   {
-    STDERR_ERROR("  Buffer contains invalid entry");
-    return false;
+    STDERR_ERROR("  {}", candidate.message);
+    STDERR_ERROR("  Failed to read {}, continue searching at offset={}", rb.type, candidate.offset + 8);
   }
-
-  return true;
 }
 
-std::size_t remainingSize(std::istream& input)
-{
-  const auto pos = input.tellg();
-  input.seekg(0, std::ios_base::end);
-  const auto end = input.tellg();
-  const std::size_t size = std::size_t(end - pos);
-  input.seekg(pos);
-  return size;
-}
-
-bool readMetadata(std::istream& input, std::vector<RecoveredBuffer>& output)
-{
-  // get session ptr as a number
-  void* sessionptr = nullptr;
-  input.read(reinterpret_cast<char*>(&sessionptr), sizeof(void*));
-  const std::uintptr_t session = reinterpret_cast<std::uintptr_t>(sessionptr);
-
-  // get the size of the metadata in the buffer
-  std::size_t size = 0;
-  input.read(reinterpret_cast<char*>(&size), sizeof(size));
-
-  // get the buffer
-  if (size > remainingSize(input))
-  {
-    STDERR_ERROR("  Input doesn't have {} bytes", size);
-    return false;
-  }
-
-  std::vector<char> metadata;
-  try
-  {
-    metadata.resize(size);
-  }
-  catch (const std::bad_alloc&)
-  {
-    STDERR_ERROR("  Failed to allocate {} bytes for metadata", size);
-    return false;
-  }
-  input.read(metadata.data(), std::streamsize(size));
-
-  if (! input)
-  {
-    STDERR_ERROR("  Failed to read {} bytes of metadata from input", size);
-    return false;
-  }
-
-  if (! checkEntryBuffer(metadata)) { return false; }
-
-  STDERR_INFO("  Recovered {} bytes of metadata from session={}", metadata.size(), session);
-
-  output.push_back(RecoveredBuffer{BufferType::Metadata, session, std::move(metadata)});
-  return true;
-}
+} // namespace
 
-bool checkQueueInvariants(binlog::detail::Queue& queue)
+int main(int argc, /*const*/ char* argv[])
 {
-  if (queue.writeIndex > queue.capacity)
-  {
-    BINLOG_ERROR("  Queue invariant violated: writer={} > capacity={}", queue.writeIndex.load(), queue.capacity);
-    return false;
-  }
+  std::size_t threads = (std::max)(1u, std::thread::hardware_concurrency());
+  bool progress = false;
 
-  if (queue.dataEnd > queue.capacity)
+  int opt;
+  while ((opt = getopt(argc, argv, "j:ph")) != -1) // NOLINT(concurrency-mt-unsafe)
   {
-    BINLOG_ERROR("  Queue invariant violated: dataEnd={} > capacity={}", queue.dataEnd, queue.capacity);
-    return false;
-  }
-
-  if (queue.readIndex > queue.capacity)
-  {
-    BINLOG_ERROR("  Queue invariant violated: reader={} > capacity={}", queue.readIndex.load(), queue.capacity);
-    return false;
+    switch (opt)
+    {
+    case 'j':
+      try
+      {
+        threads = std::stoul(optarg);
+      }
+      catch (const std::exception&)
+      {
+        threads = 0;
+      }
+      if (threads == 0 || threads > 1024)
+      {
+        STDERR_ERROR("Invalid number of threads: '{}'", optarg);
+        return 1;
+      }
+      break;
+    case 'p':
+      progress = true;
+      break;
+    case 'h':
+      showHelp();
+      return 0;
+    default:
+      // getopt prints a useful error message by default (opterr is set)
+      showHelp();
+      return 1;
+    }
   }
 
-  return true;
-}
-
-bool readData(std::istream& input, std::vector<RecoveredBuffer>& output)
-{
-  // get session ptr as a number
-  void* sessionptr = nullptr;
-  input.read(reinterpret_cast<char*>(&sessionptr), sizeof(void*));
-  const std::uintptr_t session = reinterpret_cast<std::uintptr_t>(sessionptr);
-
-  // get queue with writer and reader positions
-  // Depending on the standard/compiler, the assert below is invalid
-  // because of the std::atomic inside Queue - but we do not care.
-  // static_assert(std::is_trivially_copyable<binlog::detail::Queue>::value, "Queue must be trivial");
-  binlog::detail::Queue queue(nullptr, 0);
-  input.read(reinterpret_cast<char*>(&queue), sizeof(queue));
-
-  if (! checkQueueInvariants(queue)) { return false; }
-
-  STDERR_INFO("  Queue state is valid: capacity={} windex={} rindex={} dataend={}",
-    queue.capacity, queue.writeIndex.load(), queue.readIndex.load(), queue.dataEnd);
-
-  // get queue buffer
-  if (queue.capacity > remainingSize(input))
+  if (argc - optind < 1)
   {
-    STDERR_ERROR("  Input doesn't have {} bytes", queue.capacity);
-    return false;
+    showHelp();
+    return 1;
   }
 
-  std::vector<char> queueBuffer;
+  const std::string inputPath = argv[optind];
+  std::unique_ptr<MappedFile> input;
   try
   {
-    queueBuffer.resize(queue.capacity);
+    input.reset(new MappedFile(inputPath));
   }
-  catch (const std::bad_alloc&)
-  {
-    STDERR_ERROR("  Failed to allocate {} bytes for queue data", queue.capacity);
-    return false;
-  }
-  input.read(queueBuffer.data(), std::streamsize(queueBuffer.size()));
-
-  if (! input) { return false; }
-
-  // create a reader, get the unread data from the buffer
-  queue.buffer = queueBuffer.data();
-  binlog::detail::QueueReader reader(queue);
-  const binlog::detail::QueueReader::ReadResult dataview = reader.beginRead();
-
-  std::vector<char> data;
-  data.reserve(dataview.size());
-  data.insert(data.end(), dataview.buffer1, dataview.buffer1 + dataview.size1);
-  data.insert(data.end(), dataview.buffer2, dataview.buffer2 + dataview.size2);
-
-  if (! checkEntryBuffer(data)) { return false; }
-
-  STDERR_INFO("  Recovered {} bytes of data from session={}", data.size(), session);
-
-  output.push_back(RecoveredBuffer{BufferType::Data, session, std::move(data)});
-  return true;
-}
-
-} // namespace
-
-int main(int argc, const char* argv[])
-{
-  if (argc < 2)
+  catch (const std::exception& ex)
   {
-    showHelp();
-    return 1;
-  }
-
-  std::ifstream input(argv[1], std::ios_base::in|std::ios_base::binary);
-  if (! input)
-  {
-    STDERR_ERROR("Failed to open {} for reading", argv[1]);
+    STDERR_ERROR("Failed to open {} for reading: {}", inputPath, ex.what());
     showHelp();
     return 2;
   }
 
-  const std::string outputPath = (argc > 2) ? argv[2] : "-";
+  const std::string outputPath = (argc - optind > 1) ? argv[optind + 1] : "-";
   std::ofstream outputFile;
   std::ostream& output = openFile(outputPath, outputFile);
   if (! output)
   {
-    STDERR_ERROR("Failed to open {} for writing", argv[2]);
+    STDERR_ERROR("Failed to open {} for writing", outputPath);
     showHelp();
     return 3;
   }
 
-  std::vector<RecoveredBuffer> buffers;
-
-  // do not initialize arrays directly to remain endianness agnostic
-  const std::array<unsigned char, 8> metadataMagic = toArray(0xFE214F726E35BDBC);
-  const std::array<unsigned char, 8> dataMagic = toArray(0xFE213F716D34BCBC);
+  STDERR_INFO("Read input from {}, {} bytes, using {} threads", inputPath, input->size(), threads);
 
-  // magic numbers start with the same byte, makes searching easier
-  assert(metadataMagic[0] == dataMagic[0]);
-  const unsigned char firstMagicByte = metadataMagic[0];
-
-  STDERR_INFO("Read input from {}", argv[1]);
-
-  while (input.ignore(std::numeric_limits<std::streamsize>::max(), firstMagicByte).good())
+  const MemoryDump dump(input->data(), input->size());
+  std::size_t total = 0;
+  for (const MemorySegment& segment : dump.scannedSegments()) { total += segment.fileSize; }
+  if (dump.isElfCore())
   {
-    std::array<unsigned char, 8> magic{firstMagicByte, 0, 0, 0, 0, 0, 0, 0};
-    input.read(reinterpret_cast<char*>(magic.data()+1), 7);
+    STDERR_INFO("Input is an ELF core, scan {} writable anonymous segments of {}, {} bytes",
+      dump.scannedSegments().size(), dump.segments().size(), total);
+  }
 
-    const auto afterMagicPos = std::streamoff{input.tellg()};
+  std::vector<RecoveryCandidate> candidates;
+  try
+  {
+    std::function<void(std::size_t)> progressFn;
+    if (progress) { progressFn = [total](std::size_t scanned) { showProgress(scanned, total); }; }
 
-    if (magic == metadataMagic)
-    {
-      STDERR_INFO("Magic number found, read metadata at tellg={}", afterMagicPos);
-      if (! readMetadata(input, buffers))
-      {
-        STDERR_ERROR("  Failed to read metadata, continue searching at tellg={}", afterMagicPos);
-        input.clear();
-        input.seekg(afterMagicPos);
-      }
-    }
-    else if (magic == dataMagic)
-    {
-      STDERR_INFO("Magic number found, read data at tellg={}", afterMagicPos);
-      if (! readData(input, buffers))
-      {
-        STDERR_ERROR("  Failed to read data, continue searching at tellg={}", afterMagicPos);
-        input.clear();
-        input.seekg(afterMagicPos);
-      }
-    }
-    else
-    {
-      // not a magic number, seek back
-      input.seekg(-7, std::ios_base::cur);
-    }
+    candidates = scanForBuffers(dump, threads, std::size_t(64) << 20, progressFn);
+    if (progress) { std::cerr << "\n"; }
   }
-
-  if (input.eof())
+  catch (const std::exception& ex)
   {
-    STDERR_INFO("Done reading input");
+    STDERR_ERROR("Failure while reading input: {}", ex.what());
+    return 2;
   }
-  else
+
+  std::vector<RecoveredBuffer> buffers;
+  for (RecoveryCandidate& candidate : candidates)
   {
-    STDERR_ERROR("Failure while reading input, continue anyway");
+    logCandidate(candidate);
+    if (candidate.recovered) { buffers.push_back(std::move(candidate.result)); }
   }
 
+  STDERR_INFO("Done reading input");
+
   STDERR_INFO("Write output");
 
-  // make sure metadata precedes data, and everything is grouped by sessions
+  // make sure metadata precedes data, and everything is grouped by sessions.
+  // Stable sort keeps the order of the input for equal keys.
   const auto cmp = [](auto&& a, auto&& b)
   {
     return a.session == b.session ? a.type < b.type : a.session < b.session;
   };
-  std::sort(buffers.begin(), buffers.end(), cmp);
+  std::stable_sort(buffers.begin(), buffers.end(), cmp);
 
   std::size_t offset = 0;
   for (const RecoveredBuffer& buffer : buffers)
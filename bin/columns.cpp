@@ -0,0 +1,414 @@
+#include "columns.hpp"
+
+#include <binlog/Severity.hpp>
+#include <binlog/ToStringVisitor.hpp>
+#include <binlog/detail/OstreamBuffer.hpp>
+
+#include <mserialize/VisitProgram.hpp>
+#include <mserialize/visit.hpp>
+
+#include <mserialize/detail/tag_util.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+
+constexpr std::size_t g_flushThreshold = 1 << 16;
+
+bool isArithmetic(mserialize::string_view tag)
+{
+  return tag.size() == 1 && mserialize::VisitProgram::arithmetic_size(tag.front()) != 0;
+}
+
+// Truncate `path`
+void createFile(const std::string& path)
+{
+  std::ofstream file(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  if (! file)
+  {
+    throw std::runtime_error("Failed to create file: " + path);
+  }
+}
+
+void appendToFile(const std::string& path, std::string& buffer)
+{
+  if (buffer.empty()) { return; }
+
+  std::ofstream file(path, std::ios_base::out | std::ios_base::binary | std::ios_base::app);
+  file.write(buffer.data(), std::streamsize(buffer.size()));
+  file.close();
+  if (! file)
+  {
+    throw std::runtime_error("Failed to write file: " + path);
+  }
+
+  buffer.clear();
+}
+
+// Escape newlines, to keep a single value per schema line
+std::string schemaValue(const std::string& value)
+{
+  std::string result;
+  for (const char c : value)
+  {
+    if (c == '\n') { result += "\\n"; }
+    else if (c == '\\') { result += "\\\\"; }
+    else { result += c; }
+  }
+  return result;
+}
+
+template <typename T>
+T load(const char* p)
+{
+  T result;
+  std::memcpy(&result, p, sizeof(T));
+  return result;
+}
+
+template <typename T>
+void appendBinary(std::string& out, T value)
+{
+  out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void appendUnsigned(std::string& out, std::uint64_t value)
+{
+  char buf[24];
+  char* p = buf + sizeof(buf);
+  do
+  {
+    *--p = char('0' + value % 10);
+    value /= 10;
+  } while (value != 0);
+  out.append(p, std::size_t(buf + sizeof(buf) - p));
+}
+
+void appendSigned(std::string& out, std::int64_t value)
+{
+  if (value < 0)
+  {
+    out += '-';
+    appendUnsigned(out, std::uint64_t(0) - std::uint64_t(value));
+  }
+  else
+  {
+    appendUnsigned(out, std::uint64_t(value));
+  }
+}
+
+void appendFloat(std::string& out, double value, int precision)
+{
+  char buf[32];
+  const int size = std::snprintf(buf, sizeof(buf), "%.*g", precision, value);
+  out.append(buf, std::size_t(size));
+}
+
+// RFC 4180: quote if the field contains a separator, quote or line break
+void appendCsvString(std::string& out, const char* data, std::size_t size)
+{
+  bool quote = false;
+  for (std::size_t i = 0; i < size && ! quote; ++i)
+  {
+    quote = data[i] == ',' || data[i] == '"' || data[i] == '\n' || data[i] == '\r';
+  }
+
+  if (! quote)
+  {
+    out.append(data, size);
+    return;
+  }
+
+  out += '"';
+  for (std::size_t i = 0; i < size; ++i)
+  {
+    if (data[i] == '"') { out += '"'; }
+    out += data[i];
+  }
+  out += '"';
+}
+
+} // namespace
+
+ColumnExporter::ColumnExporter(const std::string& prefix, const binlog::EventSource& source, int formats)
+  :_prefix(prefix),
+   _fullTag(source.argumentTags),
+   _binary((formats & Binary) != 0),
+   _csv((formats & Csv) != 0)
+{
+  _columns.push_back(Column{"clock", Column::Kind::Arithmetic, "L"});
+  _columns.push_back(Column{"time_ns", Column::Kind::Arithmetic, "l"});
+  _columns.push_back(Column{"writer_id", Column::Kind::Arithmetic, "L"});
+  _columns.push_back(Column{"writer_name", Column::Kind::String, "[c"});
+
+  mserialize::string_view tags = _fullTag;
+  for (std::size_t i = 0; ! tags.empty(); ++i)
+  {
+    const mserialize::string_view tag = mserialize::detail::tag_pop(tags);
+    addColumns("arg" + std::to_string(i), tag, 0);
+  }
+
+  writeSchema(source);
+
+  if (_binary)
+  {
+    for (std::size_t i = 0; i < _columns.size(); ++i)
+    {
+      _columnFiles.push_back(OutputFile{_prefix + ".col" + std::to_string(i), {}});
+      createFile(_columnFiles.back().path);
+    }
+  }
+
+  if (_csv)
+  {
+    _csvFile.path = _prefix + ".csv";
+    createFile(_csvFile.path);
+
+    std::string& out = _csvFile.buffer;
+    for (std::size_t i = 0; i < _columns.size(); ++i)
+    {
+      if (i != 0) { out += ','; }
+      appendCsvString(out, _columns[i].name.data(), _columns[i].name.size());
+    }
+    out += "\r\n";
+  }
+}
+
+void ColumnExporter::add(const ExportedEvent& event)
+{
+  addArithmetic(0, 'L', reinterpret_cast<const char*>(&event.clockValue));
+  addArithmetic(1, 'l', reinterpret_cast<const char*>(&event.timeNs));
+  addArithmetic(2, 'L', reinterpret_cast<const char*>(&event.writerId));
+  addString(3, event.writerName->data(), std::uint32_t(event.writerName->size()));
+
+  binlog::Range input = event.arguments;
+  for (std::size_t i = 4; i < _columns.size(); ++i)
+  {
+    const Column& column = _columns[i];
+    switch (column.kind)
+    {
+    case Column::Kind::Arithmetic:
+      addArithmetic(i, column.tag.front(), input.view(mserialize::VisitProgram::arithmetic_size(column.tag.front())));
+      break;
+    case Column::Kind::String:
+    {
+      const std::uint32_t size = input.read<std::uint32_t>();
+      addString(i, input.view(size), size);
+      break;
+    }
+    case Column::Kind::Text:
+    {
+      _text.str(std::string());
+      {
+        binlog::detail::OstreamBuffer buf(_text);
+        binlog::ToStringVisitor visitor(buf);
+        mserialize::detail::visit_impl(_fullTag, column.tag, visitor, input, 2048);
+      }
+      const std::string text = _text.str();
+      addString(i, text.data(), std::uint32_t(text.size()));
+      break;
+    }
+    }
+  }
+
+  if (_csv)
+  {
+    _csvFile.buffer += "\r\n";
+    if (_csvFile.buffer.size() >= g_flushThreshold)
+    {
+      appendToFile(_csvFile.path, _csvFile.buffer);
+    }
+  }
+
+  ++_rowCount;
+}
+
+void ColumnExporter::flush()
+{
+  for (OutputFile& file : _columnFiles)
+  {
+    appendToFile(file.path, file.buffer);
+  }
+
+  appendToFile(_csvFile.path, _csvFile.buffer);
+}
+
+std::string ColumnExporter::typeName(const Column& column)
+{
+  switch (column.kind)
+  {
+  case Column::Kind::String: return "string";
+  case Column::Kind::Text:   return "string";
+  case Column::Kind::Arithmetic: break;
+  }
+
+  switch (column.tag.front())
+  {
+  case 'y': return "bool";
+  case 'c': return "char";
+  case 'b': return "i8";
+  case 'B': return "u8";
+  case 's': return "i16";
+  case 'S': return "u16";
+  case 'i': return "i32";
+  case 'I': return "u32";
+  case 'l': return "i64";
+  case 'L': return "u64";
+  case 'f': return "f32";
+  case 'd': return "f64";
+  case 'D': return "f64";
+  default:  return "unknown";
+  }
+}
+
+void ColumnExporter::addColumns(const std::string& name, mserialize::string_view tag, int depth)
+{
+  if (isArithmetic(tag))
+  {
+    _columns.push_back(Column{name, Column::Kind::Arithmetic, tag.to_string()});
+    return;
+  }
+
+  if (tag == mserialize::string_view("[c"))
+  {
+    _columns.push_back(Column{name, Column::Kind::String, tag.to_string()});
+    return;
+  }
+
+  if (depth < 32 && ! tag.empty() && tag.front() == '(')
+  {
+    // tuple: one or more columns per element
+    mserialize::string_view elems(tag.data() + 1, tag.size() - 2);
+    for (std::size_t i = 0; ! elems.empty(); ++i)
+    {
+      const mserialize::string_view elem = mserialize::detail::tag_pop(elems);
+      addColumns(name + "." + std::to_string(i), elem, depth + 1);
+    }
+    return;
+  }
+
+  if (depth < 32 && ! tag.empty() && tag.front() == '{')
+  {
+    // structure: one or more columns per field,
+    // unless empty or a reference to a recursive structure
+    mserialize::string_view fields(tag.data() + 1, tag.size() - 2);
+    mserialize::detail::remove_prefix_before(fields, '`');
+    if (! fields.empty())
+    {
+      while (! fields.empty())
+      {
+        const mserialize::string_view label = mserialize::detail::tag_pop_label(fields);
+        const mserialize::string_view field = mserialize::detail::tag_pop(fields);
+        // fields of base classes have no label, flatten them into the derived
+        addColumns(label.empty() ? name : name + "." + label.to_string(), field, depth + 1);
+      }
+      return;
+    }
+  }
+
+  // sequence, variant, enum, empty or recursive structure, or too deep
+  _columns.push_back(Column{name, Column::Kind::Text, tag.to_string()});
+}
+
+void ColumnExporter::writeSchema(const binlog::EventSource& source) const
+{
+  const std::string path = _prefix + ".schema";
+  std::ofstream out(path, std::ios_base::out | std::ios_base::trunc);
+
+  const auto severity = binlog::severityToString(source.severity);
+
+  out << "source " << source.id << '\n'
+      << "severity " << severity.data() << '\n'
+      << "category " << schemaValue(source.category) << '\n'
+      << "function " << schemaValue(source.function) << '\n'
+      << "file " << schemaValue(source.file) << '\n'
+      << "line " << source.line << '\n'
+      << "format " << schemaValue(source.formatString) << '\n'
+      << "tags " << source.argumentTags << '\n'
+      << "columns " << _columns.size() << '\n';
+
+  for (std::size_t i = 0; i < _columns.size(); ++i)
+  {
+    out << i << ' ' << _columns[i].name << ' ' << typeName(_columns[i]) << '\n';
+  }
+
+  out.close();
+  if (! out)
+  {
+    throw std::runtime_error("Failed to write file: " + path);
+  }
+}
+
+void ColumnExporter::addArithmetic(std::size_t column, char tag, const char* value)
+{
+  if (_binary)
+  {
+    std::string& out = _columnFiles[column].buffer;
+    if (tag == 'D')
+    {
+      appendBinary(out, double(load<long double>(value)));
+    }
+    else
+    {
+      out.append(value, mserialize::VisitProgram::arithmetic_size(tag));
+    }
+
+    if (out.size() >= g_flushThreshold)
+    {
+      appendToFile(_columnFiles[column].path, out);
+    }
+  }
+
+  if (_csv)
+  {
+    addCsvSeparator(column);
+    std::string& out = _csvFile.buffer;
+    switch (tag)
+    {
+    case 'y': out += load<bool>(value) ? "true" : "false"; break;
+    case 'c': appendCsvString(out, value, 1); break;
+    case 'b': appendSigned(out, load<std::int8_t>(value)); break;
+    case 'B': appendUnsigned(out, load<std::uint8_t>(value)); break;
+    case 's': appendSigned(out, load<std::int16_t>(value)); break;
+    case 'S': appendUnsigned(out, load<std::uint16_t>(value)); break;
+    case 'i': appendSigned(out, load<std::int32_t>(value)); break;
+    case 'I': appendUnsigned(out, load<std::uint32_t>(value)); break;
+    case 'l': appendSigned(out, load<std::int64_t>(value)); break;
+    case 'L': appendUnsigned(out, load<std::uint64_t>(value)); break;
+    case 'f': appendFloat(out, double(load<float>(value)), 9); break;
+    case 'd': appendFloat(out, load<double>(value), 17); break;
+    case 'D': appendFloat(out, double(load<long double>(value)), 17); break;
+    default:
+      throw std::runtime_error(std::string("Invalid arithmetic tag: ") + tag);
+    }
+  }
+}
+
+void ColumnExporter::addString(std::size_t column, const char* data, std::uint32_t size)
+{
+  if (_binary)
+  {
+    std::string& out = _columnFiles[column].buffer;
+    appendBinary(out, size);
+    out.append(data, size);
+
+    if (out.size() >= g_flushThreshold)
+    {
+      appendToFile(_columnFiles[column].path, out);
+    }
+  }
+
+  if (_csv)
+  {
+    addCsvSeparator(column);
+    appendCsvString(_csvFile.buffer, data, size);
+  }
+}
+
+void ColumnExporter::addCsvSeparator(std::size_t column)
+{
+  if (column != 0) { _csvFile.buffer += ','; }
+}
@@ -0,0 +1,126 @@
+#ifndef BINLOG_BIN_COLUMNS_HPP
+#define BINLOG_BIN_COLUMNS_HPP
+
+#include <binlog/Entries.hpp>
+#include <binlog/Range.hpp>
+
+#include <mserialize/string_view.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/** An event to export, the source is given by the ColumnExporter */
+struct ExportedEvent
+{
+  std::uint64_t clockValue;
+  std::int64_t timeNs;       /**< Nanoseconds since the UNIX epoch */
+  std::uint64_t writerId;
+  const std::string* writerName;
+  binlog::Range arguments;
+};
+
+/**
+ * Writes the events of a single EventSource as a table.
+ *
+ * Columns: clock, time_ns, writer_id, writer_name,
+ * and the arguments, flattened: tuples and structures
+ * are split to their elements and fields, recursively
+ * (e.g: arg0.bid, arg0.ask, arg1.0, arg1.1).
+ * Arithmetic values and strings get typed columns,
+ * every other value (sequences, variants, enums, recursive structures)
+ * is converted to text.
+ *
+ * Files written, `prefix` given to the constructor:
+ *
+ *  - `<prefix>.schema`: text, describes the event source and the columns,
+ *    one line per column: `<index> <name> <type>`.
+ *  - `<prefix>.col<index>`: binary, the values of a column,
+ *    in native byte order, without padding. Types:
+ *    bool, char, i8, u8, i16, u16, i32, u32, i64, u64, f32, f64:
+ *    fixed size values (bool and char are a single byte),
+ *    string: 32 bit length, followed by that many bytes.
+ *    long double values are written as f64.
+ *  - `<prefix>.csv`: RFC 4180 CSV, with a header row.
+ *
+ * Values are buffered, and appended to the files in batches,
+ * files are kept closed between batches, to allow exporting
+ * many sources at once. Call flush() after the last row.
+ * Not thread-safe, but different exporters can be used concurrently.
+ */
+class ColumnExporter
+{
+public:
+  enum Formats { Binary = 1, Csv = 2 };
+
+  struct Column
+  {
+    enum class Kind { Arithmetic, String, Text };
+
+    std::string name;
+    Kind kind;
+    std::string tag;   /**< Type tag of the values in the column */
+  };
+
+  /**
+   * Create the schema file and the empty data files of `source`,
+   * overwriting existing files.
+   *
+   * @param formats Binary, Csv or Binary|Csv
+   * @throw std::runtime_error if a file cannot be opened
+   */
+  ColumnExporter(const std::string& prefix, const binlog::EventSource& source, int formats);
+
+  ColumnExporter(const ColumnExporter&) = delete;
+  void operator=(const ColumnExporter&) = delete;
+
+  /**
+   * Add a row to the table.
+   *
+   * @throw std::runtime_error if the arguments are invalid, or writing fails.
+   */
+  void add(const ExportedEvent& event);
+
+  /**
+   * Append the buffered values to the files.
+   *
+   * @throw std::runtime_error if writing fails.
+   */
+  void flush();
+
+  /** @returns the columns, including clock, time_ns, writer_id and writer_name */
+  const std::vector<Column>& columns() const { return _columns; }
+
+  std::uint64_t rowCount() const { return _rowCount; }
+
+  /** @returns the type of `column`, as written in the schema, e.g: "u64" or "string" */
+  static std::string typeName(const Column& column);
+
+private:
+  struct OutputFile
+  {
+    std::string path;
+    std::string buffer;
+  };
+
+  void addColumns(const std::string& name, mserialize::string_view tag, int depth);
+  void writeSchema(const binlog::EventSource& source) const;
+
+  void addArithmetic(std::size_t column, char tag, const char* value);
+  void addString(std::size_t column, const char* data, std::uint32_t size);
+  void addCsvSeparator(std::size_t column);
+
+  std::string _prefix;
+  std::string _fullTag; // argument tags of the source, to resolve recursive structures
+  bool _binary;
+  bool _csv;
+  std::vector<Column> _columns;
+  std::vector<OutputFile> _columnFiles; // empty if not _binary
+  OutputFile _csvFile;
+  std::ostringstream _text; // renders Text columns
+  std::uint64_t _rowCount = 0;
+};
+
+#endif // BINLOG_BIN_COLUMNS_HPP
@@ -0,0 +1,21 @@
+#ifndef BINLOG_BIN_EVENTSOURCE_HPP
+#define BINLOG_BIN_EVENTSOURCE_HPP
+
+#include <binlog/Entries.hpp>
+
+/**
+ * @returns true if `a` and `b` have the same properties, ignoring the id.
+ *
+ * EventStream replaces a source if its id is redefined
+ * (e.g: concatenated logfiles), at the same address:
+ * tools that cache per source id use this to detect the change.
+ */
+inline bool sameDefinition(const binlog::EventSource& a, const binlog::EventSource& b)
+{
+  return a.line == b.line && a.severity == b.severity
+    && a.formatString == b.formatString && a.file == b.file
+    && a.function == b.function && a.category == b.category
+    && a.argumentTags == b.argumentTags;
+}
+
+#endif // BINLOG_BIN_EVENTSOURCE_HPP
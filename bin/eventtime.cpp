@@ -0,0 +1,57 @@
+#include "eventtime.hpp"
+
+#include <binlog/Time.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <ctime> // strftime
+
+std::int64_t eventNs(const binlog::Event& event, const binlog::ClockSync& clockSync)
+{
+  if (clockSync.clockFrequency == 0)
+  {
+    return std::int64_t(event.clockValue); // no clock sync, assume nanoseconds
+  }
+
+  return binlog::clockToNsSinceEpoch(clockSync, event.clockValue).count();
+}
+
+std::int64_t floorDiv(std::int64_t a, std::int64_t b)
+{
+  const std::int64_t q = a / b;
+  return (a % b != 0 && (a < 0) != (b < 0)) ? q - 1 : q;
+}
+
+std::string timeLabel(std::int64_t secondsSinceEpoch)
+{
+  binlog::BrokenDownTime bdt{};
+  binlog::nsSinceEpochToBrokenDownTimeUTC(std::chrono::seconds(secondsSinceEpoch), bdt);
+  char buf[64];
+  const std::size_t size = std::strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &bdt);
+  return std::string(buf, size);
+}
+
+bool parseInterval(const std::string& str, std::int64_t& resultSeconds)
+{
+  if (str.size() < 2) { return false; }
+  const std::string count = str.substr(0, str.size() - 1);
+  const bool isNumber = std::all_of(count.begin(), count.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; });
+  if (! isNumber || count.size() > 9) { return false; }
+
+  std::int64_t unit = 0;
+  switch (str.back())
+  {
+    case 's': unit = 1; break;
+    case 'm': unit = 60; break;
+    case 'h': unit = 3600; break;
+    default: return false;
+  }
+
+  const std::int64_t seconds = std::stoll(count) * unit;
+  if (seconds == 0 || seconds > maxIntervalSeconds) { return false; }
+
+  resultSeconds = seconds;
+  return true;
+}
@@ -0,0 +1,38 @@
+#ifndef BINLOG_BIN_EVENTTIME_HPP
+#define BINLOG_BIN_EVENTTIME_HPP
+
+#include <binlog/Entries.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <string>
+
+/*
+ * Time of events, and time intervals,
+ * shared by the aggregating tools (bread -S, bread -q, bexport).
+ */
+
+/** The largest interval in seconds, that can be converted to nanoseconds */
+constexpr std::int64_t maxIntervalSeconds = std::numeric_limits<std::int64_t>::max() / 1000000000;
+
+/**
+ * @returns the time of `event` in nanoseconds since epoch,
+ *          or the raw clock value, if `clockSync` is not set (assumed to be nanoseconds).
+ */
+std::int64_t eventNs(const binlog::Event& event, const binlog::ClockSync& clockSync);
+
+/** @returns `a / b`, rounded towards negative infinity. @pre b != 0 */
+std::int64_t floorDiv(std::int64_t a, std::int64_t b);
+
+/** @returns `secondsSinceEpoch` as an UTC date and time, e.g: "2019-10-01 14:15:00" */
+std::string timeLabel(std::int64_t secondsSinceEpoch);
+
+/**
+ * Parse a time interval: "<N>s", "<N>m" or "<N>h".
+ *
+ * @returns false if `str` is not a positive interval,
+ *          or it is larger than maxIntervalSeconds.
+ */
+bool parseInterval(const std::string& str, std::int64_t& resultSeconds);
+
+#endif // BINLOG_BIN_EVENTTIME_HPP
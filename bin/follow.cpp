@@ -0,0 +1,259 @@
+#include "follow.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+  #include <io.h>
+#else
+  #include <cerrno>
+  #include <unistd.h>
+#endif
+
+#ifdef __linux__
+  #include <poll.h>
+  #include <sys/inotify.h>
+#endif
+
+namespace {
+
+// Read size, bytes not available at once are read by the next fill
+constexpr std::size_t g_readSize = 1 << 16;
+
+// Wait interval if inotify is not available
+constexpr std::chrono::milliseconds g_pollInterval(10);
+
+#ifdef _WIN32
+
+int openFile(const std::string& path) { return _open(path.c_str(), _O_RDONLY | _O_BINARY); }
+long long readFile(int fd, char* buf, std::size_t size) { return _read(fd, buf, unsigned(std::min<std::size_t>(size, 1u << 30))); }
+void closeFile(int fd) { _close(fd); }
+void rewindFile(int fd) { _lseeki64(fd, 0, SEEK_SET); }
+
+using FileStat = struct _stat64;
+int statPath(const std::string& path, FileStat& st) { return _stat64(path.c_str(), &st); }
+int statFile(int fd, FileStat& st) { return _fstat64(fd, &st); }
+
+// File identity is not available, only truncation is detected
+bool sameFile(const FileStat&, const FileStat&) { return true; }
+
+#else // assume POSIX
+
+int openFile(const std::string& path) { return ::open(path.c_str(), O_RDONLY | O_CLOEXEC); }
+
+long long readFile(int fd, char* buf, std::size_t size)
+{
+  ssize_t result;
+  do { result = ::read(fd, buf, size); } while (result < 0 && errno == EINTR);
+  return result;
+}
+
+void closeFile(int fd) { ::close(fd); }
+void rewindFile(int fd) { ::lseek(fd, 0, SEEK_SET); }
+
+using FileStat = struct stat;
+int statPath(const std::string& path, FileStat& st) { return ::stat(path.c_str(), &st); }
+int statFile(int fd, FileStat& st) { return ::fstat(fd, &st); }
+
+bool sameFile(const FileStat& a, const FileStat& b)
+{
+  return a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+}
+
+#endif
+
+#ifdef __linux__
+
+std::string directoryOf(const std::string& path)
+{
+  const std::size_t slash = path.find_last_of('/');
+  if (slash == std::string::npos) { return "."; }
+  if (slash == 0) { return "/"; }
+  return path.substr(0, slash);
+}
+
+#endif
+
+} // namespace
+
+FollowEntryStream::FollowEntryStream(std::string path)
+  :_path(std::move(path))
+{
+  #ifdef __linux__
+    _notifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (_notifyFd >= 0)
+    {
+      _dirWatch = inotify_add_watch(_notifyFd, directoryOf(_path).c_str(), IN_CREATE | IN_MOVED_TO);
+    }
+  #endif
+
+  try
+  {
+    open();
+  }
+  catch (...)
+  {
+    closeNotify();
+    throw;
+  }
+}
+
+FollowEntryStream::~FollowEntryStream()
+{
+  close();
+  closeNotify();
+}
+
+binlog::Range FollowEntryStream::nextEntryPayload()
+{
+  while (true)
+  {
+    // return the next complete entry, if available
+    std::size_t available = _end - _begin;
+    std::size_t required = sizeof(std::uint32_t);
+    if (available >= required)
+    {
+      std::uint32_t size;
+      std::memcpy(&size, _buffer.data() + _begin, sizeof(size));
+      required += size;
+      if (available >= required)
+      {
+        const binlog::Range result(_buffer.data() + _begin + sizeof(size), size);
+        _begin += required;
+        return result;
+      }
+    }
+
+    if (fill(required) != 0) { continue; }
+
+    // end of file reached, check for truncation and rotation
+
+    FileStat fileStat;
+    if (statFile(_fd, fileStat) != 0)
+    {
+      throw std::runtime_error("Failed to stat '" + _path + "'");
+    }
+
+    if (static_cast<unsigned long long>(fileStat.st_size) < _offset)
+    {
+      // truncated, start over
+      _droppedBytes += _end - _begin;
+      _begin = _end = 0;
+      _offset = 0;
+      rewindFile(_fd);
+      continue;
+    }
+
+    FileStat pathStat;
+    if (statPath(_path, pathStat) != 0 || sameFile(pathStat, fileStat))
+    {
+      return {}; // no new data yet
+    }
+
+    // replaced: consume what is written to the old file before the check
+    if (fill(required) != 0) { continue; }
+
+    _droppedBytes += _end - _begin;
+    _begin = _end = 0;
+    close();
+    open();
+  }
+}
+
+void FollowEntryStream::wait(std::chrono::milliseconds timeout)
+{
+  #ifdef __linux__
+    if (_notifyFd >= 0)
+    {
+      pollfd pfd{_notifyFd, POLLIN, 0};
+      if (poll(&pfd, 1, int(timeout.count())) > 0)
+      {
+        // drain the events, the next nextEntryPayload checks the file anyway
+        alignas(inotify_event) char events[4096];
+        while (::read(_notifyFd, events, sizeof(events)) > 0) {}
+      }
+      return;
+    }
+  #endif
+
+  std::this_thread::sleep_for(std::min(timeout, g_pollInterval));
+}
+
+void FollowEntryStream::open()
+{
+  _fd = openFile(_path);
+  if (_fd < 0)
+  {
+    throw std::runtime_error("Failed to open '" + _path + "' for reading");
+  }
+  _offset = 0;
+
+  #ifdef __linux__
+    if (_notifyFd >= 0)
+    {
+      _fileWatch = inotify_add_watch(_notifyFd, _path.c_str(), IN_MODIFY | IN_MOVE_SELF | IN_DELETE_SELF);
+    }
+  #endif
+}
+
+void FollowEntryStream::close()
+{
+  #ifdef __linux__
+    if (_fileWatch >= 0)
+    {
+      inotify_rm_watch(_notifyFd, _fileWatch);
+      _fileWatch = -1;
+    }
+  #endif
+
+  if (_fd >= 0)
+  {
+    closeFile(_fd);
+    _fd = -1;
+  }
+}
+
+void FollowEntryStream::closeNotify()
+{
+  #ifdef __linux__
+    if (_notifyFd >= 0)
+    {
+      ::close(_notifyFd); // removes the watches
+      _notifyFd = -1;
+    }
+  #endif
+}
+
+std::size_t FollowEntryStream::fill(std::size_t minSize)
+{
+  // make room for at least minSize bytes and a full read after _begin
+  if (_begin != 0)
+  {
+    std::memmove(_buffer.data(), _buffer.data() + _begin, _end - _begin);
+    _end -= _begin;
+    _begin = 0;
+  }
+
+  const std::size_t capacity = std::max(minSize, _end + g_readSize);
+  if (_buffer.size() < capacity)
+  {
+    _buffer.resize(capacity);
+  }
+
+  const long long result = readFile(_fd, _buffer.data() + _end, _buffer.size() - _end);
+  if (result < 0)
+  {
+    throw std::runtime_error("Failed to read '" + _path + "'");
+  }
+
+  const std::size_t size = static_cast<std::size_t>(result);
+  _end += size;
+  _offset += size;
+  return size;
+}
@@ -0,0 +1,85 @@
+#ifndef BINLOG_BIN_FOLLOW_HPP
+#define BINLOG_BIN_FOLLOW_HPP
+
+#include <binlog/EntryStream.hpp>
+#include <binlog/Range.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * Entry stream of a logfile that is being written.
+ *
+ * Unlike IstreamEntryStream, a partially written entry
+ * at the end of the file is not an error: the available
+ * bytes are kept, and the entry is returned once it is complete.
+ *
+ * If the file at `path` is replaced (e.g: it is renamed
+ * and a new file is created with the same name, see LogRotation.cpp),
+ * the rest of the old file is consumed, then the new file is opened.
+ * If the file is truncated, it is read again from the beginning.
+ *
+ * Usage:
+ *
+ *    FollowEntryStream input(path);
+ *    while (true)
+ *    {
+ *      while (const binlog::Event* event = eventStream.nextEvent(input)) { print(event); }
+ *      input.wait(std::chrono::seconds(1));
+ *    }
+ *
+ * On Linux, wait() blocks on inotify, otherwise it polls the file.
+ */
+class FollowEntryStream : public binlog::EntryStream
+{
+public:
+  /** @throw std::runtime_error if `path` cannot be opened */
+  explicit FollowEntryStream(std::string path);
+
+  ~FollowEntryStream() override;
+
+  FollowEntryStream(const FollowEntryStream&) = delete;
+  void operator=(const FollowEntryStream&) = delete;
+
+  /**
+   * @return the payload of the next complete entry,
+   *         or an empty range, if no complete entry is available yet.
+   *
+   * @throw std::runtime_error if reading the file fails
+   */
+  binlog::Range nextEntryPayload() override;
+
+  /**
+   * Block until the followed file is (probably) changed,
+   * or `timeout` elapses. Spurious wakeups are possible.
+   */
+  void wait(std::chrono::milliseconds timeout);
+
+  /** @returns the number of bytes dropped, that were left incomplete in replaced files */
+  std::size_t droppedBytes() const { return _droppedBytes; }
+
+private:
+  void open();
+  void close();
+  void closeNotify();
+
+  // Read more bytes from _fd to _buffer, @returns the number of bytes read
+  std::size_t fill(std::size_t minSize);
+
+  std::string _path;
+  int _fd = -1;
+  int _notifyFd = -1;    // inotify instance, -1 if unavailable
+  int _fileWatch = -1;   // watches _fd
+  int _dirWatch = -1;    // watches the directory of _path, to see it recreated
+  std::size_t _offset = 0; // bytes read from _fd
+
+  std::vector<char> _buffer;
+  std::size_t _begin = 0; // first unconsumed byte in _buffer
+  std::size_t _end = 0;   // end of valid bytes in _buffer
+
+  std::size_t _droppedBytes = 0;
+};
+
+#endif // BINLOG_BIN_FOLLOW_HPP
@@ -1,31 +1,40 @@
 #include "printers.hpp"
 
+#include "resync.hpp"
+#include "stats.hpp"
+
 #include <binlog/Entries.hpp> // Event
 #include <binlog/EntryStream.hpp>
 #include <binlog/EventStream.hpp>
+#include <binlog/MergedEventStream.hpp>
 #include <binlog/PrettyPrinter.hpp>
+#include <binlog/detail/OstreamBuffer.hpp>
 
 #include <algorithm>
+#include <chrono>
 #include <cstdint>
+#include <deque>
 #include <istream>
 #include <ostream>
 #include <sstream>
 #include <utility>
 #include <vector>
 
-void printEvents(std::istream& input, std::ostream& output, const std::string& format, const std::string& dateFormat)
+void printEvents(std::istream& input, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat)
 {
   binlog::IstreamEntryStream entryStream(input);
   binlog::EventStream eventStream;
   binlog::PrettyPrinter pp(format, dateFormat);
 
-  while (const binlog::Event* event = eventStream.nextEvent(entryStream))
+  while (output.good())
   {
+    const binlog::Event* event = eventStream.nextEvent(entryStream);
+    if (event == nullptr) { break; }
     pp.printEvent(output, *event, eventStream.writerProp(), eventStream.clockSync());
   }
 }
 
-void printSortedEvents(std::istream& input, std::ostream& output, const std::string& format, const std::string& dateFormat)
+void printSortedEvents(std::istream& input, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat)
 {
   binlog::IstreamEntryStream entryStream(input);
   binlog::EventStream eventStream;
@@ -34,12 +43,14 @@ void printSortedEvents(std::istream& input, std::ostream& output, const std::str
   using Pair = std::pair<std::uint64_t /* clock */, std::string /* pretty printed event */>;
   std::vector<Pair> buffer;
   std::ostringstream stream;
+  binlog::detail::OstreamBuffer out(stream);
 
   // buffer every event in input
   while (const binlog::Event* event = eventStream.nextEvent(entryStream))
   {
     stream.str({}); // reset stream
-    pp.printEvent(stream, *event, eventStream.writerProp(), eventStream.clockSync());
+    pp.printEvent(out, *event, eventStream.writerProp(), eventStream.clockSync());
+    out.flush();
     buffer.emplace_back(event->clockValue, stream.str());
   }
 
@@ -48,6 +59,165 @@ void printSortedEvents(std::istream& input, std::ostream& output, const std::str
   std::stable_sort(buffer.begin(), buffer.end(), cmpClock);
   for (const Pair& p : buffer)
   {
-    output << p.second;
+    output.write(p.second.data(), p.second.size());
+  }
+}
+
+void printMergedEvents(const std::vector<std::istream*>& inputs, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat)
+{
+  std::deque<binlog::IstreamEntryStream> entryStreams;
+  binlog::MergedEventStream eventStream;
+  binlog::PrettyPrinter pp(format, dateFormat);
+
+  for (std::istream* input : inputs)
+  {
+    entryStreams.emplace_back(*input);
+    eventStream.addInput(entryStreams.back());
+  }
+
+  while (output.good())
+  {
+    const binlog::Event* event = eventStream.nextEvent();
+    if (event == nullptr) { break; }
+    pp.printEvent(output, *event, eventStream.writerProp(), eventStream.clockSync());
+  }
+}
+
+void printSortedMergedEvents(const std::vector<std::istream*>& inputs, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat)
+{
+  std::deque<binlog::IstreamEntryStream> entryStreams;
+  binlog::MergedEventStream eventStream;
+  binlog::PrettyPrinter pp(format, dateFormat);
+
+  for (std::istream* input : inputs)
+  {
+    entryStreams.emplace_back(*input);
+    eventStream.addInput(entryStreams.back());
+  }
+
+  using Pair = std::pair<std::int64_t /* time */, std::string /* pretty printed event */>;
+  std::vector<Pair> buffer;
+  std::ostringstream stream;
+  binlog::detail::OstreamBuffer out(stream);
+
+  // buffer every event in inputs
+  while (const binlog::Event* event = eventStream.nextEvent())
+  {
+    stream.str({}); // reset stream
+    pp.printEvent(out, *event, eventStream.writerProp(), eventStream.clockSync());
+    out.flush();
+    buffer.emplace_back(eventStream.time(), stream.str());
+  }
+
+  // sort and print the the buffer
+  const auto cmpTime = [](const Pair& p1, const Pair& p2) { return p1.first < p2.first; };
+  std::stable_sort(buffer.begin(), buffer.end(), cmpTime);
+  for (const Pair& p : buffer)
+  {
+    output.write(p.second.data(), p.second.size());
+  }
+}
+
+void printStatistics(std::istream& input, binlog::detail::OstreamBuffer& output, std::int64_t bucketSeconds, std::uint32_t maxEntrySize)
+{
+  binlog::EventStream eventStream;
+  ResyncEntryStream entryStream(input, eventStream, maxEntrySize); // buffered, faster than IstreamEntryStream
+  EventStatistics stats(bucketSeconds);
+  std::uint64_t skippedBytes = 0;
+  std::size_t skipCount = 0;
+
+  while (true)
+  {
+    try
+    {
+      const binlog::Event* event = eventStream.nextEvent(entryStream);
+      if (event == nullptr) { break; }
+      stats.add(*event, eventStream.writerProp(), eventStream.clockSync());
+    }
+    catch (const std::exception&)
+    {
+      skippedBytes += entryStream.resync().size;
+      ++skipCount;
+    }
+  }
+
+  std::ostringstream stream;
+  stats.print(stream);
+  if (skipCount != 0)
+  {
+    stream << "\nSkipped " << skippedBytes << " bytes of invalid entries in " << skipCount << " ranges\n";
+  }
+  if (entryStream.oversizedEntryCount() != 0)
+  {
+    stream << "Warning: skipped " << entryStream.oversizedEntryCount()
+           << " entries larger than the maximum entry size (" << maxEntrySize << " bytes)\n";
+  }
+  const std::string str = stream.str();
+  output.write(str.data(), str.size());
+}
+
+void printQuery(std::istream& input, binlog::detail::OstreamBuffer& output, const Query& query)
+{
+  binlog::IstreamEntryStream entryStream(input);
+  binlog::EventStream eventStream;
+  QueryAggregator aggregator(query);
+
+  while (const binlog::Event* event = eventStream.nextEvent(entryStream))
+  {
+    aggregator.add(*event, eventStream.clockSync());
+  }
+
+  std::ostringstream stream;
+  aggregator.print(stream);
+  const std::string str = stream.str();
+  output.write(str.data(), str.size());
+}
+
+std::size_t printRecoveredEvents(std::istream& input, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat, std::ostream& report, std::uint32_t maxEntrySize)
+{
+  binlog::EventStream eventStream;
+  ResyncEntryStream entryStream(input, eventStream, maxEntrySize);
+  binlog::PrettyPrinter pp(format, dateFormat);
+  std::size_t skipCount = 0;
+
+  while (output.good())
+  {
+    try
+    {
+      const binlog::Event* event = eventStream.nextEvent(entryStream);
+      if (event == nullptr) { break; }
+      pp.printEvent(output, *event, eventStream.writerProp(), eventStream.clockSync());
+    }
+    catch (const std::exception& ex)
+    {
+      const ResyncEntryStream::SkippedRange skipped = entryStream.resync();
+      ++skipCount;
+
+      output.flush(); // keep the report in place, if output and report are the same
+      report << "[bread] Skipped " << skipped.size << " bytes at offset "
+             << skipped.offset << ": " << ex.what() << "\n";
+    }
+  }
+
+  return skipCount;
+}
+
+void printFollowedEvents(FollowEntryStream& input, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat)
+{
+  binlog::EventStream eventStream;
+  binlog::PrettyPrinter pp(format, dateFormat);
+
+  while (output.good())
+  {
+    const binlog::Event* event = eventStream.nextEvent(input);
+    if (event != nullptr)
+    {
+      pp.printEvent(output, *event, eventStream.writerProp(), eventStream.clockSync());
+      continue;
+    }
+
+    // show everything available before blocking
+    output.flush();
+    input.wait(std::chrono::seconds(1));
   }
 }
@@ -1,8 +1,23 @@
 #ifndef BINLOG_BIN_PRINTERS_HPP
 #define BINLOG_BIN_PRINTERS_HPP
 
+#include <binlog/detail/OstreamBuffer.hpp>
+
+#include "follow.hpp"
+#include "query.hpp"
+#include "resync.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
 #include <iosfwd>
 #include <string>
+#include <vector>
+
+/*
+ * The printers write `output`, without flushing it.
+ * Printing stops early if `output` goes bad (e.g: the reader of the pipe exits).
+ */
 
 /**
  * Print the events in `input` to output, according to
@@ -11,7 +26,7 @@
  * @see PrettyPrinter on `format` and `dateFormat`.
  * @throws std::runtime_error if invalid binlog entry found in `input`.
  */
-void printEvents(std::istream& input, std::ostream& output, const std::string& format, const std::string& dateFormat);
+void printEvents(std::istream& input, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat);
 
 /**
  * Print the events in `input` to output, according to
@@ -22,6 +37,83 @@ void printEvents(std::istream& input, std::ostream& output, const std::string& f
  * @see PrettyPrinter on `format` and `dateFormat`.
  * @throws std::runtime_error if invalid binlog entry found in `input`.
  */
-void printSortedEvents(std::istream& input, std::ostream& output, const std::string& format, const std::string& dateFormat);
+void printSortedEvents(std::istream& input, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat);
+
+/**
+ * Print the events of every stream in `inputs` to output, according to
+ * `format` and `dateFormat`, merged by event time.
+ *
+ * Events are merged in a streaming fashion: if each input
+ * is ordered by time, the output is ordered by time.
+ *
+ * @see binlog::MergedEventStream on ordering.
+ * @see PrettyPrinter on `format` and `dateFormat`.
+ * @throws std::runtime_error if invalid binlog entry found in `inputs`.
+ */
+void printMergedEvents(const std::vector<std::istream*>& inputs, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat);
+
+/**
+ * Print the events of every stream in `inputs` to output, according to
+ * `format` and `dateFormat`, sorted by event time.
+ *
+ * First buffer every event in `inputs`, then sort and print them.
+ *
+ * @see binlog::MergedEventStream on ordering.
+ * @see PrettyPrinter on `format` and `dateFormat`.
+ * @throws std::runtime_error if invalid binlog entry found in `inputs`.
+ */
+void printSortedMergedEvents(const std::vector<std::istream*>& inputs, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat);
+
+/**
+ * Print statistics of the events in `input` to output:
+ * event count, bytes, rate and peak rate per source and per writer,
+ * and if `bucketSeconds` is not zero, the rate in each interval of that size.
+ *
+ * Event arguments are not visited. Invalid entries
+ * (including the ones larger than `maxEntrySize`) are skipped,
+ * and the number of skipped bytes is reported.
+ *
+ * @see EventStatistics
+ * @see ResyncEntryStream
+ */
+void printStatistics(std::istream& input, binlog::detail::OstreamBuffer& output, std::int64_t bucketSeconds = 0, std::uint32_t maxEntrySize = ResyncEntryStream::defaultMaxEntrySize);
+
+/**
+ * Print the aggregated value of the argument selected by `query`
+ * of the events in `input` to output.
+ *
+ * Only the required arguments of the selected events are decoded.
+ * Selected sources without a numeric argument are skipped with a warning.
+ *
+ * @see QueryAggregator
+ * @throws std::runtime_error if invalid binlog entry found in `input`.
+ */
+void printQuery(std::istream& input, binlog::detail::OstreamBuffer& output, const Query& query);
+
+/**
+ * Print the events in `input` to output, according to
+ * `format` and `dateFormat`, skipping corrupt parts of `input`.
+ *
+ * If an invalid entry is found (e.g: larger than `maxEntrySize`), it is skipped,
+ * along with the bytes following it, until the next plausible entry.
+ * Skipped byte ranges are reported to `report`.
+ *
+ * @see ResyncEntryStream on finding plausible entries.
+ * @see PrettyPrinter on `format` and `dateFormat`.
+ * @returns the number of skipped ranges
+ */
+std::size_t printRecoveredEvents(std::istream& input, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat, std::ostream& report, std::uint32_t maxEntrySize = ResyncEntryStream::defaultMaxEntrySize);
+
+/**
+ * Print the events of `input` to output, according to
+ * `format` and `dateFormat`, as they are written to the followed file.
+ *
+ * Flushes `output` before waiting for new events.
+ * Returns only if `output` goes bad.
+ *
+ * @see PrettyPrinter on `format` and `dateFormat`.
+ * @throws std::runtime_error if invalid binlog entry found in `input`.
+ */
+void printFollowedEvents(FollowEntryStream& input, binlog::detail::OstreamBuffer& output, const std::string& format, const std::string& dateFormat);
 
 #endif // BINLOG_BIN_PRINTERS_HPP
@@ -0,0 +1,317 @@
+#include "query.hpp"
+
+#include "eventtime.hpp"
+
+#include <binlog/Range.hpp>
+#include <binlog/ToStringVisitor.hpp>
+#include <binlog/detail/OstreamBuffer.hpp>
+
+#include <mserialize/VisitProgram.hpp>
+#include <mserialize/Visitor.hpp>
+#include <mserialize/string_view.hpp>
+#include <mserialize/visit.hpp>
+
+#include <mserialize/detail/tag_util.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+bool isNumber(const std::string& str)
+{
+  return ! str.empty() && std::all_of(str.begin(), str.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; });
+}
+
+bool isArithmetic(const std::string& tag)
+{
+  return tag.size() == 1 && mserialize::VisitProgram::arithmetic_size(tag.front()) != 0;
+}
+
+std::string location(const binlog::EventSource& source)
+{
+  return source.file + ":" + std::to_string(source.line);
+}
+
+// Consumes the visited object, without converting it
+struct SkipVisitor
+{
+  template <typename T>
+  void visit(T) {}
+
+  template <typename T>
+  bool visit(T, binlog::Range&) { return false; }
+
+  bool visit(mserialize::Visitor::SequenceBegin sb, binlog::Range& input)
+  {
+    // skip sequences of arithmetic values (e.g: strings) at once
+    const std::size_t elemSize = (sb.tag.size() == 1) ? mserialize::VisitProgram::arithmetic_size(sb.tag.front()) : 0;
+    if (elemSize == 0) { return false; }
+    input.view(sb.size * elemSize);
+    return true;
+  }
+};
+
+void skipArgument(const std::string& tag, binlog::Range& input)
+{
+  if (isArithmetic(tag))
+  {
+    input.view(mserialize::VisitProgram::arithmetic_size(tag.front()));
+    return;
+  }
+
+  SkipVisitor visitor;
+  mserialize::visit(tag, visitor, input);
+}
+
+double readNumber(char tag, binlog::Range& input)
+{
+  switch (tag)
+  {
+  case 'y': return input.read<bool>() ? 1 : 0;
+  case 'c': return double(input.read<char>());
+  case 'b': return double(input.read<std::int8_t>());
+  case 'B': return double(input.read<std::uint8_t>());
+  case 's': return double(input.read<std::int16_t>());
+  case 'S': return double(input.read<std::uint16_t>());
+  case 'i': return double(input.read<std::int32_t>());
+  case 'I': return double(input.read<std::uint32_t>());
+  case 'l': return double(input.read<std::int64_t>());
+  case 'L': return double(input.read<std::uint64_t>());
+  case 'f': return double(input.read<float>());
+  case 'd': return input.read<double>();
+  case 'D': return double(input.read<long double>());
+  default:
+    throw std::runtime_error(std::string("Invalid arithmetic tag: ") + tag);
+  }
+}
+
+std::string readString(const std::string& tag, binlog::Range& input)
+{
+  // fast path for common group keys: strings, characters and integers
+  if (tag == "[c")
+  {
+    const std::uint32_t size = input.read<std::uint32_t>();
+    return std::string(input.view(size), size);
+  }
+  if (tag.size() == 1)
+  {
+    switch (tag.front())
+    {
+    case 'c': return std::string(1, input.read<char>());
+    case 'b': case 's': case 'i': return std::to_string(std::int64_t(readNumber(tag.front(), input)));
+    case 'B': case 'S': case 'I': return std::to_string(std::uint64_t(readNumber(tag.front(), input)));
+    case 'l': return std::to_string(input.read<std::int64_t>());
+    case 'L': return std::to_string(input.read<std::uint64_t>());
+    default: break;
+    }
+  }
+
+  std::ostringstream str;
+  {
+    binlog::detail::OstreamBuffer buf(str);
+    binlog::ToStringVisitor visitor(buf);
+    mserialize::visit(tag, visitor, input);
+  }
+  return str.str();
+}
+
+// Nearest-rank percentile of sorted `values`
+double percentile(const std::vector<double>& values, double p)
+{
+  const std::size_t rank = std::size_t(std::ceil(p / 100 * double(values.size())));
+  return values[std::min(std::max(rank, std::size_t(1)), values.size()) - 1];
+}
+
+} // namespace
+
+bool Query::parseGroup(const std::string& group)
+{
+  const std::string argPrefix = "arg:";
+  if (group.compare(0, argPrefix.size(), argPrefix) == 0)
+  {
+    const std::string index = group.substr(argPrefix.size());
+    if (! isNumber(index)) { return false; }
+    groupByArgument = true;
+    groupArgument = std::stoul(index);
+    return true;
+  }
+
+  return parseInterval(group, bucketSeconds);
+}
+
+bool Query::matches(const binlog::EventSource& s) const
+{
+  const std::size_t colon = source.rfind(':');
+  if (colon != std::string::npos && isNumber(source.substr(colon + 1)))
+  {
+    // file:line
+    const std::string file = source.substr(0, colon);
+    const bool fileMatches = s.file.size() >= file.size()
+      && s.file.compare(s.file.size() - file.size(), file.size(), file) == 0;
+    return fileMatches && std::to_string(s.line) == source.substr(colon + 1);
+  }
+
+  return s.formatString.find(source) != std::string::npos;
+}
+
+QueryAggregator::QueryAggregator(Query query)
+  :_query(std::move(query))
+{}
+
+void QueryAggregator::add(const binlog::Event& event, const binlog::ClockSync& clockSync)
+{
+  const Plan& p = plan(*event.source);
+  if (! p.selected) { return; }
+
+  GroupKey key;
+  double value = 0;
+
+  binlog::Range input = event.arguments;
+  for (std::size_t i = 0; i < p.tags.size(); ++i)
+  {
+    if (i == _query.argument)
+    {
+      value = readNumber(p.tags[i].front(), input);
+    }
+    else if (_query.groupByArgument && i == _query.groupArgument)
+    {
+      key.second = readString(p.tags[i], input);
+    }
+    else
+    {
+      skipArgument(p.tags[i], input);
+    }
+  }
+
+  if (_query.bucketSeconds != 0)
+  {
+    const std::int64_t bucketNs = _query.bucketSeconds * 1000000000;
+    key.first = floorDiv(eventNs(event, clockSync), bucketNs) * _query.bucketSeconds;
+  }
+
+  _groups[key].push_back(value);
+}
+
+std::vector<QueryAggregator::Summary> QueryAggregator::summaries() const
+{
+  std::vector<Summary> result;
+  std::vector<double> values;
+
+  for (const auto& group : _groups)
+  {
+    values = group.second;
+    std::sort(values.begin(), values.end());
+
+    Summary s;
+    if (_query.bucketSeconds != 0) { s.group = timeLabel(group.first.first); }
+    if (_query.groupByArgument)
+    {
+      if (! s.group.empty()) { s.group += ' '; }
+      s.group += group.first.second;
+    }
+
+    s.count = values.size();
+    for (const double v : values) { s.sum += v; }
+    s.min = values.front();
+    s.max = values.back();
+    s.mean = s.sum / double(s.count);
+    s.p50 = percentile(values, 50);
+    s.p90 = percentile(values, 90);
+    s.p99 = percentile(values, 99);
+
+    result.push_back(std::move(s));
+  }
+
+  return result;
+}
+
+void QueryAggregator::print(std::ostream& out) const
+{
+  const std::vector<Summary> groups = summaries();
+
+  const std::streamsize precision = out.precision(12);
+
+  std::size_t groupWidth = 5; // "Group"
+  for (const Summary& s : groups) { groupWidth = std::max(groupWidth, s.group.size()); }
+
+  out << std::left << std::setw(int(groupWidth)) << "Group" << std::right
+      << std::setw(12) << "Count"
+      << std::setw(16) << "Sum"
+      << std::setw(12) << "Min"
+      << std::setw(12) << "Max"
+      << std::setw(12) << "Mean"
+      << std::setw(12) << "P50"
+      << std::setw(12) << "P90"
+      << std::setw(12) << "P99" << '\n';
+
+  for (const Summary& s : groups)
+  {
+    out << std::left << std::setw(int(groupWidth)) << s.group << std::right
+        << std::setw(12) << s.count
+        << std::setw(16) << s.sum
+        << std::setw(12) << s.min
+        << std::setw(12) << s.max
+        << std::setw(12) << s.mean
+        << std::setw(12) << s.p50
+        << std::setw(12) << s.p90
+        << std::setw(12) << s.p99 << '\n';
+  }
+
+  out.precision(precision);
+
+  if (! _warnings.empty()) { out << '\n'; }
+  for (const std::string& warning : _warnings)
+  {
+    out << "Warning: " << warning << '\n';
+  }
+}
+
+const QueryAggregator::Plan& QueryAggregator::plan(const binlog::EventSource& source)
+{
+  auto it = _plans.find(source.id);
+  if (it != _plans.end() && it->second.isFor(source)) { return it->second; }
+
+  Plan p;
+  p.file = source.file;
+  p.line = source.line;
+  p.formatString = source.formatString;
+  p.argumentTags = source.argumentTags;
+  p.selected = _query.matches(source);
+  if (p.selected)
+  {
+    std::size_t last = _query.argument;
+    if (_query.groupByArgument) { last = std::max(last, _query.groupArgument); }
+
+    mserialize::string_view tags = source.argumentTags;
+    for (std::size_t i = 0; i <= last; ++i)
+    {
+      const mserialize::string_view tag = mserialize::detail::tag_pop(tags);
+      if (tag.empty())
+      {
+        _warnings.push_back("Skipped event source " + location(source) + ", it has no argument " + std::to_string(i));
+        p.selected = false;
+        break;
+      }
+      p.tags.push_back(tag.to_string());
+    }
+
+    if (p.selected && ! isArithmetic(p.tags[_query.argument]))
+    {
+      _warnings.push_back("Skipped event source " + location(source) + ", its argument "
+        + std::to_string(_query.argument) + " is not a number, its tag is: " + p.tags[_query.argument]);
+      p.selected = false;
+    }
+
+    if (! p.selected) { p.tags.clear(); }
+  }
+
+  Plan& result = _plans[source.id];
+  result = std::move(p);
+  return result;
+}
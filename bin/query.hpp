@@ -0,0 +1,130 @@
+#ifndef BINLOG_BIN_QUERY_HPP
+#define BINLOG_BIN_QUERY_HPP
+
+#include <binlog/Entries.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * Select an argument of matching events,
+ * and aggregate the values, optionally grouped
+ * by time or by an other argument.
+ */
+struct Query
+{
+  /**
+   * Selects event sources, either by location: "file:line",
+   * where `file` is a suffix of the source file, or by
+   * a substring of the format string.
+   */
+  std::string source;
+
+  std::size_t argument = 0;         /**< Index of the aggregated argument, must be a number */
+
+  std::int64_t bucketSeconds = 0;   /**< If not zero, group by the event time, in buckets of this size */
+
+  bool groupByArgument = false;     /**< If true, group by the value of `groupArgument` */
+  std::size_t groupArgument = 0;
+
+  /**
+   * Parse the grouping of the query: "<N>s", "<N>m", "<N>h"
+   * for time buckets (see parseInterval), "arg:<N>" for grouping by an argument.
+   *
+   * @returns false if `group` is invalid
+   */
+  bool parseGroup(const std::string& group);
+
+  /** @returns true if the query selects `source` */
+  bool matches(const binlog::EventSource& source) const;
+};
+
+/**
+ * Aggregates the selected argument of the events selected by a Query.
+ *
+ * Only the requested arguments are decoded, others are skipped.
+ * Selected sources without the requested arguments, or with a selected
+ * argument that is not a number, are skipped, and reported by warnings().
+ *
+ * Usage:
+ *
+ *    QueryAggregator aggregator(query);
+ *    while (const binlog::Event* event = eventStream.nextEvent(input))
+ *    {
+ *      aggregator.add(*event, eventStream.clockSync());
+ *    }
+ *    aggregator.print(std::cout);
+ */
+class QueryAggregator
+{
+public:
+  struct Summary
+  {
+    std::string group; /**< Label of the group, empty if not grouped */
+    std::size_t count = 0;
+    double sum = 0;
+    double min = 0;
+    double max = 0;
+    double mean = 0;
+    double p50 = 0;    /**< Percentiles, by the nearest-rank method */
+    double p90 = 0;
+    double p99 = 0;
+  };
+
+  explicit QueryAggregator(Query query);
+
+  /**
+   * Add the selected argument of `event` to its group,
+   * if `event` is selected by the query.
+   *
+   * @throws std::runtime_error if the arguments are invalid.
+   */
+  void add(const binlog::Event& event, const binlog::ClockSync& clockSync);
+
+  /** @returns the summary of each group, ordered by the group */
+  std::vector<Summary> summaries() const;
+
+  /** @returns a message for each skipped event source, in the order of first use */
+  const std::vector<std::string>& warnings() const { return _warnings; }
+
+  /** Write the summaries as a table, followed by the warnings */
+  void print(std::ostream& out) const;
+
+private:
+  // How to extract the arguments of an event source
+  struct Plan
+  {
+    bool selected = false;
+    std::vector<std::string> tags; // argument tags, until the last required one
+
+    // properties of the planned source: ids can be redefined
+    std::string file;
+    std::uint64_t line = 0;
+    std::string formatString;
+    std::string argumentTags;
+
+    bool isFor(const binlog::EventSource& source) const
+    {
+      return line == source.line && argumentTags == source.argumentTags
+        && formatString == source.formatString && file == source.file;
+    }
+  };
+
+  const Plan& plan(const binlog::EventSource& source);
+
+  // group: time bucket, or group argument as string
+  using GroupKey = std::pair<std::int64_t, std::string>;
+
+  Query _query;
+  std::unordered_map<std::uint64_t, Plan> _plans;
+  std::map<GroupKey, std::vector<double>> _groups;
+  std::vector<std::string> _warnings;
+};
+
+#endif // BINLOG_BIN_QUERY_HPP
@@ -0,0 +1,670 @@
+#include "recovery.hpp"
+
+#include <binlog/Range.hpp>
+#include <binlog/detail/Queue.hpp>
+#include <binlog/detail/QueueReader.hpp>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <new> // bad_alloc
+#include <stdexcept>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #include <emmintrin.h>
+  #define BINLOG_RECOVERY_USE_SSE2
+#endif
+
+#ifndef _WIN32 // assume POSIX
+  #include <fcntl.h> // open
+  #include <sys/mman.h> // mmap, munmap
+  #include <sys/stat.h> // fstat
+  #include <unistd.h> // close
+#endif
+
+namespace {
+
+std::array<char, 8> toArray(std::uint64_t n)
+{
+  std::array<char, 8> result{};
+  memcpy(result.data(), &n, result.size());
+  return result;
+}
+
+// do not initialize arrays directly to remain endianness agnostic
+const std::array<char, 8> g_metadataMagicBytes = toArray(g_metadataMagic);
+const std::array<char, 8> g_dataMagicBytes = toArray(g_dataMagic);
+
+bool isMagicAt(const char* p)
+{
+  return memcmp(p, g_metadataMagicBytes.data(), 8) == 0
+      || memcmp(p, g_dataMagicBytes.data(), 8) == 0;
+}
+
+template <typename T>
+T readAt(const char* data, std::size_t offset)
+{
+  T result;
+  memcpy(static_cast<void*>(&result), data + offset, sizeof(T));
+  return result;
+}
+
+bool checkEntryBuffer(const std::vector<char>& buffer)
+{
+  binlog::Range range(buffer.data(), buffer.size());
+  try
+  {
+    while (range)
+    {
+      const std::uint32_t size = range.read<std::uint32_t>();
+      range.view(size);
+    }
+  }
+  catch (const std::runtime_error&)
+  {
+    return false;
+  }
+
+  return true;
+}
+
+bool fail(RecoveryCandidate& candidate, std::string message)
+{
+  candidate.message = std::move(message);
+  return false;
+}
+
+bool readSession(const MemoryDump& dump, std::size_t pos, RecoveryCandidate& candidate)
+{
+  candidate.result.session = readAt<std::uintptr_t>(dump.data(), pos);
+  if (! dump.isMapped(candidate.result.session))
+  {
+    return fail(candidate, "Session pointer " + std::to_string(candidate.result.session) + " is not mapped");
+  }
+  return true;
+}
+
+// `size` is the end of the segment of the magic number
+bool readMetadata(const MemoryDump& dump, std::size_t size, std::size_t pos, RecoveryCandidate& candidate)
+{
+  const char* data = dump.data();
+  if (size - pos < sizeof(void*) + sizeof(std::uint64_t))
+  {
+    return fail(candidate, "Input doesn't have a metadata header");
+  }
+
+  if (! readSession(dump, pos, candidate)) { return false; }
+  pos += sizeof(void*);
+  const std::uint64_t metadataSize = readAt<std::uint64_t>(data, pos);
+  pos += sizeof(std::uint64_t);
+
+  if (metadataSize > size - pos)
+  {
+    return fail(candidate, "Input doesn't have " + std::to_string(metadataSize) + " bytes");
+  }
+
+  std::vector<char>& metadata = candidate.result.buffer;
+  try
+  {
+    metadata.assign(data + pos, data + pos + metadataSize);
+  }
+  catch (const std::bad_alloc&)
+  {
+    return fail(candidate, "Failed to allocate " + std::to_string(metadataSize) + " bytes for metadata");
+  }
+
+  if (! checkEntryBuffer(metadata)) { return fail(candidate, "Buffer contains invalid entry"); }
+
+  candidate.end = pos + std::size_t(metadataSize);
+  return true;
+}
+
+// `size` is the end of the segment of the magic number
+bool readData(const MemoryDump& dump, std::size_t size, std::size_t pos, RecoveryCandidate& candidate)
+{
+  const char* data = dump.data();
+  if (size - pos < sizeof(void*) + sizeof(binlog::detail::Queue))
+  {
+    return fail(candidate, "Input doesn't have a queue header");
+  }
+
+  if (! readSession(dump, pos, candidate)) { return false; }
+  pos += sizeof(void*);
+
+  // get queue with writer and reader positions
+  // Depending on the standard/compiler, Queue is not trivially copyable
+  // because of the std::atomic members - but we do not care.
+  binlog::detail::Queue queue(nullptr, 0);
+  memcpy(static_cast<void*>(&queue), data + pos, sizeof(queue));
+  pos += sizeof(queue);
+
+  const std::size_t writeIndex = queue.writeIndex.load();
+  const std::size_t readIndex = queue.readIndex.load();
+  if (writeIndex > queue.capacity || queue.dataEnd > queue.capacity || readIndex > queue.capacity)
+  {
+    return fail(candidate,
+      "Queue invariant violated: capacity=" + std::to_string(queue.capacity)
+      + " windex=" + std::to_string(writeIndex) + " rindex=" + std::to_string(readIndex)
+      + " dataend=" + std::to_string(queue.dataEnd)
+    );
+  }
+
+  // Find the buffer of the queue: in a core file, by its address,
+  // otherwise it is expected to follow the queue (see Session::Channel)
+  std::size_t bufferPos = pos;
+  if (dump.isElfCore())
+  {
+    const std::uint64_t bufferAddress = reinterpret_cast<std::uintptr_t>(queue.buffer);
+    if (! dump.translate(bufferAddress, queue.capacity, bufferPos))
+    {
+      return fail(candidate, "Queue buffer at address " + std::to_string(bufferAddress)
+        + " of " + std::to_string(queue.capacity) + " bytes is not in the input");
+    }
+  }
+  else if (queue.capacity > size - pos)
+  {
+    return fail(candidate, "Input doesn't have " + std::to_string(queue.capacity) + " bytes");
+  }
+
+  // create a reader, get the unread data from the buffer.
+  // The reader does not write the buffer.
+  queue.buffer = const_cast<char*>(data + bufferPos); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+  binlog::detail::QueueReader reader(queue);
+  const binlog::detail::QueueReader::ReadResult dataview = reader.beginReadNoWait();
+
+  std::vector<char>& unread = candidate.result.buffer;
+  try
+  {
+    unread.reserve(dataview.size());
+  }
+  catch (const std::bad_alloc&)
+  {
+    return fail(candidate, "Failed to allocate " + std::to_string(dataview.size()) + " bytes for queue data");
+  }
+  unread.insert(unread.end(), dataview.buffer1, dataview.buffer1 + dataview.size1);
+  unread.insert(unread.end(), dataview.buffer2, dataview.buffer2 + dataview.size2);
+
+  if (! checkEntryBuffer(unread)) { return fail(candidate, "Buffer contains invalid entry"); }
+
+  candidate.message = "Queue state is valid: capacity=" + std::to_string(queue.capacity)
+    + " windex=" + std::to_string(writeIndex) + " rindex=" + std::to_string(readIndex)
+    + " dataend=" + std::to_string(queue.dataEnd);
+  // if the buffer follows the queue, skip it while searching
+  candidate.end = (bufferPos == pos) ? pos + queue.capacity : pos;
+  return true;
+}
+
+} // namespace
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::string& path)
+{
+  std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+  if (! file) { throw std::runtime_error("Failed to open " + path); }
+
+  file.seekg(0, std::ios_base::end);
+  _buffer.resize(std::size_t(file.tellg()));
+  file.seekg(0);
+  file.read(_buffer.data(), std::streamsize(_buffer.size()));
+  if (! file) { throw std::runtime_error("Failed to read " + path); }
+
+  _data = _buffer.data();
+  _size = _buffer.size();
+}
+
+MappedFile::~MappedFile() = default;
+
+#else
+
+MappedFile::MappedFile(const std::string& path)
+{
+  const int fd = ::open(path.data(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    throw std::runtime_error("Failed to open " + path + ": " + std::strerror(errno));
+  }
+
+  struct stat st{};
+  if (fstat(fd, &st) != 0 || st.st_size < 0)
+  {
+    ::close(fd);
+    throw std::runtime_error("Failed to get the size of " + path + ": " + std::strerror(errno));
+  }
+
+  _size = std::size_t(st.st_size);
+  if (_size != 0)
+  {
+    void* address = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address == MAP_FAILED) // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+    {
+      ::close(fd);
+      throw std::runtime_error("Failed to map " + path + ": " + std::strerror(errno));
+    }
+    _data = static_cast<const char*>(address);
+  }
+
+  // the mapping remains valid after close
+  ::close(fd);
+}
+
+MappedFile::~MappedFile()
+{
+  if (_data != nullptr)
+  {
+    munmap(const_cast<char*>(_data), _size); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+  }
+}
+
+#endif // _WIN32
+
+MemoryDump::MemoryDump(const char* data, std::size_t size)
+  :_data(data),
+   _size(size)
+{
+  _isElfCore = parseElfCore();
+  if (! _isElfCore)
+  {
+    MemorySegment whole;
+    whole.fileSize = size;
+    whole.memorySize = size;
+    _segments.assign(1, whole);
+    _scannedSegments = _segments;
+  }
+}
+
+bool MemoryDump::translate(std::uint64_t address, std::size_t size, std::size_t& offset) const
+{
+  if (! _isElfCore) { return false; }
+
+  for (const MemorySegment& segment : _segments)
+  {
+    if (segment.address <= address && address - segment.address <= segment.fileSize
+        && size <= segment.fileSize - (address - segment.address))
+    {
+      offset = segment.offset + std::size_t(address - segment.address);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool MemoryDump::isMapped(std::uint64_t address) const
+{
+  if (! _isElfCore) { return true; }
+
+  for (const MemorySegment& segment : _segments)
+  {
+    if (segment.address <= address && address - segment.address < segment.memorySize)
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+namespace {
+
+// ELF constants, see elf(5) - <elf.h> is not available everywhere
+constexpr std::uint16_t g_elfTypeCore = 4;   // ET_CORE
+constexpr std::uint32_t g_segmentLoad = 1;   // PT_LOAD
+constexpr std::uint32_t g_segmentNote = 4;   // PT_NOTE
+constexpr std::uint32_t g_segmentWritable = 2; // PF_W
+constexpr std::uint32_t g_noteFile = 0x46494c45; // NT_FILE
+
+struct AddressRange
+{
+  std::uint64_t begin;
+  std::uint64_t end;
+};
+
+// Reads fields of ELF structures of the given class (32 or 64 bit)
+struct ElfReader
+{
+  const char* data;
+  std::size_t size;
+  bool is64;
+
+  bool has(std::size_t offset, std::size_t n) const
+  {
+    return offset <= size && n <= size - offset;
+  }
+
+  // 32 bit word on ELF32, 64 bit word on ELF64 (addresses, offsets, sizes)
+  std::uint64_t word(std::size_t offset) const
+  {
+    return is64 ? readAt<std::uint64_t>(data, offset) : readAt<std::uint32_t>(data, offset);
+  }
+
+  std::size_t wordSize() const { return is64 ? 8 : 4; }
+};
+
+// Parse the file mappings (start, end) of an NT_FILE note
+void parseFileNote(const ElfReader& elf, std::size_t desc, std::size_t descSize, std::vector<AddressRange>& files)
+{
+  // count, page size, count * (start, end, file offset), file names
+  const std::size_t w = elf.wordSize();
+  if (descSize < 2 * w) { return; }
+
+  const std::uint64_t count = elf.word(desc);
+  if (count > (descSize - 2 * w) / (3 * w)) { return; }
+
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    const std::size_t entry = desc + 2 * w + i * 3 * w;
+    files.push_back(AddressRange{elf.word(entry), elf.word(entry + w)});
+  }
+}
+
+// Parse the notes in [offset, offset+size), collect file mappings
+void parseNotes(const ElfReader& elf, std::size_t offset, std::size_t size, std::vector<AddressRange>& files)
+{
+  const auto align4 = [](std::size_t n) { return (n + 3) & ~std::size_t(3); };
+
+  const std::size_t end = offset + size;
+  while (offset + 12 <= end)
+  {
+    const std::uint32_t nameSize = readAt<std::uint32_t>(elf.data, offset);
+    const std::uint32_t descSize = readAt<std::uint32_t>(elf.data, offset + 4);
+    const std::uint32_t type = readAt<std::uint32_t>(elf.data, offset + 8);
+
+    const std::size_t desc = offset + 12 + align4(nameSize);
+    if (desc > end || descSize > end - desc) { return; }
+
+    if (type == g_noteFile) { parseFileNote(elf, desc, descSize, files); }
+
+    offset = desc + align4(descSize);
+  }
+}
+
+bool overlaps(const MemorySegment& segment, const std::vector<AddressRange>& ranges)
+{
+  for (const AddressRange& range : ranges)
+  {
+    if (range.begin < segment.address + segment.memorySize && segment.address < range.end)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+} // namespace
+
+bool MemoryDump::parseElfCore()
+{
+  // identification: magic, class, data encoding
+  if (_size < 16 || memcmp(_data, "\x7f" "ELF", 4) != 0) { return false; }
+
+  const int elfClass = _data[4];
+  const int encoding = _data[5];
+  const std::uint16_t one = 1;
+  const bool isLittleEndianHost = (*reinterpret_cast<const unsigned char*>(&one) == 1);
+  if ((elfClass != 1 && elfClass != 2) || encoding != (isLittleEndianHost ? 1 : 2))
+  {
+    return false; // not supported, scan as a flat input
+  }
+
+  const ElfReader elf{_data, _size, elfClass == 2};
+  const std::size_t headerSize = elf.is64 ? 64 : 52;
+  if (! elf.has(0, headerSize)) { return false; }
+
+  if (readAt<std::uint16_t>(_data, 16) != g_elfTypeCore) { return false; }
+
+  const std::uint64_t phoff = elf.word(elf.is64 ? 32 : 28);
+  const std::uint16_t phentsize = readAt<std::uint16_t>(_data, elf.is64 ? 54 : 42);
+  const std::uint16_t phnum = readAt<std::uint16_t>(_data, elf.is64 ? 56 : 44);
+  const std::size_t minEntrySize = elf.is64 ? 56 : 32;
+  if (phentsize < minEntrySize || phoff > _size || ! elf.has(std::size_t(phoff), std::size_t(phentsize) * phnum))
+  {
+    return false;
+  }
+
+  std::vector<AddressRange> files;
+  for (std::size_t i = 0; i < phnum; ++i)
+  {
+    const std::size_t ph = std::size_t(phoff) + i * phentsize;
+    const std::uint32_t type = readAt<std::uint32_t>(_data, ph);
+
+    MemorySegment segment;
+    std::uint32_t flags = 0;
+    std::uint64_t offset = 0;
+    std::uint64_t fileSize = 0;
+    if (elf.is64)
+    {
+      flags = readAt<std::uint32_t>(_data, ph + 4);
+      offset = elf.word(ph + 8);
+      segment.address = elf.word(ph + 16);
+      fileSize = elf.word(ph + 32);
+      segment.memorySize = elf.word(ph + 40);
+    }
+    else
+    {
+      offset = elf.word(ph + 4);
+      segment.address = elf.word(ph + 8);
+      fileSize = elf.word(ph + 16);
+      segment.memorySize = elf.word(ph + 20);
+      flags = readAt<std::uint32_t>(_data, ph + 24);
+    }
+
+    // the core might be truncated: keep the available part
+    if (offset > _size) { offset = _size; }
+    fileSize = (std::min)(fileSize, std::uint64_t(_size - offset));
+
+    if (type == g_segmentNote)
+    {
+      parseNotes(elf, std::size_t(offset), std::size_t(fileSize), files);
+    }
+    else if (type == g_segmentLoad)
+    {
+      segment.offset = std::size_t(offset);
+      segment.fileSize = std::size_t(fileSize);
+      segment.writable = (flags & g_segmentWritable) != 0;
+      _segments.push_back(segment);
+    }
+  }
+
+  for (MemorySegment& segment : _segments)
+  {
+    segment.anonymous = ! overlaps(segment, files);
+    if (segment.writable && segment.anonymous && segment.fileSize != 0)
+    {
+      _scannedSegments.push_back(segment);
+    }
+  }
+
+  return true;
+}
+
+std::vector<std::size_t> findMagicNumbers(const char* data, std::size_t size, std::size_t begin, std::size_t end)
+{
+  // magic numbers start and end with the same byte, makes searching easier
+  const char firstByte = g_metadataMagicBytes[0];
+  const char lastByte = g_metadataMagicBytes[7];
+
+  std::vector<std::size_t> result;
+  end = (std::min)(end, (size < 7) ? 0 : size - 7); // magic must fit
+  std::size_t i = begin;
+
+#ifdef BINLOG_RECOVERY_USE_SSE2
+  const __m128i first = _mm_set1_epi8(firstByte);
+  const __m128i last = _mm_set1_epi8(lastByte);
+
+  for (; i < end && end - i >= 16; i += 16)
+  {
+    // compare the first bytes of 16 candidates at i, and the last bytes at i+7
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 7));
+    unsigned mask = unsigned(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last))));
+
+    for (std::size_t bit = 0; mask != 0; ++bit, mask >>= 1)
+    {
+      if ((mask & 1) != 0 && isMagicAt(data + i + bit))
+      {
+        result.push_back(i + bit);
+      }
+    }
+  }
+#endif
+
+  while (i < end)
+  {
+    const void* match = memchr(data + i, firstByte, end - i);
+    if (match == nullptr) { break; }
+
+    i = std::size_t(static_cast<const char*>(match) - data);
+    if (data[i + 7] == lastByte && isMagicAt(data + i))
+    {
+      result.push_back(i);
+    }
+    ++i;
+  }
+
+  return result;
+}
+
+RecoveryCandidate examineCandidate(const MemoryDump& dump, const MemorySegment& segment, std::size_t offset)
+{
+  RecoveryCandidate candidate;
+  candidate.offset = offset;
+
+  const std::size_t pos = offset + 8;
+  const std::size_t segmentEnd = segment.offset + segment.fileSize;
+  if (memcmp(dump.data() + offset, g_metadataMagicBytes.data(), 8) == 0)
+  {
+    candidate.result.type = BufferType::Metadata;
+    candidate.recovered = readMetadata(dump, segmentEnd, pos, candidate);
+  }
+  else
+  {
+    candidate.result.type = BufferType::Data;
+    candidate.recovered = readData(dump, segmentEnd, pos, candidate);
+  }
+
+  if (! candidate.recovered)
+  {
+    candidate.result.buffer.clear();
+    candidate.result.buffer.shrink_to_fit();
+  }
+
+  return candidate;
+}
+
+std::vector<RecoveryCandidate> scanForBuffers(
+  const MemoryDump& dump,
+  std::size_t threads, std::size_t chunkSize,
+  const std::function<void(std::size_t)>& progress
+)
+{
+  // split segments to chunks, in the order of the input
+  struct Chunk
+  {
+    const MemorySegment* segment;
+    std::size_t begin;
+    std::size_t end;
+  };
+
+  std::vector<const MemorySegment*> segments;
+  for (const MemorySegment& segment : dump.scannedSegments()) { segments.push_back(&segment); }
+  std::sort(segments.begin(), segments.end(), [](const MemorySegment* a, const MemorySegment* b) { return a->offset < b->offset; });
+
+  std::vector<Chunk> chunks;
+  for (const MemorySegment* segment : segments)
+  {
+    const std::size_t segmentEnd = segment->offset + segment->fileSize;
+    for (std::size_t begin = segment->offset; begin < segmentEnd; begin += chunkSize)
+    {
+      chunks.push_back(Chunk{segment, begin, (std::min)(segmentEnd, begin + chunkSize)});
+    }
+  }
+
+  const std::size_t chunkCount = chunks.size();
+  std::vector<std::vector<RecoveryCandidate>> chunkResults(chunkCount);
+
+  std::atomic<std::size_t> nextChunk{0};
+  std::atomic<std::size_t> scannedBytes{0};
+
+  std::mutex mutex;
+  std::condition_variable workerDone;
+  std::size_t doneCount = 0;
+  std::exception_ptr error;
+
+  // workers take the next chunk, until all chunks are taken.
+  // Results are stored per chunk, to be merged in order.
+  const auto work = [&]()
+  {
+    try
+    {
+      for (std::size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+      {
+        const Chunk& c = chunks[chunk];
+        const std::size_t segmentEnd = c.segment->offset + c.segment->fileSize;
+
+        for (const std::size_t offset : findMagicNumbers(dump.data(), segmentEnd, c.begin, c.end))
+        {
+          chunkResults[chunk].push_back(examineCandidate(dump, *c.segment, offset));
+        }
+
+        scannedBytes += c.end - c.begin;
+      }
+    }
+    catch (...)
+    {
+      const std::lock_guard<std::mutex> lock(mutex);
+      if (! error) { error = std::current_exception(); }
+      nextChunk = chunkCount; // stop the other workers
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex);
+    ++doneCount;
+    workerDone.notify_one();
+  };
+
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (std::size_t t = 0; t < threads; ++t)
+  {
+    workers.emplace_back(work);
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (! workerDone.wait_for(lock, std::chrono::milliseconds(200), [&]() { return doneCount == threads; }))
+    {
+      if (progress) { progress(scannedBytes.load()); }
+    }
+  }
+
+  for (std::thread& worker : workers)
+  {
+    worker.join();
+  }
+
+  if (error) { std::rethrow_exception(error); }
+  if (progress) { progress(scannedBytes.load()); }
+
+  // merge chunk results, drop candidates inside recovered buffers
+  std::vector<RecoveryCandidate> result;
+  std::size_t recoveredEnd = 0;
+  for (std::vector<RecoveryCandidate>& candidates : chunkResults)
+  {
+    for (RecoveryCandidate& candidate : candidates)
+    {
+      if (candidate.offset < recoveredEnd) { continue; }
+      if (candidate.recovered) { recoveredEnd = candidate.end; }
+      result.push_back(std::move(candidate));
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,176 @@
+#ifndef BINLOG_BIN_RECOVERY_HPP
+#define BINLOG_BIN_RECOVERY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/** Magic number of Session metadata buffers (see RecoverableVectorOutputStream) */
+constexpr std::uint64_t g_metadataMagic = 0xFE214F726E35BDBC;
+
+/** Magic number of Session channel queues (see Session::Channel) */
+constexpr std::uint64_t g_dataMagic = 0xFE213F716D34BCBC;
+
+enum class BufferType
+{
+  Metadata = 0,
+  Data = 1,
+};
+
+/** Metadata or unconsumed data of a Session, found in a memory dump */
+struct RecoveredBuffer
+{
+  BufferType type;
+  std::uintptr_t session;
+  std::vector<char> buffer;
+};
+
+/** The result of examining a magic number found in a memory dump */
+struct RecoveryCandidate
+{
+  std::size_t offset = 0;   /**< Offset of the magic number in the input */
+  std::size_t end = 0;      /**< Offset after the recovered buffer, if recovered */
+  bool recovered = false;
+  std::string message;      /**< State of the queue if data is recovered, or the reason of the failure */
+  RecoveredBuffer result = {BufferType::Metadata, 0, {}};
+};
+
+/**
+ * Read-only view of a file.
+ *
+ * On POSIX systems, the file is mapped to memory,
+ * otherwise its content is read to a buffer.
+ */
+class MappedFile
+{
+public:
+  /** @throws std::runtime_error if the file cannot be opened or mapped */
+  explicit MappedFile(const std::string& path);
+
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  void operator=(const MappedFile&) = delete;
+
+  const char* data() const { return _data; }
+  std::size_t size() const { return _size; }
+
+private:
+  const char* _data = nullptr;
+  std::size_t _size = 0;
+  std::vector<char> _buffer; // if not mapped
+};
+
+/** A part of the input, and the memory it was dumped from */
+struct MemorySegment
+{
+  std::size_t offset = 0;       /**< Offset of the segment in the input */
+  std::size_t fileSize = 0;     /**< Number of bytes of the segment in the input */
+  std::uint64_t address = 0;    /**< Virtual address of the segment */
+  std::uint64_t memorySize = 0; /**< Number of bytes mapped at `address` */
+  bool writable = true;
+  bool anonymous = true;        /**< True, if not mapped from a file */
+};
+
+/**
+ * The memory image of a process.
+ *
+ * If the input is an ELF core file, its program headers
+ * are parsed: only the writable, anonymous (e.g: heap, stack) PT_LOAD segments
+ * are scanned for magic numbers, as buffers of the Session are never placed
+ * elsewhere. File backed mappings are identified by the NT_FILE note, if present.
+ * Pointers (e.g: Queue::buffer) are resolved to file offsets
+ * by the virtual addresses of the segments.
+ *
+ * Otherwise (e.g: a RecoveryFile, or a raw memory dump),
+ * the input is scanned as a single segment, and pointers are not resolved.
+ */
+class MemoryDump
+{
+public:
+  /** @pre [data, data+size) remains valid as long as *this */
+  MemoryDump(const char* data, std::size_t size);
+
+  const char* data() const { return _data; }
+  std::size_t size() const { return _size; }
+
+  /** @returns true, if the input is an ELF core file */
+  bool isElfCore() const { return _isElfCore; }
+
+  /** @returns the PT_LOAD segments of an ELF core, or a single segment of the whole input */
+  const std::vector<MemorySegment>& segments() const { return _segments; }
+
+  /** @returns the segments to scan for magic numbers */
+  const std::vector<MemorySegment>& scannedSegments() const { return _scannedSegments; }
+
+  /**
+   * @returns the offset of the virtual address range [address, address+size)
+   *          in the input, or false if it is not (completely) in the input.
+   *          Always false, if the input is not an ELF core.
+   */
+  bool translate(std::uint64_t address, std::size_t size, std::size_t& offset) const;
+
+  /** @returns true, if `address` was mapped in the dumped process, or the input is not an ELF core */
+  bool isMapped(std::uint64_t address) const;
+
+private:
+  bool parseElfCore();
+
+  const char* _data;
+  std::size_t _size;
+  bool _isElfCore = false;
+  std::vector<MemorySegment> _segments;
+  std::vector<MemorySegment> _scannedSegments;
+};
+
+/**
+ * Find the magic numbers in `data`, that begin in [begin, end).
+ *
+ * Reads at most 7 bytes after `end`, but not after `data + size`.
+ * Uses SSE2 if available: the two magic numbers share their
+ * first and last bytes, 16 positions are checked for
+ * those at a time, only the matches are compared fully.
+ *
+ * @pre begin <= end <= size
+ * @returns the offsets of the magic numbers, in increasing order
+ */
+std::vector<std::size_t> findMagicNumbers(const char* data, std::size_t size, std::size_t begin, std::size_t end);
+
+/**
+ * Try to recover the buffer identified by the magic number at `offset`,
+ * in `segment` of `dump`.
+ *
+ * Checks the size of the buffer, the queue invariants,
+ * and that the recovered buffer consists of complete entries.
+ * The headers must be in `segment`. If `dump` is an ELF core,
+ * the session pointer must be mapped, and the queue buffer is
+ * found by its address, otherwise it must follow the queue.
+ *
+ * @pre [offset, offset+8) contains g_metadataMagic or g_dataMagic
+ */
+RecoveryCandidate examineCandidate(const MemoryDump& dump, const MemorySegment& segment, std::size_t offset);
+
+/**
+ * Find and examine the magic numbers in the scanned segments of `dump`,
+ * by `threads` threads, in chunks of at most `chunkSize` bytes.
+ * Magic numbers spanning segment boundaries are not found.
+ *
+ * The result does not depend on the number of threads:
+ * candidates are ordered by offset, and candidates
+ * inside a recovered buffer are dropped, as they
+ * are part of the recovered content.
+ *
+ * While the threads work, `progress` (if set) is called periodically
+ * by the calling thread, with the number of bytes scanned so far.
+ *
+ * @pre threads > 0, chunkSize > 0
+ */
+std::vector<RecoveryCandidate> scanForBuffers(
+  const MemoryDump& dump,
+  std::size_t threads, std::size_t chunkSize = std::size_t(64) << 20,
+  const std::function<void(std::size_t)>& progress = {}
+);
+
+#endif // BINLOG_BIN_RECOVERY_HPP
@@ -0,0 +1,184 @@
+#include "resync.hpp"
+
+#include <binlog/Entries.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+// Read size, bytes not available at once are read by the next fill
+constexpr std::size_t g_readSize = 1 << 16;
+
+template <typename T>
+T load(const char* p)
+{
+  T result;
+  std::memcpy(&result, p, sizeof(T));
+  return result;
+}
+
+// @returns the first non-zero byte in [begin, end), or end if none
+const char* findNonZero(const char* begin, const char* end)
+{
+  while (end - begin >= 8 && load<std::uint64_t>(begin) == 0) { begin += 8; }
+  while (begin != end && *begin == 0) { ++begin; }
+  return begin;
+}
+
+} // namespace
+
+ResyncEntryStream::ResyncEntryStream(std::istream& input, const binlog::EventStream& eventStream, std::uint32_t maxEntrySize)
+  :_input(input),
+   _eventStream(eventStream),
+   _maxEntrySize(maxEntrySize)
+{}
+
+binlog::Range ResyncEntryStream::nextEntryPayload()
+{
+  _lastEntry = _begin;
+
+  if (! fill(sizeof(std::uint32_t)))
+  {
+    if (_begin == _end) { return {}; } // eof
+
+    throw std::runtime_error("Failed to read entry size, only got "
+      + std::to_string(_end - _begin) + " bytes, expected " + std::to_string(sizeof(std::uint32_t)));
+  }
+
+  const std::uint32_t size = load<std::uint32_t>(_buffer.data() + _begin);
+  if (size > _maxEntrySize)
+  {
+    ++_oversizedEntryCount;
+    throw std::runtime_error("Entry size " + std::to_string(size)
+      + " is larger than the allowed maximum: " + std::to_string(_maxEntrySize));
+  }
+  if (size < sizeof(std::uint64_t))
+  {
+    // an empty range would also mean the end of input
+    throw std::runtime_error("Entry size " + std::to_string(size) + " is too small to hold a tag");
+  }
+
+  if (! fill(sizeof(size) + size))
+  {
+    throw std::runtime_error("Failed to read entry payload, only got "
+      + std::to_string(_end - _begin - sizeof(size)) + " bytes, expected " + std::to_string(size));
+  }
+
+  const binlog::Range result(_buffer.data() + _begin + sizeof(size), size);
+  _begin += sizeof(size) + size;
+  return result;
+}
+
+ResyncEntryStream::SkippedRange ResyncEntryStream::resync()
+{
+  const std::uint64_t skippedBegin = _bufferOffset + _lastEntry;
+
+  // If the most significant byte of a valid size is zero,
+  // candidates are found by memchr, that is vectorized.
+  const bool zeroMsb = _maxEntrySize <= defaultMaxEntrySize;
+
+  _begin = std::min(_lastEntry + 1, _end);
+  while (true)
+  {
+    _lastEntry = _begin; // drop the skipped bytes from the buffer
+
+    if (! fill(sizeof(std::uint32_t)))
+    {
+      _begin = _end; // too short to be an entry, skip the rest
+      break;
+    }
+
+    if (zeroMsb)
+    {
+      // The most significant byte of a little endian entry size is 0
+      const char* first = _buffer.data() + _begin + 3;
+      const char* zero = static_cast<const char*>(std::memchr(first, 0, _end - _begin - 3));
+      if (zero == nullptr)
+      {
+        _begin = _end - 3; // keep the last three bytes, they might be part of a size
+        continue;
+      }
+
+      _begin += std::size_t(zero - first);
+    }
+
+    if (plausible(0, true)) { break; }
+
+    // A plausible size has a non-zero byte in its first three (or four) bytes:
+    // skip runs of zeros (e.g: preallocated, unwritten parts of the file) at once.
+    const char* candidate = _buffer.data() + _begin;
+    const char* nonZero = findNonZero(candidate, _buffer.data() + _end);
+    _begin += std::size_t(std::max(std::ptrdiff_t(1), nonZero - candidate - (zeroMsb ? 2 : 3)));
+  }
+
+  _lastEntry = _begin;
+  return SkippedRange{skippedBegin, _bufferOffset + _begin - skippedBegin};
+}
+
+bool ResyncEntryStream::fill(std::size_t size)
+{
+  while (_end - _begin < size)
+  {
+    if (! _input) { return false; }
+
+    // drop consumed bytes, keep the last entry
+    if (_lastEntry != 0)
+    {
+      std::memmove(_buffer.data(), _buffer.data() + _lastEntry, _end - _lastEntry);
+      _bufferOffset += _lastEntry;
+      _begin -= _lastEntry;
+      _end -= _lastEntry;
+      _lastEntry = 0;
+    }
+
+    const std::size_t capacity = std::max(_begin + size, _end + g_readSize);
+    if (_buffer.size() < capacity)
+    {
+      _buffer.resize(capacity);
+    }
+
+    _input.read(_buffer.data() + _end, std::streamsize(_buffer.size() - _end));
+    _end += std::size_t(_input.gcount());
+  }
+
+  return true;
+}
+
+bool ResyncEntryStream::plausible(std::size_t offset, bool chain, bool afterEventSource)
+{
+  const std::size_t headerSize = sizeof(std::uint32_t) + sizeof(std::uint64_t);
+  if (! fill(offset + headerSize)) { return false; }
+
+  const char* entry = _buffer.data() + _begin + offset;
+  const std::uint32_t size = load<std::uint32_t>(entry);
+  if (size < sizeof(std::uint64_t) || size > _maxEntrySize) { return false; }
+
+  const std::uint64_t tag = load<std::uint64_t>(entry + sizeof(size));
+  const bool special = (tag & (std::uint64_t(1) << 63)) != 0;
+  if (special)
+  {
+    if (tag != binlog::EventSource::Tag && tag != binlog::WriterProp::Tag && tag != binlog::ClockSync::Tag)
+    {
+      return false;
+    }
+  }
+  else
+  {
+    // an event source is usually followed by an event of that source
+    const bool knownSource = afterEventSource || _eventStream.hasEventSource(tag);
+    if (size < 2 * sizeof(std::uint64_t) || ! knownSource) { return false; }
+  }
+
+  if (! chain) { return true; }
+
+  const std::size_t next = offset + sizeof(size) + size;
+  if (! fill(next)) { return false; } // truncated
+  if (! fill(next + 1)) { return true; } // last entry of the input
+  return plausible(next, false, tag == binlog::EventSource::Tag);
+}
@@ -0,0 +1,95 @@
+#ifndef BINLOG_BIN_RESYNC_HPP
+#define BINLOG_BIN_RESYNC_HPP
+
+#include <binlog/EntryStream.hpp>
+#include <binlog/EventStream.hpp>
+#include <binlog/Range.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+
+/**
+ * Entry stream of a possibly corrupt logfile,
+ * that can skip to the next plausible entry after an error.
+ *
+ * If reading an entry, or processing the returned entry fails
+ * (e.g: EventStream throws because the event has an unknown source id,
+ * or printing the arguments fails), resync() skips the
+ * entry, and the bytes following it, until an entry is found that:
+ *
+ *  - has a size not larger than `maxEntrySize` (16 MiB - 1 by default),
+ *  - is an event of a source known by `eventStream`,
+ *    or an EventSource, WriterProp or ClockSync,
+ *  - is followed by a similarly plausible entry or by the end of the input.
+ *
+ * Events of sources defined in a skipped range cannot be recovered.
+ *
+ * The format allows entries up to 4 GiB - 1, but larger limits make
+ * resync() slower and less selective: sizes below 16 MiB have a zero
+ * most significant byte, that is used to find candidates quickly.
+ */
+class ResyncEntryStream : public binlog::EntryStream
+{
+public:
+  /** Bytes of the input skipped by resync() */
+  struct SkippedRange
+  {
+    std::uint64_t offset; /**< Offset of the first skipped byte in the input */
+    std::uint64_t size;
+  };
+
+  /** Default maximum size of a plausible entry, see the class description */
+  static constexpr std::uint32_t defaultMaxEntrySize = (1u << 24) - 1;
+
+  /**
+   * Stores a reference to `input` and `eventStream`: they
+   * must remain valid as long as *this is valid.
+   * `eventStream` is used to identify known sources.
+   * Entries larger than `maxEntrySize` are considered to be corrupt.
+   */
+  ResyncEntryStream(std::istream& input, const binlog::EventStream& eventStream, std::uint32_t maxEntrySize = defaultMaxEntrySize);
+
+  /**
+   * @see EntryStream::nextEntryPayload
+   *
+   * @throw std::runtime_error if the entry is truncated,
+   *        too small to have a tag, or larger than `maxEntrySize`.
+   */
+  binlog::Range nextEntryPayload() override;
+
+  /** @returns the number of entries rejected by nextEntryPayload for being larger than `maxEntrySize` */
+  std::size_t oversizedEntryCount() const { return _oversizedEntryCount; }
+
+  /**
+   * Skip the entry last returned or failed to return by nextEntryPayload,
+   * and everything after it, until the next plausible entry or the end of the input.
+   *
+   * @returns the skipped range of the input, at least one byte,
+   *          unless the input is consumed.
+   */
+  SkippedRange resync();
+
+private:
+  // Make sure `size` bytes are available after _begin,
+  // @returns false if the input ends before.
+  bool fill(std::size_t size);
+
+  // @returns true if the entry at `offset` (relative to _begin) looks valid.
+  // If `chain` is true, the entry after it must be plausible as well.
+  bool plausible(std::size_t offset, bool chain, bool afterEventSource = false);
+
+  std::istream& _input;
+  const binlog::EventStream& _eventStream;
+  std::uint32_t _maxEntrySize;
+  std::size_t _oversizedEntryCount = 0;
+
+  std::vector<char> _buffer;
+  std::size_t _lastEntry = 0; // entry last returned by nextEntryPayload, kept in _buffer
+  std::size_t _begin = 0;     // next entry
+  std::size_t _end = 0;       // end of valid bytes in _buffer
+  std::uint64_t _bufferOffset = 0; // offset of _buffer[0] in the input
+};
+
+#endif // BINLOG_BIN_RESYNC_HPP
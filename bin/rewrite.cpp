@@ -0,0 +1,221 @@
+#include "rewrite.hpp"
+
+#include <mserialize/serialize.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <ios>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+
+namespace {
+
+// Adapts OstreamBuffer to the mserialize::OutputStream concept
+struct OutputStream
+{
+  binlog::detail::OstreamBuffer& out;
+
+  OutputStream& write(const char* buf, std::streamsize size)
+  {
+    out.write(buf, std::size_t(size));
+    return *this;
+  }
+};
+
+std::string toLower(std::string str)
+{
+  std::transform(str.begin(), str.end(), str.begin(), [](char c) { return char(std::tolower(static_cast<unsigned char>(c))); });
+  return str;
+}
+
+bool endsWith(const std::string& str, const std::string& suffix)
+{
+  return str.size() >= suffix.size() && str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Days since 1970-01-01 of a date in the proleptic Gregorian calendar
+std::int64_t daysFromCivil(std::int64_t y, std::int64_t m, std::int64_t d)
+{
+  y -= (m <= 2) ? 1 : 0;
+  const std::int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const std::int64_t yoe = y - era * 400;
+  const std::int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  const std::int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+} // namespace
+
+bool EventSelector::matches(const binlog::EventSource& source) const
+{
+  return source.severity >= minSeverity
+    && (category.empty() || source.category == category)
+    && (file.empty() || endsWith(source.file, file))
+    && (format.empty() || source.formatString.find(format) != std::string::npos);
+}
+
+bool EventSelector::parseSeverity(const std::string& str, binlog::Severity& result)
+{
+  using binlog::Severity;
+  const std::pair<const char*, Severity> names[] = {
+    {"trace", Severity::trace}, {"trac", Severity::trace},
+    {"debug", Severity::debug}, {"debg", Severity::debug},
+    {"info", Severity::info},
+    {"warning", Severity::warning}, {"warn", Severity::warning},
+    {"error", Severity::error}, {"erro", Severity::error},
+    {"critical", Severity::critical}, {"crit", Severity::critical},
+  };
+
+  const std::string lower = toLower(str);
+  for (const auto& name : names)
+  {
+    if (lower == name.first)
+    {
+      result = name.second;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool EventSelector::parseTime(const std::string& str, std::int64_t& resultNs)
+{
+  if (! str.empty() && std::all_of(str.begin(), str.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)) != 0; }))
+  {
+    try
+    {
+      resultNs = std::stoll(str);
+      return true;
+    }
+    catch (const std::out_of_range&)
+    {
+      return false;
+    }
+  }
+
+  int y = 0, mo = 0, d = 0, h = 0, mi = 0, s = 0;
+  char sep = 0;
+  int consumed = 0;
+  if (std::sscanf(str.data(), "%4d-%2d-%2d%c%2d:%2d:%2d%n", &y, &mo, &d, &sep, &h, &mi, &s, &consumed) != 7 // NOLINT(cert-err34-c)
+      || (sep != ' ' && sep != 'T')
+      || mo < 1 || mo > 12 || d < 1 || d > 31 || h > 23 || mi > 59 || s > 60)
+  {
+    return false;
+  }
+
+  // optional fraction of second, up to nanoseconds
+  std::int64_t fractionNs = 0;
+  std::size_t pos = std::size_t(consumed);
+  if (pos < str.size())
+  {
+    if (str[pos] != '.' || pos + 1 == str.size() || str.size() - pos - 1 > 9) { return false; }
+    std::int64_t scale = 100000000;
+    for (++pos; pos < str.size(); ++pos, scale /= 10)
+    {
+      if (! std::isdigit(static_cast<unsigned char>(str[pos]))) { return false; }
+      fractionNs += (str[pos] - '0') * scale;
+    }
+  }
+
+  const std::int64_t seconds = daysFromCivil(y, mo, d) * 86400 + h * 3600 + mi * 60 + s;
+  resultNs = seconds * 1000000000 + fractionNs;
+  return true;
+}
+
+EventRewriter::EventRewriter(binlog::detail::OstreamBuffer& out, EventSelector selector)
+  :_out(out),
+   _selector(std::move(selector))
+{}
+
+bool EventRewriter::write(
+  std::size_t inputIndex,
+  const binlog::Event& event,
+  const binlog::WriterProp& writer,
+  const binlog::ClockSync& clockSync,
+  std::int64_t timeNs
+)
+{
+  if (! _selector.matches(writer, timeNs)) { return false; }
+
+  const std::uint64_t sourceId = outputSourceId(inputIndex, *event.source);
+  if (sourceId == 0) { return false; }
+
+  if (! _clockSyncWritten)
+  {
+    // event clocks are written as nanoseconds since epoch
+    binlog::ClockSync nsClockSync{0, 1000000000, 0, 0, "UTC"};
+    if (clockSync.clockFrequency != 0)
+    {
+      nsClockSync.tzOffset = clockSync.tzOffset;
+      nsClockSync.tzName = clockSync.tzName;
+    }
+    writeEntry(nsClockSync);
+    _clockSyncWritten = true;
+  }
+
+  if (! _hasWriter || _writerInput != inputIndex || _writer.id != writer.id || _writer.name != writer.name)
+  {
+    _writer.id = writer.id;
+    _writer.name = writer.name;
+    _writer.batchSize = 0; // unknown
+    _writerInput = inputIndex;
+    _hasWriter = true;
+    writeEntry(_writer);
+  }
+
+  binlog::Range arguments = event.arguments;
+  const std::size_t argumentsSize = arguments.size();
+  const std::uint32_t size = std::uint32_t(sizeof(sourceId) + sizeof(std::uint64_t) + argumentsSize);
+  const std::uint64_t clockValue = std::uint64_t(timeNs);
+
+  OutputStream out{_out};
+  mserialize::serialize(size, out);
+  mserialize::serialize(sourceId, out);
+  mserialize::serialize(clockValue, out);
+  _out.write(arguments.view(argumentsSize), argumentsSize);
+
+  ++_eventCount;
+  return true;
+}
+
+std::uint64_t EventRewriter::outputSourceId(std::size_t inputIndex, const binlog::EventSource& source)
+{
+  if (inputIndex >= _sourceIds.size())
+  {
+    _sourceIds.resize(inputIndex + 1);
+  }
+
+  const auto sourceTie = std::tie(source.severity, source.category, source.function, source.file, source.line, source.formatString, source.argumentTags);
+
+  std::unordered_map<std::uint64_t, InputSource>& ids = _sourceIds[inputIndex];
+  const auto it = ids.find(source.id);
+  if (it != ids.end() && it->second.key == sourceTie) { return it->second.outputId; }
+
+  SourceKey key(sourceTie);
+  std::uint64_t id = 0;
+  if (_selector.matches(source))
+  {
+    const auto inserted = _sources.emplace(key, _nextSourceId);
+    id = inserted.first->second;
+    if (inserted.second)
+    {
+      ++_nextSourceId;
+      binlog::EventSource renumbered = source;
+      renumbered.id = id;
+      writeEntry(renumbered);
+    }
+  }
+
+  ids[source.id] = InputSource{std::move(key), id};
+  return id;
+}
+
+template <typename Entry>
+void EventRewriter::writeEntry(const Entry& entry)
+{
+  OutputStream out{_out};
+  binlog::serializeSizePrefixedTagged(entry, out);
+}
@@ -0,0 +1,145 @@
+#ifndef BINLOG_BIN_REWRITE_HPP
+#define BINLOG_BIN_REWRITE_HPP
+
+#include <binlog/Entries.hpp>
+#include <binlog/Severity.hpp>
+
+#include <binlog/detail/OstreamBuffer.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Selects events by their source, writer and time.
+ * Empty strings match everything.
+ */
+struct EventSelector
+{
+  binlog::Severity minSeverity = binlog::Severity::trace;
+  std::string category;     /**< Exact match */
+  std::string file;         /**< Suffix of the source file path */
+  std::string format;       /**< Substring of the format string */
+  std::string writer;       /**< Exact match of the writer name */
+
+  /** Select events in [beginNs, endNs), nanoseconds since epoch */
+  std::int64_t beginNs = std::numeric_limits<std::int64_t>::min();
+  std::int64_t endNs = std::numeric_limits<std::int64_t>::max();
+
+  /** @returns true if events of `source` can be selected */
+  bool matches(const binlog::EventSource& source) const;
+
+  /** @returns true if an event of a matching source is selected */
+  bool matches(const binlog::WriterProp& writerProp, std::int64_t timeNs) const
+  {
+    return beginNs <= timeNs && timeNs < endNs && (writer.empty() || writer == writerProp.name);
+  }
+
+  /**
+   * Parse a severity name, e.g: "warning" or "WARN", case insensitive.
+   *
+   * @returns false if `str` is not a severity
+   */
+  static bool parseSeverity(const std::string& str, binlog::Severity& result);
+
+  /**
+   * Parse a point in time: either nanoseconds since epoch, e.g: "1569939300000000000",
+   * or an UTC date and time, e.g: "2019-10-01 14:15:00", "2019-10-01T14:15:00.123".
+   *
+   * @returns false if `str` is not a time
+   */
+  static bool parseTime(const std::string& str, std::int64_t& resultNs);
+};
+
+/**
+ * Writes events of one or more binlog streams to a single binary stream,
+ * without converting them to text.
+ *
+ * Event sources are deduplicated: sources of different inputs
+ * with identical properties (severity, category, function, file,
+ * line, format string and argument tags) get the same id,
+ * others get different ids, assigned in the order of first use.
+ * Only sources of written events are written.
+ *
+ * Event clocks are replaced by nanoseconds since epoch,
+ * a single clock sync is written before the first event,
+ * with the time zone of the first input that has a clock sync.
+ *
+ * Usage:
+ *
+ *    EventRewriter rewriter(output);
+ *    while (const binlog::Event* event = merged.nextEvent())
+ *    {
+ *      rewriter.write(merged.inputIndex(), *event, merged.writerProp(), merged.clockSync(), merged.time());
+ *    }
+ */
+class EventRewriter
+{
+public:
+  /** Write the events to `out`, those selected by `selector` */
+  explicit EventRewriter(binlog::detail::OstreamBuffer& out, EventSelector selector = {});
+
+  /**
+   * Write `event`, read from the input identified by `inputIndex`,
+   * if it is selected.
+   *
+   * Event source ids are scoped to the input, different inputs
+   * may use the same id for different sources.
+   *
+   * @param timeNs nanoseconds since epoch of `event`
+   * @returns true if `event` was written
+   */
+  bool write(
+    std::size_t inputIndex,
+    const binlog::Event& event,
+    const binlog::WriterProp& writer,
+    const binlog::ClockSync& clockSync,
+    std::int64_t timeNs
+  );
+
+  /** @returns the number of events written */
+  std::uint64_t eventCount() const { return _eventCount; }
+
+  /** @returns the number of distinct event sources written */
+  std::size_t sourceCount() const { return _sources.size(); }
+
+private:
+  // id of the written source, 0 if the source is not selected
+  std::uint64_t outputSourceId(std::size_t inputIndex, const binlog::EventSource& source);
+
+  template <typename Entry>
+  void writeEntry(const Entry& entry);
+
+  using SourceKey = std::tuple<binlog::Severity, std::string, std::string, std::string, std::uint64_t, std::string, std::string>;
+
+  binlog::detail::OstreamBuffer& _out;
+  EventSelector _selector;
+
+  // An input may redefine a source id (e.g: concatenated logfiles),
+  // the cached output id is only valid for the same properties
+  struct InputSource
+  {
+    SourceKey key;
+    std::uint64_t outputId;
+  };
+
+  std::vector<std::unordered_map<std::uint64_t, InputSource>> _sourceIds; // per input: input id -> output id
+  std::map<SourceKey, std::uint64_t> _sources; // written sources -> output id
+  std::uint64_t _nextSourceId = 1;
+
+  bool _clockSyncWritten = false;
+
+  // writer of the last written event
+  bool _hasWriter = false;
+  std::size_t _writerInput = 0;
+  binlog::WriterProp _writer;
+
+  std::uint64_t _eventCount = 0;
+};
+
+#endif // BINLOG_BIN_REWRITE_HPP
@@ -0,0 +1,241 @@
+#include "stats.hpp"
+
+#include "eventsource.hpp"
+#include "eventtime.hpp"
+
+#include <binlog/Severity.hpp>
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// size prefix, source id and clock value
+constexpr std::uint64_t g_eventHeaderSize = sizeof(std::uint32_t) + 2 * sizeof(std::uint64_t);
+
+double rate(std::uint64_t count, std::int64_t durationNs)
+{
+  if (durationNs <= 0) { return double(count); }
+  return double(count) * 1e9 / double(durationNs);
+}
+
+void printHeader(std::ostream& out, const char* title)
+{
+  out << std::setw(12) << "Count"
+      << std::setw(14) << "Bytes"
+      << std::setw(12) << "Rate/s"
+      << std::setw(10) << "Peak/s"
+      << "  " << title << '\n';
+}
+
+void printCounter(std::ostream& out, const EventStatistics::Counter& c, std::int64_t durationNs)
+{
+  out << std::setw(12) << c.count
+      << std::setw(14) << c.bytes
+      << std::setw(12) << rate(c.count, durationNs)
+      << std::setw(10) << c.finalPeak()
+      << "  ";
+}
+
+// @returns pointers to the elements of `counters`, ordered by bytes, descending,
+// then by the order of first use
+template <typename Counters>
+std::vector<const typename Counters::value_type*> sortedByBytes(const Counters& counters)
+{
+  using Element = typename Counters::value_type;
+
+  std::vector<const Element*> result;
+  result.reserve(counters.size());
+  for (const Element& c : counters) { result.push_back(&c); }
+
+  std::stable_sort(result.begin(), result.end(), [](const Element* a, const Element* b)
+  {
+    return a->counter.bytes > b->counter.bytes;
+  });
+
+  return result;
+}
+
+// Write the rate of each element of `sorted` (see sortedByBytes), in each interval,
+// ordered by time, then by the order of `sorted`.
+template <typename Element, typename PrintLabel>
+void printIntervals(std::ostream& out, const std::vector<const Element*>& sorted, std::int64_t bucketSeconds, const char* title, PrintLabel printLabel)
+{
+  std::set<std::int64_t> buckets;
+  for (const Element* c : sorted)
+  {
+    for (const auto& bucket : c->counter.buckets) { buckets.insert(bucket.first); }
+  }
+
+  out << std::left << std::setw(21) << "Interval (UTC)" << std::right
+      << std::setw(12) << "Count"
+      << std::setw(12) << "Rate/s"
+      << "  " << title << '\n';
+
+  for (const std::int64_t bucket : buckets)
+  {
+    const std::string label = timeLabel(bucket);
+    for (const Element* c : sorted)
+    {
+      const auto& counts = c->counter.buckets;
+      const auto it = counts.find(bucket);
+      if (it == counts.end()) { continue; }
+
+      out << std::left << std::setw(21) << label << std::right
+          << std::setw(12) << it->second
+          << std::setw(12) << double(it->second) / double(bucketSeconds)
+          << "  ";
+      printLabel(*c);
+    }
+  }
+}
+
+void printSource(std::ostream& out, const binlog::EventSource& s)
+{
+  const auto severity = binlog::severityToString(s.severity);
+  out.write(severity.data(), std::streamsize(severity.size()));
+  out << ' ' << s.category << ' ' << s.file << ':' << s.line << " \"" << s.formatString << "\"\n";
+}
+
+} // namespace
+
+EventStatistics::EventStatistics(std::int64_t bucketSeconds)
+  :_bucketSeconds(bucketSeconds)
+{}
+
+void EventStatistics::Counter::add(std::uint64_t entrySize, std::int64_t second)
+{
+  ++count;
+  bytes += entrySize;
+
+  const std::size_t slot = std::size_t(second & 3);
+  if (seconds[slot] == second)
+  {
+    ++counts[slot];
+  }
+  else if (seconds[slot] < second)
+  {
+    peak = std::max(peak, counts[slot]);
+    seconds[slot] = second;
+    counts[slot] = 1;
+  }
+  // else: too old, not tracked
+}
+
+std::uint64_t EventStatistics::Counter::finalPeak() const
+{
+  return std::max({peak, counts[0], counts[1], counts[2], counts[3]});
+}
+
+void EventStatistics::add(const binlog::Event& event, const binlog::WriterProp& writer, const binlog::ClockSync& clockSync)
+{
+  const std::int64_t ns = eventNs(event, clockSync);
+  const std::int64_t second = floorDiv(ns, 1000000000);
+  const std::int64_t bucket = (_bucketSeconds != 0) ? floorDiv(second, _bucketSeconds) * _bucketSeconds : 0;
+  const std::uint64_t entrySize = g_eventHeaderSize + event.arguments.size();
+
+  if (_empty)
+  {
+    _minNs = _maxNs = ns;
+    _empty = false;
+  }
+  else
+  {
+    _minNs = std::min(_minNs, ns);
+    _maxNs = std::max(_maxNs, ns);
+  }
+
+  const binlog::EventSource& source = *event.source;
+  if (_lastSource == nullptr || _lastSource->source.id != source.id || ! sameDefinition(_lastSource->source, source))
+  {
+    SourceCounter*& counter = _sourceById[source.id];
+    if (counter == nullptr || ! sameDefinition(counter->source, source))
+    {
+      _sources.push_back(SourceCounter{source, {}});
+      counter = &_sources.back();
+    }
+    _lastSource = counter;
+  }
+  _lastSource->counter.add(entrySize, second);
+  if (_bucketSeconds != 0) { ++_lastSource->counter.buckets[bucket]; }
+
+  if (_lastWriter == nullptr || _lastWriter->id != writer.id || _lastWriter->name != writer.name)
+  {
+    WriterCounter*& counter = _writerByKey[std::make_pair(writer.id, writer.name)];
+    if (counter == nullptr)
+    {
+      _writers.push_back(WriterCounter{writer.id, writer.name, {}});
+      counter = &_writers.back();
+    }
+    _lastWriter = counter;
+  }
+  _lastWriter->counter.add(entrySize, second);
+  if (_bucketSeconds != 0) { ++_lastWriter->counter.buckets[bucket]; }
+}
+
+void EventStatistics::print(std::ostream& out) const
+{
+  const std::int64_t duration = durationNs();
+
+  std::uint64_t totalCount = 0;
+  std::uint64_t totalBytes = 0;
+  for (const SourceCounter& c : _sources)
+  {
+    totalCount += c.counter.count;
+    totalBytes += c.counter.bytes;
+  }
+
+  const std::ios_base::fmtflags flags = out.flags();
+  const std::streamsize precision = out.precision();
+  out << std::fixed << std::setprecision(1);
+
+  out << "Events: " << totalCount << ", bytes: " << totalBytes
+      << ", duration: " << double(duration) / 1e9 << " s\n\n";
+
+  const auto sources = sortedByBytes(_sources);
+  const auto writers = sortedByBytes(_writers);
+
+  out << "Sources: " << _sources.size() << '\n';
+  printHeader(out, "Source");
+  for (const SourceCounter* c : sources)
+  {
+    printCounter(out, c->counter, duration);
+    printSource(out, c->source);
+  }
+
+  out << "\nWriters: " << _writers.size() << '\n';
+  printHeader(out, "Writer");
+  for (const WriterCounter* c : writers)
+  {
+    printCounter(out, c->counter, duration);
+    out << c->id << ' ' << c->name << '\n';
+  }
+
+  if (_bucketSeconds != 0)
+  {
+    out << "\nSources per " << _bucketSeconds << " s interval:\n";
+    printIntervals(out, sources, _bucketSeconds, "Source", [&out](const SourceCounter& c)
+    {
+      printSource(out, c.source);
+    });
+
+    out << "\nWriters per " << _bucketSeconds << " s interval:\n";
+    printIntervals(out, writers, _bucketSeconds, "Writer", [&out](const WriterCounter& c)
+    {
+      out << c.id << ' ' << c.name << '\n';
+    });
+  }
+
+  out.flags(flags);
+  out.precision(precision);
+}
+
+std::int64_t EventStatistics::durationNs() const
+{
+  return _maxNs - _minNs;
+}
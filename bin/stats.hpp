@@ -0,0 +1,124 @@
+#ifndef BINLOG_BIN_STATS_HPP
+#define BINLOG_BIN_STATS_HPP
+
+#include <binlog/Entries.hpp>
+
+#include <cstdint>
+#include <deque>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+/**
+ * Event counts, byte volumes and rates,
+ * per event source and per writer.
+ *
+ * Arguments of the events are not visited.
+ *
+ * If a source id is redefined (e.g: concatenated logfiles),
+ * the events of the new definition are counted separately.
+ * Writers are identified by their id and name together
+ * (the id of named writers is often 0).
+ *
+ * The rate is the number of events per second
+ * between the first and last event of the log.
+ * The peak is the largest number of events
+ * within a single second (wall clock, not sliding).
+ * Events that are older than the four most recent seconds
+ * of their source or writer are counted, but do not
+ * contribute to the peak (logs are not strictly ordered).
+ *
+ * If `bucketSeconds` is given, the rate is also reported
+ * over time: per source and per writer, for each interval
+ * of `bucketSeconds` (wall clock, UTC) that has events.
+ *
+ * Usage:
+ *
+ *    EventStatistics stats;
+ *    while (const binlog::Event* event = eventStream.nextEvent(input))
+ *    {
+ *      stats.add(*event, eventStream.writerProp(), eventStream.clockSync());
+ *    }
+ *    stats.print(std::cout);
+ */
+class EventStatistics
+{
+public:
+  struct Counter
+  {
+    std::uint64_t count = 0;
+    std::uint64_t bytes = 0;  /**< Size of the entries, including the size prefix */
+    std::uint64_t peak = 0;   /**< Largest count within a single second */
+
+    // count of the four most recent seconds, indexed by second % 4
+    std::int64_t seconds[4] = {-1, -1, -1, -1};
+    std::uint64_t counts[4] = {};
+
+    // event count by interval start (seconds since epoch), if intervals are tracked
+    std::map<std::int64_t, std::uint64_t> buckets;
+
+    void add(std::uint64_t entrySize, std::int64_t second);
+    std::uint64_t finalPeak() const;
+  };
+
+  struct SourceCounter
+  {
+    binlog::EventSource source;
+    Counter counter;
+  };
+
+  struct WriterCounter
+  {
+    std::uint64_t id;
+    std::string name;
+    Counter counter;
+  };
+
+  /** If `bucketSeconds` is not zero, track the rate in intervals of this size */
+  explicit EventStatistics(std::int64_t bucketSeconds = 0);
+
+  // not copyable, caches pointers to its own elements
+  EventStatistics(const EventStatistics&) = delete;
+  void operator=(const EventStatistics&) = delete;
+
+  /** Account `event`, written by `writer`, timestamped by `clockSync` */
+  void add(const binlog::Event& event, const binlog::WriterProp& writer, const binlog::ClockSync& clockSync);
+
+  /**
+   * Write a table of sources and a table of writers, ordered by bytes, descending.
+   * If intervals are tracked, the rate of each source and writer
+   * in each interval follows, ordered by time.
+   */
+  void print(std::ostream& out) const;
+
+  /** @returns the counter of each source definition, in the order of first use */
+  const std::deque<SourceCounter>& sources() const { return _sources; }
+
+  /** @returns the counter of each writer, in the order of first use */
+  const std::deque<WriterCounter>& writers() const { return _writers; }
+
+  /** @returns the nanoseconds between the first and last event, 0 if no events */
+  std::int64_t durationNs() const;
+
+private:
+  std::int64_t _bucketSeconds;
+
+  // elements of a deque remain valid after push_back
+  std::deque<SourceCounter> _sources;
+  std::deque<WriterCounter> _writers;
+
+  std::unordered_map<std::uint64_t, SourceCounter*> _sourceById; // the last definition of each id
+  std::map<std::pair<std::uint64_t, std::string>, WriterCounter*> _writerByKey;
+
+  // the previous event likely has the same source and writer
+  SourceCounter* _lastSource = nullptr;
+  WriterCounter* _lastWriter = nullptr;
+
+  std::int64_t _minNs = 0;
+  std::int64_t _maxNs = 0;
+  bool _empty = true;
+};
+
+#endif // BINLOG_BIN_STATS_HPP
@@ -1,7 +1,7 @@
 #include <binlog/binlog.hpp>
 
 //[ostream
-#include <binlog/EventFilter.hpp>
+#include <binlog/Router.hpp>
 #include <binlog/TextOutputStream.hpp> // requires binlog library to be linked
 //]
 
@@ -13,28 +13,29 @@
 
 // Write complete binlog output to `binary`,
 // and also write error and above events to `text` - as text.
+// The consumed entries are parsed only once, by the Router.
 class MultiOutputStream
 {
 public:
   MultiOutputStream(std::ostream& binary, std::ostream& text)
     :_binary(binary),
-     _text(text),
-     _filter([](const binlog::EventSource& source) {
-        return source.severity >= binlog::Severity::error;
-     })
-  {}
+     _text(text)
+  {
+    _router.addSink(_binary);
+    _router.addSink(_text, [](const binlog::EventSource& source) {
+      return source.severity >= binlog::Severity::error;
+    });
+  }
 
   MultiOutputStream& write(const char* buffer, std::streamsize size)
   {
-    _binary.write(buffer, size);
-
     try
     {
-      _filter.writeAllowed(buffer, std::size_t(size), _text);
+      _router.write(buffer, size);
     }
     catch (const std::runtime_error& ex)
     {
-      std::cerr << "Failed to convert buffer to text: " << ex.what() << "\n";
+      std::cerr << "Failed to route buffer: " << ex.what() << "\n";
     }
 
     return *this;
@@ -43,7 +44,7 @@ public:
 private:
   std::ostream& _binary;
   binlog::TextOutputStream _text;
-  binlog::EventFilter _filter;
+  binlog::Router _router;
 };
 //]
 
@@ -0,0 +1,189 @@
+#include <binlog/EmergencyFlush.hpp>
+
+#include <binlog/FlightRecorder.hpp>
+#include <binlog/detail/FdOutputStream.hpp>
+
+#include <atomic>
+
+#ifndef _WIN32
+  #include <cerrno>
+  #include <csignal>
+  #include <ctime> // nanosleep
+#endif
+
+namespace binlog {
+
+std::size_t emergencyFlush(Session& session, int fd) noexcept
+{
+  detail::FdOutputStream out(fd);
+  session.emergencyConsume(out);
+  return out.written;
+}
+
+#ifdef _WIN32
+
+bool installEmergencyFlush(Session&, int)
+{
+  return false;
+}
+
+bool installEmergencyFlush(Session&, FlightRecorder&)
+{
+  return false;
+}
+
+void uninstallEmergencyFlush() {}
+
+#else
+
+namespace {
+
+const int g_fatalSignals[] = {SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT};
+constexpr std::size_t g_fatalSignalCount = sizeof(g_fatalSignals) / sizeof(g_fatalSignals[0]);
+
+std::atomic<Session*> g_session{nullptr};
+std::atomic<int> g_fd{-1};
+std::atomic<FlightRecorder*> g_recorder{nullptr};
+std::atomic<bool> g_flushed{false};   // a thread started flushing
+std::atomic<bool> g_flushDone{false}; // the flushing thread is done
+
+// How long a crashing thread waits for an other one, flushing
+constexpr int g_flushWaitMs = 5000;
+
+struct sigaction g_previousActions[g_fatalSignalCount];
+bool g_installed = false;
+
+void restorePreviousAction(int signo)
+{
+  for (std::size_t i = 0; i < g_fatalSignalCount; ++i)
+  {
+    if (g_fatalSignals[i] == signo)
+    {
+      sigaction(signo, &g_previousActions[i], nullptr);
+      return;
+    }
+  }
+}
+
+// Wait until the thread that won g_flushed is done, so that the default action
+// of the signal does not terminate the process in the middle of the flush.
+// The wait is bounded: the flushing thread might crash again, and
+// get here from a nested handler, waiting for itself.
+void waitForFlush()
+{
+  const struct timespec oneMs{0, 1000000};
+  for (int i = 0; i < g_flushWaitMs && ! g_flushDone.load(); ++i)
+  {
+    nanosleep(&oneMs, nullptr);
+  }
+}
+
+void handleFatalSignal(int signo)
+{
+  const int savedErrno = errno;
+
+  // flush once, even if several threads crash
+  Session* session = g_session.load();
+  if (session != nullptr)
+  {
+    if (! g_flushed.exchange(true))
+    {
+      // recorded (consumed) entries first, then the unconsumed ones
+      FlightRecorder* recorder = g_recorder.load();
+      if (recorder != nullptr) { recorder->emergencyDump(); }
+
+      emergencyFlush(*session, g_fd.load());
+      g_flushDone = true;
+    }
+    else
+    {
+      waitForFlush();
+    }
+  }
+
+  // Let the previous handler (or the default action) handle the signal.
+  // The signal is blocked while this handler runs: it is delivered
+  // again after return. If the signal was caused by a fault,
+  // returning executes the faulting instruction again.
+  restorePreviousAction(signo);
+  raise(signo);
+
+  errno = savedErrno; // if the signal is ignored, the interrupted code continues
+}
+
+bool installHandlers()
+{
+  if (g_installed) { return true; }
+
+  struct sigaction action{};
+  action.sa_handler = handleFatalSignal; // NOLINT(cppcoreguidelines-pro-type-union-access)
+  action.sa_flags = SA_ONSTACK;
+  sigemptyset(&action.sa_mask);
+
+  for (std::size_t i = 0; i < g_fatalSignalCount; ++i)
+  {
+    if (sigaction(g_fatalSignals[i], &action, &g_previousActions[i]) != 0)
+    {
+      // roll back the handlers already installed
+      for (std::size_t j = 0; j < i; ++j)
+      {
+        sigaction(g_fatalSignals[j], &g_previousActions[j], nullptr);
+      }
+      return false;
+    }
+  }
+
+  g_installed = true;
+  return true;
+}
+
+} // namespace
+
+bool installEmergencyFlush(Session& session, int fd)
+{
+  g_session = &session;
+  g_fd = fd;
+  g_recorder = nullptr;
+  g_flushed = false;
+  g_flushDone = false;
+
+  if (installHandlers()) { return true; }
+
+  g_session = nullptr;
+  return false;
+}
+
+bool installEmergencyFlush(Session& session, FlightRecorder& recorder)
+{
+  g_session = &session;
+  g_fd = recorder.fd();
+  g_recorder = &recorder;
+  g_flushed = false;
+  g_flushDone = false;
+
+  if (installHandlers()) { return true; }
+
+  g_session = nullptr;
+  g_recorder = nullptr;
+  return false;
+}
+
+void uninstallEmergencyFlush()
+{
+  if (g_installed)
+  {
+    for (std::size_t i = 0; i < g_fatalSignalCount; ++i)
+    {
+      sigaction(g_fatalSignals[i], &g_previousActions[i], nullptr);
+    }
+    g_installed = false;
+  }
+
+  g_session = nullptr;
+  g_fd = -1;
+  g_recorder = nullptr;
+}
+
+#endif // _WIN32
+
+} // namespace binlog
@@ -0,0 +1,61 @@
+#ifndef BINLOG_EMERGENCY_FLUSH_HPP
+#define BINLOG_EMERGENCY_FLUSH_HPP
+
+#include <binlog/Session.hpp>
+
+#include <cstddef>
+
+namespace binlog {
+
+class FlightRecorder;
+
+/**
+ * Write the metadata and the unconsumed data of `session`
+ * to the file descriptor `fd`, see Session::emergencyConsume.
+ *
+ * Async-signal-safe (best effort, see Session::emergencyConsume):
+ * does not allocate, writes `fd` using write(2),
+ * retries interrupted and partial writes.
+ *
+ * @returns the number of bytes written
+ */
+std::size_t emergencyFlush(Session& session, int fd) noexcept;
+
+/**
+ * Install a handler of fatal signals (SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT),
+ * that calls emergencyFlush(session, fd), then restores the previously
+ * installed handler, and raises the signal again.
+ * This makes the last events available, even if they are not yet
+ * consumed when the application crashes. The output is a
+ * self contained binary logfile:
+ *
+ *    const int fd = open("crash.blog", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+ *    binlog::installEmergencyFlush(binlog::default_session(), fd);
+ *
+ * The file must be opened in advance, as opening a file is not
+ * safe in every crash scenario. It remains empty if no fatal signal is received.
+ * To handle stack overflows, an alternate signal stack (see sigaltstack)
+ * must be set up by the application, the handler is installed with SA_ONSTACK.
+ *
+ * Only one session and file can be registered, a second call replaces the first.
+ * `session` must remain valid until uninstallEmergencyFlush is called.
+ *
+ * @returns false if the handlers cannot be installed, or the platform is not supported.
+ */
+bool installEmergencyFlush(Session& session, int fd);
+
+/**
+ * Install a handler of fatal signals, like installEmergencyFlush(Session&, int),
+ * that dumps the entries recorded by `recorder` (see FlightRecorder::emergencyDump),
+ * then appends the unconsumed data of `session` to the file of `recorder`.
+ *
+ * `session` and `recorder` must remain valid until uninstallEmergencyFlush is called.
+ */
+bool installEmergencyFlush(Session& session, FlightRecorder& recorder);
+
+/** Restore the signal handlers replaced by installEmergencyFlush */
+void uninstallEmergencyFlush();
+
+} // namespace binlog
+
+#endif // BINLOG_EMERGENCY_FLUSH_HPP
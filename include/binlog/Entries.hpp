@@ -107,6 +107,8 @@ struct ClockSync
   std::string tzName;                /**< Time zone name */
 };
 
+class MessageTemplate;
+
 /**
  * Represents a log event (one line in a logfile).
  *
@@ -116,12 +118,16 @@ struct ClockSync
  * `clockValue` marks the time when the event was created.
  * It can be interpreted together with a ClockSync.
  * `clockValue` is zero if the event is not timestamped.
+ *
+ * `messageTemplate`, if not null, is the compiled format string
+ * and argument tags of `source`.
  */
 struct Event
 {
   const EventSource* source = nullptr;
   std::uint64_t clockValue = {};
   Range arguments;
+  const MessageTemplate* messageTemplate = nullptr;
 };
 
 /**
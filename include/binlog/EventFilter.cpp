@@ -0,0 +1,15 @@
+#include <binlog/EventFilter.hpp>
+
+#include <regex>
+
+namespace binlog {
+
+EventFilter::Predicate EventFilter::formatMatches(const std::string& pattern)
+{
+  return [re = std::regex(pattern)](const EventSource& source)
+  {
+    return std::regex_search(source.formatString, re);
+  };
+}
+
+} // namespace binlog
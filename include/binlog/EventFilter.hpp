@@ -3,31 +3,55 @@
 
 #include <binlog/Entries.hpp> // EventSource
 #include <binlog/Range.hpp>
+#include <binlog/Severity.hpp>
+#include <binlog/detail/SourceIdMap.hpp>
 
 #include <mserialize/deserialize.hpp>
 
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <initializer_list>
 #include <ios> // streamsize
-#include <set>
 #include <stdexcept> // runtime_error
+#include <string>
 #include <utility> // move
+#include <vector>
 
 namespace binlog {
 
 /**
  * From a stream of entries, pass through events produced by
- * event sources selected by a user specified predicate.
+ * event sources selected by a user specified predicate,
+ * and optionally, by writers selected by a second predicate.
+ *
+ * Predicates are evaluated once per EventSource and WriterProp entry,
+ * not per event. Common predicates are provided as static members,
+ * and can be combined:
+ *
+ *    binlog::EventFilter filter(binlog::EventFilter::allOf({
+ *      binlog::EventFilter::severityAtLeast(binlog::Severity::warning),
+ *      binlog::EventFilter::categoryIs("orders"),
+ *    }));
  */
 class EventFilter
 {
 public:
   using Predicate = std::function<bool(const EventSource&)>;
+  using WriterPredicate = std::function<bool(const WriterProp&)>;
 
   /** @param isAllowed should return true for allowed EventSources */
   explicit EventFilter(Predicate isAllowed);
 
+  /**
+   * @param isAllowed should return true for allowed EventSources
+   * @param isWriterAllowed should return true for allowed writers.
+   *        Events following a WriterProp entry, that is not allowed,
+   *        are not written. Until the first WriterProp entry,
+   *        every writer is allowed.
+   */
+  EventFilter(Predicate isAllowed, WriterPredicate isWriterAllowed);
+
   /**
    * From the sequence of entries in [buffer, buffer+bufferSize),
    * write special entries and events produced allowed EventSources
@@ -37,10 +61,14 @@ public:
    *  - special entries are written to `out` unconditionally
    *  - EventSources are categorized by the Predicate given in the constructor
    *    as either allowed or disallowed sources.
-   *  - Events are written to `out` only if produced by allowed EventSources.
+   *  - WriterProps are categorized by the WriterPredicate, if given.
+   *  - Events are written to `out` only if produced by allowed EventSources,
+   *    and allowed writers.
    *
-   * The predicate is invoked for each EventSource, but not for Events.
-   * Only EventSources are deserialized, other entries are categorized by their tags.
+   * The predicates are invoked for each EventSource and WriterProp, but not for Events.
+   * Only EventSources (and WriterProps, if there is a WriterPredicate)
+   * are deserialized, other entries are categorized by their tags.
+   * Consecutive entries to write are written by a single `out.write` call.
    *
    * @requires OutputStream must model the mserialize::OutputStream concept
    * @throws std::runtime_error if `buffer` contains an invalid entry
@@ -48,59 +76,184 @@ public:
   template <typename OutputStream>
   std::size_t writeAllowed(const char* buffer, std::size_t bufferSize, OutputStream& out);
 
+  /** @returns true if events of the EventSource identified by `id` are allowed */
+  bool isAllowed(std::uint64_t id) const;
+
+  /** @returns a predicate, true for event sources of `severity` or above */
+  static Predicate severityAtLeast(Severity severity);
+
+  /** @returns a predicate, true for event sources of `category` */
+  static Predicate categoryIs(std::string category);
+
+  /** @returns a predicate, true for event sources in files whose path ends with `suffix` */
+  static Predicate fileEndsWith(std::string suffix);
+
+  /**
+   * @returns a predicate, true for event sources whose format string
+   *          contains a match of the ECMAScript regular expression `pattern`
+   * @throws std::regex_error if `pattern` is invalid
+   *
+   * Defined in EventFilter.cpp, requires linking the binlog library.
+   */
+  static Predicate formatMatches(const std::string& pattern);
+
+  /** @returns a predicate, true if every one of `predicates` is true */
+  static Predicate allOf(std::initializer_list<Predicate> predicates);
+
+  /** @returns a predicate, true if any of `predicates` is true */
+  static Predicate anyOf(std::initializer_list<Predicate> predicates);
+
+  /** @returns a writer predicate, true for writers named `name` */
+  static WriterPredicate writerNameIs(std::string name);
+
 private:
+  void setAllowed(std::uint64_t id, bool allowed);
+
   Predicate _isAllowed;
-  std::set<std::uint64_t> _allowedSourceIds; // TODO(benedek) perf: use a more efficient set
+  WriterPredicate _isWriterAllowed;
+  bool _writerAllowed = true;
+
+  detail::SourceIdMap<bool> _allowedIds;
 };
 
 inline EventFilter::EventFilter(Predicate isAllowed)
   :_isAllowed(std::move(isAllowed))
 {}
 
+inline EventFilter::EventFilter(Predicate isAllowed, WriterPredicate isWriterAllowed)
+  :_isAllowed(std::move(isAllowed)),
+   _isWriterAllowed(std::move(isWriterAllowed))
+{}
+
 template <typename OutputStream>
 std::size_t EventFilter::writeAllowed(const char* buffer, std::size_t bufferSize, OutputStream& out)
 {
-  std::size_t totalWriteSize = 0;
-
   Range entries(buffer, bufferSize);
 
-  while (! entries.empty())
+  // entries in [runBegin, runEnd) are to be written, but not yet written
+  const char* runBegin = buffer;
+  const char* runEnd = buffer;
+  std::size_t totalWriteSize = 0;
+
+  const auto flushRun = [&]()
   {
-    Range entry = entries;
-    const std::uint32_t size = entries.read<std::uint32_t>();
-    Range payload(entries.view(size), size);
-    const std::uint64_t tag = payload.read<std::uint64_t>();
-    const bool special = (tag & (std::uint64_t(1) << 63)) != 0;
+    const std::size_t runSize = std::size_t(runEnd - runBegin);
+    if (runSize != 0)
+    {
+      const char* run = runBegin;
+      runBegin = runEnd; // do not write again, even if out.write throws
+      out.write(run, std::streamsize(runSize));
+      totalWriteSize += runSize;
+    }
+  };
 
-    if (special)
+  try
+  {
+    while (! entries.empty())
     {
-      // event sources are inspected to populate _allowedSourceIds
-      if (tag == EventSource::Tag)
+      const std::uint32_t size = entries.read<std::uint32_t>();
+      Range payload(entries.view(size), size);
+      const char* entryEnd = runEnd + sizeof(size) + size; // runEnd is the beginning of this entry
+      const std::uint64_t tag = payload.read<std::uint64_t>();
+      const bool special = (tag & (std::uint64_t(1) << 63)) != 0;
+
+      if (special)
       {
-        EventSource eventSource;
-        mserialize::deserialize(eventSource, payload);
-        if (_isAllowed(eventSource))
+        // event sources are inspected to populate the set of allowed ids
+        if (tag == EventSource::Tag)
+        {
+          EventSource eventSource;
+          mserialize::deserialize(eventSource, payload);
+          setAllowed(eventSource.id, _isAllowed(eventSource));
+          // if not allowed, events referencing it will not be written.
+        }
+        else if (tag == WriterProp::Tag && _isWriterAllowed)
         {
-          _allowedSourceIds.insert(eventSource.id);
+          WriterProp writerProp;
+          mserialize::deserialize(writerProp, payload);
+          _writerAllowed = _isWriterAllowed(writerProp);
         }
-        // else: event source is not allowed, events referencing it
-        // will not be written.
       }
+      else if (! _writerAllowed || ! isAllowed(tag))
+      {
+        // event is produced by a disallowed source or writer, ignore it
+        flushRun();
+        runBegin = entryEnd;
+        runEnd = entryEnd;
+        continue;
+      }
+
+      // either special entry or event produced by an allowed source, write it
+      runEnd = entryEnd;
     }
-    else if (_allowedSourceIds.count(tag) == 0)
+  }
+  catch (...)
+  {
+    // write the valid entries before the invalid one
+    flushRun();
+    throw;
+  }
+
+  flushRun();
+  return totalWriteSize;
+}
+
+inline bool EventFilter::isAllowed(std::uint64_t id) const
+{
+  return _allowedIds.get(id);
+}
+
+inline void EventFilter::setAllowed(std::uint64_t id, bool allowed)
+{
+  _allowedIds.set(id, allowed);
+}
+
+inline EventFilter::Predicate EventFilter::severityAtLeast(Severity severity)
+{
+  return [severity](const EventSource& source) { return source.severity >= severity; };
+}
+
+inline EventFilter::Predicate EventFilter::categoryIs(std::string category)
+{
+  return [category](const EventSource& source) { return source.category == category; };
+}
+
+inline EventFilter::Predicate EventFilter::fileEndsWith(std::string suffix)
+{
+  return [suffix](const EventSource& source)
+  {
+    return source.file.size() >= suffix.size()
+      && source.file.compare(source.file.size() - suffix.size(), suffix.size(), suffix) == 0;
+  };
+}
+
+inline EventFilter::Predicate EventFilter::allOf(std::initializer_list<Predicate> predicates)
+{
+  return [ps = std::vector<Predicate>(predicates)](const EventSource& source)
+  {
+    for (const Predicate& p : ps)
     {
-      // event is produced by a disallowed source, ignore it
-      continue;
+      if (! p(source)) { return false; }
     }
+    return true;
+  };
+}
 
-    // either special entry or event produced by an allowed source, write it
-    // TODO(benedek) perf: batch contiguous entries into one out.write
-    const std::size_t sizePrefixedSize = size + sizeof(size);
-    out.write(entry.view(sizePrefixedSize), std::streamsize(sizePrefixedSize));
-    totalWriteSize += sizePrefixedSize;
-  }
+inline EventFilter::Predicate EventFilter::anyOf(std::initializer_list<Predicate> predicates)
+{
+  return [ps = std::vector<Predicate>(predicates)](const EventSource& source)
+  {
+    for (const Predicate& p : ps)
+    {
+      if (p(source)) { return true; }
+    }
+    return false;
+  };
+}
 
-  return totalWriteSize;
+inline EventFilter::WriterPredicate EventFilter::writerNameIs(std::string name)
+{
+  return [name](const WriterProp& writer) { return writer.name == name; };
 }
 
 } // namespace binlog
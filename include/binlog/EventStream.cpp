@@ -70,7 +70,8 @@ void EventStream::readEvent(std::uint64_t eventSourceId, Range range)
     throw std::runtime_error("Event has invalid source id: " + std::to_string(eventSourceId));
   }
 
-  _event.source = it;
+  _event.source = &it->source;
+  _event.messageTemplate = &it->messageTemplate;
   _event.clockValue = range.read<std::uint64_t>();
   _event.arguments = range;
 }
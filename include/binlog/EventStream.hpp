@@ -3,12 +3,14 @@
 
 #include <binlog/Entries.hpp>
 #include <binlog/EntryStream.hpp>
+#include <binlog/MessageTemplate.hpp>
 #include <binlog/Range.hpp>
 
 #include <binlog/detail/SegmentedMap.hpp>
 
 #include <istream>
 #include <map>
+#include <utility>
 
 namespace binlog {
 
@@ -48,6 +50,15 @@ public:
    */
   const ClockSync& clockSync() const { return _clockSync; }
 
+  /**
+   * @return true if an event source with the given `id`
+   *         was consumed from the stream.
+   */
+  bool hasEventSource(std::uint64_t id) const
+  {
+    return _eventSources.find(id) != _eventSources.end();
+  }
+
 private:
   void readEventSource(Range range);
 
@@ -57,7 +68,19 @@ private:
 
   void readEvent(std::uint64_t eventSourceId, Range range);
 
-  detail::SegmentedMap<EventSource> _eventSources;
+  /** An event source and its compiled message template */
+  struct CompiledEventSource
+  {
+    explicit CompiledEventSource(EventSource source_)
+      :source(std::move(source_)),
+       messageTemplate(source)
+    {}
+
+    EventSource source;
+    MessageTemplate messageTemplate;
+  };
+
+  detail::SegmentedMap<CompiledEventSource> _eventSources;
   WriterProp _writerProp;
   ClockSync _clockSync;
   Event _event;
@@ -0,0 +1,204 @@
+#include <binlog/FlightRecorder.hpp>
+
+#include <binlog/Entries.hpp>
+#include <binlog/detail/FdOutputStream.hpp>
+
+#include <mserialize/deserialize.hpp>
+
+#include <algorithm> // min
+#include <cstring>
+#include <stdexcept>
+#include <utility> // move
+
+#ifdef _WIN32
+  #include <fcntl.h>
+  #include <io.h> // _open, _close
+  #include <sys/stat.h>
+#else // assume POSIX
+  #include <fcntl.h> // open
+  #include <unistd.h> // close
+#endif
+
+namespace binlog {
+
+FlightRecorder::FlightRecorder(std::size_t capacity, std::string path, Severity triggerSeverity)
+  :_path(std::move(path)),
+   _triggerSeverity(triggerSeverity),
+   _ring(capacity)
+{
+#ifdef _WIN32
+  _fd = _open(_path.data(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+  _fd = open(_path.data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+
+  if (_fd < 0)
+  {
+    throw std::runtime_error("Failed to open flight recorder file: " + _path);
+  }
+}
+
+FlightRecorder::~FlightRecorder()
+{
+#ifdef _WIN32
+  _close(_fd);
+#else
+  close(_fd);
+#endif
+}
+
+FlightRecorder& FlightRecorder::write(const char* buffer, std::streamsize size)
+{
+  Range entries(buffer, std::size_t(size));
+  bool triggered = false;
+
+  try
+  {
+    while (! entries.empty())
+    {
+      const std::uint32_t payloadSize = entries.read<std::uint32_t>();
+      const char* payloadBegin = entries.view(payloadSize);
+      const char* entry = payloadBegin - sizeof(payloadSize);
+      const std::size_t entrySize = sizeof(payloadSize) + payloadSize;
+
+      Range payload(payloadBegin, payloadSize);
+      const std::uint64_t tag = payload.read<std::uint64_t>();
+      const bool special = (tag & (std::uint64_t(1) << 63)) != 0;
+
+      if (! special)
+      {
+        record(entry, entrySize, false);
+        triggered = triggered || isTrigger(tag);
+      }
+      else if (tag == EventSource::Tag)
+      {
+        addEventSource(payload, entry, entrySize);
+      }
+      else
+      {
+        if (tag == WriterProp::Tag) { _latestWriterProp.assign(entry, entry + entrySize); }
+        else if (tag == ClockSync::Tag) { _latestClockSync.assign(entry, entry + entrySize); }
+
+        record(entry, entrySize, true);
+      }
+    }
+  }
+  catch (...)
+  {
+    if (triggered) { dump(); }
+    throw;
+  }
+
+  if (triggered) { dump(); }
+  return *this;
+}
+
+void FlightRecorder::dump()
+{
+  const std::size_t expected = (_sources.size() - _sourcesDumpPos)
+    + _headClockSync.size() + _headWriterProp.size() + _size;
+
+  if (emergencyDump() != expected)
+  {
+    throw std::runtime_error("Failed to write flight recorder file: " + _path);
+  }
+
+  clear();
+}
+
+std::size_t FlightRecorder::emergencyDump() noexcept
+{
+  detail::FdOutputStream out(_fd);
+
+  out.write(_sources.data() + _sourcesDumpPos, std::streamsize(_sources.size() - _sourcesDumpPos));
+  if (! out.failed) { _sourcesDumpPos = _sources.size(); }
+
+  out.write(_headClockSync.data(), std::streamsize(_headClockSync.size()));
+  out.write(_headWriterProp.data(), std::streamsize(_headWriterProp.size()));
+
+  const std::size_t size1 = std::min(_size, _ring.size() - _begin);
+  out.write(_ring.data() + _begin, std::streamsize(size1));
+  out.write(_ring.data(), std::streamsize(_size - size1));
+
+  return out.written;
+}
+
+void FlightRecorder::addEventSource(Range payload, const char* entry, std::size_t entrySize)
+{
+  EventSource eventSource;
+  mserialize::deserialize(eventSource, payload);
+
+  _sources.insert(_sources.end(), entry, entry + entrySize);
+
+  // a redefined source id might be no longer a trigger
+  _triggers.set(eventSource.id, eventSource.severity >= _triggerSeverity);
+}
+
+bool FlightRecorder::isTrigger(std::uint64_t sourceId) const
+{
+  return _triggers.get(sourceId);
+}
+
+void FlightRecorder::record(const char* entry, std::size_t entrySize, bool special)
+{
+  if (entrySize > _ring.size())
+  {
+    // An event that does not fit is dropped.
+    // A special entry that does not fit affects every later entry:
+    // drop the ring, the entry is kept as the new head state.
+    if (special) { clear(); }
+    return;
+  }
+
+  while (_ring.size() - _size < entrySize)
+  {
+    evictOldest();
+  }
+
+  const std::size_t end = (_begin + _size) % _ring.size();
+  const std::size_t size1 = std::min(entrySize, _ring.size() - end);
+  memcpy(_ring.data() + end, entry, size1);
+  memcpy(_ring.data(), entry + size1, entrySize - size1);
+  _size += entrySize;
+}
+
+void FlightRecorder::evictOldest()
+{
+  std::uint32_t payloadSize = 0;
+  ringRead(_begin, reinterpret_cast<char*>(&payloadSize), sizeof(payloadSize));
+  const std::size_t entrySize = sizeof(payloadSize) + payloadSize;
+
+  std::uint64_t tag = 0;
+  ringRead((_begin + sizeof(payloadSize)) % _ring.size(), reinterpret_cast<char*>(&tag), sizeof(tag));
+
+  // keep the state the remaining entries depend on
+  std::vector<char>* head = nullptr;
+  if (tag == WriterProp::Tag) { head = &_headWriterProp; }
+  else if (tag == ClockSync::Tag) { head = &_headClockSync; }
+
+  if (head != nullptr)
+  {
+    head->resize(entrySize);
+    ringRead(_begin, head->data(), entrySize);
+  }
+
+  _begin = (_begin + entrySize) % _ring.size();
+  _size -= entrySize;
+}
+
+void FlightRecorder::clear()
+{
+  _begin = 0;
+  _size = 0;
+  _headWriterProp = _latestWriterProp;
+  _headClockSync = _latestClockSync;
+}
+
+void FlightRecorder::ringRead(std::size_t pos, char* dst, std::size_t size) const
+{
+  const std::size_t size1 = std::min(size, _ring.size() - pos);
+  memcpy(dst, _ring.data() + pos, size1);
+  memcpy(dst + size1, _ring.data(), size - size1);
+}
+
+} // namespace binlog
@@ -0,0 +1,146 @@
+#ifndef BINLOG_FLIGHT_RECORDER_HPP
+#define BINLOG_FLIGHT_RECORDER_HPP
+
+#include <binlog/Range.hpp>
+#include <binlog/Severity.hpp>
+#include <binlog/detail/SourceIdMap.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <ios> // streamsize
+#include <string>
+#include <vector>
+
+namespace binlog {
+
+/**
+ * Keeps the most recent entries of a binlog stream in memory,
+ * writes them to a file only when triggered.
+ *
+ * Events are kept in a bounded ring buffer. If the ring is full,
+ * the oldest entries are evicted to make room for the new ones.
+ * EventSources are kept outside of the ring, and never evicted,
+ * the WriterProp and ClockSync in effect at the oldest entry are
+ * also kept: the dump is always self contained, readable by bread.
+ *
+ * The ring is dumped (appended to the file, and cleared) if:
+ *
+ *  - an event of a source with severity >= `triggerSeverity` is written
+ *    (after the whole buffer containing it is recorded)
+ *  - `dump` is called
+ *  - a fatal signal is received, see installEmergencyFlush
+ *
+ * This allows verbose (e.g: debug or trace) logging, without
+ * the cost of writing every event to disk: only the events
+ * preceding a failure are written.
+ *
+ * Models the mserialize::OutputStream concept, usage:
+ *
+ *    binlog::FlightRecorder recorder(16 << 20, "incidents.blog");
+ *    session.consume(recorder);
+ *
+ * Not thread-safe: `write` and `dump` must not be called concurrently.
+ */
+class FlightRecorder
+{
+public:
+  /**
+   * Create a recorder keeping at most `capacity` bytes of entries,
+   * that will dump to the file at `path`, truncated by the constructor.
+   *
+   * The file is opened by the constructor, to make dumping
+   * possible in a signal handler.
+   *
+   * @param triggerSeverity events of this or higher severity trigger a dump.
+   *        If Severity::no_logs, dumps are triggered only explicitly.
+   * @throws std::runtime_error if the file cannot be opened
+   */
+  FlightRecorder(std::size_t capacity, std::string path, Severity triggerSeverity = Severity::error);
+
+  ~FlightRecorder();
+
+  FlightRecorder(const FlightRecorder&) = delete;
+  void operator=(const FlightRecorder&) = delete;
+
+  /**
+   * Record the binlog entries in [buffer, buffer+size).
+   *
+   * The entries in the buffer must be complete,
+   * no partial entry is allowed.
+   * Entries larger than the capacity are not recorded.
+   *
+   * @throws std::runtime_error on invalid input, or if a triggered dump fails.
+   *         The entries before the invalid entry are recorded.
+   */
+  FlightRecorder& write(const char* buffer, std::streamsize size);
+
+  /**
+   * Append the recorded entries to the file, and clear the ring.
+   * EventSources already dumped are not written again.
+   *
+   * To include the events not yet consumed from a session,
+   * call session.consume(recorder) first.
+   *
+   * @throws std::runtime_error if writing the file fails
+   */
+  void dump();
+
+  /**
+   * Append the recorded entries to the file, without clearing the ring.
+   *
+   * Does not allocate memory, and writes the file by write(2):
+   * can be called from a signal handler, if the recorder is not
+   * being modified concurrently.
+   *
+   * @returns the number of bytes written
+   */
+  std::size_t emergencyDump() noexcept;
+
+  /** @returns the maximum number of bytes recorded */
+  std::size_t capacity() const { return _ring.size(); }
+
+  /** @returns the number of bytes of the entries in the ring */
+  std::size_t size() const { return _size; }
+
+  /** @returns the path of the file the entries are dumped to */
+  const std::string& path() const { return _path; }
+
+  /** @returns the file descriptor the entries are dumped to */
+  int fd() const { return _fd; }
+
+private:
+  void addEventSource(Range payload, const char* entry, std::size_t entrySize);
+
+  bool isTrigger(std::uint64_t sourceId) const;
+
+  void record(const char* entry, std::size_t entrySize, bool special);
+
+  void evictOldest();
+
+  void clear();
+
+  void ringRead(std::size_t pos, char* dst, std::size_t size) const;
+
+  std::string _path;
+  int _fd = -1;
+  Severity _triggerSeverity;
+
+  // entries are in [_begin, _begin + _size), modulo capacity
+  std::vector<char> _ring;
+  std::size_t _begin = 0;
+  std::size_t _size = 0;
+
+  std::vector<char> _sources;       // every EventSource entry
+  std::size_t _sourcesDumpPos = 0;  // _sources before this are already in the file
+
+  std::vector<char> _headWriterProp;   // in effect at the oldest entry of the ring
+  std::vector<char> _headClockSync;    // in effect at the oldest entry of the ring
+  std::vector<char> _latestWriterProp; // in effect after the newest entry of the ring
+  std::vector<char> _latestClockSync;  // in effect after the newest entry of the ring
+
+  detail::SourceIdMap<bool> _triggers; // true for sources of trigger severity
+};
+
+} // namespace binlog
+
+#endif // BINLOG_FLIGHT_RECORDER_HPP
@@ -0,0 +1,89 @@
+#include <binlog/MergedEventStream.hpp>
+
+#include <binlog/Time.hpp>
+
+#include <algorithm> // push_heap, pop_heap
+#include <cassert>
+
+namespace binlog {
+
+std::size_t MergedEventStream::addInput(EntryStream& input)
+{
+  _inputs.push_back(std::unique_ptr<Input>(new Input(input)));
+  return _inputs.size() - 1;
+}
+
+const Event* MergedEventStream::nextEvent()
+{
+  // read the first event of each input not yet read.
+  // If advance throws, the invalid entry is dropped,
+  // and the same input is read again by the next call.
+  while (_next != _inputs.size())
+  {
+    advance(_next);
+    ++_next;
+  }
+
+  // replace the previously returned event with the next one of the same input
+  if (_advanceCurrent)
+  {
+    advance(_current);
+    _advanceCurrent = false;
+  }
+
+  if (_heap.empty()) { return nullptr; }
+
+  const auto cmp = [this](std::size_t a, std::size_t b) { return later(a, b); };
+  std::pop_heap(_heap.begin(), _heap.end(), cmp);
+  _current = _heap.back();
+  _heap.pop_back();
+  _advanceCurrent = true;
+
+  return _inputs[_current]->event;
+}
+
+const WriterProp& MergedEventStream::writerProp() const
+{
+  assert(_current < _inputs.size());
+  return _inputs[_current]->eventStream.writerProp();
+}
+
+const ClockSync& MergedEventStream::clockSync() const
+{
+  assert(_current < _inputs.size());
+  return _inputs[_current]->eventStream.clockSync();
+}
+
+std::int64_t MergedEventStream::time() const
+{
+  assert(_current < _inputs.size());
+  return _inputs[_current]->time;
+}
+
+void MergedEventStream::advance(std::size_t index)
+{
+  Input& input = *_inputs[index];
+
+  input.event = nullptr; // stays null if nextEvent throws
+  const Event* event = input.eventStream.nextEvent(*input.entryStream);
+  if (event == nullptr) { return; } // input is exhausted
+
+  const ClockSync& clockSync = input.eventStream.clockSync();
+  input.event = event;
+  input.time = (std::int64_t(clockSync.clockFrequency) > 0)
+    ? clockToNsSinceEpoch(clockSync, event->clockValue).count()
+    : std::int64_t(event->clockValue);
+
+  const auto cmp = [this](std::size_t a, std::size_t b) { return later(a, b); };
+  _heap.push_back(index);
+  std::push_heap(_heap.begin(), _heap.end(), cmp);
+}
+
+bool MergedEventStream::later(std::size_t a, std::size_t b) const
+{
+  const std::int64_t ta = _inputs[a]->time;
+  const std::int64_t tb = _inputs[b]->time;
+  return (ta == tb) ? a > b : ta > tb;
+}
+
+} // namespace binlog
@@ -0,0 +1,115 @@
+#ifndef BINLOG_MERGED_EVENT_STREAM_HPP
+#define BINLOG_MERGED_EVENT_STREAM_HPP
+
+#include <binlog/Entries.hpp>
+#include <binlog/EntryStream.hpp>
+#include <binlog/EventStream.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace binlog {
+
+/**
+ * Convert several binlog streams to a single stream of events,
+ * ordered by wall clock time.
+ *
+ * Each input has its own EventStream, i.e: its own set
+ * of event sources, writer properties and clock sync.
+ * Event clocks are converted to nanoseconds since epoch
+ * using the clock sync of the input they were read from,
+ * and the event with the earliest time is returned first.
+ * Events of inputs without a clock sync (clockFrequency is not positive)
+ * are ordered by their raw clock value. Events with equal time
+ * are ordered by input index, then by input order.
+ *
+ * Inputs are read lazily, at most one event is buffered per input,
+ * therefore the merge is done in a streaming fashion:
+ * if every input is ordered by time, the result is also ordered by time.
+ *
+ * Usage:
+ *
+ *    binlog::MergedEventStream merged;
+ *    merged.addInput(entryStream1);
+ *    merged.addInput(entryStream2);
+ *    while (const binlog::Event* event = merged.nextEvent())
+ *    {
+ *      printer.printEvent(out, *event, merged.writerProp(), merged.clockSync());
+ *    }
+ */
+class MergedEventStream
+{
+public:
+  /**
+   * Add `input` to the set of merged streams.
+   *
+   * Stores a reference to `input`: it must remain valid
+   * as long as *this is valid. Must not be called after `nextEvent`.
+   *
+   * @returns the index of the added input, see inputIndex()
+   */
+  std::size_t addInput(EntryStream& input);
+
+  /** @returns the number of inputs added */
+  std::size_t inputCount() const { return _inputs.size(); }
+
+  /**
+   * Get the earliest event of the inputs.
+   *
+   * The returned pointer (and the objects reachable from it)
+   * is valid until the next call to `nextEvent` and
+   * as long as `*this` and the inputs are valid.
+   *
+   * If an input entry is invalid, it is dropped,
+   * and an exception is thrown. The merge can be continued
+   * by calling `nextEvent` again.
+   *
+   * @returns pointer to the next event
+   *          or nullptr if every input is exhausted
+   * @throws std::runtime_error on error.
+   */
+  const Event* nextEvent();
+
+  /** @returns the index of the input the last event was read from */
+  std::size_t inputIndex() const { return _current; }
+
+  /** @returns writer properties of the last event, see EventStream::writerProp */
+  const WriterProp& writerProp() const;
+
+  /** @returns clock sync of the last event, see EventStream::clockSync */
+  const ClockSync& clockSync() const;
+
+  /**
+   * @returns nanoseconds since epoch of the last event,
+   *          or its raw clock value, if the input has no clock sync.
+   */
+  std::int64_t time() const;
+
+private:
+  struct Input
+  {
+    explicit Input(EntryStream& entryStream_) :entryStream(&entryStream_) {}
+
+    EntryStream* entryStream;
+    EventStream eventStream;
+    const Event* event = nullptr;
+    std::int64_t time = 0;
+  };
+
+  /** Read the next event of _inputs[index], add it to the heap if found */
+  void advance(std::size_t index);
+
+  bool later(std::size_t a, std::size_t b) const;
+
+  std::vector<std::unique_ptr<Input>> _inputs;
+  std::vector<std::size_t> _heap; // indices of _inputs with a pending event
+  std::size_t _next = 0;          // _inputs[_next, end) are not yet read
+  std::size_t _current = 0;       // index of the input of the last returned event
+  bool _advanceCurrent = false;   // true if the input of the last returned event must be read
+};
+
+} // namespace binlog
+
+#endif // BINLOG_MERGED_EVENT_STREAM_HPP
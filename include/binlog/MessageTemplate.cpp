@@ -0,0 +1,49 @@
+#include <binlog/MessageTemplate.hpp>
+
+#include <mserialize/detail/tag_util.hpp>
+
+#include <cassert>
+
+namespace binlog {
+
+MessageTemplate::MessageTemplate(const EventSource& source)
+{
+  mserialize::string_view tags = source.argumentTags;
+  const std::string& fmt = source.formatString;
+
+  std::size_t literalBegin = 0;
+  for (std::size_t i = 0; i < fmt.size(); ++i)
+  {
+    const char c = fmt[i];
+    if (c == '{' && i + 1 != fmt.size() && fmt[i+1] == '}')
+    {
+      const mserialize::string_view tag = mserialize::detail::tag_pop(tags);
+      _segments.push_back(CompiledSegment{literalBegin, _literals.size(), mserialize::VisitProgram(tag), true});
+      literalBegin = _literals.size();
+      ++i; // skip }
+    }
+    else
+    {
+      _literals.push_back(c);
+    }
+  }
+
+  if (literalBegin != _literals.size())
+  {
+    _segments.push_back(CompiledSegment{literalBegin, _literals.size(), mserialize::VisitProgram(), false});
+  }
+}
+
+MessageTemplate::Segment MessageTemplate::segment(std::size_t i) const
+{
+  assert(i < _segments.size());
+  const CompiledSegment& s = _segments[i];
+  return Segment{
+    mserialize::string_view(_literals.data() + s.literalBegin, s.literalEnd - s.literalBegin),
+    s.argument.tag(),
+    s.hasArgument,
+    s.hasArgument ? &s.argument : nullptr
+  };
+}
+
+} // namespace binlog
@@ -0,0 +1,83 @@
+#ifndef BINLOG_MESSAGE_TEMPLATE_HPP
+#define BINLOG_MESSAGE_TEMPLATE_HPP
+
+#include <binlog/Entries.hpp>
+
+#include <mserialize/VisitProgram.hpp>
+#include <mserialize/string_view.hpp>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace binlog {
+
+/**
+ * The format string of an EventSource,
+ * split to literals and argument placeholders.
+ *
+ * Each `{}` in the format string is paired with
+ * the tag of the matching argument, popped from
+ * the argument tags of the source, and compiled
+ * to a mserialize::VisitProgram.
+ * Placeholders without matching tag get an empty tag,
+ * extra argument tags are ignored.
+ *
+ * The template is compiled once per event source,
+ * to make rendering of the message a simple interleaving
+ * of literals and arguments, without scanning the format
+ * string and the argument tags for every event.
+ *
+ * Usage:
+ *
+ *    binlog::MessageTemplate mt(eventSource);
+ *    for (std::size_t i = 0; i < mt.size(); ++i)
+ *    {
+ *      const binlog::MessageTemplate::Segment s = mt.segment(i);
+ *      out.write(s.literal.data(), s.literal.size());
+ *      if (s.hasArgument) { mserialize::visit(*s.argument, visitor, args); }
+ *    }
+ */
+class MessageTemplate
+{
+public:
+  /** A literal, followed by an optional placeholder */
+  struct Segment
+  {
+    mserialize::string_view literal;     /**< Text before the placeholder */
+    mserialize::string_view argumentTag; /**< Tag of the argument, empty if none */
+    bool hasArgument;                    /**< False only for the closing literal */
+    const mserialize::VisitProgram* argument; /**< Compiled argumentTag, null if !hasArgument */
+  };
+
+  /** Create an empty template, that renders nothing */
+  MessageTemplate() = default;
+
+  /** Compile the format string and argument tags of `source` */
+  explicit MessageTemplate(const EventSource& source);
+
+  /** @returns the number of segments */
+  std::size_t size() const { return _segments.size(); }
+
+  /**
+   * @pre i < size()
+   * @returns the i-th segment, valid as long as *this is not changed
+   */
+  Segment segment(std::size_t i) const;
+
+private:
+  struct CompiledSegment
+  {
+    std::size_t literalBegin;
+    std::size_t literalEnd;
+    mserialize::VisitProgram argument;
+    bool hasArgument;
+  };
+
+  std::string _literals; // literals of the format string, concatenated
+  std::vector<CompiledSegment> _segments;
+};
+
+} // namespace binlog
+
+#endif // BINLOG_MESSAGE_TEMPLATE_HPP
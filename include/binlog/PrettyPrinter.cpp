@@ -1,18 +1,20 @@
 #include <binlog/PrettyPrinter.hpp>
 
+#include <binlog/MessageTemplate.hpp>
 #include <binlog/ToStringVisitor.hpp>
 
 #include <mserialize/detail/Visit.hpp> // IntegerToHex
-#include <mserialize/detail/tag_util.hpp>
 #include <mserialize/string_view.hpp>
 #include <mserialize/visit.hpp>
 
 #include <cassert>
 #include <cstddef>
-#include <cstdio>
 #include <cstdlib> // abs
+#include <cstring> // strchr
 #include <iomanip> // setw
 #include <ostream>
+#include <ratio> // nano
+#include <sstream>
 
 namespace {
 
@@ -60,9 +62,14 @@ void printTwoDigits(binlog::detail::OstreamBuffer& out, int i)
 
 void printNineDigits(binlog::detail::OstreamBuffer& out, int i)
 {
-  char buf[16];
-  (void)snprintf(buf, sizeof(buf), "%.9d", i);
-  out.write(buf, 9);
+  assert(0 <= i && i < 1000000000);
+  char digits[9];
+  for (int d = 8; d >= 0; --d)
+  {
+    digits[d] = char('0' + i % 10);
+    i /= 10;
+  }
+  out.write(digits, 9);
 }
 
 // print `seconds` as TZ offset in the ISO 8601 format (e.g: +0340 or -0430)
@@ -83,11 +90,12 @@ void printTimeZoneOffset(binlog::detail::OstreamBuffer& out, int seconds)
 namespace binlog {
 
 PrettyPrinter::PrettyPrinter(std::string eventFormat, std::string timeFormat)
-  :_eventFormat(std::move(eventFormat)),
-   _timeFormat(std::move(timeFormat)),
-   _useLocaltime(useLocaltime(_eventFormat)),
+  :_useLocaltime(useLocaltime(eventFormat)),
    _clockSync(nullptr)
-{}
+{
+  compileFormat(eventFormat, "ISCMFGLPTntdurm", true, _eventProgram);
+  compileFormat(timeFormat, "YymdHMSzZN", false, _timeProgram);
+}
 
 void PrettyPrinter::printEvent(
   std::ostream& ostr,
@@ -97,19 +105,27 @@ void PrettyPrinter::printEvent(
 )
 {
   detail::OstreamBuffer out(ostr);
+  printEvent(out, event, writerProp, clockSync);
+}
+
+void PrettyPrinter::printEvent(
+  detail::OstreamBuffer& out,
+  const Event& event,
+  const WriterProp& writerProp,
+  const ClockSync& clockSync
+)
+{
   _clockSync = &clockSync;
 
-  for (std::size_t i = 0; i < _eventFormat.size(); ++i)
+  for (const FormatOp& op : _eventProgram)
   {
-    const char c = _eventFormat[i];
-    if (c == '%' && ++i != _eventFormat.size())
+    if (op.spec == 0)
     {
-      const char spec = _eventFormat[i];
-      printEventField(out, spec, event, writerProp);
+      printLiteral(out, op);
     }
     else
     {
-      out.put(c);
+      printEventField(out, op.spec, event, writerProp);
     }
   }
 }
@@ -129,19 +145,16 @@ bool PrettyPrinter::printStruct(detail::OstreamBuffer& out, mserialize::Visitor:
   {
     if (_clockSync == nullptr) { return false; }
 
-    BrokenDownTime bdt{};
     const auto sinceEpoch = std::chrono::nanoseconds{input.read<std::int64_t>()};
 
     if (_useLocaltime)
     {
       const std::chrono::nanoseconds sinceEpochTz = sinceEpoch + std::chrono::seconds{_clockSync->tzOffset};
-      nsSinceEpochToBrokenDownTimeUTC(sinceEpochTz, bdt);
-      printTime(out, bdt, _clockSync->tzOffset, _clockSync->tzName.data());
+      printTime(out, sinceEpochTz, _clockSync->tzOffset, _clockSync->tzName.data(), _localTimeCache);
     }
     else
     {
-      nsSinceEpochToBrokenDownTimeUTC(sinceEpoch, bdt);
-      printTime(out, bdt, 0, "UTC");
+      printTime(out, sinceEpoch, 0, "UTC", _utcTimeCache);
     }
     return true;
   }
@@ -185,6 +198,49 @@ bool PrettyPrinter::printStruct(detail::OstreamBuffer& out, mserialize::Visitor:
   return false;
 }
 
+void PrettyPrinter::compileFormat(const std::string& format, const char* specs, bool escape, FormatProgram& program)
+{
+  const auto addLiteral = [&](const char* literal, std::size_t size)
+  {
+    if (program.empty() || program.back().spec != 0)
+    {
+      program.push_back(FormatOp{0, _literals.size(), 0});
+    }
+    _literals.append(literal, size);
+    program.back().size += size;
+  };
+
+  for (std::size_t i = 0; i < format.size(); ++i)
+  {
+    const char c = format[i];
+    if (c == '%' && i + 1 != format.size())
+    {
+      const char spec = format[++i];
+      if (spec != 0 && std::strchr(specs, spec) != nullptr)
+      {
+        program.push_back(FormatOp{spec, 0, 0});
+      }
+      else if (spec == '%' && escape)
+      {
+        addLiteral(&spec, 1);
+      }
+      else
+      {
+        addLiteral(&format[i-1], 2); // unknown placeholder, print as is
+      }
+    }
+    else
+    {
+      addLiteral(&c, 1);
+    }
+  }
+}
+
+void PrettyPrinter::printLiteral(detail::OstreamBuffer& out, const FormatOp& op) const
+{
+  out.write(_literals.data() + op.offset, op.size);
+}
+
 void PrettyPrinter::printEventField(
   detail::OstreamBuffer& out,
   char spec,
@@ -239,49 +295,45 @@ void PrettyPrinter::printEventField(
   case 'm':
     printEventMessage(out, event);
     break;
-  case '%':
-    out.put('%');
-    break;
   default:
-    out << '%' << spec;
-    break;
+    break; // unknown placeholders are compiled to literals
   }
 }
 
 void PrettyPrinter::printEventMessage(detail::OstreamBuffer& out, const Event& event) const
 {
-  mserialize::string_view tags = event.source->argumentTags;
-  Range args = event.arguments;
+  if (event.messageTemplate != nullptr)
+  {
+    printEventMessage(out, *event.messageTemplate, event.arguments);
+  }
+  else
+  {
+    printEventMessage(out, MessageTemplate(*event.source), event.arguments);
+  }
+}
+
+void PrettyPrinter::printEventMessage(detail::OstreamBuffer& out, const MessageTemplate& mt, Range args) const
+{
   ToStringVisitor visitor(out, this);
 
-  const std::string& fmt = event.source->formatString;
-  for (std::size_t i = 0; i < fmt.size(); ++i)
+  for (std::size_t i = 0; i < mt.size(); ++i)
   {
-    const char c = fmt[i];
-    if (c == '{' && fmt[i+1] == '}')
-    {
-      const mserialize::string_view tag = mserialize::detail::tag_pop(tags);
-      mserialize::visit(tag, visitor, args);
-      ++i; // skip }
-    }
-    else
+    const MessageTemplate::Segment segment = mt.segment(i);
+    out.write(segment.literal.data(), segment.literal.size());
+    if (segment.hasArgument)
     {
-      out.put(c);
+      mserialize::visit(*segment.argument, visitor, args);
     }
   }
 }
 
 void PrettyPrinter::printProducerLocalTime(detail::OstreamBuffer& out, std::uint64_t clockValue) const
 {
-  // TODO(benedek) perf: cache bdt, update instead of complete recompute
-
   if (std::int64_t(_clockSync->clockFrequency) > 0)
   {
-    BrokenDownTime bdt{};
     const std::chrono::nanoseconds sinceEpoch = clockToNsSinceEpoch(*_clockSync, clockValue);
     const std::chrono::nanoseconds sinceEpochTz = sinceEpoch + std::chrono::seconds{_clockSync->tzOffset};
-    nsSinceEpochToBrokenDownTimeUTC(sinceEpochTz, bdt);
-    printTime(out, bdt, _clockSync->tzOffset, _clockSync->tzName.data());
+    printTime(out, sinceEpochTz, _clockSync->tzOffset, _clockSync->tzName.data(), _localTimeCache);
   }
   else
   {
@@ -291,14 +343,10 @@ void PrettyPrinter::printProducerLocalTime(detail::OstreamBuffer& out, std::uint
 
 void PrettyPrinter::printUTCTime(detail::OstreamBuffer& out, std::uint64_t clockValue) const
 {
-  // TODO(benedek) perf: cache bdt, update instead of complete recompute
-
   if (std::int64_t(_clockSync->clockFrequency) > 0)
   {
-    BrokenDownTime bdt{};
     const std::chrono::nanoseconds sinceEpoch = clockToNsSinceEpoch(*_clockSync, clockValue);
-    nsSinceEpochToBrokenDownTimeUTC(sinceEpoch, bdt);
-    printTime(out, bdt, 0, "UTC");
+    printTime(out, sinceEpoch, 0, "UTC", _utcTimeCache);
   }
   else
   {
@@ -306,21 +354,71 @@ void PrettyPrinter::printUTCTime(detail::OstreamBuffer& out, std::uint64_t clock
   }
 }
 
-void PrettyPrinter::printTime(detail::OstreamBuffer& out, BrokenDownTime& bdt, int tzoffset, const char* tzname) const
+void PrettyPrinter::printTime(
+  detail::OstreamBuffer& out,
+  std::chrono::nanoseconds sinceEpoch,
+  int tzoffset,
+  const char* tzname,
+  TimeCache& cache
+) const
 {
-  for (std::size_t i = 0; i < _timeFormat.size(); ++i)
+  // floor, to keep the nanoseconds non-negative before the epoch
+  std::int64_t second = sinceEpoch.count() / std::nano::den;
+  std::int64_t nanosecond = sinceEpoch.count() % std::nano::den;
+  if (nanosecond < 0)
   {
-    const char c = _timeFormat[i];
-    if (c == '%' && ++i != _timeFormat.size())
-    {
-      const char spec = _timeFormat[i];
-      printTimeField(out, spec, bdt, tzoffset, tzname);
-    }
-    else
+    second -= 1;
+    nanosecond += std::nano::den;
+  }
+
+  if (! cache.valid || cache.second != second || cache.tzoffset != tzoffset || cache.tzname != tzname)
+  {
+    updateTimeCache(cache, second, tzoffset, tzname);
+  }
+
+  std::size_t begin = 0;
+  for (const std::size_t end : cache.nsOffsets)
+  {
+    out.write(cache.text.data() + begin, end - begin);
+    printNineDigits(out, int(nanosecond));
+    begin = end;
+  }
+  out.write(cache.text.data() + begin, cache.text.size() - begin);
+}
+
+void PrettyPrinter::updateTimeCache(TimeCache& cache, std::int64_t second, int tzoffset, const char* tzname) const
+{
+  BrokenDownTime bdt{};
+  nsSinceEpochToBrokenDownTimeUTC(std::chrono::seconds{second}, bdt);
+
+  std::ostringstream str;
+  cache.nsOffsets.clear();
+
+  {
+    detail::OstreamBuffer buf(str);
+    for (const FormatOp& op : _timeProgram)
     {
-      out.put(c);
+      if (op.spec == 0)
+      {
+        printLiteral(buf, op);
+      }
+      else if (op.spec == 'N')
+      {
+        buf.flush();
+        cache.nsOffsets.push_back(std::size_t(str.tellp()));
+      }
+      else
+      {
+        printTimeField(buf, op.spec, bdt, tzoffset, tzname);
+      }
     }
   }
+
+  cache.second = second;
+  cache.tzoffset = tzoffset;
+  cache.tzname = tzname;
+  cache.text = str.str();
+  cache.valid = true;
 }
 
 void PrettyPrinter::printTimeField(detail::OstreamBuffer& out, char spec, BrokenDownTime& bdt, int tzoffset, const char* tzname) const
@@ -354,12 +452,8 @@ void PrettyPrinter::printTimeField(detail::OstreamBuffer& out, char spec, Broken
   case 'Z':
     out << tzname;
     break;
-  case 'N':
-    printNineDigits(out, bdt.tm_nsec);
-    break;
   default:
-    out << '%' << spec;
-    break;
+    break; // %N is handled by printTime, unknown placeholders are compiled to literals
   }
 }
 
@@ -8,9 +8,12 @@
 
 #include <mserialize/Visitor.hpp>
 
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <iosfwd>
 #include <string>
+#include <vector>
 
 namespace binlog {
 
@@ -40,6 +43,9 @@ namespace binlog {
  *
  *    %Y, %y, %m, %d, %H, %M, %S, %z, %Z as for strftime
  *    %N Nanoseconds (0-999999999)
+ *
+ * Both formats are compiled once, in the constructor,
+ * to a sequence of literals and placeholders.
  */
 class PrettyPrinter
 {
@@ -64,6 +70,20 @@ public:
     const ClockSync& clockSync = {}
   );
 
+  /**
+   * Same as printEvent(std::ostream&, ...), but write `out`.
+   *
+   * This allows reusing the buffer of `out` for several events:
+   * the printed event is flushed to the underlying ostream
+   * only if the buffer is full, or by an explicit `out.flush()`.
+   */
+  void printEvent(
+    detail::OstreamBuffer& out,
+    const Event& event,
+    const WriterProp& writerProp = {},
+    const ClockSync& clockSync = {}
+  );
+
   /**
    * If the type indicated by `sb` is known, deserialize it from `input`,
    * and print it to `out`, then return true.
@@ -75,6 +95,27 @@ public:
   bool printStruct(detail::OstreamBuffer& out, mserialize::Visitor::StructBegin sb, Range& input) const;
 
 private:
+  /** Compiled part of a format string: a literal or a placeholder */
+  struct FormatOp
+  {
+    char spec;          /**< The placeholder character, 0 for literals */
+    std::size_t offset; /**< Literals: offset of the literal in _literals */
+    std::size_t size;   /**< Literals: size of the literal */
+  };
+
+  using FormatProgram = std::vector<FormatOp>;
+
+  /**
+   * Compile `format` to `program`, adding literals to _literals.
+   *
+   * %x sequences are compiled to placeholders if x is in `specs`,
+   * to a single % if x is % and `escape` is true,
+   * or to literals otherwise. Adjacent literals are merged.
+   */
+  void compileFormat(const std::string& format, const char* specs, bool escape, FormatProgram& program);
+
+  void printLiteral(detail::OstreamBuffer& out, const FormatOp& op) const;
+
   void printEventField(
     detail::OstreamBuffer& out,
     char spec,
@@ -83,17 +124,47 @@ private:
   ) const;
 
   void printEventMessage(detail::OstreamBuffer& out, const Event& event) const;
+  void printEventMessage(detail::OstreamBuffer& out, const MessageTemplate& mt, Range args) const;
 
   void printProducerLocalTime(detail::OstreamBuffer& out, std::uint64_t clockValue) const;
   void printUTCTime(detail::OstreamBuffer& out, std::uint64_t clockValue) const;
 
-  void printTime(detail::OstreamBuffer& out, BrokenDownTime& bdt, int tzoffset, const char* tzname) const;
+  /**
+   * The time format rendered for a given second and time zone.
+   *
+   * Consecutive events are likely to fall into the same second,
+   * only the nanoseconds (%N) are different: those are inserted
+   * at `nsOffsets` of `text` when printed.
+   */
+  struct TimeCache
+  {
+    bool valid = false;
+    std::int64_t second = 0;
+    int tzoffset = 0;
+    std::string tzname;
+    std::string text;                   // time format rendered, without %N
+    std::vector<std::size_t> nsOffsets; // offsets of %N in `text`, ascending
+  };
+
+  void printTime(
+    detail::OstreamBuffer& out,
+    std::chrono::nanoseconds sinceEpoch,
+    int tzoffset,
+    const char* tzname,
+    TimeCache& cache
+  ) const;
+
+  void updateTimeCache(TimeCache& cache, std::int64_t second, int tzoffset, const char* tzname) const;
+
   void printTimeField(detail::OstreamBuffer& out, char spec, BrokenDownTime& bdt, int tzoffset, const char* tzname) const;
 
-  std::string _eventFormat;
-  std::string _timeFormat;
+  std::string _literals;        // literals of both formats
+  FormatProgram _eventProgram;  // compiled event format
+  FormatProgram _timeProgram;   // compiled time format
   bool _useLocaltime; // true if timestamps in messages should be rendered in producer-localtime
   const ClockSync* _clockSync;
+  mutable TimeCache _localTimeCache; // producer local time, %d
+  mutable TimeCache _utcTimeCache;   // UTC time, %u
 };
 
 } // namespace binlog
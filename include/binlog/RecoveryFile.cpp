@@ -0,0 +1,142 @@
+#include <binlog/RecoveryFile.hpp>
+
+#include <cerrno>
+#include <cstring> // strerror
+#include <stdexcept>
+#include <utility>
+
+#ifndef _WIN32 // assume POSIX
+  #include <fcntl.h> // open, posix_fallocate
+  #include <sys/mman.h> // mmap, munmap
+  #include <unistd.h> // close, ftruncate, unlink, sysconf
+#endif
+
+namespace binlog {
+
+#ifdef _WIN32
+
+RecoveryFile::RecoveryFile(std::string path)
+  :_path(std::move(path))
+{
+  throw std::runtime_error("RecoveryFile is not supported on this platform");
+}
+
+RecoveryFile::~RecoveryFile() = default;
+
+char* RecoveryFile::allocate(std::size_t)
+{
+  throw std::runtime_error("RecoveryFile is not supported on this platform");
+}
+
+void RecoveryFile::deallocate(char*, std::size_t) noexcept {}
+
+#else
+
+namespace {
+
+std::string errorMessage(const char* what, const std::string& path)
+{
+  return std::string(what) + " " + path + ": " + std::strerror(errno);
+}
+
+} // namespace
+
+RecoveryFile::RecoveryFile(std::string path)
+  :_path(std::move(path)),
+   _fd(::open(_path.data(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600))
+{
+  if (_fd < 0)
+  {
+    throw std::runtime_error(errorMessage("Failed to open recovery file", _path));
+  }
+
+  const long pageSize = sysconf(_SC_PAGESIZE);
+  if (pageSize > 0) { _pageSize = std::size_t(pageSize); }
+}
+
+RecoveryFile::~RecoveryFile()
+{
+  for (const Mapping& mapping : _mappings)
+  {
+    munmap(mapping.address, mapping.size);
+  }
+
+  ::close(_fd);
+
+  // the buffers are released, the file has nothing to recover
+  ::unlink(_path.data());
+}
+
+char* RecoveryFile::allocate(std::size_t size)
+{
+  const std::size_t alignedSize = blockSize(size);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  const auto freeBlock = _freeBlocks.find(alignedSize);
+  if (freeBlock != _freeBlocks.end())
+  {
+    char* result = freeBlock->second;
+    _freeBlocks.erase(freeBlock);
+    return result;
+  }
+
+  // Extend the file. Reserve disk blocks if possible:
+  // if the filesystem is full, fail here, instead of
+  // raising SIGBUS later, when the mapped memory is written.
+  const off_t offset = off_t(_fileSize);
+#ifdef __linux__
+  const int error = posix_fallocate(_fd, offset, off_t(alignedSize));
+  if (error != 0)
+  {
+    errno = error;
+    throw std::runtime_error(errorMessage("Failed to extend recovery file", _path));
+  }
+#else
+  if (ftruncate(_fd, off_t(_fileSize + alignedSize)) != 0)
+  {
+    throw std::runtime_error(errorMessage("Failed to extend recovery file", _path));
+  }
+#endif
+
+  void* address = mmap(nullptr, alignedSize, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, offset);
+  if (address == MAP_FAILED) // NOLINT(cppcoreguidelines-pro-type-cstyle-cast)
+  {
+    throw std::runtime_error(errorMessage("Failed to map recovery file", _path));
+  }
+
+  _fileSize += alignedSize;
+  _mappings.push_back(Mapping{static_cast<char*>(address), alignedSize});
+  return static_cast<char*>(address);
+}
+
+void RecoveryFile::deallocate(char* block, std::size_t size) noexcept
+{
+  const std::size_t alignedSize = blockSize(size);
+
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  try
+  {
+    _freeBlocks.emplace(alignedSize, block);
+  }
+  catch (...)
+  {
+    // failed to allocate a node: the block will not be reused
+  }
+}
+
+#endif // _WIN32
+
+std::size_t RecoveryFile::fileSize() const
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  return _fileSize;
+}
+
+std::size_t RecoveryFile::blockSize(std::size_t size) const
+{
+  return (size + _pageSize - 1) / _pageSize * _pageSize;
+}
+
+} // namespace binlog
@@ -0,0 +1,90 @@
+#ifndef BINLOG_RECOVERY_FILE_HPP
+#define BINLOG_RECOVERY_FILE_HPP
+
+#include <binlog/detail/MemoryResource.hpp>
+
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace binlog {
+
+/**
+ * A file backed, shared memory region, to store
+ * the channel queues and metadata of a Session.
+ *
+ * If the application crashes, unconsumed data
+ * remains in the file (the shared pages are kept by the kernel),
+ * and can be recovered by `brecovery`, without a memory dump:
+ *
+ *    auto recoveryFile = std::make_shared<binlog::RecoveryFile>("/dev/shm/app.blogrec");
+ *    binlog::Session session(recoveryFile);
+ *
+ *    // after a crash:
+ *    $ brecovery /dev/shm/app.blogrec recovered.blog
+ *
+ * To avoid I/O, put the file on a memory backed filesystem (e.g: tmpfs).
+ * The size of the file is about the total capacity of the
+ * channel queues, plus twice the size of the metadata.
+ *
+ * The file is removed when *this is destroyed,
+ * i.e: it remains only if the application does not exit cleanly.
+ *
+ * Supported on POSIX systems only.
+ */
+class RecoveryFile : public detail::MemoryResource
+{
+public:
+  /**
+   * Create (or truncate) the file at `path`, open it for writing.
+   *
+   * @throws std::runtime_error if the file cannot be opened,
+   *         or the platform is not supported.
+   */
+  explicit RecoveryFile(std::string path);
+
+  ~RecoveryFile() override;
+
+  /**
+   * Extend the file, and map the new part to memory.
+   * Freed blocks of the same (page aligned) size are reused.
+   *
+   * @returns a page aligned block of at least `size` bytes,
+   *          mapped to a part of the file.
+   * @throws std::runtime_error if the file cannot be extended or mapped
+   */
+  char* allocate(std::size_t size) override;
+
+  /** Make `block` available for allocations of the same size */
+  void deallocate(char* block, std::size_t size) noexcept override;
+
+  /** @returns the path of the file */
+  const std::string& path() const { return _path; }
+
+  /** @returns the current size of the file, in bytes */
+  std::size_t fileSize() const;
+
+private:
+  struct Mapping
+  {
+    char* address;
+    std::size_t size;
+  };
+
+  std::size_t blockSize(std::size_t size) const;
+
+  std::string _path;
+  int _fd = -1;
+  std::size_t _pageSize = 4096;
+
+  mutable std::mutex _mutex;
+  std::size_t _fileSize = 0;
+  std::vector<Mapping> _mappings;
+  std::multimap<std::size_t, char*> _freeBlocks; // size -> block
+};
+
+} // namespace binlog
+
+#endif // BINLOG_RECOVERY_FILE_HPP
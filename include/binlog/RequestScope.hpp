@@ -0,0 +1,148 @@
+#ifndef BINLOG_REQUEST_SCOPE_HPP
+#define BINLOG_REQUEST_SCOPE_HPP
+
+#include <binlog/SessionWriter.hpp>
+#include <binlog/Severity.hpp>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <utility> // move
+#include <vector>
+
+namespace binlog {
+
+/**
+ * Gathers the events of a logical request, added to `writer`,
+ * and keeps them only if the request turns out to be interesting
+ * (tail sampling).
+ *
+ * The constructor begins a scope of the writer, the destructor ends it:
+ * if the predicate given in the constructor returns true for the Summary
+ * of the scope, the gathered events are committed to the channel of the writer,
+ * otherwise they are discarded. See SessionWriter::beginScope.
+ *
+ * Common predicates are provided as static members,
+ * and can be combined:
+ *
+ *    {
+ *      binlog::RequestScope scope(writer, binlog::RequestScope::anyOf({
+ *        binlog::RequestScope::slowerThan(std::chrono::milliseconds(10)),
+ *        binlog::RequestScope::severityAtLeast(binlog::Severity::warning),
+ *      }));
+ *
+ *      BINLOG_DEBUG_W(writer, "Request: {}", request);
+ *      // ... handle request, log more
+ *    } // events are kept only if the request was slow, or a warning was logged
+ *
+ * Events added to `writer` in the scope are not visible
+ * to the session (e.g: Session::consume) until the end of the scope.
+ * Scopes of the same writer do not nest.
+ */
+class RequestScope
+{
+public:
+  using Clock = std::chrono::steady_clock;
+
+  /** Properties of a finished scope */
+  struct Summary
+  {
+    Clock::duration elapsed;  /**< Time between the construction and destruction of the scope */
+    Severity maxSeverity;     /**< See SessionWriter::scopeSeverity */
+    std::size_t size;         /**< Number of bytes gathered */
+  };
+
+  /** Returns true, if the events of the scope should be kept. Must not throw. */
+  using Predicate = std::function<bool(const Summary&)>;
+
+  /**
+   * Begin a scope of `writer`.
+   *
+   * @pre ! writer.inScope()
+   * @param keep returns true for the scopes to commit
+   * @throws std::bad_alloc if the first scope buffer of the writer cannot be allocated
+   */
+  RequestScope(SessionWriter& writer, Predicate keep);
+
+  /** Commit or discard the events of the scope, see the constructor */
+  ~RequestScope();
+
+  RequestScope(const RequestScope&) = delete;
+  void operator=(const RequestScope&) = delete;
+
+  /** Commit the events of the scope, regardless of the predicate */
+  void keep() { _forceKeep = true; }
+
+  /** @returns a predicate, true for scopes that took at least `threshold` */
+  static Predicate slowerThan(Clock::duration threshold);
+
+  /**
+   * @returns a predicate, true for scopes with an event of `severity` or above
+   * @throws std::runtime_error if `severity` is Severity::trace:
+   *   the lowest severity would select every scope, even the empty ones.
+   *   To keep every scope, do not use a RequestScope.
+   */
+  static Predicate severityAtLeast(Severity severity);
+
+  /** @returns a predicate, true if any of `predicates` is true */
+  static Predicate anyOf(std::initializer_list<Predicate> predicates);
+
+private:
+  SessionWriter& _writer;
+  Predicate _keep;
+  Clock::time_point _begin;
+  bool _forceKeep = false;
+};
+
+inline RequestScope::RequestScope(SessionWriter& writer, Predicate keep)
+  :_writer(writer),
+   _keep(std::move(keep))
+{
+  _writer.beginScope();
+  _begin = Clock::now();
+}
+
+inline RequestScope::~RequestScope()
+{
+  bool commit = _forceKeep;
+  if (! commit)
+  {
+    const Summary summary{Clock::now() - _begin, _writer.scopeSeverity(), _writer.scopeSize()};
+    commit = _keep(summary);
+  }
+
+  _writer.endScope(commit);
+}
+
+inline RequestScope::Predicate RequestScope::slowerThan(Clock::duration threshold)
+{
+  return [threshold](const Summary& summary) { return summary.elapsed >= threshold; };
+}
+
+inline RequestScope::Predicate RequestScope::severityAtLeast(Severity severity)
+{
+  if (severity == Severity::trace)
+  {
+    throw std::runtime_error("RequestScope::severityAtLeast(Severity::trace) would select every scope");
+  }
+
+  return [severity](const Summary& summary) { return summary.maxSeverity >= severity; };
+}
+
+inline RequestScope::Predicate RequestScope::anyOf(std::initializer_list<Predicate> predicates)
+{
+  return [ps = std::vector<Predicate>(predicates)](const Summary& summary)
+  {
+    for (const Predicate& p : ps)
+    {
+      if (p(summary)) { return true; }
+    }
+    return false;
+  };
+}
+
+} // namespace binlog
+
+#endif // BINLOG_REQUEST_SCOPE_HPP
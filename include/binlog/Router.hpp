@@ -0,0 +1,228 @@
+#ifndef BINLOG_ROUTER_HPP
+#define BINLOG_ROUTER_HPP
+
+#include <binlog/Entries.hpp> // EventSource
+#include <binlog/Range.hpp>
+#include <binlog/detail/SourceIdMap.hpp>
+
+#include <mserialize/deserialize.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ios> // streamsize
+#include <stdexcept> // runtime_error
+#include <string>
+#include <utility> // move
+#include <vector>
+
+namespace binlog {
+
+/**
+ * Routes a stream of entries to multiple outputs (sinks),
+ * parsing the stream only once.
+ *
+ * Each sink has a predicate, that selects the EventSources
+ * whose events are written to the sink. The predicates are
+ * evaluated once per EventSource, the result is stored
+ * as a bitmask (one bit per sink), that is looked up for each event.
+ *
+ *  - EventSources are written to the sinks that select them
+ *  - other special entries (e.g: WriterProp, ClockSync) are written to every sink
+ *  - Events are written to the sinks that select their source
+ *
+ * Consecutive entries routed to the same sink are written
+ * by a single `write` call.
+ *
+ * Models the mserialize::OutputStream concept, usage:
+ *
+ *    binlog::Router router;
+ *    router.addSink(logfile); // every event
+ *    router.addSink(textOutput, [](const binlog::EventSource& source) {
+ *      return source.severity >= binlog::Severity::error;
+ *    });
+ *    session.consume(router);
+ */
+class Router
+{
+public:
+  using Predicate = std::function<bool(const EventSource&)>;
+
+  /** Maximum number of sinks */
+  static constexpr std::size_t maxSinkCount = 64;
+
+  /**
+   * Add `out` to the sinks, events of sources selected by `isAllowed`
+   * will be written to it. If `isAllowed` is empty, every event is written.
+   *
+   * Stores a reference to `out`: it must remain valid
+   * as long as *this is valid. Must be called before the first `write`,
+   * as the routing of sources already seen is not recomputed.
+   *
+   * @requires OutputStream must model the mserialize::OutputStream concept
+   * @throws std::runtime_error if there are already maxSinkCount sinks
+   */
+  template <typename OutputStream>
+  void addSink(OutputStream& out, Predicate isAllowed = {});
+
+  /** @returns the number of sinks added */
+  std::size_t sinkCount() const { return _sinks.size(); }
+
+  /**
+   * Write the entries in [buffer, buffer+size) to the sinks.
+   *
+   * @throws std::runtime_error if `buffer` contains an invalid entry.
+   *         The entries before the invalid entry are written.
+   */
+  Router& write(const char* buffer, std::streamsize size);
+
+private:
+  struct Sink
+  {
+    std::function<void(const char*, std::streamsize)> write;
+    Predicate isAllowed;
+
+    // entries in [runBegin, runEnd) are routed to this sink, but not yet written
+    const char* runBegin = nullptr;
+    const char* runEnd = nullptr;
+  };
+
+  std::uint64_t routeSource(const EventSource& source);
+
+  std::uint64_t sourceMask(std::uint64_t id) const;
+
+  void setSourceMask(std::uint64_t id, std::uint64_t mask);
+
+  void route(std::uint64_t mask, const char* entryBegin, const char* entryEnd);
+
+  void flush();
+
+  std::vector<Sink> _sinks;
+  std::uint64_t _allSinks = 0;
+
+  detail::SourceIdMap<std::uint64_t> _sourceMasks;
+};
+
+template <typename OutputStream>
+void Router::addSink(OutputStream& out, Predicate isAllowed)
+{
+  if (_sinks.size() == maxSinkCount)
+  {
+    throw std::runtime_error("Too many sinks, maximum is " + std::to_string(maxSinkCount));
+  }
+
+  Sink sink;
+  sink.write = [&out](const char* buffer, std::streamsize size) { out.write(buffer, size); };
+  sink.isAllowed = std::move(isAllowed);
+  _sinks.push_back(std::move(sink));
+
+  _allSinks |= std::uint64_t(1) << (_sinks.size() - 1);
+}
+
+inline Router& Router::write(const char* buffer, std::streamsize size)
+{
+  Range entries(buffer, std::size_t(size));
+  const char* entryBegin = buffer;
+
+  try
+  {
+    while (! entries.empty())
+    {
+      const std::uint32_t entrySize = entries.read<std::uint32_t>();
+      Range payload(entries.view(entrySize), entrySize);
+      const char* entryEnd = entryBegin + sizeof(entrySize) + entrySize;
+      const std::uint64_t tag = payload.read<std::uint64_t>();
+      const bool special = (tag & (std::uint64_t(1) << 63)) != 0;
+
+      std::uint64_t mask = _allSinks;
+      if (! special)
+      {
+        mask = sourceMask(tag);
+      }
+      else if (tag == EventSource::Tag)
+      {
+        EventSource eventSource;
+        mserialize::deserialize(eventSource, payload);
+        mask = routeSource(eventSource);
+      }
+
+      route(mask, entryBegin, entryEnd);
+      entryBegin = entryEnd;
+    }
+  }
+  catch (...)
+  {
+    // write the valid entries before the invalid one
+    flush();
+    throw;
+  }
+
+  flush();
+  return *this;
+}
+
+inline std::uint64_t Router::routeSource(const EventSource& source)
+{
+  std::uint64_t mask = 0;
+  for (std::size_t i = 0; i < _sinks.size(); ++i)
+  {
+    const Predicate& isAllowed = _sinks[i].isAllowed;
+    if (! isAllowed || isAllowed(source))
+    {
+      mask |= std::uint64_t(1) << i;
+    }
+  }
+
+  setSourceMask(source.id, mask);
+  return mask;
+}
+
+inline std::uint64_t Router::sourceMask(std::uint64_t id) const
+{
+  return _sourceMasks.get(id);
+}
+
+inline void Router::setSourceMask(std::uint64_t id, std::uint64_t mask)
+{
+  _sourceMasks.set(id, mask);
+}
+
+inline void Router::route(std::uint64_t mask, const char* entryBegin, const char* entryEnd)
+{
+  for (std::size_t i = 0; mask != 0; ++i, mask >>= 1)
+  {
+    if ((mask & 1) == 0) { continue; }
+
+    Sink& sink = _sinks[i];
+    if (sink.runEnd != entryBegin)
+    {
+      // not contiguous with the pending entries, write those first
+      if (sink.runBegin != sink.runEnd)
+      {
+        const char* run = sink.runBegin;
+        sink.runBegin = sink.runEnd; // do not write again, even if write throws
+        sink.write(run, std::streamsize(sink.runEnd - run));
+      }
+      sink.runBegin = entryBegin;
+    }
+    sink.runEnd = entryEnd;
+  }
+}
+
+inline void Router::flush()
+{
+  for (Sink& sink : _sinks)
+  {
+    const char* run = sink.runBegin;
+    const char* runEnd = sink.runEnd;
+    sink.runBegin = sink.runEnd = nullptr;
+    if (run != runEnd)
+    {
+      sink.write(run, std::streamsize(runEnd - run));
+    }
+  }
+}
+
+} // namespace binlog
+
+#endif // BINLOG_ROUTER_HPP
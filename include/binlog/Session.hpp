@@ -2,18 +2,26 @@
 #define BINLOG_SESSION_HPP
 
 #include <binlog/Entries.hpp>
+#include <binlog/Range.hpp>
 #include <binlog/Severity.hpp>
 #include <binlog/Time.hpp>
+#include <binlog/detail/MemoryResource.hpp>
 #include <binlog/detail/Queue.hpp>
 #include <binlog/detail/QueueReader.hpp>
 #include <binlog/detail/VectorOutputStream.hpp>
 
-#include <algorithm> // remove_if
+#include <algorithm> // remove_if, find, find_if
+#include <array>
 #include <atomic>
+#include <bitset>
+#include <cstddef>
 #include <cstdint>
 #include <deque>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <stdexcept> // runtime_error
+#include <string>
 #include <utility> // move
 #include <vector>
 
@@ -37,6 +45,10 @@ namespace binlog {
  * Readers can read metadata and data, via consume.
  * Concurrent reads are serialized by a mutex.
  *
+ * Channel queues and metadata are recoverable from memory dumps
+ * (see brecovery). If a MemoryResource is given, e.g: a RecoveryFile,
+ * these buffers are allocated from it, instead of the heap.
+ *
  * Session responsibilities:
  *  - Assign unique ids to event sources
  *  - Add clock syncs to the stream when needed
@@ -49,7 +61,7 @@ class Session
 public:
   struct Channel
   {
-    explicit Channel(Session& session, std::size_t queueCapacity, WriterProp writerProp_ = {});
+    explicit Channel(Session& session, std::size_t queueCapacity, WriterProp writerProp_ = {}, bool overwrite = false);
     ~Channel();
 
     Channel(const Channel&) = delete;
@@ -63,9 +75,22 @@ public:
     WriterProp writerProp;      /**< Describes the writer of this channel (optional) */ // NOLINT
 
   private:
-    std::unique_ptr<char[]> _queue; /**< Magic, Queue, and the underlying buffer of `queue` */
+    std::shared_ptr<detail::MemoryResource> _memory; /**< Owner of `_queue`, if not the heap */
+    std::size_t _queueSize;
+    char* _queue; /**< Magic, Queue, and the underlying buffer of `queue` */
+  };
+
+  /** An added event source, and the state of its call site, see setTracepointsEnabled */
+  struct Tracepoint
+  {
+    EventSource source;
+    bool enabled = true;    /**< If false, the call site does not add events */
+    bool switchable = false; /**< If false, the call site cannot be disabled */
   };
 
+  /** Selects event sources, e.g: EventFilter::fileEndsWith */
+  using EventSourcePredicate = std::function<bool(const EventSource&)>;
+
   /** Describe the result of a consume call */
   struct ConsumeResult
   {
@@ -77,6 +102,18 @@ public:
 
   Session();
 
+  /**
+   * Allocate channel queues and metadata buffers from `memory`.
+   *
+   * If `memory` is a RecoveryFile, unconsumed data
+   * can be recovered from the file after a crash,
+   * without a memory dump of the application.
+   * `memory` is kept alive by *this and the created channels.
+   *
+   * @param memory if null, buffers are allocated from the heap
+   */
+  explicit Session(std::shared_ptr<detail::MemoryResource> memory);
+
   /**
    * Create a channel with a queue of `queueCapacity` bytes.
    *
@@ -116,9 +153,55 @@ public:
    * are guaranteed to be consumed after the event source
    * by `Session::consume`.
    *
+   * If `enabled` is not null, the call site adding events
+   * of `eventSource` is expected to add events only if `*enabled` is true,
+   * which is set by this call and by setTracepointsEnabled.
+   *
+   * @pre `enabled` must outlive *this, if not null
    * @returns the id assigned to the added event source
    */
-  std::uint64_t addEventSource(EventSource eventSource);
+  std::uint64_t addEventSource(EventSource eventSource, std::atomic<bool>* enabled = nullptr);
+
+  /** @returns the event sources added so far, and the state of their call sites */
+  std::vector<Tracepoint> tracepoints();
+
+  /**
+   * Enable or disable the call sites of the event sources selected by `predicate`.
+   *
+   * The change affects the already added event sources, and also the ones
+   * added later: the call sites of the log macros add their event sources
+   * when first executed. To this end, `predicate` is stored as a rule,
+   * evaluated for each added event source. If multiple rules select
+   * the same source, the last one takes effect.
+   *
+   * If `ruleName` is not empty, a previous rule with the same name
+   * is replaced, e.g: to switch the same call sites on and off repeatedly,
+   * without accumulating rules. Rules can be removed by clearTracepointRules.
+   *
+   * A disabled call site of the log macros does not add events,
+   * and does not evaluate its arguments. This is advisory only,
+   * like setMinSeverity. Does not block writers.
+   *
+   * Example:
+   *
+   *     session.setTracepointsEnabled(binlog::EventFilter::fileEndsWith("OrderBook.cpp"), false);
+   *
+   * @returns the number of already added event sources selected by `predicate`
+   * @throws std::runtime_error if there are already maxTracepointRules rules,
+   *         and `ruleName` does not replace one of them.
+   */
+  std::size_t setTracepointsEnabled(EventSourcePredicate predicate, bool enabled, std::string ruleName = {});
+
+  /**
+   * Remove every rule added by setTracepointsEnabled.
+   *
+   * The state of the already added event sources is not changed,
+   * the call sites of event sources added later are enabled.
+   */
+  void clearTracepointRules();
+
+  /** The maximum number of rules stored by setTracepointsEnabled */
+  static constexpr std::size_t maxTracepointRules = 64;
 
   /** @returns Severity below writers should not add events */
   Severity minSeverity() const;
@@ -129,9 +212,77 @@ public:
    * This is advisory only: writers are encouraged
    * not to add new events with severity below the given limit,
    * but not required to.
+   *
+   * Categories with a minimum severity set by setCategoryMinSeverity
+   * are not affected.
+   *
+   * Does not block writers, and does not wait for a consume in progress.
    */
   void setMinSeverity(Severity severity);
 
+  /** The maximum number of categories with a distinct minimum severity */
+  static constexpr std::size_t maxCategories = 256;
+
+  /**
+   * Map `category` to a small integer, the same in every session.
+   *
+   * Log call sites resolve their category once,
+   * and use the result to call categoryMinSeverity.
+   * Thread-safe. Takes a process wide lock.
+   *
+   * @returns the index of `category`, in [1, maxCategories),
+   *          or 0, if there are already too many categories.
+   */
+  static std::size_t categoryIndex(const std::string& category);
+
+  /**
+   * @returns Severity below writers should not add events of the category,
+   *          identified by `categoryIndex` (see categoryIndex):
+   *          the severity set by setCategoryMinSeverity or minSeverity().
+   *
+   * Lock-free, a single relaxed load: to be called by every log call site.
+   *
+   * @pre categoryIndex < maxCategories
+   */
+  Severity categoryMinSeverity(std::size_t categoryIndex) const
+  {
+    return _categoryMinSeverity[categoryIndex].load(std::memory_order_relaxed);
+  }
+
+  /**
+   * Set minimum severity of new events of `category`,
+   * overriding minSeverity() for this category.
+   *
+   * Like setMinSeverity, this is advisory only.
+   * Does not block writers, and does not wait for a consume in progress.
+   *
+   * @throws std::runtime_error if there are too many categories
+   */
+  void setCategoryMinSeverity(const std::string& category, Severity severity);
+
+  /**
+   * Make minSeverity() the minimum severity of `category` again,
+   * undo setCategoryMinSeverity.
+   */
+  void resetCategoryMinSeverity(const std::string& category);
+
+  /**
+   * Create channels in overwrite mode, if `overwrite` is true.
+   *
+   * Affects channels created after this call.
+   * If the queue of an overwrite mode channel is full,
+   * the oldest events are evicted, to make room for the new one
+   * (see detail::Queue). The queue is never replaced by a larger one
+   * (see SessionWriter), memory usage remains constant.
+   *
+   * Useful for black-box tracing: the session is consumed only
+   * on demand, e.g: if an error is detected, to get the most recent events
+   * of each writer. Consuming an overwrite mode channel is more expensive,
+   * as its data is copied and validated first, because it
+   * can be overwritten concurrently.
+   */
+  void setOverwriteMode(bool overwrite);
+
   /**
    * Add `clockSync` to the set of managed metadata.
    *
@@ -186,35 +337,98 @@ public:
   template <typename OutputStream>
   ConsumeResult reconsumeMetadata(OutputStream& out);
 
+  /**
+   * Write the metadata and the unconsumed data of every channel to `out`,
+   * without changing the state of the session, e.g: from a signal handler,
+   * when the application is about to crash.
+   *
+   * The ClockSync, every EventSource (consumed or not),
+   * and the unread data of each channel (prefixed by a WriterProp) is written,
+   * making the output self contained. The data remains in the channels,
+   * and will be consumed again by the next `consume` call.
+   *
+   * Does not allocate memory, and does not lock the session mutex:
+   * the session is read without locking. If a `consume` call is in progress
+   * (e.g: on a different thread, or the crashing thread crashed in `consume`),
+   * nothing is written, as the channels might be modified concurrently.
+   * Otherwise, the output might be incomplete, or the call might crash,
+   * if a concurrent call (e.g: adding an EventSource or a channel)
+   * modifies the session. Best effort only.
+   *
+   * @requires OutputStream must model the mserialize::OutputStream concept,
+   *           and to be used by a signal handler, OutputStream::write
+   *           must be async-signal-safe, and must not allocate.
+   * @returns description of the job done, see ConsumeResult.
+   *          totalBytesConsumed is not changed.
+   */
+  template <typename OutputStream>
+  ConsumeResult emergencyConsume(OutputStream& out) noexcept;
+
 private:
   template <typename Entry, typename OutputStream>
   std::size_t consumeSpecialEntry(const Entry& entry, OutputStream& out);
 
   std::mutex _mutex;
+  std::atomic<bool> _consuming = {false}; // true while consume runs, read by emergencyConsume
+
+  std::shared_ptr<detail::MemoryResource> _memory;
 
   std::vector<std::shared_ptr<Channel>> _channels;
-  detail::RecoverableVectorOutputStream _clockSync = {0xFE214F726E35BDBC, this};
-  detail::RecoverableVectorOutputStream _sources = {0xFE214F726E35BDBC, this};
+  detail::RecoverableVectorOutputStream _clockSync = {0xFE214F726E35BDBC, this, _memory};
+  detail::RecoverableVectorOutputStream _sources = {0xFE214F726E35BDBC, this, _memory};
   std::streamsize _sourcesConsumePos = 0;
   std::uint64_t _nextSourceId = 1;
 
+  // Call `f(EventSource, TracepointEntry)` for each added event source
+  template <typename F>
+  void forEachTracepoint(F f);
+
+  // The event source of _tracepoints[i] is the i-th entry of _sources
+  struct TracepointEntry
+  {
+    std::uint64_t id;
+    std::atomic<bool>* enabled; // nullptr if not switchable
+  };
+
+  struct TracepointRule
+  {
+    std::string name;
+    EventSourcePredicate predicate;
+    bool enabled;
+  };
+
+  std::vector<TracepointEntry> _tracepoints;
+  std::vector<TracepointRule> _tracepointRules; // the last matching rule applies to new sources
+
   std::size_t _totalConsumedBytes = 0;
 
   std::atomic<Severity> _minSeverity = {Severity::trace};
 
+  // Effective minimum severity of each category, see categoryIndex.
+  // Index 0 is the category of call sites exceeding maxCategories, it follows _minSeverity.
+  // Writes are guarded by _severityMutex, not _mutex: setting the severity
+  // must not wait for a consume in progress.
+  std::mutex _severityMutex;
+  std::array<std::atomic<Severity>, maxCategories> _categoryMinSeverity;
+  std::bitset<maxCategories> _categoryMinSeverityIsSet; // true if not following _minSeverity
+
   bool _consumeClockSync = true;
+  bool _overwriteMode = false;
 
   detail::VectorOutputStream _specialEntryBuffer;
+  detail::VectorOutputStream _overwriteBuffer; // copy of the data of an overwrite mode channel
 };
 
-inline Session::Channel::Channel(Session& session, std::size_t queueCapacity, WriterProp writerProp_)
+inline Session::Channel::Channel(Session& session, std::size_t queueCapacity, WriterProp writerProp_, bool overwrite)
   :writerProp(std::move(writerProp_)),
-   _queue(new char[sizeof(std::uint64_t) + sizeof(Session*) + sizeof(detail::Queue) + queueCapacity])
+   _memory(session._memory),
+   _queueSize(sizeof(std::uint64_t) + sizeof(Session*) + sizeof(detail::Queue) + queueCapacity),
+   _queue((_memory) ? _memory->allocate(_queueSize) : new char[_queueSize])
 {
   // To be able to recover unconsumed queue data from memory dumps,
   // put a magic number, a pointer to the owning session, the queue and the queue buffer
   // next to each other.
-  char* buffer = _queue.get();
+  char* buffer = _queue;
 
   // The magic number is used to indentify the queue in the memory dump
   new (buffer) std::uint64_t(0xFE213F716D34BCBC);
@@ -229,26 +443,39 @@ inline Session::Channel::Channel(Session& session, std::size_t queueCapacity, Wr
   static_assert(alignof(detail::Queue) <= alignof(std::uint64_t), "");
   static_assert(alignof(detail::Queue) <= alignof(Session*), "");
   char* queueBuffer = buffer + sizeof(detail::Queue);
-  new (buffer) detail::Queue(queueBuffer, queueCapacity);
+  new (buffer) detail::Queue(queueBuffer, queueCapacity, overwrite);
 }
 
 inline Session::Channel::~Channel()
 {
   // clear magic number - do not recover invalid data
   std::uint64_t magic = 0;
-  memcpy(_queue.get(), &magic, sizeof(magic));
+  memcpy(_queue, &magic, sizeof(magic));
 
   // destroy queue
   queue().~Queue();
+
+  if (_memory) { _memory->deallocate(_queue, _queueSize); }
+  else { delete[] _queue; }
 }
 
 inline detail::Queue& Session::Channel::queue()
 {
-  return *reinterpret_cast<detail::Queue*>(_queue.get() + sizeof(std::uint64_t) + sizeof(Session*));
+  return *reinterpret_cast<detail::Queue*>(_queue + sizeof(std::uint64_t) + sizeof(Session*));
 }
 
 inline Session::Session()
+  :Session(nullptr)
+{}
+
+inline Session::Session(std::shared_ptr<detail::MemoryResource> memory)
+  :_memory(std::move(memory))
 {
+  for (std::atomic<Severity>& severity : _categoryMinSeverity)
+  {
+    severity.store(Severity::trace, std::memory_order_relaxed);
+  }
+
   const ClockSync clockSync = systemClockSync();
   serializeSizePrefixedTagged(clockSync, _clockSync);
 }
@@ -257,7 +484,7 @@ inline std::shared_ptr<Session::Channel> Session::createChannel(std::size_t queu
 {
   std::lock_guard<std::mutex> lock(_mutex);
 
-  _channels.push_back(std::make_shared<Channel>(*this, queueCapacity, std::move(writerProp)));
+  _channels.push_back(std::make_shared<Channel>(*this, queueCapacity, std::move(writerProp), _overwriteMode));
   return _channels.back();
 }
 
@@ -275,15 +502,96 @@ inline void Session::setChannelWriterName(Channel& channel, std::string name)
   channel.writerProp.name = std::move(name);
 }
 
-inline std::uint64_t Session::addEventSource(EventSource eventSource)
+inline std::uint64_t Session::addEventSource(EventSource eventSource, std::atomic<bool>* enabled)
 {
   std::lock_guard<std::mutex> lock(_mutex);
 
   eventSource.id = _nextSourceId;
   serializeSizePrefixedTagged(eventSource, _sources);
+
+  if (enabled != nullptr)
+  {
+    bool isEnabled = true;
+    for (auto rule = _tracepointRules.rbegin(); rule != _tracepointRules.rend(); ++rule)
+    {
+      if (rule->predicate(eventSource))
+      {
+        isEnabled = rule->enabled;
+        break;
+      }
+    }
+    enabled->store(isEnabled, std::memory_order_relaxed);
+  }
+
+  _tracepoints.push_back(TracepointEntry{eventSource.id, enabled});
   return _nextSourceId++;
 }
 
+template <typename F>
+void Session::forEachTracepoint(F f)
+{
+  Range sources(_sources.data(), _sources.size());
+  for (const TracepointEntry& entry : _tracepoints)
+  {
+    const std::uint32_t size = sources.read<std::uint32_t>();
+    Range payload(sources.view(size), size);
+    payload.read<std::uint64_t>(); // tag
+
+    EventSource source;
+    mserialize::deserialize(source, payload);
+    f(std::move(source), entry);
+  }
+}
+
+inline std::vector<Session::Tracepoint> Session::tracepoints()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  std::vector<Tracepoint> result;
+  result.reserve(_tracepoints.size());
+  forEachTracepoint([&result](EventSource source, const TracepointEntry& entry)
+  {
+    const bool switchable = entry.enabled != nullptr;
+    const bool enabled = ! switchable || entry.enabled->load(std::memory_order_relaxed);
+    result.push_back(Tracepoint{std::move(source), enabled, switchable});
+  });
+
+  return result;
+}
+
+inline std::size_t Session::setTracepointsEnabled(EventSourcePredicate predicate, bool enabled, std::string ruleName)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  const auto sameName = std::find_if(_tracepointRules.begin(), _tracepointRules.end(),
+    [&ruleName](const TracepointRule& rule) { return ! ruleName.empty() && rule.name == ruleName; }
+  );
+  if (sameName == _tracepointRules.end() && _tracepointRules.size() >= maxTracepointRules)
+  {
+    throw std::runtime_error("Too many tracepoint rules, use rule names or clearTracepointRules");
+  }
+
+  std::size_t result = 0;
+  forEachTracepoint([&](const EventSource& source, const TracepointEntry& entry)
+  {
+    if (predicate(source))
+    {
+      if (entry.enabled != nullptr) { entry.enabled->store(enabled, std::memory_order_relaxed); }
+      ++result;
+    }
+  });
+
+  if (sameName != _tracepointRules.end()) { _tracepointRules.erase(sameName); }
+  _tracepointRules.push_back(TracepointRule{std::move(ruleName), std::move(predicate), enabled});
+  return result;
+}
+
+inline void Session::clearTracepointRules()
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+  _tracepointRules.clear();
+}
+
 inline Severity Session::minSeverity() const
 {
   return _minSeverity.load(std::memory_order_acquire);
@@ -291,7 +599,68 @@ inline Severity Session::minSeverity() const
 
 inline void Session::setMinSeverity(Severity severity)
 {
+  std::lock_guard<std::mutex> lock(_severityMutex);
+
   _minSeverity.store(severity, std::memory_order_release);
+
+  for (std::size_t i = 0; i < maxCategories; ++i)
+  {
+    if (! _categoryMinSeverityIsSet[i])
+    {
+      _categoryMinSeverity[i].store(severity, std::memory_order_relaxed);
+    }
+  }
+}
+
+inline std::size_t Session::categoryIndex(const std::string& category)
+{
+  static std::mutex mutex;
+  static std::vector<std::string> categories; // category i+1 is at i
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  const auto it = std::find(categories.begin(), categories.end(), category);
+  if (it != categories.end())
+  {
+    return std::size_t(it - categories.begin()) + 1;
+  }
+
+  if (categories.size() + 1 >= maxCategories) { return 0; }
+
+  categories.push_back(category);
+  return categories.size();
+}
+
+inline void Session::setCategoryMinSeverity(const std::string& category, Severity severity)
+{
+  const std::size_t index = categoryIndex(category);
+  if (index == 0)
+  {
+    throw std::runtime_error("Too many categories to set the minimum severity of: " + category);
+  }
+
+  std::lock_guard<std::mutex> lock(_severityMutex);
+
+  _categoryMinSeverityIsSet[index] = true;
+  _categoryMinSeverity[index].store(severity, std::memory_order_relaxed);
+}
+
+inline void Session::resetCategoryMinSeverity(const std::string& category)
+{
+  const std::size_t index = categoryIndex(category);
+  if (index == 0) { return; }
+
+  std::lock_guard<std::mutex> lock(_severityMutex);
+
+  _categoryMinSeverityIsSet[index] = false;
+  _categoryMinSeverity[index].store(_minSeverity.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+inline void Session::setOverwriteMode(bool overwrite)
+{
+  std::lock_guard<std::mutex> lock(_mutex);
+
+  _overwriteMode = overwrite;
 }
 
 inline void Session::setClockSync(const ClockSync& clockSync)
@@ -323,6 +692,17 @@ Session::ConsumeResult Session::consume(OutputStream& out)
   // that blocks P1 *and* P2 while adding ES123.
   std::lock_guard<std::mutex> lock(_mutex);
 
+  // Tell emergencyConsume that _channels are being modified.
+  // It cannot use _mutex: the signal handler might run on this thread.
+  struct ConsumingFlag
+  {
+    std::atomic<bool>& flag;
+    explicit ConsumingFlag(std::atomic<bool>& f) :flag(f) { flag.store(true); }
+    ~ConsumingFlag() { flag.store(false); }
+    ConsumingFlag(const ConsumingFlag&) = delete;
+    void operator=(const ConsumingFlag&) = delete;
+  } consuming(_consuming);
+
   ConsumeResult result;
 
   // add a clock sync if not yet added
@@ -354,7 +734,26 @@ Session::ConsumeResult Session::consume(OutputStream& out)
 
     detail::QueueReader reader(ch.queue());
     const detail::QueueReader::ReadResult data = reader.beginRead();
-    if (data.size())
+    if (data.size() && ch.queue().overwrite)
+    {
+      // The writer might overwrite the data while it is being read:
+      // copy it first, then consume the part that remained valid.
+      _overwriteBuffer.clear();
+      _overwriteBuffer.write(data.buffer1, std::streamsize(data.size1));
+      _overwriteBuffer.write(data.buffer2, std::streamsize(data.size2));
+
+      const std::size_t evicted = reader.endRead();
+      const std::size_t validSize = data.size() - evicted;
+      if (validSize != 0)
+      {
+        ch.writerProp.batchSize = validSize;
+        result.bytesConsumed += consumeSpecialEntry(ch.writerProp, out);
+
+        out.write(_overwriteBuffer.data() + evicted, std::streamsize(validSize));
+        result.bytesConsumed += validSize;
+      }
+    }
+    else if (data.size())
     {
       // consume writerProp entry
       ch.writerProp.batchSize = data.size();
@@ -417,6 +816,58 @@ Session::ConsumeResult Session::reconsumeMetadata(OutputStream& out)
   return result;
 }
 
+template <typename OutputStream>
+Session::ConsumeResult Session::emergencyConsume(OutputStream& out) noexcept
+{
+  // Locking _mutex is not async-signal-safe, and it is undefined behavior
+  // if this thread already holds it (e.g: it crashed in consume).
+  // Instead, give up if a consume is in progress, as it modifies _channels.
+  ConsumeResult result;
+  result.totalBytesConsumed = _totalConsumedBytes;
+  if (_consuming.load()) { return result; }
+
+  out.write(_clockSync.data(), _clockSync.ssize());
+  result.bytesConsumed += std::size_t(_clockSync.ssize());
+
+  out.write(_sources.data(), _sources.ssize());
+  result.bytesConsumed += std::size_t(_sources.ssize());
+
+  for (std::shared_ptr<Channel>& channelptr : _channels)
+  {
+    if (! channelptr) { continue; }
+
+    // do not call endRead: data remains in the queue.
+    // do not wait for the writer, if it is evicting records in overwrite mode
+    detail::QueueReader reader(channelptr->queue());
+    const detail::QueueReader::ReadResult data = reader.beginReadNoWait();
+    if (data.size())
+    {
+      // WriterProp is serialized field by field, to avoid copying the name
+      const WriterProp& writerProp = channelptr->writerProp;
+      const std::uint64_t tag = WriterProp::Tag;
+      const std::uint64_t batchSize = data.size();
+      const std::uint32_t size = std::uint32_t(mserialize::serialized_size(writerProp) + sizeof(tag));
+      mserialize::serialize(size, out);
+      mserialize::serialize(tag, out);
+      mserialize::serialize(writerProp.id, out);
+      mserialize::serialize(writerProp.name, out);
+      mserialize::serialize(batchSize, out);
+      result.bytesConsumed += sizeof(size) + size;
+
+      out.write(data.buffer1, std::streamsize(data.size1));
+      if (data.size2)
+      {
+        out.write(data.buffer2, std::streamsize(data.size2));
+      }
+      result.bytesConsumed += data.size();
+    }
+
+    result.channelsPolled++;
+  }
+
+  return result;
+}
+
 template <typename Entry, typename OutputStream>
 std::size_t Session::consumeSpecialEntry(const Entry& entry, OutputStream& out)
 {
@@ -2,14 +2,19 @@
 #define BINLOG_SESSION_WRITER_HPP
 
 #include <binlog/Session.hpp>
+#include <binlog/Severity.hpp>
+#include <binlog/detail/Queue.hpp>
 #include <binlog/detail/QueueWriter.hpp>
 
 #include <mserialize/serialize.hpp>
 
 #include <algorithm> // max
+#include <cassert>
 #include <cstddef>
-#include <memory> // shared_ptr
+#include <cstring> // memcpy
+#include <memory> // shared_ptr, unique_ptr
 #include <utility> // move
+#include <vector>
 
 namespace binlog {
 
@@ -35,7 +40,10 @@ public:
    */
   explicit SessionWriter(Session& session, std::size_t queueCapacity = 1 << 20, std::uint64_t id = {}, std::string name = {});
 
-  /** Marks the underlying channel closed. */
+  /**
+   * Marks the underlying channel closed.
+   * Events of an unfinished scope are discarded.
+   */
   ~SessionWriter() = default;
 
   SessionWriter(const SessionWriter&) = delete;
@@ -95,7 +103,8 @@ public:
    *
    * If the queue is full (it has not enough space for the event),
    * a new channel is created, suitable to hold this event,
-   * and the old one is closed.
+   * and the old one is closed. In overwrite mode (see Session::setOverwriteMode),
+   * the oldest events are evicted instead, and no new channel is created.
    *
    * @pre `eventSourceId` must be the id of an event source added to `session()`,
    *      see Session::addEventSource.
@@ -112,12 +121,83 @@ public:
   template <typename... Args>
   bool addEvent(std::uint64_t eventSourceId, std::uint64_t clock, Args&&... args) noexcept;
 
+  /**
+   * Add a log event of `severity`, see addEvent above.
+   *
+   * `severity` is not serialized (it is the severity of the event source),
+   * it is only used to track the highest severity of the scope, see scopeSeverity.
+   * This overload is called by the log macros, if available:
+   * custom writers only need to provide the one above.
+   */
+  template <typename... Args>
+  bool addEvent(Severity severity, std::uint64_t eventSourceId, std::uint64_t clock, Args&&... args) noexcept;
+
+  /**
+   * Start gathering events in a scope buffer, instead of the channel.
+   *
+   * Events added until endScope are kept by this writer,
+   * invisible to the session, until the scope is committed
+   * or discarded, e.g: depending on the outcome of a request.
+   * The scope buffer grows as needed, and it is reused by later scopes.
+   *
+   * @pre ! inScope()
+   * @throws std::bad_alloc if the first scope buffer cannot be allocated
+   */
+  void beginScope();
+
+  /**
+   * Finish the scope started by beginScope.
+   *
+   * If `commit` is true, the events of the scope are added to the channel,
+   * in a single write - consumers never see a partial scope.
+   * Otherwise, the events are discarded, in constant time.
+   *
+   * @returns false if the events were to be committed,
+   *          but the channel has no space for them, true otherwise.
+   */
+  bool endScope(bool commit) noexcept;
+
+  /** @returns true, if between beginScope and endScope */
+  bool inScope() const { return _scope && _scope->active; }
+
+  /** @returns the number of bytes gathered in the current scope */
+  std::size_t scopeSize() const;
+
+  /**
+   * @returns the highest severity of the events added by
+   *          the log macros since beginScope, or Severity::trace
+   *          if there was no such event.
+   */
+  Severity scopeSeverity() const { return _scopeSeverity; }
+
 private:
   bool replaceChannel(std::size_t minQueueCapacity) noexcept;
 
+  bool growScope(std::size_t minWriteCapacity) noexcept;
+
+  /**
+   * Events of a scope are written to `queue`,
+   * by the same QueueWriter that writes the channel otherwise.
+   * The queue is never read, therefore the data is
+   * contiguous, at [0, writeIndex).
+   */
+  struct Scope
+  {
+    explicit Scope(std::size_t capacity)
+      :buffer(capacity),
+       queue(buffer.data(), buffer.size())
+    {}
+
+    std::vector<char> buffer;
+    detail::Queue queue;
+    bool active = false;
+  };
+
   Session* _session;
   std::shared_ptr<Session::Channel> _channel;
   detail::QueueWriter _qw;
+  std::unique_ptr<Scope> _scope;
+  Severity _scopeSeverity = Severity::trace;
 };
 
 inline SessionWriter::SessionWriter(Session& session, std::size_t queueCapacity, std::uint64_t id, std::string name)
@@ -151,8 +231,11 @@ bool SessionWriter::addEvent(std::uint64_t eventSourceId, std::uint64_t clock, A
   const std::size_t totalSize = size + sizeof(std::uint32_t);
   if (! _qw.beginWrite(totalSize))
   {
-    // not enough space in queue, create a new channel
-    replaceChannel(totalSize);
+    // not enough space in queue, create a new channel (or grow the scope),
+    // unless memory usage must remain constant
+    if (inScope()) { growScope(totalSize); }
+    else if (_qw.overwrite()) { return false; }
+    else { replaceChannel(totalSize); }
     if (! _qw.beginWrite(totalSize)) { return false; }
   }
 
@@ -169,6 +252,53 @@ bool SessionWriter::addEvent(std::uint64_t eventSourceId, std::uint64_t clock, A
   return true;
 }
 
+template <typename... Args>
+bool SessionWriter::addEvent(Severity severity, std::uint64_t eventSourceId, std::uint64_t clock, Args&&... args) noexcept
+{
+  _scopeSeverity = (std::max)(_scopeSeverity, severity);
+  return addEvent(eventSourceId, clock, std::forward<Args>(args)...);
+}
+
+inline void SessionWriter::beginScope()
+{
+  assert(! inScope());
+
+  if (! _scope) { _scope.reset(new Scope(4096)); }
+
+  _scope->active = true;
+  _scopeSeverity = Severity::trace;
+  _qw = detail::QueueWriter(_scope->queue);
+}
+
+inline bool SessionWriter::endScope(bool commit) noexcept
+{
+  assert(inScope());
+
+  const std::size_t size = scopeSize();
+  _scope->active = false;
+  _scope->queue.writeIndex.store(0, std::memory_order_relaxed);
+  _scopeSeverity = Severity::trace;
+  _qw = detail::QueueWriter(_channel->queue());
+
+  if (! commit || size == 0) { return true; }
+
+  if (! _qw.beginWrite(size))
+  {
+    if (_qw.overwrite()) { return false; }
+    replaceChannel(size);
+    if (! _qw.beginWrite(size)) { return false; }
+  }
+
+  _qw.writeBuffer(_scope->buffer.data(), size);
+  _qw.endWrite();
+  return true;
+}
+
+inline std::size_t SessionWriter::scopeSize() const
+{
+  return inScope() ? _scope->queue.writeIndex.load(std::memory_order_relaxed) : 0;
+}
+
 inline bool SessionWriter::replaceChannel(std::size_t minQueueCapacity) noexcept
 {
   const std::size_t newCapacity = (std::max)(_qw.capacity(), 2 * minQueueCapacity);
@@ -190,6 +320,30 @@ inline bool SessionWriter::replaceChannel(std::size_t minQueueCapacity) noexcept
   return true;
 }
 
+inline bool SessionWriter::growScope(std::size_t minWriteCapacity) noexcept
+{
+  const std::size_t size = scopeSize();
+  const std::size_t newCapacity = (std::max)(2 * _scope->buffer.size(), size + 2 * minWriteCapacity);
+
+  try
+  {
+    std::unique_ptr<Scope> newScope(new Scope(newCapacity));
+    memcpy(newScope->buffer.data(), _scope->buffer.data(), size);
+    newScope->queue.writeIndex.store(size, std::memory_order_relaxed);
+    newScope->active = true;
+
+    _scope = std::move(newScope);
+    _qw = detail::QueueWriter(_scope->queue);
+  }
+  catch (...)
+  {
+    // see replaceChannel
+    return false;
+  }
+
+  return true;
+}
+
 } // namespace binlog
 
 #endif // BINLOG_SESSION_WRITER_HPP
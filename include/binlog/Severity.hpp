@@ -5,6 +5,18 @@
 
 #include <cstdint>
 
+/*
+ * Numeric value of each Severity, for preprocessor conditionals,
+ * e.g: BINLOG_ACTIVE_SEVERITY, see advanced_log_macros.hpp
+ */
+#define BINLOG_SEVERITY_TRACE    32
+#define BINLOG_SEVERITY_DEBUG    64
+#define BINLOG_SEVERITY_INFO     128
+#define BINLOG_SEVERITY_WARNING  256
+#define BINLOG_SEVERITY_ERROR    512
+#define BINLOG_SEVERITY_CRITICAL 1024
+#define BINLOG_SEVERITY_NO_LOGS  32768
+
 namespace binlog {
 
 enum class Severity : std::uint16_t
@@ -18,6 +30,14 @@ enum class Severity : std::uint16_t
   no_logs  = 1 << 15, // For filtering, not to create events
 };
 
+static_assert(BINLOG_SEVERITY_TRACE    == std::uint16_t(Severity::trace), "");
+static_assert(BINLOG_SEVERITY_DEBUG    == std::uint16_t(Severity::debug), "");
+static_assert(BINLOG_SEVERITY_INFO     == std::uint16_t(Severity::info), "");
+static_assert(BINLOG_SEVERITY_WARNING  == std::uint16_t(Severity::warning), "");
+static_assert(BINLOG_SEVERITY_ERROR    == std::uint16_t(Severity::error), "");
+static_assert(BINLOG_SEVERITY_CRITICAL == std::uint16_t(Severity::critical), "");
+static_assert(BINLOG_SEVERITY_NO_LOGS  == std::uint16_t(Severity::no_logs), "");
+
 inline mserialize::cx_string<4> severityToString(Severity severity)
 {
   switch (severity)
@@ -3,6 +3,7 @@
 #include <binlog/Entries.hpp> // Event
 #include <binlog/EntryStream.hpp> // RangeEntryStream
 #include <binlog/Range.hpp>
+#include <binlog/detail/OstreamBuffer.hpp>
 
 #include <utility> // move
 
@@ -17,10 +18,11 @@ TextOutputStream& TextOutputStream::write(const char* data, std::streamsize size
 {
   const Range range{data, data + size};
   RangeEntryStream entryStream(range);
+  detail::OstreamBuffer out(_out);
 
   while (const Event* event = _eventStream.nextEvent(entryStream))
   {
-    _printer.printEvent(_out, *event, _eventStream.writerProp(), _eventStream.clockSync());
+    _printer.printEvent(out, *event, _eventStream.writerProp(), _eventStream.clockSync());
   }
 
   return *this;
@@ -7,6 +7,65 @@
 
 #include <chrono>
 
+/**
+ * BINLOG_ACTIVE_SEVERITY
+ *
+ * Compile time minimum severity of the BINLOG_<SEVERITY>* macros
+ * (including the ones in basic_log_macros.hpp).
+ * Log macros of lower severity do not generate any code,
+ * do not add event sources, and do not evaluate their arguments,
+ * but their arguments are still checked (in unevaluated context)
+ * to be loggable and to match the format string.
+ *
+ * Must be defined before including any binlog header,
+ * consistently in each translation unit, e.g:
+ *
+ *     -DBINLOG_ACTIVE_SEVERITY=BINLOG_SEVERITY_INFO
+ *
+ * The value is one of the BINLOG_SEVERITY_<SEVERITY> constants of Severity.hpp.
+ * By default, every severity is active, and controlled at runtime only,
+ * see Session::setMinSeverity.
+ */
+#ifndef BINLOG_ACTIVE_SEVERITY
+  #define BINLOG_ACTIVE_SEVERITY BINLOG_SEVERITY_TRACE
+#endif
+
+#if BINLOG_ACTIVE_SEVERITY <= BINLOG_SEVERITY_TRACE
+  #define BINLOG_DETAIL_IF_TRACE_ACTIVE BINLOG_CREATE_SOURCE_AND_EVENT_IF
+#else
+  #define BINLOG_DETAIL_IF_TRACE_ACTIVE BINLOG_CHECK_SOURCE_AND_EVENT
+#endif
+
+#if BINLOG_ACTIVE_SEVERITY <= BINLOG_SEVERITY_DEBUG
+  #define BINLOG_DETAIL_IF_DEBUG_ACTIVE BINLOG_CREATE_SOURCE_AND_EVENT_IF
+#else
+  #define BINLOG_DETAIL_IF_DEBUG_ACTIVE BINLOG_CHECK_SOURCE_AND_EVENT
+#endif
+
+#if BINLOG_ACTIVE_SEVERITY <= BINLOG_SEVERITY_INFO
+  #define BINLOG_DETAIL_IF_INFO_ACTIVE BINLOG_CREATE_SOURCE_AND_EVENT_IF
+#else
+  #define BINLOG_DETAIL_IF_INFO_ACTIVE BINLOG_CHECK_SOURCE_AND_EVENT
+#endif
+
+#if BINLOG_ACTIVE_SEVERITY <= BINLOG_SEVERITY_WARNING
+  #define BINLOG_DETAIL_IF_WARN_ACTIVE BINLOG_CREATE_SOURCE_AND_EVENT_IF
+#else
+  #define BINLOG_DETAIL_IF_WARN_ACTIVE BINLOG_CHECK_SOURCE_AND_EVENT
+#endif
+
+#if BINLOG_ACTIVE_SEVERITY <= BINLOG_SEVERITY_ERROR
+  #define BINLOG_DETAIL_IF_ERROR_ACTIVE BINLOG_CREATE_SOURCE_AND_EVENT_IF
+#else
+  #define BINLOG_DETAIL_IF_ERROR_ACTIVE BINLOG_CHECK_SOURCE_AND_EVENT
+#endif
+
+#if BINLOG_ACTIVE_SEVERITY <= BINLOG_SEVERITY_CRITICAL
+  #define BINLOG_DETAIL_IF_CRITICAL_ACTIVE BINLOG_CREATE_SOURCE_AND_EVENT_IF
+#else
+  #define BINLOG_DETAIL_IF_CRITICAL_ACTIVE BINLOG_CHECK_SOURCE_AND_EVENT
+#endif
+
 /**
  * BINLOG_<SEVERITY>_WC(writer, category, format, args...)
  *
@@ -20,6 +79,7 @@
  * The event is timestamped using std::chrono::system_clock.
  * If <SEVERITY> is below the minimum severity configured
  * for `writer`, no event is created, the arguments are not evaluated.
+ * If <SEVERITY> is below BINLOG_ACTIVE_SEVERITY, no code is generated.
  *
  * @param writer binlog::SessionWriter
  * @param category arbitrary valid symbol name
@@ -28,7 +88,7 @@
  */
 
 #define BINLOG_TRACE_WC(writer, category, ...)                                  \
-  BINLOG_CREATE_SOURCE_AND_EVENT_IF(                                            \
+  BINLOG_DETAIL_IF_TRACE_ACTIVE(                                                \
     writer, binlog::Severity::trace, category,                                  \
     binlog::clockNow(),                                                         \
     __VA_ARGS__                                                                 \
@@ -36,7 +96,7 @@
   /**/
 
 #define BINLOG_DEBUG_WC(writer, category, ...)                                  \
-  BINLOG_CREATE_SOURCE_AND_EVENT_IF(                                            \
+  BINLOG_DETAIL_IF_DEBUG_ACTIVE(                                                \
     writer, binlog::Severity::debug, category,                                  \
     binlog::clockNow(),                                                         \
     __VA_ARGS__                                                                 \
@@ -44,7 +104,7 @@
   /**/
 
 #define BINLOG_INFO_WC(writer, category, ...)                                   \
-  BINLOG_CREATE_SOURCE_AND_EVENT_IF(                                            \
+  BINLOG_DETAIL_IF_INFO_ACTIVE(                                                 \
     writer, binlog::Severity::info, category,                                   \
     binlog::clockNow(),                                                         \
     __VA_ARGS__                                                                 \
@@ -52,7 +112,7 @@
   /**/
 
 #define BINLOG_WARN_WC(writer, category, ...)                                   \
-  BINLOG_CREATE_SOURCE_AND_EVENT_IF(                                            \
+  BINLOG_DETAIL_IF_WARN_ACTIVE(                                                 \
     writer, binlog::Severity::warning, category,                                \
     binlog::clockNow(),                                                         \
     __VA_ARGS__                                                                 \
@@ -60,7 +120,7 @@
   /**/
 
 #define BINLOG_ERROR_WC(writer, category, ...)                                  \
-  BINLOG_CREATE_SOURCE_AND_EVENT_IF(                                            \
+  BINLOG_DETAIL_IF_ERROR_ACTIVE(                                                \
     writer, binlog::Severity::error, category,                                  \
     binlog::clockNow(),                                                         \
     __VA_ARGS__                                                                 \
@@ -68,7 +128,7 @@
   /**/
 
 #define BINLOG_CRITICAL_WC(writer, category, ...)                               \
-  BINLOG_CREATE_SOURCE_AND_EVENT_IF(                                            \
+  BINLOG_DETAIL_IF_CRITICAL_ACTIVE(                                             \
     writer, binlog::Severity::critical, category,                               \
     binlog::clockNow(),                                                         \
     __VA_ARGS__                                                                 \
@@ -3,6 +3,7 @@
 
 #include <binlog/Session.hpp>
 #include <binlog/SessionWriter.hpp>
+#include <binlog/Severity.hpp>
 
 #include <mserialize/cx_string.hpp>
 #include <mserialize/detail/preprocessor.hpp>
@@ -24,6 +25,9 @@
  * the added event source with `clock` and `args...` to `writer`.
  * @see SessionWriter::addEvent.
  *
+ * The call site can be disabled at runtime, see Session::setTracepointsEnabled.
+ * A disabled call site does not add events, and does not evaluate `args...`.
+ *
  * @param writer binlog::SessionWriter
  * @param severity binlog::Severity
  * @param category arbitrary valid symbol name
@@ -43,29 +47,63 @@
       "Number of {} placeholders in format string must match number of arugments"            \
     );                                                                                       \
     static std::atomic<std::uint64_t> _binlog_sid{0};                                        \
+    static std::atomic<bool> _binlog_enabled{true};                                          \
     std::uint64_t _binlog_sid_v = _binlog_sid.load(std::memory_order_relaxed);               \
     if (_binlog_sid_v == 0)                                                                  \
     {                                                                                        \
       _binlog_sid_v = writer.session().addEventSource(binlog::EventSource{                   \
         0, severity, #category, __func__, __FILE__, std::uint64_t(__LINE__), MSERIALIZE_FIRST(__VA_ARGS__), /* NOLINT */ \
-        binlog::detail::concatenated_tags(__VA_ARGS__).data()                                /* NOLINT */ \
-      });                                                                                    \
+        decltype(binlog::detail::concatenated_tags(__VA_ARGS__))::value().data()             /* NOLINT */ \
+      }, &_binlog_enabled);                                                                  \
       _binlog_sid.store(_binlog_sid_v);                                                      \
     }                                                                                        \
-    binlog::detail::addEventIgnoreFirst(writer, _binlog_sid_v, clock, __VA_ARGS__);          \
+    if (_binlog_enabled.load(std::memory_order_relaxed))                                     \
+    {                                                                                        \
+      binlog::detail::addEventIgnoreFirst(writer, severity, _binlog_sid_v, clock, __VA_ARGS__); \
+    }                                                                                        \
+  } while (false)                                                                            \
+  /**/
+
+/**
+ * BINLOG_CHECK_SOURCE_AND_EVENT(writer, severity, category, clock, format, args...)
+ *
+ * Check the arguments as BINLOG_CREATE_SOURCE_AND_EVENT does at compile time,
+ * but do nothing at runtime: no event source, no event is added to `writer`,
+ * the arguments are not evaluated, and no code is generated.
+ *
+ * Used by the log macros of severities below BINLOG_ACTIVE_SEVERITY,
+ * to keep them compiling, even if disabled.
+ *
+ * @see BINLOG_CREATE_SOURCE_AND_EVENT
+ */
+#define BINLOG_CHECK_SOURCE_AND_EVENT(writer, severity, category, clock, /* format, */ ...)  \
+  do {                                                                                       \
+    static_assert(                                                                           \
+      binlog::detail::count_placeholders(MSERIALIZE_FIRST(__VA_ARGS__))+1 ==                 \
+      decltype(binlog::detail::count_arguments(__VA_ARGS__))::value,                         \
+      "Number of {} placeholders in format string must match number of arugments"            \
+    );                                                                                       \
+    static_assert(sizeof(binlog::detail::checkEvent(                                         \
+      writer.session(), severity, clock,                                                     \
+      decltype(binlog::detail::concatenated_tags(__VA_ARGS__))::value()                      \
+    )) != 0, "");                                                                            \
   } while (false)                                                                            \
   /**/
 
 namespace binlog {
 namespace detail {
 
+template <typename... T>
+struct ConcatenatedTags
+{
+  static constexpr auto value() { return mserialize::cx_strcat(mserialize::tag<T>()...); }
+};
+
 // The first argument is dropped because __VA_ARGS__ cannot be empty,
 // therefore it is always combined with something unrelated.
+// Used in unevaluated context only, to not evaluate the log arguments.
 template <typename Unused, typename... T>
-constexpr auto concatenated_tags(Unused&&, T&&...)
-{
-  return mserialize::cx_strcat(mserialize::tag<T>()...);
-}
+constexpr ConcatenatedTags<T...> concatenated_tags(Unused&&, T&&...) { return {}; } // Implementation should be omitted but cannot be on MSVC
 
 /** @return the number of "{}" substrings in `str` */
 constexpr std::size_t count_placeholders(const char* str)
@@ -87,12 +125,33 @@ template <typename... T>
 constexpr std::integral_constant<std::size_t, sizeof...(T)>
 count_arguments(T&&...) { return {}; } // Implementation should be omitted but cannot be on MSVC
 
+// Used in unevaluated context only, by BINLOG_CHECK_SOURCE_AND_EVENT
+template <std::size_t N>
+char checkEvent(Session&, Severity, std::uint64_t, mserialize::cx_string<N>) { return {}; } // Implementation should be omitted but cannot be on MSVC
+
+// Writers that track the severity of their events (e.g: SessionWriter, see scopeSeverity)
+// get it as the first argument, other writers are only required to provide
+// addEvent(eventSourceId, clock, args...). The int/long tag prefers the former.
+template <typename Writer, typename... T>
+auto addEventWithSeverity(int, Writer& writer, Severity severity, std::uint64_t eventSourceId, std::uint64_t clock, T&&... t)
+  -> decltype(writer.addEvent(severity, eventSourceId, clock, std::forward<T>(t)...))
+{
+  return writer.addEvent(severity, eventSourceId, clock, std::forward<T>(t)...);
+}
+
+template <typename Writer, typename... T>
+auto addEventWithSeverity(long, Writer& writer, Severity /* severity */, std::uint64_t eventSourceId, std::uint64_t clock, T&&... t)
+  -> decltype(writer.addEvent(eventSourceId, clock, std::forward<T>(t)...))
+{
+  return writer.addEvent(eventSourceId, clock, std::forward<T>(t)...);
+}
+
 // The first argument is dropped because __VA_ARGS__ cannot be empty,
 // therefore it is always combined with something unrelated.
 template <typename Writer, typename Unused, typename... T>
-void addEventIgnoreFirst(Writer& writer, std::uint64_t eventSourceId, std::uint64_t clock, Unused&&, T&&... t)
+void addEventIgnoreFirst(Writer& writer, Severity severity, std::uint64_t eventSourceId, std::uint64_t clock, Unused&&, T&&... t)
 {
-  writer.addEvent(eventSourceId, clock, std::forward<T>(t)...);
+  addEventWithSeverity(0, writer, severity, eventSourceId, clock, std::forward<T>(t)...);
 }
 
 } // namespace detail
@@ -5,20 +5,27 @@
 #include <binlog/SessionWriter.hpp>
 #include <binlog/create_source_and_event.hpp>
 
+#include <cstddef>
+
 /**
  * Call BINLOG_CREATE_SOURCE_AND_EVENT with the given
  * arguments if `severity` >= the minimum severity
- * configured for `writer`.
+ * configured for `category` in the session of `writer`
+ * (see Session::setCategoryMinSeverity and Session::setMinSeverity).
  *
  * If `severity` is below the configured minimum severity,
  * no event will be created, and the event arguments
  * will not be evaluated.
  *
+ * The category is resolved to a Session::categoryIndex once per call site,
+ * the minimum severity is checked by a single relaxed load.
+ *
  * @see BINLOG_CREATE_SOURCE_AND_EVENT
  */
 #define BINLOG_CREATE_SOURCE_AND_EVENT_IF(writer, severity, category, clock, ...)     \
   do {                                                               \
-    if (severity >= writer.session().minSeverity())                  \
+    static const std::size_t _binlog_category = binlog::Session::categoryIndex(#category); \
+    if (severity >= writer.session().categoryMinSeverity(_binlog_category)) \
     {                                                                \
       BINLOG_CREATE_SOURCE_AND_EVENT(writer, severity, category, clock, __VA_ARGS__); \
     }                                                                \
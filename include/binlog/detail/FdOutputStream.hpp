@@ -0,0 +1,58 @@
+#ifndef BINLOG_DETAIL_FD_OUTPUT_STREAM_HPP
+#define BINLOG_DETAIL_FD_OUTPUT_STREAM_HPP
+
+#include <cstddef>
+#include <ios> // streamsize
+
+#ifdef _WIN32
+  #include <io.h> // _write
+#else // assume POSIX
+  #include <cerrno>
+  #include <unistd.h> // write
+#endif
+
+namespace binlog {
+namespace detail {
+
+/**
+ * Writes a file descriptor, without allocation or buffering.
+ *
+ * Retries interrupted and partial writes, stops at the first error.
+ * Async-signal-safe on POSIX, suitable to be used in signal handlers.
+ *
+ * Models mserialize::OutputStream.
+ */
+struct FdOutputStream
+{
+  int fd;
+  std::size_t written = 0; /**< Number of bytes successfully written */
+  bool failed = false;     /**< True, if a write failed */
+
+  explicit FdOutputStream(int fd_) :fd(fd_) {}
+
+  FdOutputStream& write(const char* buffer, std::streamsize size)
+  {
+    std::size_t remaining = std::size_t(size);
+    while (remaining != 0 && ! failed)
+    {
+#ifdef _WIN32
+      const unsigned chunk = unsigned(remaining < (1u << 30) ? remaining : (1u << 30));
+      const int result = _write(fd, buffer, chunk);
+#else
+      const ssize_t result = ::write(fd, buffer, remaining);
+      if (result < 0 && errno == EINTR) { continue; }
+#endif
+      if (result <= 0) { failed = true; break; }
+
+      buffer += result;
+      remaining -= std::size_t(result);
+      written += std::size_t(result);
+    }
+    return *this;
+  }
+};
+
+} // namespace detail
+} // namespace binlog
+
+#endif // BINLOG_DETAIL_FD_OUTPUT_STREAM_HPP
@@ -0,0 +1,46 @@
+#ifndef BINLOG_DETAIL_MEMORY_RESOURCE_HPP
+#define BINLOG_DETAIL_MEMORY_RESOURCE_HPP
+
+#include <cstddef>
+
+namespace binlog {
+namespace detail {
+
+/**
+ * Provides memory for the recoverable buffers of a Session:
+ * the channel queues and the metadata buffers.
+ *
+ * Similar to std::pmr::memory_resource.
+ * Allocated blocks are aligned at least to alignof(std::max_align_t).
+ * Implementations must be thread-safe.
+ */
+class MemoryResource
+{
+public:
+  MemoryResource() = default;
+  virtual ~MemoryResource() = default;
+
+  MemoryResource(const MemoryResource&) = delete;
+  void operator=(const MemoryResource&) = delete;
+
+  MemoryResource(MemoryResource&&) = delete;
+  void operator=(MemoryResource&&) = delete;
+
+  /**
+   * @returns a block of at least `size` bytes
+   * @throws std::runtime_error if the allocation fails
+   */
+  virtual char* allocate(std::size_t size) = 0;
+
+  /**
+   * Release `block`, previously returned by allocate(size).
+   *
+   * @pre `block` was returned by allocate(size), and not yet deallocated
+   */
+  virtual void deallocate(char* block, std::size_t size) noexcept = 0;
+};
+
+} // namespace detail
+} // namespace binlog
+
+#endif // BINLOG_DETAIL_MEMORY_RESOURCE_HPP
@@ -1,19 +1,123 @@
 #include <binlog/detail/OstreamBuffer.hpp>
 
 #include <cassert>
-#include <cinttypes>
+#include <cmath> // signbit
 #include <cstdio>
 #include <cstring>
 
+#if __cplusplus >= 201703L
+  #include <charconv>
+#endif
+
+#ifdef _WIN32
+  #include <io.h> // _write
+#else // assume POSIX
+  #include <cerrno>
+  #include <sys/uio.h> // writev
+  #include <unistd.h> // write, sysconf
+#endif
+
+namespace {
+
+// "00", "01", ..., "99"
+const char g_digitPairs[201] =
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+std::size_t pageSize()
+{
+#ifdef _WIN32
+  return 4096;
+#else
+  const long result = sysconf(_SC_PAGESIZE);
+  return (result > 0) ? std::size_t(result) : 4096;
+#endif
+}
+
+/** @returns the number of decimal digits of `v` */
+std::size_t digitCount(std::uint64_t v)
+{
+  std::size_t result = 1;
+  while (true)
+  {
+    if (v < 10) { return result; }
+    if (v < 100) { return result + 1; }
+    if (v < 1000) { return result + 2; }
+    if (v < 10000) { return result + 3; }
+    v /= 10000;
+    result += 4;
+  }
+}
+
+/**
+ * Write `v` in decimal, ending right before `end`,
+ * two digits at a time.
+ *
+ * @pre [end - digitCount(v), end) is writable
+ */
+void writeDigitsBackwards(std::uint64_t v, char* end)
+{
+  while (v >= 100)
+  {
+    const std::size_t i = std::size_t(v % 100) * 2;
+    v /= 100;
+    end -= 2;
+    end[0] = g_digitPairs[i];
+    end[1] = g_digitPairs[i + 1];
+  }
+
+  if (v >= 10)
+  {
+    const std::size_t i = std::size_t(v) * 2;
+    end[-2] = g_digitPairs[i];
+    end[-1] = g_digitPairs[i + 1];
+  }
+  else
+  {
+    end[-1] = char('0' + v);
+  }
+}
+
+} // namespace
+
 namespace binlog {
 namespace detail {
 
 OstreamBuffer::OstreamBuffer(std::ostream& out)
-  :_out(out),
+  :_out(&out),
+   _fd(-1),
+   _fdFailed(false),
    _buf{},
-   _p(_buf.data())
+   _begin(_buf.data()),
+   _end(_buf.data() + _buf.size()),
+   _p(_begin)
 {}
 
+OstreamBuffer::OstreamBuffer(int fd, std::size_t bufferSize)
+  :_out(nullptr),
+   _fd(fd),
+   _fdFailed(false),
+   _buf{},
+   _begin(nullptr),
+   _end(nullptr),
+   _p(nullptr)
+{
+  assert(bufferSize >= _buf.size());
+
+  // page aligned buffer, to let the kernel
+  // move complete pages if it is able to
+  const std::size_t alignment = pageSize();
+  _fdBuf.reset(new char[bufferSize + alignment]);
+  const std::uintptr_t address = reinterpret_cast<std::uintptr_t>(_fdBuf.get());
+  const std::size_t misalignment = std::size_t(address % alignment);
+  _begin = _fdBuf.get() + (misalignment != 0 ? alignment - misalignment : 0);
+  _end = _begin + bufferSize;
+  _p = _begin;
+}
+
 OstreamBuffer::~OstreamBuffer()
 {
   flush();
@@ -27,9 +131,19 @@ void OstreamBuffer::put(char c)
 
 void OstreamBuffer::write(const char* buf, std::size_t size)
 {
+  const std::size_t capacity = std::size_t(_end - _begin);
+
+  if (_out == nullptr && size >= capacity)
+  {
+    // large write: write the buffer and `buf` at once, without copying
+    writeFd(_begin, std::size_t(_p - _begin), buf, size);
+    _p = _begin;
+    return;
+  }
+
   while (size != 0)
   {
-    const std::size_t wsize = (std::min)(size, _buf.size());
+    const std::size_t wsize = (std::min)(size, capacity);
     reserve(wsize);
     memcpy(_p, buf, wsize);
     _p += wsize;
@@ -46,8 +160,24 @@ OstreamBuffer& OstreamBuffer::operator<<(bool b)
 
 OstreamBuffer& OstreamBuffer::operator<<(double v)
 {
+  // Integral values (e.g: prices, quantities) are common, and
+  // %.16g prints them as integers if they have at most 16 digits.
+  // -0 is excluded, as it is printed with its sign.
+  if (v == std::trunc(v) && std::fabs(v) < 1e15 && !(v == 0 && std::signbit(v)))
+  {
+    writeSigned(std::int64_t(v));
+    return *this;
+  }
+
   reserve(64);
+
+#if __cplusplus >= 201703L && defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+  // same as %.16g, without parsing the format and locale lookup
+  _p = std::to_chars(_p, _p + 64, v, std::chars_format::general, 16).ptr;
+#else
   _p += snprintf(_p, 64, "%.16g", v);
+#endif
+
   return *this;
 }
 
@@ -60,23 +190,34 @@ OstreamBuffer& OstreamBuffer::operator<<(long double v)
 
 void OstreamBuffer::writeSigned(std::int64_t v)
 {
-  // TODO(benedek) perf: use a faster than printf int-to-string solution
   reserve(32);
-  _p += snprintf(_p, 32, "%" PRId64, v);
+
+  std::uint64_t u = std::uint64_t(v);
+  if (v < 0)
+  {
+    *_p++ = '-';
+    u = 0 - u; // well defined for INT64_MIN
+  }
+
+  const std::size_t n = digitCount(u);
+  writeDigitsBackwards(u, _p + n);
+  _p += n;
 }
 
 void OstreamBuffer::writeUnsigned(std::uint64_t v)
 {
-  // TODO(benedek) perf: use a faster than printf uint-to-string solution
   reserve(32);
-  _p += snprintf(_p, 32, "%" PRIu64, v);
+
+  const std::size_t n = digitCount(v);
+  writeDigitsBackwards(v, _p + n);
+  _p += n;
 }
 
 void OstreamBuffer::reserve(std::size_t n)
 {
-  assert(n <= _buf.size());
+  assert(n <= std::size_t(_end - _begin));
 
-  if (std::size_t(_p - _buf.data()) + n > _buf.size())
+  if (n > std::size_t(_end - _p))
   {
     flush();
   }
@@ -84,8 +225,77 @@ void OstreamBuffer::reserve(std::size_t n)
 
 void OstreamBuffer::flush()
 {
-  _out.write(_buf.data(), _p - _buf.data());
-  _p = _buf.data();
+  if (_out != nullptr)
+  {
+    _out->write(_begin, _p - _begin);
+  }
+  else
+  {
+    writeFd(_begin, std::size_t(_p - _begin), nullptr, 0);
+  }
+
+  _p = _begin;
+}
+
+bool OstreamBuffer::good() const
+{
+  return (_out != nullptr) ? _out->good() : !_fdFailed;
+}
+
+void OstreamBuffer::writeFd(const char* buf1, std::size_t size1, const char* buf2, std::size_t size2)
+{
+  if (_fdFailed) { return; }
+
+#ifdef _WIN32
+  const char* bufs[2] = {buf1, buf2};
+  std::size_t sizes[2] = {size1, size2};
+  for (int i = 0; i < 2; ++i)
+  {
+    while (sizes[i] != 0)
+    {
+      const unsigned chunk = unsigned((std::min)(sizes[i], std::size_t(1) << 30));
+      const int written = _write(_fd, bufs[i], chunk);
+      if (written <= 0) { _fdFailed = true; return; }
+      bufs[i] += written;
+      sizes[i] -= std::size_t(written);
+    }
+  }
+#else
+  iovec iov[2];
+  iov[0].iov_base = const_cast<char*>(buf1); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+  iov[0].iov_len = size1;
+  iov[1].iov_base = const_cast<char*>(buf2); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+  iov[1].iov_len = size2;
+
+  iovec* first = (size1 != 0) ? &iov[0] : &iov[1];
+  int count = (size1 != 0) ? 2 : 1;
+  if (size2 == 0) { --count; }
+
+  while (count != 0)
+  {
+    const ssize_t written = writev(_fd, first, count);
+    if (written < 0)
+    {
+      if (errno == EINTR) { continue; }
+      _fdFailed = true;
+      return;
+    }
+
+    // partial write: skip the written bytes
+    std::size_t remaining = std::size_t(written);
+    while (count != 0 && remaining >= first->iov_len)
+    {
+      remaining -= first->iov_len;
+      ++first;
+      --count;
+    }
+    if (count != 0)
+    {
+      first->iov_base = static_cast<char*>(first->iov_base) + remaining;
+      first->iov_len -= remaining;
+    }
+  }
+#endif
 }
 
 } // namespace detail
@@ -4,7 +4,9 @@
 #include <mserialize/string_view.hpp>
 
 #include <array>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <ostream>
 
 namespace binlog {
@@ -26,11 +28,29 @@ namespace detail {
  * The number-to-string operations are
  * more efficient than the equivalent
  * ostream formatted operations.
+ *
+ * Alternatively, the underlying device can be
+ * a file descriptor, e.g: stdout. In this case,
+ * the buffer is larger, page aligned, and it is flushed by
+ * write system calls, bypassing the streambuf machinery.
  */
 class OstreamBuffer
 {
 public:
   explicit OstreamBuffer(std::ostream& out);
+
+  /**
+   * Write `fd`, using a buffer of `bufferSize` bytes.
+   *
+   * Interrupted and partial writes are retried.
+   * If writing fails otherwise, the remaining output is dropped,
+   * and good() returns false. `fd` is not closed by *this.
+   *
+   * @pre `fd` is a valid file descriptor, open for writing
+   * @pre bufferSize >= 1024
+   */
+  explicit OstreamBuffer(int fd, std::size_t bufferSize = 1 << 16);
+
   ~OstreamBuffer();
 
   OstreamBuffer(const OstreamBuffer&) = delete;
@@ -78,15 +98,29 @@ public:
 
   void flush();
 
+  /**
+   * @returns false if writing the underlying
+   *          ostream or file descriptor failed.
+   */
+  bool good() const;
+
 private:
   void writeSigned(std::int64_t);
   void writeUnsigned(std::uint64_t);
 
-  /** @pre n <= _buf.size() */
+  /** @pre n <= capacity of the buffer */
   void reserve(std::size_t n);
 
-  std::ostream& _out;
-  std::array<char, 1024> _buf;
+  /** Write [buf1, buf1+size1) and [buf2, buf2+size2) to _fd */
+  void writeFd(const char* buf1, std::size_t size1, const char* buf2, std::size_t size2);
+
+  std::ostream* _out;   // underlying device, if not _fd
+  int _fd;              // underlying device, if not _out, -1 otherwise
+  bool _fdFailed;       // true if writing _fd failed
+  std::array<char, 1024> _buf; // buffer if _out is set
+  std::unique_ptr<char[]> _fdBuf; // buffer storage if _fd is set, _begin is aligned in it
+  char* _begin;
+  char* _end;
   char* _p;
 };
 
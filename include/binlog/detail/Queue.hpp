@@ -89,6 +89,31 @@ namespace detail {
  * The writer continues writing the beginning of the queue.
  * The reader will notice that E is reached, so it will
  * also wrap around, starting again from the beginning.
+ *
+ * Overwrite mode:
+ *
+ * By default, a write fails if the queue is full.
+ * In overwrite mode, the writer evicts the oldest data instead,
+ * making the queue suitable for black-box tracing (the reader
+ * reads the queue rarely, only when the recent history is needed).
+ * In this mode, each write must consist of complete records,
+ * each record is prefixed by its size, as an uint32_t,
+ * excluding the size of the prefix (like binlog entries).
+ *
+ * The writer evicts complete records, by moving R forward,
+ * therefore R always points to the oldest complete record,
+ * even after a wrap around. Both the writer and the reader
+ * move R, by compare-exchange. Evicted bytes are counted by
+ * the writer in `evictedBytes`. A reader can detect whether the
+ * data it read was overwritten by comparing `evictedBytes`
+ * before and after the read: the difference is the number of bytes
+ * at the beginning of the read data that are no longer valid.
+ * R, E and `evictedBytes` are changed by the writer between
+ * an odd and an even `evictSeq` (sequence lock), to let the reader
+ * take a consistent snapshot.
+ *
+ * Records larger than (capacity - 1) / 2 might not fit,
+ * even if every other record is evicted.
  */
 struct Queue
 {
@@ -97,12 +122,15 @@ struct Queue
    *
    * @pre [buffer,buffer+capacity) must be valid
    */
-  explicit Queue(char* buffer_, std::size_t capacity_)
+  explicit Queue(char* buffer_, std::size_t capacity_, bool overwrite_ = false)
     :writeIndex(0),
      dataEnd(0),
      capacity(capacity_),
      buffer(buffer_),
-     readIndex(0)
+     readIndex(0),
+     overwrite(overwrite_),
+     evictSeq(0),
+     evictedBytes(0)
   {}
 
   // members written by Writer
@@ -111,8 +139,13 @@ struct Queue
   std::size_t capacity;                /**< Buffer size */
   char* buffer;                        /**< Unmanaged underlying buffer */
 
-  // members written by Reader
+  // members written by Reader (and by Writer, in overwrite mode)
   std::atomic<std::size_t> readIndex;  /**< Next index to read */
+
+  // members used in overwrite mode only, written by Writer
+  bool overwrite;                         /**< Evict the oldest records if full */
+  std::atomic<std::size_t> evictSeq;      /**< Odd while R, E or evictedBytes is being changed */
+  std::atomic<std::size_t> evictedBytes;  /**< Total number of bytes evicted */
 };
 
 } // namespace detail
@@ -3,8 +3,10 @@
 
 #include <binlog/detail/Queue.hpp>
 
+#include <algorithm> // min
 #include <atomic>
 #include <cstring> // memcpy
+#include <thread> // yield
 
 namespace binlog {
 namespace detail {
@@ -39,13 +41,111 @@ public:
    * If the first buffer is empty, the queue was empty,
    * if the second part is empty, there was no wrap-around.
    *
+   * In overwrite mode, the writer might overwrite the returned
+   * data concurrently: the data must be copied first,
+   * and the result of endRead tells which part of the copy is valid.
+   * If the writer is evicting records at the time of the call,
+   * waits until the eviction completes.
+   *
    * @returns A two-buffer view of the readable data
    */
   ReadResult beginRead()
+  {
+    if (! _queue->overwrite)
+    {
+      const std::size_t w = _queue->writeIndex.load(std::memory_order_acquire);
+      const std::size_t r = _queue->readIndex.load(std::memory_order_relaxed);
+      return view(w, r);
+    }
+
+    while (true)
+    {
+      const std::size_t seq = _queue->evictSeq.load(std::memory_order_acquire);
+      if ((seq & 1) == 0)
+      {
+        const std::size_t w = _queue->writeIndex.load(std::memory_order_acquire);
+        const std::size_t r = _queue->readIndex.load(std::memory_order_relaxed);
+        _evictedBytes = _queue->evictedBytes.load(std::memory_order_relaxed);
+        const ReadResult result = view(w, r);
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (_queue->evictSeq.load(std::memory_order_relaxed) == seq)
+        {
+          _readSize = result.size();
+          return result;
+        }
+      }
+
+      std::this_thread::yield();
+    }
+  }
+
+  /**
+   * Same as beginRead, but does not wait for a concurrent eviction
+   * to complete. In overwrite mode, if the queue is written concurrently,
+   * the result might be inconsistent. Does not allow endRead.
+   *
+   * Suitable if the writer is not running, e.g: in a crash handler,
+   * or to read a memory dump.
+   */
+  ReadResult beginReadNoWait()
   {
     const std::size_t w = _queue->writeIndex.load(std::memory_order_acquire);
     const std::size_t r = _queue->readIndex.load(std::memory_order_relaxed);
+    return view(w, r);
+  }
 
+  /**
+   * Make the consumed parts of the internal buffer available to write.
+   *
+   * @returns the number of bytes at the beginning of the data
+   *          returned by beginRead, that were evicted (and possibly overwritten)
+   *          by the writer since beginRead. It is always 0, if not in overwrite mode.
+   *          Otherwise, it is always at the beginning of a record.
+   */
+  std::size_t endRead()
+  {
+    if (! _queue->overwrite)
+    {
+      _queue->readIndex.store(_readEnd, std::memory_order_release);
+      return 0;
+    }
+
+    // the data must be read before `evictedBytes` is checked
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    std::size_t evicted = 0;
+    while (true)
+    {
+      const std::size_t seq = _queue->evictSeq.load(std::memory_order_acquire);
+      if ((seq & 1) != 0)
+      {
+        std::this_thread::yield();
+        continue;
+      }
+
+      std::size_t r = _queue->readIndex.load(std::memory_order_relaxed);
+      evicted = _queue->evictedBytes.load(std::memory_order_relaxed) - _evictedBytes;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (_queue->evictSeq.load(std::memory_order_relaxed) != seq) { continue; }
+
+      // the writer evicted everything read, and maybe more: leave R as is
+      if (evicted >= _readSize) { break; }
+
+      // otherwise R is in the read data: move it to the end.
+      // If the writer moves R concurrently, try again.
+      if (_queue->readIndex.compare_exchange_strong(r, _readEnd, std::memory_order_release, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+
+    return (std::min)(evicted, _readSize);
+  }
+
+private:
+  ReadResult view(std::size_t w, std::size_t r)
+  {
     _readEnd = w;
 
     if (r <= w)  // [...R######W...]
@@ -53,10 +153,11 @@ public:
       return ReadResult{buffer() + r, w - r, nullptr, 0};
     }
 
-    if (r < _queue->dataEnd)  // [###W...R###E..]
+    const std::size_t dataEnd = _queue->dataEnd;
+    if (r < dataEnd)  // [###W...R###E..]
     {
       return ReadResult{
-        buffer() + r, _queue->dataEnd - r,
+        buffer() + r, dataEnd - r,
         buffer(), w
       };
     }
@@ -65,17 +166,14 @@ public:
     return ReadResult{buffer(), w, nullptr, 0};
   }
 
-  /** Make the consumed parts of the internal buffer available to write. */
-  void endRead()
-  {
-    _queue->readIndex.store(_readEnd, std::memory_order_release);
-  }
-
-private:
   char* buffer() { return _queue->buffer; }
 
   Queue* _queue;
   std::size_t _readEnd = 0;
+
+  // overwrite mode only
+  std::size_t _readSize = 0;     // number of bytes returned by beginRead
+  std::size_t _evictedBytes = 0; // Queue::evictedBytes at beginRead
 };
 
 } // namespace detail
@@ -29,6 +29,9 @@ public:
   /** @returns the maximum number of bytes the queue can store */
   std::size_t capacity() const { return _queue->capacity; }
 
+  /** @returns true, if the oldest records are evicted when the queue is full */
+  bool overwrite() const { return _queue->overwrite; }
+
   /** @returns the number of bytes currently available for write */
   std::size_t writeCapacity() const
   {
@@ -54,13 +57,16 @@ public:
    * (those without a subsequent endWrite())
    * will be lost.
    *
+   * In overwrite mode, evicts the oldest records,
+   * until `size` bytes become available.
+   *
    * @returns `size` <= writeCapacity()
    */
   bool beginWrite(std::size_t size)
   {
-    return (size <= writeCapacity())
-      ? true
-      : size <= maximizeWriteCapacity();
+    if (size <= writeCapacity()) { return true; }
+    if (size <= maximizeWriteCapacity()) { return true; }
+    return _queue->overwrite && evictUntil(size);
   }
 
   /**
@@ -126,7 +132,18 @@ private:
       }
       else
       {
-        _queue->dataEnd = w;
+        if (_queue->overwrite)
+        {
+          // E is part of the snapshot of the reader
+          const std::size_t seq = beginEvict();
+          _queue->dataEnd = w;
+          endEvict(seq);
+        }
+        else
+        {
+          _queue->dataEnd = w;
+        }
+
         _writePos = buffer();
         _writeEnd = buffer() + leftSize;
       }
@@ -135,6 +152,95 @@ private:
     return writeCapacity();
   }
 
+  /**
+   * Evict the oldest records, until writeCapacity() >= `size`.
+   *
+   * @pre overwrite mode
+   * @returns false if `size` might not fit, even if the queue is empty
+   */
+  bool evictUntil(std::size_t size)
+  {
+    // do not evict everything in vain
+    if (size > (_queue->capacity - 1) / 2) { return false; }
+
+    do
+    {
+      if (! evictOldest())
+      {
+        // queue is empty, maybe emptied by the reader
+        // since the last maximizeWriteCapacity call
+        if (maximizeWriteCapacity() < size) { return false; }
+        break;
+      }
+    }
+    while (maximizeWriteCapacity() < size);
+
+    // the evictions must be visible before the evicted bytes are overwritten
+    std::atomic_thread_fence(std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Move R after the oldest committed record.
+   *
+   * If the reader moves R concurrently, R is not changed,
+   * as the reader freed up some space.
+   *
+   * @returns false if there is no committed record
+   */
+  bool evictOldest()
+  {
+    const std::size_t seq = beginEvict();
+
+    const std::size_t w = _queue->writeIndex.load(std::memory_order_relaxed);
+    std::size_t r = _queue->readIndex.load(std::memory_order_acquire);
+
+    // find the oldest record, see QueueReader::beginRead
+    const bool wrapped = (r > w);                                // [###W...R###E..]
+    const std::size_t pos = (wrapped && r >= _queue->dataEnd) ? 0 : r; // [###W......RE..]
+    const std::size_t end = (wrapped && pos != 0) ? _queue->dataEnd : w;
+
+    if (pos == end)
+    {
+      endEvict(seq);
+      return false;
+    }
+
+    std::uint32_t recordSize = 0;
+    memcpy(&recordSize, buffer() + pos, sizeof(recordSize));
+    std::size_t newR = pos + sizeof(recordSize) + recordSize;
+    if (newR > end) { newR = end; } // invalid record, do not evict committed data
+    const std::size_t evicted = newR - pos;
+
+    // the end of the previous round is reached: let the reader (and the writer)
+    // continue from the beginning, instead of E
+    if (wrapped && pos != 0 && newR == end) { newR = 0; }
+
+    if (_queue->readIndex.compare_exchange_strong(r, newR, std::memory_order_acq_rel, std::memory_order_relaxed))
+    {
+      _queue->evictedBytes.store(
+        _queue->evictedBytes.load(std::memory_order_relaxed) + evicted,
+        std::memory_order_relaxed
+      );
+    }
+
+    endEvict(seq);
+    return true;
+  }
+
+  std::size_t beginEvict()
+  {
+    const std::size_t seq = _queue->evictSeq.load(std::memory_order_relaxed);
+    _queue->evictSeq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    return seq;
+  }
+
+  void endEvict(std::size_t seq)
+  {
+    _queue->evictSeq.store(seq + 2, std::memory_order_release);
+  }
+
   char* buffer() { return _queue->buffer; }
 
   Queue* _queue;
@@ -0,0 +1,70 @@
+#ifndef BINLOG_DETAIL_SOURCE_ID_MAP_HPP
+#define BINLOG_DETAIL_SOURCE_ID_MAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace binlog {
+namespace detail {
+
+/**
+ * A map<uint64_t, V> like container of per event source values,
+ * optimized for fast lookup by source id.
+ *
+ * Source ids are usually assigned sequentially, from 1:
+ * values of ids below `maxDenseId` are stored in a vector
+ * (packed bits, if V is bool), others in a hash map.
+ *
+ * Missing keys are mapped to V{}.
+ */
+template <typename V>
+class SourceIdMap
+{
+public:
+  static constexpr std::uint64_t maxDenseId = std::uint64_t(1) << 20;
+
+  /** @returns the value of `id`, or V{}, if not set */
+  V get(std::uint64_t id) const
+  {
+    if (id < maxDenseId)
+    {
+      return (id < _dense.size()) ? V(_dense[std::size_t(id)]) : V{};
+    }
+
+    const auto it = _sparse.find(id);
+    return (it != _sparse.end()) ? it->second : V{};
+  }
+
+  /** Set the value of `id` to `value` */
+  void set(std::uint64_t id, V value)
+  {
+    if (id < maxDenseId)
+    {
+      if (id >= _dense.size())
+      {
+        if (value == V{}) { return; }
+        _dense.resize(std::size_t(id) + 1);
+      }
+      _dense[std::size_t(id)] = value;
+    }
+    else if (value == V{})
+    {
+      _sparse.erase(id);
+    }
+    else
+    {
+      _sparse[id] = value;
+    }
+  }
+
+private:
+  std::vector<V> _dense;
+  std::unordered_map<std::uint64_t, V> _sparse;
+};
+
+} // namespace detail
+} // namespace binlog
+
+#endif // BINLOG_DETAIL_SOURCE_ID_MAP_HPP
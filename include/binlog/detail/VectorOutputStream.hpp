@@ -1,9 +1,15 @@
 #ifndef BINLOG_DETAIL_VECTOR_OUTPUT_STREAM_HPP
 #define BINLOG_DETAIL_VECTOR_OUTPUT_STREAM_HPP
 
+#include <binlog/detail/MemoryResource.hpp>
+
+#include <algorithm> // max
 #include <cstdint>
 #include <cstring>
 #include <ios> // streamsize
+#include <memory>
+#include <new>
+#include <utility> // move
 #include <vector>
 
 namespace binlog {
@@ -38,6 +44,9 @@ struct VectorOutputStream
  * `id` can be used to correlate the object to others.
  * `size` the number of valid bytes following it.
  *
+ * The buffer is allocated from the heap, or if given,
+ * from a MemoryResource, e.g: a RecoveryFile.
+ *
  * @models mserialize::OutputStream
  */
 class RecoverableVectorOutputStream
@@ -49,10 +58,11 @@ class RecoverableVectorOutputStream
     sizeof(std::uint64_t) + sizeof(void*);
 
 public:
-  RecoverableVectorOutputStream(std::uint64_t magic, void* id)
+  RecoverableVectorOutputStream(std::uint64_t magic, void* id, std::shared_ptr<MemoryResource> memory = {})
+    :_memory(std::move(memory))
   {
-    _vector.resize(HeaderSize);
-    char* buffer = _vector.data();
+    reserve(HeaderSize + 1024);
+    char* buffer = _buffer;
 
     memcpy(buffer, &magic, sizeof(magic));
     buffer += sizeof(magic);
@@ -61,44 +71,48 @@ public:
     buffer += sizeof(id);
 
     new (buffer) std::uint64_t{0}; // size
+    _size = HeaderSize;
   }
 
   ~RecoverableVectorOutputStream()
   {
     // do not recover invalid data from destroyed objects
     clearMagic();
+    deallocate(_buffer, _capacity);
   }
 
   RecoverableVectorOutputStream(const RecoverableVectorOutputStream&) = delete;
   void operator=(const RecoverableVectorOutputStream&) = delete;
 
-  RecoverableVectorOutputStream(RecoverableVectorOutputStream&&) = default;
-  RecoverableVectorOutputStream& operator=(RecoverableVectorOutputStream&&) = default;
+  RecoverableVectorOutputStream(RecoverableVectorOutputStream&&) = delete;
+  void operator=(RecoverableVectorOutputStream&&) = delete;
 
   RecoverableVectorOutputStream& write(const char* buffer, std::streamsize size)
   {
-    std::uint64_t magic = 0;
-    if (_vector.capacity() < _vector.size() + std::size_t(size))
+    const std::size_t newSize = _size + std::size_t(size);
+    if (_capacity < newSize)
     {
-      // vector will reallocate, clear the magic of the old buffer
+      // the buffer will be reallocated, clear the magic of the old buffer
       // to avoid recovering invalid data
-      magic = clearMagic();
+      const std::uint64_t magic = clearMagic();
+      reserve((std::max)(newSize, _capacity * 2));
+      setMagic(magic);
     }
 
-    _vector.insert(_vector.end(), buffer, buffer + size);
-    if (magic != 0) { setMagic(magic); }
+    memcpy(_buffer + _size, buffer, std::size_t(size));
+    _size = newSize;
     updateSize();
     return *this;
   }
 
   const char* data() const
   {
-    return _vector.data() + HeaderSize;
+    return _buffer + HeaderSize;
   }
 
   std::size_t size() const
   {
-    return _vector.size() - HeaderSize;
+    return _size - HeaderSize;
   }
 
   std::streamsize ssize() const
@@ -107,26 +121,47 @@ public:
   }
 
 private:
+  void reserve(std::size_t capacity)
+  {
+    char* buffer = (_memory) ? _memory->allocate(capacity) : new char[capacity];
+    if (_buffer != nullptr)
+    {
+      memcpy(buffer, _buffer, _size);
+      deallocate(_buffer, _capacity);
+    }
+    _buffer = buffer;
+    _capacity = capacity;
+  }
+
+  void deallocate(char* buffer, std::size_t capacity)
+  {
+    if (_memory) { _memory->deallocate(buffer, capacity); }
+    else { delete[] buffer; }
+  }
+
   void updateSize()
   {
     const std::uint64_t sz = size();
-    memcpy(_vector.data() + SizeOffset, &sz, sizeof(sz));
+    memcpy(_buffer + SizeOffset, &sz, sizeof(sz));
   }
 
   void setMagic(std::uint64_t magic)
   {
-    memcpy(_vector.data(), &magic, sizeof(magic));
+    memcpy(_buffer, &magic, sizeof(magic));
   }
 
   std::uint64_t clearMagic()
   {
     std::uint64_t magic = 0;
-    memcpy(&magic, _vector.data(), sizeof(magic));
+    memcpy(&magic, _buffer, sizeof(magic));
     setMagic(0);
     return magic;
   }
 
-  std::vector<char> _vector;
+  std::shared_ptr<MemoryResource> _memory;
+  char* _buffer = nullptr;
+  std::size_t _size = 0;
+  std::size_t _capacity = 0;
 };
 
 } // namespace detail
@@ -0,0 +1,287 @@
+#ifndef MSERIALIZE_VISIT_PROGRAM_HPP
+#define MSERIALIZE_VISIT_PROGRAM_HPP
+
+#include <mserialize/string_view.hpp>
+
+#include <mserialize/detail/tag_util.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace mserialize {
+
+/**
+ * A type tag, compiled to a flat sequence of operations.
+ *
+ * Visiting a serialized object by its tag (see mserialize::visit)
+ * parses the tag for every visited object: for each tuple element
+ * and structure field, the tag is popped, labels are scanned, and
+ * the recursion limit is checked. If many objects are visited
+ * by the same tag, the tag can be compiled once, and the
+ * resulting program can be visited instead, with identical results:
+ *
+ *    const mserialize::VisitProgram program(tag);
+ *    mserialize::visit(program, visitor, istream1);
+ *    mserialize::visit(program, visitor, istream2);
+ *
+ * Arithmetic values, tuples and non-recursive structures
+ * are compiled to operations. Consecutive arithmetic values
+ * (e.g: the fields of a struct of integers) form a block,
+ * that is read from the input stream at once, and its values
+ * are decoded at precomputed offsets. Other tags (sequences, variants,
+ * enums, recursive structures) are visited by mserialize::visit.
+ *
+ * Visitors might see less calls if the input stream is truncated
+ * in the middle of a block: as the block is read at once,
+ * the values preceding the truncation are not visited.
+ */
+class VisitProgram
+{
+public:
+  /** Maximum number of bytes read at once */
+  static constexpr std::size_t max_block_size = 256;
+
+  enum class OpCode : std::uint8_t
+  {
+    Arithmetic,  /**< Decode and visit an arithmetic value */
+    TupleBegin,  /**< Visit TupleBegin, jump to `next` if skipped */
+    TupleEnd,
+    StructBegin, /**< Visit StructBegin, jump to `next` if skipped */
+    StructEnd,
+    FieldBegin,
+    FieldEnd,
+    Generic,     /**< Visit the tag by mserialize::visit */
+  };
+
+  struct Op
+  {
+    OpCode code = OpCode::Generic;
+    char arithmetic = 0;            /**< Arithmetic: type tag */
+    std::uint32_t block_size = 0;   /**< Arithmetic: if not zero, read a new block of this size first */
+    std::uint32_t block_offset = 0; /**< Arithmetic: offset of the value in the block */
+    std::uint32_t tag_begin = 0;    /**< Tag of Tuple/Struct/FieldBegin and Generic, offset in tag() */
+    std::uint32_t tag_size = 0;
+    std::uint32_t name_begin = 0;   /**< Name of Struct/FieldBegin, offset in tag() */
+    std::uint32_t name_size = 0;
+    std::size_t next = 0;           /**< TupleBegin, StructBegin: index of the op after the matching end */
+    int max_recursion = 0;          /**< Generic: recursion limit given to visit */
+  };
+
+  /** Create an empty program, that visits nothing - as the empty tag */
+  VisitProgram() = default;
+
+  /**
+   * Compile `tag`.
+   *
+   * Invalid tags are not rejected here, visiting
+   * the program throws the same errors as visiting the tag would.
+   */
+  explicit VisitProgram(string_view tag)
+    :_tag(tag.data(), tag.size())
+  {
+    compile(_tag, 2048, 0); // same recursion limit as mserialize::visit
+    make_blocks();
+  }
+
+  /** @returns the compiled tag */
+  string_view tag() const { return _tag; }
+
+  const std::vector<Op>& ops() const { return _ops; }
+
+  /** @returns the tag of `op`, see Op::tag_begin */
+  string_view op_tag(const Op& op) const
+  {
+    return string_view(_tag.data() + op.tag_begin, op.tag_size);
+  }
+
+  /** @returns the name of `op`, see Op::name_begin */
+  string_view op_name(const Op& op) const
+  {
+    return string_view(_tag.data() + op.name_begin, op.name_size);
+  }
+
+  /** @returns the serialized size of the arithmetic `tag`, or 0 if `tag` is not arithmetic */
+  static std::size_t arithmetic_size(char tag)
+  {
+    switch (tag)
+    {
+    case 'y': return sizeof(bool);
+    case 'c': return sizeof(char);
+    case 'b': case 'B': return 1;
+    case 's': case 'S': return 2;
+    case 'i': case 'I': return 4;
+    case 'l': case 'L': return 8;
+    case 'f': return sizeof(float);
+    case 'd': return sizeof(double);
+    case 'D': return sizeof(long double);
+    default: return 0;
+    }
+  }
+
+private:
+  // Deeper tags are visited by mserialize::visit, to limit the stack usage of compile
+  static constexpr int max_compile_depth = 32;
+
+  // Mirrors detail::visit_impl
+  void compile(string_view tag, int max_recursion, int depth)
+  {
+    if (max_recursion == 0 || depth == max_compile_depth)
+    {
+      add_generic(tag, max_recursion); // throws at visit time if max_recursion is 0
+      return;
+    }
+
+    if (tag.empty()) { return; }
+
+    switch (tag.front())
+    {
+    case '(':
+      compile_tuple(tag, max_recursion - 1, depth + 1);
+      break;
+    case '{':
+      compile_struct(tag, max_recursion, depth + 1);
+      break;
+    default:
+      if (tag.size() == 1 && arithmetic_size(tag.front()) != 0)
+      {
+        Op op;
+        op.code = OpCode::Arithmetic;
+        op.arithmetic = tag.front();
+        _ops.push_back(op);
+      }
+      else
+      {
+        // sequence, variant, enum or invalid tag
+        add_generic(tag, max_recursion);
+      }
+    }
+  }
+
+  // Mirrors detail::visit_tuple
+  void compile_tuple(string_view tag, int max_recursion, int depth)
+  {
+    tag.remove_prefix(1); // drop (
+    tag.remove_suffix(1); // drop )
+
+    const std::size_t begin = _ops.size();
+    _ops.push_back(make_op(OpCode::TupleBegin, tag, {}));
+
+    for (string_view elem_tag = detail::tag_pop(tag); ! elem_tag.empty(); elem_tag = detail::tag_pop(tag))
+    {
+      compile(elem_tag, max_recursion, depth);
+    }
+
+    _ops.push_back(make_op(OpCode::TupleEnd, {}, {}));
+    _ops[begin].next = _ops.size();
+  }
+
+  // Mirrors detail::visit_struct
+  void compile_struct(const string_view full_struct_tag, int max_recursion, int depth)
+  {
+    string_view tag = full_struct_tag;
+    tag.remove_suffix(1); // drop }
+
+    string_view intro = detail::remove_prefix_before(tag, '`');
+
+    if (tag.empty())
+    {
+      // empty or recursive struct, resolved at visit time
+      add_generic(full_struct_tag, max_recursion);
+      return;
+    }
+
+    intro.remove_prefix(1); // drop {
+
+    const std::size_t begin = _ops.size();
+    _ops.push_back(make_op(OpCode::StructBegin, tag, intro));
+
+    while (! tag.empty())
+    {
+      const string_view field_name = detail::tag_pop_label(tag);
+      const string_view field_tag = detail::tag_pop(tag);
+
+      _ops.push_back(make_op(OpCode::FieldBegin, field_tag, field_name));
+      compile(field_tag, max_recursion - 1, depth);
+      _ops.push_back(make_op(OpCode::FieldEnd, {}, {}));
+    }
+
+    _ops.push_back(make_op(OpCode::StructEnd, {}, {}));
+    _ops[begin].next = _ops.size();
+  }
+
+  void add_generic(string_view tag, int max_recursion)
+  {
+    Op op = make_op(OpCode::Generic, tag, {});
+    op.max_recursion = max_recursion;
+    _ops.push_back(op);
+  }
+
+  /** @pre `tag` and `name` are empty or substrings of _tag */
+  Op make_op(OpCode code, string_view tag, string_view name) const
+  {
+    Op op;
+    op.code = code;
+    if (! tag.empty())
+    {
+      op.tag_begin = std::uint32_t(tag.data() - _tag.data());
+      op.tag_size = std::uint32_t(tag.size());
+    }
+    if (! name.empty())
+    {
+      op.name_begin = std::uint32_t(name.data() - _tag.data());
+      op.name_size = std::uint32_t(name.size());
+    }
+    return op;
+  }
+
+  // Group consecutive arithmetic ops, that are not separated by
+  // ops that can read the input stream or can be jumped to, into blocks.
+  void make_blocks()
+  {
+    Op* block_begin = nullptr;
+    std::size_t block_size = 0;
+
+    const auto close_block = [&]()
+    {
+      if (block_begin != nullptr) { block_begin->block_size = std::uint32_t(block_size); }
+      block_begin = nullptr;
+      block_size = 0;
+    };
+
+    for (Op& op : _ops)
+    {
+      switch (op.code)
+      {
+      case OpCode::Arithmetic:
+      {
+        const std::size_t size = arithmetic_size(op.arithmetic);
+        if (block_begin == nullptr || block_size + size > max_block_size)
+        {
+          close_block();
+          block_begin = &op;
+        }
+        op.block_offset = std::uint32_t(block_size);
+        block_size += size;
+        break;
+      }
+      case OpCode::FieldBegin:
+      case OpCode::FieldEnd:
+        break; // do not read the input, cannot be jumped to
+      default:
+        close_block();
+        break;
+      }
+    }
+
+    close_block();
+  }
+
+  std::string _tag;
+  std::vector<Op> _ops;
+};
+
+} // namespace mserialize
+
+#endif // MSERIALIZE_VISIT_PROGRAM_HPP
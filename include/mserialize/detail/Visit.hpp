@@ -1,6 +1,7 @@
 #ifndef MSERIALIZE_DETAIL_VISIT_HPP
 #define MSERIALIZE_DETAIL_VISIT_HPP
 
+#include <mserialize/VisitProgram.hpp>
 #include <mserialize/Visitor.hpp>
 #include <mserialize/deserialize.hpp>
 #include <mserialize/singular.hpp>
@@ -8,6 +9,8 @@
 #include <mserialize/detail/integer_to_hex.hpp>
 #include <mserialize/detail/tag_util.hpp>
 
+#include <cstring>
+#include <ios> // streamsize
 #include <type_traits>
 
 namespace mserialize {
@@ -276,6 +279,89 @@ void visit_impl(const string_view full_tag, string_view tag, Visitor& visitor, I
   }
 }
 
+template <typename T, typename Visitor>
+void visit_arithmetic_at(const char* p, Visitor& visitor)
+{
+  T t;
+  std::memcpy(&t, p, sizeof(T));
+  visitor.visit(t);
+}
+
+/** Same as visit_arithmetic, but read the value from `p` */
+template <typename Visitor>
+void visit_arithmetic_at(char tag, const char* p, Visitor& visitor)
+{
+  switch(tag)
+  {
+  case 'y': visit_arithmetic_at<bool>(p, visitor); break;
+  case 'c': visit_arithmetic_at<char>(p, visitor); break;
+
+  case 'b': visit_arithmetic_at<std::int8_t >(p, visitor); break;
+  case 's': visit_arithmetic_at<std::int16_t>(p, visitor); break;
+  case 'i': visit_arithmetic_at<std::int32_t>(p, visitor); break;
+  case 'l': visit_arithmetic_at<std::int64_t>(p, visitor); break;
+
+  case 'B': visit_arithmetic_at<std::uint8_t >(p, visitor); break;
+  case 'S': visit_arithmetic_at<std::uint16_t>(p, visitor); break;
+  case 'I': visit_arithmetic_at<std::uint32_t>(p, visitor); break;
+  case 'L': visit_arithmetic_at<std::uint64_t>(p, visitor); break;
+
+  case 'f': visit_arithmetic_at<float      >(p, visitor); break;
+  case 'd': visit_arithmetic_at<double     >(p, visitor); break;
+  case 'D': visit_arithmetic_at<long double>(p, visitor); break;
+  default: throw std::runtime_error(std::string("Invalid arithmetic tag: ") + tag); break;
+  }
+}
+
+/** Run the operations of `program`, see VisitProgram */
+template <typename Visitor, typename InputStream>
+void visit_program(const VisitProgram& program, Visitor& visitor, InputStream& istream)
+{
+  using OpCode = VisitProgram::OpCode;
+
+  const std::vector<VisitProgram::Op>& ops = program.ops();
+  char block[VisitProgram::max_block_size] = {};
+
+  std::size_t pc = 0;
+  while (pc != ops.size())
+  {
+    const VisitProgram::Op& op = ops[pc];
+    ++pc;
+
+    switch (op.code)
+    {
+    case OpCode::Arithmetic:
+      if (op.block_size != 0)
+      {
+        istream.read(block, std::streamsize(op.block_size));
+      }
+      visit_arithmetic_at(op.arithmetic, block + op.block_offset, visitor);
+      break;
+    case OpCode::TupleBegin:
+      if (visitor.visit(mserialize::Visitor::TupleBegin{program.op_tag(op)}, istream)) { pc = op.next; }
+      break;
+    case OpCode::TupleEnd:
+      visitor.visit(mserialize::Visitor::TupleEnd{});
+      break;
+    case OpCode::StructBegin:
+      if (visitor.visit(mserialize::Visitor::StructBegin{program.op_name(op), program.op_tag(op)}, istream)) { pc = op.next; }
+      break;
+    case OpCode::StructEnd:
+      visitor.visit(mserialize::Visitor::StructEnd{});
+      break;
+    case OpCode::FieldBegin:
+      visitor.visit(mserialize::Visitor::FieldBegin{program.op_name(op), program.op_tag(op)});
+      break;
+    case OpCode::FieldEnd:
+      visitor.visit(mserialize::Visitor::FieldEnd{});
+      break;
+    case OpCode::Generic:
+      visit_impl(program.tag(), program.op_tag(op), visitor, istream, op.max_recursion);
+      break;
+    }
+  }
+}
+
 } // namespace detail
 } // namespace mserialize
 
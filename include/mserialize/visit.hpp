@@ -3,6 +3,7 @@
 
 #include <mserialize/detail/Visit.hpp>
 
+#include <mserialize/VisitProgram.hpp>
 #include <mserialize/cx_string.hpp>
 #include <mserialize/string_view.hpp>
 
@@ -28,6 +29,21 @@ void visit(string_view tag, Visitor& visitor, InputStream& istream)
   detail::visit_impl(tag, tag, visitor, istream, 2048);
 }
 
+/**
+ * Visit the serialized objects in `istream`,
+ * by a precompiled tag.
+ *
+ * Equivalent to visit(program.tag(), visitor, istream),
+ * but faster, if the same tag is visited many times.
+ *
+ * @see VisitProgram
+ */
+template <typename Visitor, typename InputStream>
+void visit(const VisitProgram& program, Visitor& visitor, InputStream& istream)
+{
+  detail::visit_program(program, visitor, istream);
+}
+
 } // namespace mserialize
 
 #endif // MSERIALIZE_VISIT_HPP
@@ -202,6 +202,58 @@ TEST_CASE("RecoverMetadataAndData")
   std::remove(corepath.data());
 }
 
+#ifndef _WIN32
+
+TEST_CASE("RecoverFromRecoveryFile")
+{
+  // run shell, log to a session backed by a recovery file, crash
+  const std::string recpath = "shell.blogrec";
+
+  std::ostringstream shellcmd;
+  shellcmd << g_inttest_dir << "Shell" << extension()
+    << " 'recovery " << recpath << "'"
+    " 'log r hello r'"
+    " 'log w1 not recovered'"
+    " 'log r bye r'"
+    " terminate 2>/dev/null";
+  const int shellretval = std::system(shellcmd.str().data());
+  CHECK(shellretval != 0);
+
+  // recover data from the recovery file
+  REQUIRE(fileReadable(recpath));
+  std::ostringstream reccmd;
+  reccmd << g_inttest_dir + "brecovery" + extension() << " " << recpath
+         << " 2>/dev/null | " << g_bread_path << " -f %m";
+  const std::string recovered = executePipeline(reccmd.str());
+  CHECK(recovered == "hello r\nbye r\n");
+
+  std::remove(recpath.data());
+}
+
+TEST_CASE("EmergencyFlushOnTerminate")
+{
+  // run shell, log to the default session, crash before consuming it
+  const std::string path = "shell.emergency.blog";
+
+  std::ostringstream shellcmd;
+  shellcmd << g_inttest_dir << "Shell" << extension()
+    << " 'emergency " << path << "'"
+    " 'log w1 hello'"
+    " 'log w2 world'"
+    " terminate 2>/dev/null";
+  const int shellretval = std::system(shellcmd.str().data());
+  CHECK(shellretval != 0);
+
+  // the unconsumed events are written by the signal handler
+  REQUIRE(fileReadable(path));
+  const std::string flushed = executePipeline(g_bread_path + " -f %m " + path);
+  CHECK(flushed == "hello\nworld\n");
+
+  std::remove(path.data());
+}
+
+#endif // _WIN32
+
 void initGlobals(int argc, const char* argv[])
 {
   g_bread_path = (argc > 1) ? argv[1] : "./bread" + extension();
@@ -64,6 +64,18 @@ int main()
   BINLOG_INFO("Call f: {}", f()); // f will not be called
   //]
 
+  //[catmin
+  // enable debug events of a single category
+  session.setCategoryMinSeverity("orders", binlog::Severity::debug);
+  BINLOG_DEBUG_C(orders, "Enabled");
+  BINLOG_DEBUG("Disabled");
+  // Outputs: DEBG Enabled
+
+  // the category follows the session minimum severity again
+  session.resetCategoryMinSeverity("orders");
+  BINLOG_DEBUG_C(orders, "Disabled");
+  //]
+
   binlog::consume(std::cout);
   return 0;
 }
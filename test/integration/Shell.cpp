@@ -1,16 +1,27 @@
+#include <binlog/EmergencyFlush.hpp>
+#include <binlog/RecoveryFile.hpp>
 #include <binlog/binlog.hpp>
 
 #include <mserialize/string_view.hpp>
 
 #include <exception> // terminate
 #include <iostream>
+#include <memory>
 #include <string>
 
+#ifndef _WIN32
+  #include <fcntl.h> // open
+#endif
+
 namespace {
 
 binlog::SessionWriter w1(binlog::default_session());
 binlog::SessionWriter w2(binlog::default_session());
 
+// session and writer backed by a recovery file, created on demand
+std::unique_ptr<binlog::Session> g_recoverableSession;
+std::unique_ptr<binlog::SessionWriter> g_recoverableWriter;
+
 bool prefixed(mserialize::string_view command, mserialize::string_view prefix, mserialize::string_view& suffix)
 {
   if (! command.starts_with(prefix)) { return false; }
@@ -24,6 +35,40 @@ void log(binlog::SessionWriter& w, mserialize::string_view message)
   BINLOG_INFO_W(w, "{}", message);
 }
 
+void openRecoveryFile(mserialize::string_view path)
+{
+  g_recoverableWriter.reset();
+  g_recoverableSession.reset(new binlog::Session(
+    std::make_shared<binlog::RecoveryFile>(std::string(path.data(), path.size()))
+  ));
+  g_recoverableWriter.reset(new binlog::SessionWriter(*g_recoverableSession));
+}
+
+void logRecoverable(mserialize::string_view message)
+{
+  if (! g_recoverableWriter)
+  {
+    std::cerr << "No recovery file is open\n";
+    return;
+  }
+
+  log(*g_recoverableWriter, message);
+}
+
+void installEmergencyFlush(mserialize::string_view path)
+{
+#ifdef _WIN32
+  (void)path;
+  std::cerr << "Emergency flush is not supported on this platform\n";
+#else
+  const int fd = open(std::string(path.data(), path.size()).data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0 || ! binlog::installEmergencyFlush(binlog::default_session(), fd))
+  {
+    std::cerr << "Failed to install emergency flush to " << path << "\n";
+  }
+#endif
+}
+
 void terminate()
 {
   std::terminate();
@@ -38,6 +83,9 @@ void showHelp()
     "\n"
     "  log w1 <msg>     Log <msg> using the first writer\n"
     "  log w2 <msg>     Log <msg> using the second writer\n"
+    "  recovery <path>  Create a session backed by the recovery file <path>\n"
+    "  log r <msg>      Log <msg> to the session backed by the recovery file\n"
+    "  emergency <path> Flush the default session to <path> on a fatal signal\n"
     "  terminate        Forcefully terminate the application\n"
     "  help             Show this help\n"
     "\n"
@@ -50,6 +98,9 @@ void execute(mserialize::string_view command)
 
     if      (prefixed(command, "log w1 ", args)) { log(w1, args); }
     else if (prefixed(command, "log w2 ", args)) { log(w2, args); }
+    else if (prefixed(command, "log r ", args))  { logRecoverable(args); }
+    else if (prefixed(command, "recovery ", args)) { openRecoveryFile(args); }
+    else if (prefixed(command, "emergency ", args)) { installEmergencyFlush(args); }
     else if (command == "terminate")             { terminate(); }
     else if (command == "help")                  { showHelp(); }
     else { std::cerr << "Unknown command " << command << "\n"; showHelp(); }
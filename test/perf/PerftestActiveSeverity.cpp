@@ -0,0 +1,56 @@
+// Must be defined before including any binlog header
+#define BINLOG_ACTIVE_SEVERITY BINLOG_SEVERITY_INFO
+
+#include <binlog/binlog.hpp>
+
+#include <benchmark/benchmark.h>
+
+namespace {
+
+// A call site disabled at runtime: checks the minimum severity
+void BM_disabledAtRuntime(benchmark::State& state)
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session);
+  session.setMinSeverity(binlog::Severity::info);
+
+  for (int i = 0; state.KeepRunning(); ++i)
+  {
+    BINLOG_CREATE_SOURCE_AND_EVENT_IF(writer, binlog::Severity::trace, main, binlog::clockNow(), "Single int: {}", i);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_disabledAtRuntime); // NOLINT
+
+// A call site disabled by BINLOG_ACTIVE_SEVERITY: no code is generated
+void BM_disabledAtCompileTime(benchmark::State& state)
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session);
+
+  for (int i = 0; state.KeepRunning(); ++i)
+  {
+    BINLOG_TRACE_W(writer, "Single int: {}", i);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_disabledAtCompileTime); // NOLINT
+
+// A call site disabled at runtime, as a tracepoint
+void BM_disabledTracepoint(benchmark::State& state)
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session);
+  session.setTracepointsEnabled([](const binlog::EventSource&) { return true; }, false);
+
+  for (int i = 0; state.KeepRunning(); ++i)
+  {
+    BINLOG_INFO_W(writer, "Single int: {}", i);
+    benchmark::ClobberMemory();
+  }
+}
+BENCHMARK(BM_disabledTracepoint); // NOLINT
+
+} // namespace
+
+BENCHMARK_MAIN();
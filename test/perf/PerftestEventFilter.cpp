@@ -0,0 +1,153 @@
+#include <binlog/EventFilter.hpp>
+#include <binlog/Router.hpp>
+
+#include <binlog/Entries.hpp>
+
+#include <mserialize/serialize.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <ios>
+#include <vector>
+
+namespace {
+
+// Models mserialize::OutputStream, counts the bytes written
+struct CountingOutputStream
+{
+  std::size_t written = 0;
+  std::size_t writes = 0;
+
+  CountingOutputStream& write(const char* buffer, std::streamsize size)
+  {
+    benchmark::DoNotOptimize(buffer);
+    written += std::size_t(size);
+    ++writes;
+    return *this;
+  }
+};
+
+// Models mserialize::OutputStream, appends to a vector
+struct VectorOutputStream
+{
+  std::vector<char> buffer;
+
+  VectorOutputStream& write(const char* data, std::streamsize size)
+  {
+    buffer.insert(buffer.end(), data, data + size);
+    return *this;
+  }
+};
+
+constexpr std::uint64_t g_sourceCount = 64;
+
+// Event sources 1..g_sourceCount, followed by
+// events of 32 bytes, using the sources round-robin
+std::vector<char> testEntries()
+{
+  VectorOutputStream out;
+  for (std::uint64_t id = 1; id <= g_sourceCount; ++id)
+  {
+    binlog::EventSource source;
+    source.id = id;
+    source.severity = (id % 2 == 0) ? binlog::Severity::error : binlog::Severity::info;
+    source.category = "main";
+    source.formatString = "x={} y={}";
+    source.argumentTags = "LL";
+    binlog::serializeSizePrefixedTagged(source, out);
+  }
+
+  for (std::uint64_t i = 0; i < 32768; ++i)
+  {
+    const std::uint32_t size = 28;
+    const std::uint64_t sourceId = i % g_sourceCount + 1;
+    mserialize::serialize(size, out);
+    mserialize::serialize(sourceId, out);
+    mserialize::serialize(i, out); // clock
+    mserialize::serialize(i, out); // x
+    mserialize::serialize(std::uint32_t(i), out); // y, truncated
+  }
+
+  return out.buffer;
+}
+
+void filterEntries(benchmark::State& state, binlog::EventFilter::Predicate predicate)
+{
+  const std::vector<char> entries = testEntries();
+
+  binlog::EventFilter filter(std::move(predicate));
+  CountingOutputStream out;
+
+  while (state.KeepRunning())
+  {
+    filter.writeAllowed(entries.data(), entries.size(), out);
+  }
+
+  state.SetBytesProcessed(std::int64_t(state.iterations()) * std::int64_t(entries.size())); // input bytes/sec
+  state.counters["writes/iteration"] = double(out.writes) / double(state.iterations());
+}
+
+void BM_allowAll(benchmark::State& state)
+{
+  filterEntries(state, [](const binlog::EventSource&) { return true; });
+}
+BENCHMARK(BM_allowAll); // NOLINT
+
+void BM_allowNone(benchmark::State& state)
+{
+  filterEntries(state, [](const binlog::EventSource&) { return false; });
+}
+BENCHMARK(BM_allowNone); // NOLINT
+
+void BM_allowHalf(benchmark::State& state)
+{
+  filterEntries(state, [](const binlog::EventSource& source) { return source.severity >= binlog::Severity::error; });
+}
+BENCHMARK(BM_allowHalf); // NOLINT
+
+// Three outputs: everything, error and above, and a single category,
+// by one EventFilter per output
+void BM_threeFilters(benchmark::State& state)
+{
+  const std::vector<char> entries = testEntries();
+
+  binlog::EventFilter all([](const binlog::EventSource&) { return true; });
+  binlog::EventFilter errors(binlog::EventFilter::severityAtLeast(binlog::Severity::error));
+  binlog::EventFilter other(binlog::EventFilter::categoryIs("other"));
+  CountingOutputStream out1, out2, out3;
+
+  while (state.KeepRunning())
+  {
+    all.writeAllowed(entries.data(), entries.size(), out1);
+    errors.writeAllowed(entries.data(), entries.size(), out2);
+    other.writeAllowed(entries.data(), entries.size(), out3);
+  }
+
+  state.SetBytesProcessed(std::int64_t(state.iterations()) * std::int64_t(entries.size())); // input bytes/sec
+}
+BENCHMARK(BM_threeFilters); // NOLINT
+
+// Same outputs as BM_threeFilters, by a single Router
+void BM_routeToThreeSinks(benchmark::State& state)
+{
+  const std::vector<char> entries = testEntries();
+
+  CountingOutputStream out1, out2, out3;
+  binlog::Router router;
+  router.addSink(out1);
+  router.addSink(out2, binlog::EventFilter::severityAtLeast(binlog::Severity::error));
+  router.addSink(out3, binlog::EventFilter::categoryIs("other"));
+
+  while (state.KeepRunning())
+  {
+    router.write(entries.data(), std::streamsize(entries.size()));
+  }
+
+  state.SetBytesProcessed(std::int64_t(state.iterations()) * std::int64_t(entries.size())); // input bytes/sec
+}
+BENCHMARK(BM_routeToThreeSinks); // NOLINT
+
+} // namespace
+
+BENCHMARK_MAIN();
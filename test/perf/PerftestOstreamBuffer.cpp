@@ -0,0 +1,137 @@
+#include <binlog/detail/OstreamBuffer.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <streambuf>
+#include <vector>
+
+namespace {
+
+// Discards everything, counts the number of characters written
+class NullStreambuf : public std::streambuf
+{
+public:
+  std::streamsize written = 0;
+
+protected:
+  std::streamsize xsputn(const char*, std::streamsize n) override
+  {
+    written += n;
+    return n;
+  }
+
+  int_type overflow(int_type c) override
+  {
+    ++written;
+    return c;
+  }
+};
+
+// Values of varying magnitude, to defeat branch prediction
+template <typename T>
+std::vector<T> randomValues()
+{
+  std::mt19937_64 rng(42); // NOLINT(cert-msc32-c,cert-msc51-cpp)
+  std::vector<T> result;
+  for (int i = 0; i < 1024; ++i)
+  {
+    const std::uint64_t r = rng();
+    const int shift = int(r % 64);
+    result.push_back(static_cast<T>(r >> shift));
+  }
+  return result;
+}
+
+template <>
+std::vector<bool> randomValues<bool>()
+{
+  std::mt19937_64 rng(42); // NOLINT(cert-msc32-c,cert-msc51-cpp)
+  std::vector<bool> result;
+  for (int i = 0; i < 1024; ++i)
+  {
+    result.push_back((rng() & 1) != 0);
+  }
+  return result;
+}
+
+template <typename T>
+std::vector<T> randomFloatingValues()
+{
+  std::mt19937_64 rng(42); // NOLINT(cert-msc32-c,cert-msc51-cpp)
+  std::uniform_real_distribution<double> real(-1e6, 1e6);
+  std::vector<T> result;
+  for (int i = 0; i < 1024; ++i)
+  {
+    const double v = real(rng);
+    switch (i % 3)
+    {
+    case 0: result.push_back(T(v)); break;                            // arbitrary
+    case 1: result.push_back(T(std::int64_t(v))); break;              // integral
+    default: result.push_back(T(double(std::int64_t(v * 100)) / 100)); // price-like
+    }
+  }
+  return result;
+}
+
+template <> std::vector<float> randomValues<float>() { return randomFloatingValues<float>(); }
+template <> std::vector<double> randomValues<double>() { return randomFloatingValues<double>(); }
+template <> std::vector<long double> randomValues<long double>() { return randomFloatingValues<long double>(); }
+
+template <typename T>
+void BM_shiftOp(benchmark::State& state)
+{
+  const std::vector<T> values = randomValues<T>();
+
+  NullStreambuf nullbuf;
+  std::ostream nullstream(&nullbuf);
+  binlog::detail::OstreamBuffer out(nullstream);
+
+  std::size_t i = 0;
+  while (state.KeepRunning())
+  {
+    out << T(values[i]);
+    i = (i + 1) % values.size();
+  }
+
+  out.flush();
+  state.SetItemsProcessed(state.iterations()); // values/sec
+  state.SetBytesProcessed(nullbuf.written);
+}
+
+BENCHMARK_TEMPLATE(BM_shiftOp, bool);          // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, char);          // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, std::int8_t);   // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, std::int16_t);  // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, std::int32_t);  // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, std::int64_t);  // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, std::uint8_t);  // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, std::uint16_t); // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, std::uint32_t); // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, std::uint64_t); // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, float);         // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, double);        // NOLINT
+BENCHMARK_TEMPLATE(BM_shiftOp, long double);   // NOLINT
+
+void BM_shiftOpString(benchmark::State& state)
+{
+  NullStreambuf nullbuf;
+  std::ostream nullstream(&nullbuf);
+  binlog::detail::OstreamBuffer out(nullstream);
+
+  while (state.KeepRunning())
+  {
+    out << "Order filled";
+  }
+
+  out.flush();
+  state.SetItemsProcessed(state.iterations()); // values/sec
+  state.SetBytesProcessed(nullbuf.written);
+}
+BENCHMARK(BM_shiftOpString); // NOLINT
+
+} // namespace
+
+BENCHMARK_MAIN();
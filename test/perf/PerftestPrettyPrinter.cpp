@@ -0,0 +1,187 @@
+#include <binlog/EntryStream.hpp>
+#include <binlog/adapt_struct.hpp>
+#include <binlog/EventStream.hpp>
+#include <binlog/PrettyPrinter.hpp>
+#include <binlog/Session.hpp>
+#include <binlog/SessionWriter.hpp>
+#include <binlog/advanced_log_macros.hpp>
+#include <binlog/detail/OstreamBuffer.hpp>
+#include <binlog/detail/VectorOutputStream.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <tuple>
+
+namespace {
+
+struct Quote
+{
+  std::int64_t bid;
+  std::int64_t ask;
+  std::int32_t bidQty;
+  std::int32_t askQty;
+  double mid;
+};
+
+} // namespace
+
+BINLOG_ADAPT_STRUCT(Quote, bid, ask, bidQty, askQty, mid)
+
+namespace {
+
+// Discards everything, counts the number of characters written
+class NullStreambuf : public std::streambuf
+{
+public:
+  std::streamsize written = 0;
+
+protected:
+  std::streamsize xsputn(const char*, std::streamsize n) override
+  {
+    written += n;
+    return n;
+  }
+
+  int_type overflow(int_type c) override
+  {
+    ++written;
+    return c;
+  }
+};
+
+// Default format of bread
+const char* const g_eventFormat = "%S %C [%d] %n %m (%G:%L)\n";
+const char* const g_dateFormat = "%Y-%m-%d %H:%M:%S.%N";
+
+// Log an event to a Session by `logFn`, then read it back.
+// A log call site registers its event source only once,
+// therefore each fixture is shared by the benchmarks.
+struct EventFixture
+{
+  binlog::Session session;
+  binlog::detail::VectorOutputStream data;
+  binlog::RangeEntryStream entryStream{binlog::Range{}};
+  binlog::EventStream eventStream;
+  const binlog::Event* event = nullptr;
+
+  explicit EventFixture(void (*logFn)(binlog::SessionWriter&))
+  {
+    binlog::SessionWriter writer(session, 1 << 10, 1, "writer");
+    logFn(writer);
+    session.consume(data);
+
+    entryStream = binlog::RangeEntryStream(binlog::Range{data.data(), std::size_t(data.ssize())});
+    event = eventStream.nextEvent(entryStream);
+  }
+};
+
+// A typical event
+EventFixture& eventFixture()
+{
+  static EventFixture f([](binlog::SessionWriter& writer)
+  {
+    BINLOG_INFO_W(writer, "Order {} filled: qty={} price={} venue={}", 12345, 100, 99.95, std::string("XNYS"));
+  });
+  return f;
+}
+
+// An event with several structure arguments
+EventFixture& structEventFixture()
+{
+  static EventFixture f([](binlog::SessionWriter& writer)
+  {
+    const Quote q1{10000, 10002, 500, 700, 10001.0};
+    const Quote q2{20000, 20010, 100, 200, 20005.0};
+    BINLOG_INFO_W(writer, "Book update: {} {} {}", q1, q2, std::make_tuple(q1, 3, true));
+  });
+  return f;
+}
+
+void BM_printEventDefaultFormat(benchmark::State& state)
+{
+  EventFixture& f = eventFixture();
+  binlog::PrettyPrinter pp(g_eventFormat, g_dateFormat);
+
+  NullStreambuf nullbuf;
+  std::ostream nullstream(&nullbuf);
+  binlog::detail::OstreamBuffer out(nullstream);
+
+  while (state.KeepRunning())
+  {
+    pp.printEvent(out, *f.event, f.eventStream.writerProp(), f.eventStream.clockSync());
+  }
+
+  out.flush();
+  state.SetItemsProcessed(state.iterations()); // events/sec
+  state.SetBytesProcessed(nullbuf.written);
+}
+BENCHMARK(BM_printEventDefaultFormat); // NOLINT
+
+void BM_printEventDefaultFormatToOstream(benchmark::State& state)
+{
+  EventFixture& f = eventFixture();
+  binlog::PrettyPrinter pp(g_eventFormat, g_dateFormat);
+
+  NullStreambuf nullbuf;
+  std::ostream nullstream(&nullbuf);
+
+  while (state.KeepRunning())
+  {
+    pp.printEvent(nullstream, *f.event, f.eventStream.writerProp(), f.eventStream.clockSync());
+  }
+
+  state.SetItemsProcessed(state.iterations()); // events/sec
+  state.SetBytesProcessed(nullbuf.written);
+}
+BENCHMARK(BM_printEventDefaultFormatToOstream); // NOLINT
+
+void BM_printStructEvent(benchmark::State& state)
+{
+  EventFixture& f = structEventFixture();
+  binlog::PrettyPrinter pp("%m\n", g_dateFormat);
+
+  NullStreambuf nullbuf;
+  std::ostream nullstream(&nullbuf);
+  binlog::detail::OstreamBuffer out(nullstream);
+
+  while (state.KeepRunning())
+  {
+    pp.printEvent(out, *f.event, f.eventStream.writerProp(), f.eventStream.clockSync());
+  }
+
+  out.flush();
+  state.SetItemsProcessed(state.iterations()); // events/sec
+  state.SetBytesProcessed(nullbuf.written);
+}
+BENCHMARK(BM_printStructEvent); // NOLINT
+
+void BM_printTimestamp(benchmark::State& state)
+{
+  EventFixture& f = eventFixture();
+  binlog::Event event = *f.event;
+  binlog::PrettyPrinter pp("%d\n", g_dateFormat);
+  const binlog::ClockSync clockSync{0, 1000000000, 1569939329000000000, 3600, "CET"};
+
+  NullStreambuf nullbuf;
+  std::ostream nullstream(&nullbuf);
+  binlog::detail::OstreamBuffer out(nullstream);
+
+  while (state.KeepRunning())
+  {
+    event.clockValue += 1000; // 1 million events per second
+    pp.printEvent(out, event, {}, clockSync);
+  }
+
+  out.flush();
+  state.SetItemsProcessed(state.iterations()); // timestamps/sec
+  state.SetBytesProcessed(nullbuf.written);
+}
+BENCHMARK(BM_printTimestamp); // NOLINT
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,86 @@
+#include <recovery.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+// 256 MiB of pseudo random bytes, with a magic number every 16 MiB
+const std::vector<char>& testDump()
+{
+  static const std::vector<char> dump = []()
+  {
+    std::vector<char> result(std::size_t(256) << 20);
+    std::mt19937_64 random(42);
+    for (std::size_t i = 0; i + 8 <= result.size(); i += 8)
+    {
+      const std::uint64_t r = random();
+      memcpy(&result[i], &r, sizeof(r));
+    }
+
+    for (std::size_t i = 12345; i + 8 <= result.size(); i += std::size_t(16) << 20)
+    {
+      memcpy(&result[i], &g_dataMagic, sizeof(g_dataMagic));
+    }
+
+    return result;
+  }();
+  return dump;
+}
+
+// Naive byte by byte search, for reference
+void BM_findMagicNumbersNaive(benchmark::State& state)
+{
+  const std::vector<char>& dump = testDump();
+
+  while (state.KeepRunning())
+  {
+    std::size_t count = 0;
+    for (std::size_t i = 0; i + 8 <= dump.size(); ++i)
+    {
+      std::uint64_t v;
+      memcpy(&v, &dump[i], sizeof(v));
+      if (v == g_dataMagic || v == g_metadataMagic) { ++count; }
+    }
+    benchmark::DoNotOptimize(count);
+  }
+
+  state.SetBytesProcessed(std::int64_t(state.iterations()) * std::int64_t(dump.size()));
+}
+BENCHMARK(BM_findMagicNumbersNaive); // NOLINT
+
+void BM_findMagicNumbers(benchmark::State& state)
+{
+  const std::vector<char>& dump = testDump();
+
+  while (state.KeepRunning())
+  {
+    benchmark::DoNotOptimize(findMagicNumbers(dump.data(), dump.size(), 0, dump.size()));
+  }
+
+  state.SetBytesProcessed(std::int64_t(state.iterations()) * std::int64_t(dump.size()));
+}
+BENCHMARK(BM_findMagicNumbers); // NOLINT
+
+// arg: number of threads
+void BM_scanForBuffers(benchmark::State& state)
+{
+  const std::vector<char>& dump = testDump();
+  const std::size_t threads = std::size_t(state.range(0));
+
+  while (state.KeepRunning())
+  {
+    benchmark::DoNotOptimize(scanForBuffers(MemoryDump(dump.data(), dump.size()), threads));
+  }
+
+  state.SetBytesProcessed(std::int64_t(state.iterations()) * std::int64_t(dump.size()));
+}
+BENCHMARK(BM_scanForBuffers)->Arg(1)->Arg(2)->Arg(4)->UseRealTime(); // NOLINT
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,42 @@
+// Built as a separate program, BINLOG_ACTIVE_SEVERITY=BINLOG_SEVERITY_INFO is defined by CMake
+#include <binlog/advanced_log_macros.hpp>
+
+#include "test_utils.hpp"
+
+#include <binlog/Session.hpp>
+#include <binlog/SessionWriter.hpp>
+
+#include <doctest/doctest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+int failIfCalled()
+{
+  FAIL("Argument of stripped severity evaluated");
+  return 0;
+}
+
+} // namespace
+
+TEST_CASE("strip_below_active_severity")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 4096);
+
+  const std::string onlyInStripped = "no unused variable warning";
+
+  BINLOG_TRACE_W(writer, "{} {}", failIfCalled(), onlyInStripped);
+  BINLOG_DEBUG_WC(writer, category, "{}", failIfCalled());
+  BINLOG_INFO_W(writer, "a {}", 1);
+  BINLOG_WARN_WC(writer, category, "b");
+  BINLOG_ERROR_W(writer, "c");
+  BINLOG_CRITICAL_W(writer, "d");
+
+  CHECK(getEvents(session, "%S %m") == std::vector<std::string>{"INFO a 1", "WARN b", "ERRO c", "CRIT d"});
+
+  // stripped call sites do not add event sources
+  CHECK(session.tracepoints().size() == 4);
+}
@@ -0,0 +1,172 @@
+#include <columns.hpp>
+
+#include <binlog/EntryStream.hpp>
+#include <binlog/EventStream.hpp>
+#include <binlog/Session.hpp>
+#include <binlog/SessionWriter.hpp>
+#include <binlog/adapt_struct.hpp>
+#include <binlog/advanced_log_macros.hpp>
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <cstdio> // remove
+#include <cstdlib> // getenv
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+struct ExportedQuote
+{
+  int bid;
+  double ask;
+};
+
+} // namespace
+
+BINLOG_ADAPT_STRUCT(ExportedQuote, bid, ask)
+
+namespace {
+
+// Removes the files exported to `prefix` at the end of the test, even if it fails
+struct ExportFiles
+{
+  std::string prefix;
+
+  explicit ExportFiles(const std::string& name)
+  {
+#ifdef _WIN32
+    const char* dir = std::getenv("TEMP");
+    prefix = std::string(dir != nullptr ? dir : ".") + "\\" + name;
+#else
+    const char* dir = std::getenv("TMPDIR");
+    prefix = std::string(dir != nullptr ? dir : "/tmp") + "/" + name;
+#endif
+  }
+
+  ~ExportFiles()
+  {
+    std::remove((prefix + ".schema").data());
+    std::remove((prefix + ".csv").data());
+    for (int i = 0; i < 16; ++i)
+    {
+      std::remove((prefix + ".col" + std::to_string(i)).data());
+    }
+  }
+
+  ExportFiles(const ExportFiles&) = delete;
+  void operator=(const ExportFiles&) = delete;
+};
+
+std::string readFile(const std::string& path)
+{
+  std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Export the events of `session`, all from a single source, to files starting with `prefix`
+std::unique_ptr<ColumnExporter> exportEvents(binlog::Session& session, const std::string& prefix, int formats)
+{
+  std::stringstream stream;
+  session.consume(stream);
+
+  binlog::IstreamEntryStream entryStream(stream);
+  binlog::EventStream eventStream;
+  std::unique_ptr<ColumnExporter> exporter;
+  while (const binlog::Event* event = eventStream.nextEvent(entryStream))
+  {
+    if (! exporter) { exporter.reset(new ColumnExporter(prefix, *event->source, formats)); }
+    const binlog::WriterProp& writer = eventStream.writerProp();
+    exporter->add(ExportedEvent{event->clockValue, 0, writer.id, &writer.name, event->arguments});
+  }
+
+  REQUIRE(exporter);
+  exporter->flush();
+  return exporter;
+}
+
+std::string columnSummary(const ColumnExporter& exporter)
+{
+  std::string result;
+  for (const ColumnExporter::Column& column : exporter.columns())
+  {
+    result += column.name + ":" + ColumnExporter::typeName(column) + " ";
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("export_flattened_columns")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 1024, 7, "w7");
+
+  BINLOG_INFO_W(writer, "{} {} {} {}", std::string("AAA"), ExportedQuote{10, 10.5}, std::make_tuple(1, 'x'), std::vector<int>{1, 2});
+  BINLOG_INFO_W(writer, "{} {} {} {}", std::string("BB"), ExportedQuote{-20, 0.25}, std::make_tuple(2, 'y'), std::vector<int>{});
+
+  const ExportFiles files("binlog_test_export_flattened_columns");
+  const std::string& prefix = files.prefix;
+  const std::unique_ptr<ColumnExporter> exporter = exportEvents(session, prefix, ColumnExporter::Binary | ColumnExporter::Csv);
+
+  CHECK(exporter->rowCount() == 2);
+  CHECK(columnSummary(*exporter) ==
+    "clock:u64 time_ns:i64 writer_id:u64 writer_name:string "
+    "arg0:string arg1.bid:i32 arg1.ask:f64 arg2.0:i32 arg2.1:char arg3:string "
+  );
+
+  const std::string schema = readFile(prefix + ".schema");
+  CHECK(schema.find("format {} {} {} {}\n") != std::string::npos);
+  CHECK(schema.find("columns 10\n") != std::string::npos);
+  CHECK(schema.find("5 arg1.bid i32\n") != std::string::npos);
+
+  const std::string csv = readFile(prefix + ".csv");
+  const std::size_t firstRow = csv.find("\r\n") + 2;
+  CHECK(csv.substr(0, firstRow) == "clock,time_ns,writer_id,writer_name,arg0,arg1.bid,arg1.ask,arg2.0,arg2.1,arg3\r\n");
+  const std::string rows = csv.substr(firstRow);
+  CHECK(rows.find(",0,7,w7,AAA,10,10.5,1,x,\"[1, 2]\"\r\n") != std::string::npos);
+  CHECK(rows.find(",0,7,w7,BB,-20,0.25,2,y,[]\r\n") != std::string::npos);
+
+  const std::string bids = readFile(prefix + ".col5");
+  REQUIRE(bids.size() == 2 * sizeof(std::int32_t));
+  std::int32_t bid[2];
+  std::memcpy(bid, bids.data(), sizeof(bid));
+  CHECK(bid[0] == 10);
+  CHECK(bid[1] == -20);
+
+  const std::string names = readFile(prefix + ".col4");
+  CHECK(names == std::string("\3\0\0\0AAA\2\0\0\0BB", 13));
+
+  const std::string writerIds = readFile(prefix + ".col2");
+  REQUIRE(writerIds.size() == 2 * sizeof(std::uint64_t));
+  std::uint64_t writerId = 0;
+  std::memcpy(&writerId, writerIds.data(), sizeof(writerId));
+  CHECK(writerId == 7);
+}
+
+TEST_CASE("export_csv_quoting")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 1024, 1, "a,b");
+
+  BINLOG_INFO_W(writer, "{} {}", std::string("say \"hi\""), std::string("line\nbreak"));
+  BINLOG_INFO_W(writer, "{} {}", std::string("plain"), std::string("comma,"));
+
+  const ExportFiles files("binlog_test_export_csv_quoting");
+  const std::string& prefix = files.prefix;
+  exportEvents(session, prefix, ColumnExporter::Csv);
+
+  const std::string csv = readFile(prefix + ".csv");
+  CHECK(csv.find(",1,\"a,b\",\"say \"\"hi\"\"\",\"line\nbreak\"\r\n") != std::string::npos);
+  CHECK(csv.find(",1,\"a,b\",plain,\"comma,\"\r\n") != std::string::npos);
+
+  // binary columns are not written
+  CHECK(! std::ifstream(prefix + ".col0"));
+}
@@ -9,13 +9,23 @@
 #include <doctest/doctest.h>
 
 #include <chrono>
+#include <cstdint>
 #include <sstream>
 #include <string>
 #include <thread>
+#include <utility>
 #include <vector>
 
 namespace {
 
+int g_evaluated = 0;
+
+int evaluate(int i)
+{
+  ++g_evaluated;
+  return i;
+}
+
 void writeEvent(binlog::Session& session)
 {
   binlog::SessionWriter writer(session, 128);
@@ -23,6 +33,27 @@ void writeEvent(binlog::Session& session)
   BINLOG_CREATE_SOURCE_AND_EVENT(writer, binlog::Severity::info, category, 0, "Hello Concurrent World");
 }
 
+// Provides only the minimal writer interface: no severity in addEvent
+class CountingWriter
+{
+public:
+  explicit CountingWriter(binlog::SessionWriter& writer) :_writer(writer) {}
+
+  binlog::Session& session() { return _writer.session(); }
+
+  template <typename... Args>
+  bool addEvent(std::uint64_t eventSourceId, std::uint64_t clock, Args&&... args)
+  {
+    ++count;
+    return _writer.addEvent(eventSourceId, clock, std::forward<Args>(args)...);
+  }
+
+  int count = 0;
+
+private:
+  binlog::SessionWriter& _writer;
+};
+
 } // namespace
 
 TEST_CASE("no_arg")
@@ -61,6 +92,18 @@ TEST_CASE("several_args")
   CHECK(getEvents(session, "%m") == std::vector<std::string>{"Hello World a=1 b=true c=[2, 3, 4]"});
 }
 
+TEST_CASE("writer_without_severity")
+{
+  binlog::Session session;
+  binlog::SessionWriter sessionWriter(session, 128);
+  CountingWriter writer(sessionWriter);
+
+  BINLOG_CREATE_SOURCE_AND_EVENT(writer, binlog::Severity::info, category, 0, "Hello {}", 123);
+
+  CHECK(writer.count == 1);
+  CHECK(getEvents(session, "%S %m") == std::vector<std::string>{"INFO Hello 123"});
+}
+
 TEST_CASE("severity_and_category")
 {
   binlog::Session session;
@@ -182,3 +225,37 @@ static_assert(binlog::detail::count_placeholders("{} foo {} bar {}") == 3, "");
 static_assert(binlog::detail::count_placeholders("{}{}{}") == 3, "");
 static_assert(binlog::detail::count_placeholders("{{}{}{}}") == 3, "");
 static_assert(binlog::detail::count_placeholders("{}{}{}{}{}{}{}{}{}{}") == 10, "");
+
+TEST_CASE("disable_tracepoints")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 4096);
+
+  const auto isA = [](const binlog::EventSource& source) { return source.formatString == "a {}"; };
+  const auto isB = [](const binlog::EventSource& source) { return source.formatString == "b {}"; };
+
+  // disable b, before its call site is first executed
+  CHECK(session.setTracepointsEnabled(isB, false) == 0);
+
+  g_evaluated = 0;
+  for (int i = 0; i < 6; ++i)
+  {
+    if (i == 2) { CHECK(session.setTracepointsEnabled(isA, false) == 1); }
+    if (i == 4) { CHECK(session.setTracepointsEnabled(isA, true) == 1); }
+
+    BINLOG_CREATE_SOURCE_AND_EVENT(writer, binlog::Severity::info, category, 0, "a {}", evaluate(i));
+    BINLOG_CREATE_SOURCE_AND_EVENT(writer, binlog::Severity::info, category, 0, "b {}", evaluate(i));
+  }
+
+  // arguments of disabled call sites are not evaluated
+  CHECK(g_evaluated == 4);
+  CHECK(getEvents(session, "%m") == std::vector<std::string>{"a 0", "a 1", "a 4", "a 5"});
+
+  const std::vector<binlog::Session::Tracepoint> tracepoints = session.tracepoints();
+  REQUIRE(tracepoints.size() == 2);
+  CHECK(tracepoints[0].source.formatString == "a {}");
+  CHECK(tracepoints[0].enabled);
+  CHECK(tracepoints[0].switchable);
+  CHECK(tracepoints[1].source.formatString == "b {}");
+  CHECK(! tracepoints[1].enabled);
+}
@@ -78,3 +78,21 @@ TEST_CASE("no_eval_if_disabled")
 
   CHECK(true); // if reached, we are fine.
 }
+
+TEST_CASE("category_min_severity")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 4096);
+
+  session.setMinSeverity(binlog::Severity::warning);
+  session.setCategoryMinSeverity("verbose", binlog::Severity::debug);
+  session.setCategoryMinSeverity("quiet", binlog::Severity::no_logs);
+
+  BINLOG_CREATE_SOURCE_AND_EVENT_IF(writer, binlog::Severity::debug, verbose, 0, "a");
+  BINLOG_CREATE_SOURCE_AND_EVENT_IF(writer, binlog::Severity::debug, other, 0, "b");
+  BINLOG_CREATE_SOURCE_AND_EVENT_IF(writer, binlog::Severity::warning, other, 0, "c");
+  BINLOG_CREATE_SOURCE_AND_EVENT_IF(writer, binlog::Severity::critical, quiet, 0, "d");
+  BINLOG_CREATE_SOURCE_AND_EVENT_IF(writer, binlog::Severity::trace, verbose, 0, "{}", failIfCalled());
+
+  CHECK(getEvents(session, "%C %m") == std::vector<std::string>{"verbose a", "other c"});
+}
@@ -0,0 +1,291 @@
+#include <binlog/EmergencyFlush.hpp>
+
+#include <binlog/FlightRecorder.hpp>
+#include <binlog/Session.hpp>
+#include <binlog/SessionWriter.hpp>
+#include <binlog/advanced_log_macros.hpp>
+
+#include "test_utils.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cerrno>
+#include <cstdio> // remove
+#include <fstream>
+#include <ios> // streamsize
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+  #include <csignal>
+  #include <fcntl.h> // open
+  #include <sys/wait.h> // waitpid
+  #include <unistd.h> // fork, close
+#endif
+
+TEST_CASE("emergency_consume")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512, 1, "w1");
+
+  BINLOG_INFO_W(writer, "Hello {}", 1);
+  BINLOG_INFO_W(writer, "Hello {}", 2);
+
+  TestStream stream;
+  const binlog::Session::ConsumeResult cr = session.emergencyConsume(stream);
+  CHECK(cr.channelsPolled == 1);
+  CHECK(cr.bytesConsumed == stream.buffer.size());
+  CHECK(cr.totalBytesConsumed == 0);
+
+  const std::vector<std::string> expectedEvents{"w1 Hello 1", "w1 Hello 2"};
+  CHECK(streamToEvents(stream, "%n %m") == expectedEvents);
+
+  // data remains in the session
+  CHECK(getEvents(session, "%n %m") == expectedEvents);
+
+  // sources are written again, even if consumed
+  BINLOG_INFO_W(writer, "Hello {}", 3);
+  TestStream stream2;
+  session.emergencyConsume(stream2);
+  CHECK(streamToEvents(stream2, "%n %m") == std::vector<std::string>{"w1 Hello 3"});
+}
+
+TEST_CASE("emergency_consume_empty")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 128);
+
+  TestStream stream;
+  const binlog::Session::ConsumeResult cr = session.emergencyConsume(stream);
+  CHECK(cr.channelsPolled == 1);
+  CHECK(streamToEvents(stream, "%m").empty());
+}
+
+namespace {
+
+// Calls emergencyConsume on each write, as if consume crashed while writing
+struct CrashingStream
+{
+  binlog::Session& session;
+  TestStream emergencyOutput;
+  binlog::Session::ConsumeResult emergencyResult;
+
+  CrashingStream& write(const char* /* data */, std::streamsize /* size */)
+  {
+    emergencyResult = session.emergencyConsume(emergencyOutput);
+    return *this;
+  }
+};
+
+} // namespace
+
+TEST_CASE("emergency_consume_during_consume")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512, 1, "w1");
+  BINLOG_INFO_W(writer, "Hello {}", 1);
+
+  CrashingStream stream{session, {}, {}};
+  session.consume(stream);
+
+  // the consume in progress might modify the channels, nothing is written
+  CHECK(stream.emergencyResult.channelsPolled == 0);
+  CHECK(stream.emergencyResult.bytesConsumed == 0);
+  CHECK(stream.emergencyOutput.buffer.empty());
+
+  // after the consume, emergencyConsume writes again
+  BINLOG_INFO_W(writer, "Hello {}", 2);
+  TestStream stream2;
+  session.emergencyConsume(stream2);
+  CHECK(streamToEvents(stream2, "%n %m") == std::vector<std::string>{"w1 Hello 2"});
+}
+
+#ifndef _WIN32
+
+namespace {
+
+std::string readFile(const std::string& path)
+{
+  std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+TestStream toTestStream(const std::string& content)
+{
+  TestStream stream;
+  stream.buffer.assign(content.begin(), content.end());
+  return stream;
+}
+
+} // namespace
+
+TEST_CASE("emergency_flush_on_signal")
+{
+  const char* path = "binlog_unittest_emergency.blog";
+  const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  REQUIRE(fd >= 0);
+
+  const pid_t pid = fork();
+  REQUIRE(pid >= 0);
+
+  if (pid == 0)
+  {
+    // child: log, then crash
+    signal(SIGSEGV, SIG_DFL); // do not chain to the crash handler of the test framework
+
+    binlog::Session session;
+    binlog::SessionWriter writer(session, 512, 1, "child");
+    BINLOG_INFO_W(writer, "Before crash {}", 123);
+
+    if (! binlog::installEmergencyFlush(session, fd)) { _exit(1); }
+    raise(SIGSEGV);
+    _exit(2); // unreachable: the default action of SIGSEGV is to terminate
+  }
+
+  close(fd);
+
+  int status = 0;
+  REQUIRE(waitpid(pid, &status, 0) == pid);
+  CHECK(WIFSIGNALED(status));
+  CHECK(WTERMSIG(status) == SIGSEGV);
+
+  TestStream stream = toTestStream(readFile(path));
+  CHECK(streamToEvents(stream, "%n %m") == std::vector<std::string>{"child Before crash 123"});
+
+  std::remove(path);
+}
+
+TEST_CASE("emergency_flush_with_flight_recorder")
+{
+  const char* path = "binlog_unittest_emergency_recorder.blog";
+
+  const pid_t pid = fork();
+  REQUIRE(pid >= 0);
+
+  if (pid == 0)
+  {
+    // child: record, log, then crash
+    signal(SIGABRT, SIG_DFL); // do not chain to the crash handler of the test framework
+
+    binlog::Session session;
+    binlog::SessionWriter writer(session, 512, 1, "child");
+    binlog::FlightRecorder recorder(4096, path);
+
+    BINLOG_DEBUG_W(writer, "Recorded {}", 1);
+    session.consume(recorder);
+    BINLOG_DEBUG_W(writer, "Unconsumed {}", 2);
+
+    if (! binlog::installEmergencyFlush(session, recorder)) { _exit(1); }
+    raise(SIGABRT);
+    _exit(2); // unreachable: the default action of SIGABRT is to terminate
+  }
+
+  int status = 0;
+  REQUIRE(waitpid(pid, &status, 0) == pid);
+  CHECK(WIFSIGNALED(status));
+  CHECK(WTERMSIG(status) == SIGABRT);
+
+  TestStream stream = toTestStream(readFile(path));
+  CHECK(streamToEvents(stream, "%n %m") == std::vector<std::string>{"child Recorded 1", "child Unconsumed 2"});
+
+  std::remove(path);
+}
+
+TEST_CASE("emergency_flush_from_two_threads")
+{
+  const char* path = "binlog_unittest_emergency_threads.blog";
+  const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  REQUIRE(fd >= 0);
+
+  const pid_t pid = fork();
+  REQUIRE(pid >= 0);
+
+  if (pid == 0)
+  {
+    // child: log a lot, then crash on two threads at once
+    signal(SIGSEGV, SIG_DFL); // do not chain to the crash handler of the test framework
+
+    binlog::Session session;
+    binlog::SessionWriter writer(session, 1 << 20, 1, "child");
+    for (int i = 0; i < 10000; ++i)
+    {
+      BINLOG_INFO_W(writer, "Event {}", i);
+    }
+
+    if (! binlog::installEmergencyFlush(session, fd)) { _exit(1); }
+
+    // the thread that does not flush must wait for the other one
+    std::thread other([]() { raise(SIGSEGV); });
+    raise(SIGSEGV);
+    other.join();
+    _exit(2); // unreachable: the default action of SIGSEGV is to terminate
+  }
+
+  close(fd);
+
+  int status = 0;
+  REQUIRE(waitpid(pid, &status, 0) == pid);
+  CHECK(WIFSIGNALED(status));
+  CHECK(WTERMSIG(status) == SIGSEGV);
+
+  TestStream stream = toTestStream(readFile(path));
+  const std::vector<std::string> events = streamToEvents(stream, "%m");
+  CHECK(events.size() == 10000);
+  if (! events.empty()) { CHECK(events.back() == "Event 9999"); }
+
+  std::remove(path);
+}
+
+TEST_CASE("emergency_flush_keeps_errno")
+{
+  const pid_t pid = fork();
+  REQUIRE(pid >= 0);
+
+  if (pid == 0)
+  {
+    // child: the previous action ignores the signal, execution continues
+    signal(SIGFPE, SIG_IGN);
+
+    binlog::Session session;
+    const int fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+    if (fd < 0 || ! binlog::installEmergencyFlush(session, fd)) { _exit(1); }
+
+    errno = EDOM;
+    raise(SIGFPE);
+    _exit(errno == EDOM ? 0 : 3);
+  }
+
+  int status = 0;
+  REQUIRE(waitpid(pid, &status, 0) == pid);
+  REQUIRE(WIFEXITED(status));
+  CHECK(WEXITSTATUS(status) == 0);
+}
+
+TEST_CASE("uninstall_emergency_flush")
+{
+  binlog::Session session;
+  const int fd = open("/dev/null", O_WRONLY | O_CLOEXEC);
+  REQUIRE(fd >= 0);
+
+  struct sigaction before{};
+  sigaction(SIGSEGV, nullptr, &before);
+
+  CHECK(binlog::installEmergencyFlush(session, fd));
+  CHECK(binlog::installEmergencyFlush(session, fd)); // replace
+
+  struct sigaction installed{};
+  sigaction(SIGSEGV, nullptr, &installed);
+  CHECK(installed.sa_handler != before.sa_handler); // NOLINT(cppcoreguidelines-pro-type-union-access)
+
+  binlog::uninstallEmergencyFlush();
+
+  struct sigaction after{};
+  sigaction(SIGSEGV, nullptr, &after);
+  CHECK(after.sa_handler == before.sa_handler); // NOLINT(cppcoreguidelines-pro-type-union-access)
+
+  close(fd);
+}
+
+#endif // _WIN32
@@ -4,11 +4,16 @@
 #include <binlog/SessionWriter.hpp>
 #include <binlog/advanced_log_macros.hpp>
 
+#include <mserialize/serialize.hpp>
+
 #include "test_utils.hpp"
 
 #include <doctest/doctest.h>
 
+#include <cstdint>
 #include <sstream>
+#include <string>
+#include <vector>
 
 namespace {
 
@@ -26,6 +31,19 @@ struct FilterAdapter
   }
 };
 
+struct CountingStream
+{
+  TestStream stream;
+  int writes = 0;
+
+  CountingStream& write(const char* buffer, std::streamsize size)
+  {
+    ++writes;
+    stream.write(buffer, size);
+    return *this;
+  }
+};
+
 std::vector<std::string> filterEvents(binlog::Session& session, binlog::EventFilter& filter)
 {
   FilterAdapter adapter{filter, {}};
@@ -89,3 +107,112 @@ TEST_CASE("allow_some")
   };
   CHECK(filterEvents(session, filter) == expectedEvents2);
 }
+
+TEST_CASE("builtin_predicates")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512);
+
+  using F = binlog::EventFilter;
+  binlog::EventFilter filter(F::anyOf({
+    F::allOf({F::severityAtLeast(binlog::Severity::warning), F::categoryIs("orders")}),
+    F::allOf({F::categoryIs("audit"), F::fileEndsWith("TestEventFilter.cpp")}),
+    F::formatMatches("^Bye [a-z]+$"),
+  }));
+
+  BINLOG_INFO_WC(writer, orders, "Hello orders");
+  BINLOG_ERROR_WC(writer, orders, "Hello orders");
+  BINLOG_ERROR_WC(writer, other, "Hello other");
+  BINLOG_DEBUG_WC(writer, audit, "Hello audit");
+  BINLOG_INFO_WC(writer, other, "Bye other");
+  BINLOG_INFO_WC(writer, other, "Bye 1");
+
+  const std::vector<std::string> expectedEvents{
+    "ERRO Hello orders", "DEBG Hello audit", "INFO Bye other",
+  };
+  CHECK(filterEvents(session, filter) == expectedEvents);
+}
+
+TEST_CASE("allow_writers")
+{
+  binlog::Session session;
+  binlog::SessionWriter writerA(session, 512, 1, "a");
+  binlog::SessionWriter writerB(session, 512, 2, "b");
+
+  binlog::EventFilter filter(
+    binlog::EventFilter::severityAtLeast(binlog::Severity::info),
+    binlog::EventFilter::writerNameIs("b")
+  );
+
+  BINLOG_INFO_W(writerA, "Hello a");
+  BINLOG_INFO_W(writerB, "Hello b");
+  BINLOG_DEBUG_W(writerB, "Hello b debug");
+  CHECK(filterEvents(session, filter) == std::vector<std::string>{"INFO Hello b"});
+}
+
+TEST_CASE("batch_consecutive_writes")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 4096);
+
+  binlog::EventFilter filter([](const binlog::EventSource& source){ return source.severity >= binlog::Severity::info; });
+
+  for (int i = 0; i < 4; ++i)
+  {
+    BINLOG_INFO_W(writer, "a={}", i);
+    BINLOG_INFO_W(writer, "b={}", i);
+    BINLOG_DEBUG_W(writer, "c={}", i);
+  }
+
+  std::ostringstream consumed;
+  session.consume(consumed);
+  const std::string input = consumed.str();
+
+  CountingStream output;
+  filter.writeAllowed(input.data(), input.size(), output);
+  CHECK(streamToEvents(output.stream, "%m").size() == 8);
+
+  // metadata and the first pair of info events are contiguous,
+  // later pairs are separated by debug events
+  CHECK(output.writes == 4);
+}
+
+TEST_CASE("sparse_and_redefined_sources")
+{
+  TestStream input;
+  const auto addSource = [&input](std::uint64_t id, binlog::Severity severity)
+  {
+    binlog::EventSource source;
+    source.id = id;
+    source.severity = severity;
+    source.formatString = "id=" + std::to_string(id);
+    serializeSizePrefixedTagged(source, input);
+  };
+  const auto addEvent = [&input](std::uint64_t id)
+  {
+    const std::uint32_t size = 16;
+    const std::uint64_t clock = 0;
+    mserialize::serialize(size, input);
+    mserialize::serialize(id, input);
+    mserialize::serialize(clock, input);
+  };
+
+  const std::uint64_t sparseId = std::uint64_t(1) << 40;
+  addSource(3, binlog::Severity::info);
+  addSource(sparseId, binlog::Severity::info);
+  addEvent(3);
+  addEvent(sparseId);
+  addSource(3, binlog::Severity::debug); // redefined, not allowed anymore
+  addSource(sparseId, binlog::Severity::debug);
+  addEvent(3);
+  addEvent(sparseId);
+  addEvent(4); // unknown source
+
+  binlog::EventFilter filter(binlog::EventFilter::severityAtLeast(binlog::Severity::info));
+  TestStream output;
+  filter.writeAllowed(input.buffer.data(), input.buffer.size(), output);
+
+  CHECK(streamToEvents(output, "%m") == std::vector<std::string>{"id=3", "id=1099511627776"});
+  CHECK(! filter.isAllowed(3));
+  CHECK(! filter.isAllowed(sparseId));
+}
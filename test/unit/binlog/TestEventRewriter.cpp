@@ -0,0 +1,257 @@
+#include <rewrite.hpp>
+
+#include <binlog/Entries.hpp>
+#include <binlog/EntryStream.hpp>
+#include <binlog/EventStream.hpp>
+#include <binlog/MergedEventStream.hpp>
+
+#include <binlog/detail/OstreamBuffer.hpp>
+
+#include <mserialize/make_struct_serializable.hpp>
+#include <mserialize/serialize.hpp>
+
+#include "test_utils.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct RewrittenEvent
+{
+  std::uint64_t eventSourceId;
+  std::uint64_t clockValue;
+  std::int32_t argument;
+};
+
+void addEvent(TestStream& out, std::uint64_t eventSourceId, std::uint64_t clockValue, std::int32_t argument)
+{
+  const RewrittenEvent event{eventSourceId, clockValue, argument};
+  const std::uint32_t size = std::uint32_t(mserialize::serialized_size(event));
+  mserialize::serialize(size, out);
+  mserialize::serialize(event, out);
+}
+
+void addSource(TestStream& out, std::uint64_t id, std::string format, std::string category = "main")
+{
+  binlog::EventSource source;
+  source.id = id;
+  source.category = std::move(category);
+  source.file = "dir/file.cpp";
+  source.formatString = std::move(format);
+  source.argumentTags = "i";
+  serializeSizePrefixedTagged(source, out);
+}
+
+void addWriter(TestStream& out, std::uint64_t id, std::string name)
+{
+  serializeSizePrefixedTagged(binlog::WriterProp{id, std::move(name), 0}, out);
+}
+
+// Rewrite the merged `inputs`, return the output
+std::string rewrite(std::vector<TestStream*> inputs, const EventSelector& selector, std::uint64_t& eventCount, std::size_t& sourceCount)
+{
+  binlog::MergedEventStream merged;
+  for (TestStream* input : inputs) { merged.addInput(*input); }
+
+  std::ostringstream str;
+  {
+    binlog::detail::OstreamBuffer out(str);
+    EventRewriter rewriter(out, selector);
+    while (const binlog::Event* event = merged.nextEvent())
+    {
+      rewriter.write(merged.inputIndex(), *event, merged.writerProp(), merged.clockSync(), merged.time());
+    }
+    eventCount = rewriter.eventCount();
+    sourceCount = rewriter.sourceCount();
+  }
+  return str.str();
+}
+
+// Describe each event of `data`: "<source id> <format> <writer> <clock> <argument>"
+std::vector<std::string> readEvents(const std::string& data)
+{
+  binlog::RangeEntryStream input(binlog::Range(data.data(), data.size()));
+  binlog::EventStream eventStream;
+  std::vector<std::string> result;
+  while (const binlog::Event* event = eventStream.nextEvent(input))
+  {
+    binlog::Range args = event->arguments;
+    result.push_back(
+      std::to_string(event->source->id) + " " + event->source->formatString + " "
+      + eventStream.writerProp().name + " " + std::to_string(event->clockValue) + " "
+      + std::to_string(args.read<std::int32_t>())
+    );
+    CHECK(eventStream.clockSync().clockFrequency == 1000000000);
+  }
+  return result;
+}
+
+} // namespace
+
+MSERIALIZE_MAKE_STRUCT_SERIALIZABLE(RewrittenEvent, eventSourceId, clockValue, argument)
+
+TEST_CASE("rewrite_merged_inputs")
+{
+  // input1: 1 tick = 1 ns, clock 0 = 1000 ns since epoch
+  TestStream input1;
+  serializeSizePrefixedTagged(binlog::ClockSync{0, 1000000000, 1000, 3600, "CET"}, input1);
+  addSource(input1, 1, "a {}");
+  addSource(input1, 2, "b {}");
+  addWriter(input1, 10, "w1");
+  addEvent(input1, 1, 100, 1); // 1100
+  addEvent(input1, 2, 300, 2); // 1300
+
+  // input2: 1 tick = 10 ns, clock 0 = 0 ns since epoch, source 7 = source 2 of input1
+  TestStream input2;
+  serializeSizePrefixedTagged(binlog::ClockSync{0, 100000000, 0, 0, "UTC"}, input2);
+  addSource(input2, 1, "c {}");
+  addSource(input2, 7, "b {}");
+  addWriter(input2, 20, "w2");
+  addEvent(input2, 7, 100, 3); // 1000
+  addEvent(input2, 1, 120, 4); // 1200
+
+  std::uint64_t eventCount = 0;
+  std::size_t sourceCount = 0;
+  const std::string output = rewrite({&input1, &input2}, EventSelector{}, eventCount, sourceCount);
+  CHECK(eventCount == 4);
+  CHECK(sourceCount == 3);
+
+  const std::vector<std::string> expected{
+    "1 b {} w2 1000 3",
+    "2 a {} w1 1100 1",
+    "3 c {} w2 1200 4",
+    "1 b {} w1 1300 2",
+  };
+  CHECK(readEvents(output) == expected);
+
+  // time zone of the first event is kept
+  binlog::RangeEntryStream input(binlog::Range(output.data(), output.size()));
+  binlog::EventStream eventStream;
+  REQUIRE(eventStream.nextEvent(input) != nullptr);
+  CHECK(eventStream.clockSync().tzName == "UTC");
+}
+
+TEST_CASE("rewrite_redefined_source")
+{
+  // concatenated logfiles: the second one reuses the source id
+  TestStream input;
+  serializeSizePrefixedTagged(binlog::ClockSync{0, 1000000000, 0, 0, "UTC"}, input);
+  addWriter(input, 10, "w1");
+  addSource(input, 1, "a {}");
+  addEvent(input, 1, 100, 1);
+  addSource(input, 1, "b {}");
+  addEvent(input, 1, 200, 2);
+  addSource(input, 1, "a {}");
+  addEvent(input, 1, 300, 3);
+
+  std::uint64_t eventCount = 0;
+  std::size_t sourceCount = 0;
+  const std::string output = rewrite({&input}, EventSelector{}, eventCount, sourceCount);
+  CHECK(eventCount == 3);
+  CHECK(sourceCount == 2);
+
+  const std::vector<std::string> expected{
+    "1 a {} w1 100 1",
+    "2 b {} w1 200 2",
+    "1 a {} w1 300 3",
+  };
+  CHECK(readEvents(output) == expected);
+}
+
+TEST_CASE("rewrite_selected_events")
+{
+  TestStream input1;
+  addSource(input1, 1, "a {}", "main");
+  addSource(input1, 2, "b {}", "other");
+  addSource(input1, 3, "c {}", "main");
+  addWriter(input1, 10, "w1");
+  addEvent(input1, 1, 100, 1);
+  addEvent(input1, 2, 200, 2);
+  addEvent(input1, 3, 300, 3);
+  addWriter(input1, 20, "w2");
+  addEvent(input1, 1, 400, 4);
+  addEvent(input1, 3, 500, 5);
+  addWriter(input1, 10, "w1");
+  addEvent(input1, 1, 600, 6);
+
+  EventSelector selector;
+  selector.category = "main";
+  selector.writer = "w1";
+  selector.beginNs = 200;
+  selector.endNs = 600;
+
+  std::uint64_t eventCount = 0;
+  std::size_t sourceCount = 0;
+  const std::string output = rewrite({&input1}, selector, eventCount, sourceCount);
+  CHECK(eventCount == 1);
+  CHECK(sourceCount == 1);
+
+  const std::vector<std::string> expected{"1 c {} w1 300 3"};
+  CHECK(readEvents(output) == expected);
+}
+
+TEST_CASE("select_event_source")
+{
+  binlog::EventSource source;
+  source.severity = binlog::Severity::warning;
+  source.category = "orders";
+  source.file = "/src/app/order.cpp";
+  source.formatString = "Order {} filled";
+
+  EventSelector selector;
+  CHECK(selector.matches(source));
+
+  selector.minSeverity = binlog::Severity::warning;
+  selector.category = "orders";
+  selector.file = "app/order.cpp";
+  selector.format = "filled";
+  CHECK(selector.matches(source));
+
+  EventSelector s1 = selector;
+  s1.minSeverity = binlog::Severity::error;
+  CHECK(! s1.matches(source));
+
+  EventSelector s2 = selector;
+  s2.category = "order";
+  CHECK(! s2.matches(source));
+
+  EventSelector s3 = selector;
+  s3.file = "border.cpp";
+  CHECK(! s3.matches(source));
+
+  EventSelector s4 = selector;
+  s4.format = "cancelled";
+  CHECK(! s4.matches(source));
+}
+
+TEST_CASE("parse_selector_severity_and_time")
+{
+  binlog::Severity severity = binlog::Severity::trace;
+  CHECK(EventSelector::parseSeverity("warning", severity));
+  CHECK(severity == binlog::Severity::warning);
+  CHECK(EventSelector::parseSeverity("ERRO", severity));
+  CHECK(severity == binlog::Severity::error);
+  CHECK(! EventSelector::parseSeverity("loud", severity));
+
+  std::int64_t ns = 0;
+  CHECK(EventSelector::parseTime("1569939300000000000", ns));
+  CHECK(ns == 1569939300000000000);
+  CHECK(EventSelector::parseTime("2019-10-01 14:15:00", ns));
+  CHECK(ns == 1569939300000000000);
+  CHECK(EventSelector::parseTime("2019-10-01T14:15:00.25", ns));
+  CHECK(ns == 1569939300250000000);
+  CHECK(EventSelector::parseTime("1969-12-31 23:59:59", ns));
+  CHECK(ns == -1000000000);
+
+  CHECK(! EventSelector::parseTime("", ns));
+  CHECK(! EventSelector::parseTime("2019-10-01", ns));
+  CHECK(! EventSelector::parseTime("2019-13-01 14:15:00", ns));
+  CHECK(! EventSelector::parseTime("2019-10-01 14:15:00.", ns));
+  CHECK(! EventSelector::parseTime("2019-10-01 14:15:00x", ns));
+}
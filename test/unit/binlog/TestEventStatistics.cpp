@@ -0,0 +1,196 @@
+#include <stats.hpp>
+
+#include <binlog/Entries.hpp>
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+binlog::EventSource testEventSource(std::uint64_t id, std::string formatString)
+{
+  binlog::EventSource source;
+  source.id = id;
+  source.category = "main";
+  source.file = "file.cpp";
+  source.line = id;
+  source.formatString = std::move(formatString);
+  return source;
+}
+
+binlog::Event testEvent(const binlog::EventSource& source, std::uint64_t clockValue, const char* args, std::size_t argsSize)
+{
+  binlog::Event event;
+  event.source = &source;
+  event.clockValue = clockValue;
+  event.arguments = binlog::Range(args, argsSize);
+  return event;
+}
+
+} // namespace
+
+TEST_CASE("empty_statistics")
+{
+  const EventStatistics stats;
+  CHECK(stats.sources().empty());
+  CHECK(stats.writers().empty());
+  CHECK(stats.durationNs() == 0);
+
+  std::ostringstream out;
+  stats.print(out);
+  CHECK(out.str().find("Events: 0, bytes: 0") != std::string::npos);
+}
+
+TEST_CASE("count_sources_and_writers")
+{
+  const binlog::EventSource source1 = testEventSource(1, "foo");
+  const binlog::EventSource source2 = testEventSource(2, "bar {}");
+  const binlog::WriterProp writer1{10, "w1", 0};
+  const binlog::WriterProp writer2{20, "w2", 0};
+  const binlog::ClockSync clockSync{0, 1000, 0, 0, "UTC"}; // 1 tick = 1 ms
+
+  const char args[8] = {};
+  EventStatistics stats;
+
+  // second 0: 3 events of source1, 1 of source2
+  stats.add(testEvent(source1, 0, args, 0), writer1, clockSync);
+  stats.add(testEvent(source1, 100, args, 0), writer1, clockSync);
+  stats.add(testEvent(source1, 999, args, 0), writer2, clockSync);
+  stats.add(testEvent(source2, 500, args, 8), writer2, clockSync);
+
+  // second 2: 1 event of source1, 2 of source2
+  stats.add(testEvent(source1, 2000, args, 0), writer1, clockSync);
+  stats.add(testEvent(source2, 2500, args, 8), writer2, clockSync);
+  stats.add(testEvent(source2, 2999, args, 8), writer2, clockSync);
+
+  // out of order, older than the tracked seconds: counted, not in peak
+  stats.add(testEvent(source2, 10000, args, 8), writer2, clockSync);
+  stats.add(testEvent(source2, 6000, args, 8), writer2, clockSync);
+
+  REQUIRE(stats.sources().size() == 2);
+  REQUIRE(stats.writers().size() == 2);
+  CHECK(stats.durationNs() == 10000000000);
+
+  const EventStatistics::Counter& c1 = stats.sources()[0].counter;
+  CHECK(c1.count == 4);
+  CHECK(c1.bytes == 4 * 20);
+  CHECK(c1.finalPeak() == 3);
+  CHECK(stats.sources()[0].source.formatString == "foo");
+
+  const EventStatistics::Counter& c2 = stats.sources()[1].counter;
+  CHECK(c2.count == 5);
+  CHECK(c2.bytes == 5 * 28);
+  CHECK(c2.finalPeak() == 2);
+
+  const EventStatistics::Counter& w1 = stats.writers()[0].counter;
+  CHECK(w1.count == 3);
+  CHECK(w1.finalPeak() == 2);
+  CHECK(stats.writers()[0].name == "w1");
+
+  const EventStatistics::Counter& w2 = stats.writers()[1].counter;
+  CHECK(w2.count == 6);
+  CHECK(w2.bytes == 20 + 5 * 28);
+
+  std::ostringstream out;
+  stats.print(out);
+  const std::string str = out.str();
+  CHECK(str.find("Events: 9, bytes: 220, duration: 10.0 s") != std::string::npos);
+
+  // ordered by bytes
+  const std::size_t pos1 = str.find("INFO main file.cpp:1 \"foo\"");
+  const std::size_t pos2 = str.find("INFO main file.cpp:2 \"bar {}\"");
+  CHECK(pos1 != std::string::npos);
+  CHECK(pos2 < pos1);
+  CHECK(str.find("20 w2") != std::string::npos);
+}
+
+TEST_CASE("redefined_sources_and_named_writers")
+{
+  binlog::EventSource source = testEventSource(1, "foo");
+  const binlog::WriterProp writer1{0, "w1", 0};
+  const binlog::WriterProp writer2{0, "w2", 0};
+  const binlog::ClockSync clockSync{0, 1000, 0, 0, "UTC"};
+
+  const char args[8] = {};
+  EventStatistics stats;
+
+  stats.add(testEvent(source, 0, args, 0), writer1, clockSync);
+  stats.add(testEvent(source, 1, args, 0), writer2, clockSync);
+
+  // the id is redefined in place (as EventStream does)
+  source.formatString = "bar {}";
+  source.argumentTags = "i";
+  stats.add(testEvent(source, 2, args, 4), writer1, clockSync);
+
+  REQUIRE(stats.sources().size() == 2);
+  CHECK(stats.sources()[0].source.formatString == "foo");
+  CHECK(stats.sources()[0].counter.count == 2);
+  CHECK(stats.sources()[1].source.formatString == "bar {}");
+  CHECK(stats.sources()[1].counter.count == 1);
+
+  // writers with the same id, but different names are not merged
+  REQUIRE(stats.writers().size() == 2);
+  CHECK(stats.writers()[0].name == "w1");
+  CHECK(stats.writers()[0].counter.count == 2);
+  CHECK(stats.writers()[1].name == "w2");
+  CHECK(stats.writers()[1].counter.count == 1);
+}
+
+TEST_CASE("rate_over_time")
+{
+  const binlog::EventSource source1 = testEventSource(1, "foo");
+  const binlog::EventSource source2 = testEventSource(2, "bar");
+  const binlog::WriterProp writer{10, "w1", 0};
+  const binlog::ClockSync clockSync{0, 1000, 0, 0, "UTC"}; // 1 tick = 1 ms
+
+  const char args[8] = {};
+  EventStatistics stats(10); // 10 s intervals
+
+  // [0s, 10s): 4 events of source1
+  for (std::uint64_t i = 0; i < 4; ++i)
+  {
+    stats.add(testEvent(source1, i * 1000, args, 0), writer, clockSync);
+  }
+
+  // [20s, 30s): 1 event of source1, 2 of source2
+  stats.add(testEvent(source1, 25000, args, 0), writer, clockSync);
+  stats.add(testEvent(source2, 21000, args, 0), writer, clockSync);
+  stats.add(testEvent(source2, 29999, args, 0), writer, clockSync);
+
+  const auto& b1 = stats.sources()[0].counter.buckets;
+  CHECK(b1 == std::map<std::int64_t, std::uint64_t>{{0, 4}, {20, 1}});
+  const auto& b2 = stats.sources()[1].counter.buckets;
+  CHECK(b2 == std::map<std::int64_t, std::uint64_t>{{20, 2}});
+  const auto& bw = stats.writers()[0].counter.buckets;
+  CHECK(bw == std::map<std::int64_t, std::uint64_t>{{0, 4}, {20, 3}});
+
+  std::ostringstream out;
+  stats.print(out);
+  const std::string str = out.str();
+  CHECK(str.find("Sources per 10 s interval:") != std::string::npos);
+  CHECK(str.find("1970-01-01 00:00:00             4         0.4  INFO main file.cpp:1 \"foo\"") != std::string::npos);
+  CHECK(str.find("1970-01-01 00:00:20             2         0.2  INFO main file.cpp:2 \"bar\"") != std::string::npos);
+  CHECK(str.find("1970-01-01 00:00:20             3         0.3  10 w1") != std::string::npos);
+  CHECK(str.find("00:00:10") == std::string::npos); // no events, not printed
+}
+
+TEST_CASE("no_rate_over_time_by_default")
+{
+  const binlog::EventSource source = testEventSource(1, "foo");
+  const binlog::WriterProp writer{10, "w1", 0};
+  const binlog::ClockSync clockSync{0, 1000, 0, 0, "UTC"};
+
+  const char args[8] = {};
+  EventStatistics stats;
+  stats.add(testEvent(source, 0, args, 0), writer, clockSync);
+
+  CHECK(stats.sources()[0].counter.buckets.empty());
+
+  std::ostringstream out;
+  stats.print(out);
+  CHECK(out.str().find("interval") == std::string::npos);
+}
@@ -187,6 +187,30 @@ TEST_CASE("read_event_with_args")
   CHECK(e2 == nullptr);
 }
 
+TEST_CASE("read_event_message_template")
+{
+  binlog::EventSource eventSource = testEventSource(123, "foo", "iy");
+  eventSource.formatString = "a: {}, b: {}";
+  const TestEvent<int, bool> event{123, 0, std::make_tuple(789, true)};
+
+  TestStream stream;
+  serializeSizePrefixedTagged(eventSource, stream);
+  serializeSizePrefixed(event, stream);
+
+  binlog::EventStream eventStream;
+
+  const binlog::Event* e1 = eventStream.nextEvent(stream);
+  REQUIRE(e1 != nullptr);
+  REQUIRE(e1->messageTemplate != nullptr);
+
+  const binlog::MessageTemplate& mt = *e1->messageTemplate;
+  REQUIRE(mt.size() == 2);
+  CHECK(mt.segment(0).literal == "a: ");
+  CHECK(mt.segment(0).argumentTag == "i");
+  CHECK(mt.segment(1).literal == ", b: ");
+  CHECK(mt.segment(1).argumentTag == "y");
+}
+
 TEST_CASE("multiple_sources")
 {
   const binlog::EventSource eventSource1 = testEventSource(123, "foo");
@@ -220,6 +244,24 @@ TEST_CASE("multiple_sources")
   }
 }
 
+TEST_CASE("has_event_source")
+{
+  TestStream stream;
+  serializeSizePrefixedTagged(testEventSource(123), stream);
+  serializeSizePrefixedTagged(testEventSource(0), stream);
+  serializeSizePrefixed(TestEvent<>{123, 0, {}}, stream);
+
+  binlog::EventStream eventStream;
+  CHECK(! eventStream.hasEventSource(0));
+  CHECK(! eventStream.hasEventSource(123));
+
+  CHECK(eventStream.nextEvent(stream) != nullptr);
+  CHECK(eventStream.hasEventSource(0));
+  CHECK(eventStream.hasEventSource(123));
+  CHECK(! eventStream.hasEventSource(1));
+  CHECK(! eventStream.hasEventSource(124));
+}
+
 TEST_CASE("override_event_source")
 {
   const binlog::EventSource eventSource1 = testEventSource(123, "foo");
@@ -0,0 +1,52 @@
+#include <eventtime.hpp>
+
+#include <binlog/Entries.hpp>
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+
+TEST_CASE("event_ns")
+{
+  binlog::Event event;
+  event.clockValue = 123;
+  CHECK(eventNs(event, binlog::ClockSync{}) == 123); // no clock sync
+
+  const binlog::ClockSync clockSync{0, 1000, 5000000000, 0, "UTC"}; // 1 tick = 1 ms
+  CHECK(eventNs(event, clockSync) == 5123000000);
+}
+
+TEST_CASE("floor_div")
+{
+  CHECK(floorDiv(7, 2) == 3);
+  CHECK(floorDiv(6, 2) == 3);
+  CHECK(floorDiv(-7, 2) == -4);
+  CHECK(floorDiv(-6, 2) == -3);
+}
+
+TEST_CASE("time_label")
+{
+  CHECK(timeLabel(0) == "1970-01-01 00:00:00");
+  CHECK(timeLabel(1569939300) == "2019-10-01 14:15:00");
+}
+
+TEST_CASE("parse_interval")
+{
+  std::int64_t seconds = 0;
+  CHECK(parseInterval("30s", seconds));
+  CHECK(seconds == 30);
+  CHECK(parseInterval("5m", seconds));
+  CHECK(seconds == 300);
+  CHECK(parseInterval("2h", seconds));
+  CHECK(seconds == 7200);
+
+  std::int64_t invalid = 0;
+  CHECK(! parseInterval("", invalid));
+  CHECK(! parseInterval("s", invalid));
+  CHECK(! parseInterval("0s", invalid));
+  CHECK(! parseInterval("-1s", invalid));
+  CHECK(! parseInterval("10d", invalid));
+  CHECK(! parseInterval("arg:1", invalid));
+  CHECK(! parseInterval("999999999h", invalid)); // overflows in nanoseconds
+  CHECK(invalid == 0);
+}
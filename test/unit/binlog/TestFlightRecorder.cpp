@@ -0,0 +1,198 @@
+#include <binlog/FlightRecorder.hpp>
+
+#include <binlog/Session.hpp>
+#include <binlog/SessionWriter.hpp>
+#include <binlog/advanced_log_macros.hpp>
+
+#include "test_utils.hpp"
+
+#include <mserialize/serialize.hpp>
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <cstdio> // remove
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char* g_recorderPath = "binlog_unittest_flight.blog";
+
+std::vector<std::string> dumpedEvents(const char* eventFormat)
+{
+  std::ifstream file(g_recorderPath, std::ios_base::in | std::ios_base::binary);
+  TestStream stream;
+  stream.buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return streamToEvents(stream, eventFormat);
+}
+
+} // namespace
+
+TEST_CASE("dump_on_request")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512, 1, "w1");
+
+  {
+    binlog::FlightRecorder recorder(4096, g_recorderPath);
+    CHECK(recorder.capacity() == 4096);
+    CHECK(recorder.path() == g_recorderPath);
+
+    BINLOG_DEBUG_W(writer, "Hello {}", 1);
+    BINLOG_TRACE_W(writer, "Hello {}", 2);
+    session.consume(recorder);
+    CHECK(recorder.size() != 0);
+
+    // nothing is written until dump
+    CHECK(dumpedEvents("%m").empty());
+
+    recorder.dump();
+    CHECK(recorder.size() == 0);
+    CHECK(dumpedEvents("%n %S %m") == std::vector<std::string>{"w1 DEBG Hello 1", "w1 TRAC Hello 2"});
+
+    // dump again: recorded events are not repeated
+    BINLOG_INFO_W(writer, "Hello {}", 3);
+    session.consume(recorder);
+    recorder.dump();
+    recorder.dump();
+  }
+
+  CHECK(dumpedEvents("%n %m") == std::vector<std::string>{"w1 Hello 1", "w1 Hello 2", "w1 Hello 3"});
+  std::remove(g_recorderPath);
+}
+
+TEST_CASE("evict_oldest")
+{
+  binlog::Session session;
+  binlog::SessionWriter w1(session, 512, 1, "w1");
+  binlog::SessionWriter w2(session, 512, 2, "w2");
+
+  // log the same source repeatedly, evicted events must not take their source
+  std::vector<std::string> expectedEvents;
+  {
+    binlog::FlightRecorder recorder(512, g_recorderPath);
+
+    for (int i = 0; i < 100; ++i)
+    {
+      BINLOG_INFO_W(w1, "Hello {}", i);
+      expectedEvents.push_back("w1 Hello " + std::to_string(i));
+      if (i % 10 == 0)
+      {
+        BINLOG_INFO_W(w2, "Hi {}", i);
+        expectedEvents.push_back("w2 Hi " + std::to_string(i));
+      }
+
+      session.consume(recorder);
+      CHECK(recorder.size() <= recorder.capacity());
+    }
+
+    recorder.dump();
+  }
+
+  // the dump is a complete suffix of the logged events:
+  // the writer of the oldest event is kept, even if its WriterProp is evicted
+  const std::vector<std::string> events = dumpedEvents("%n %m");
+  REQUIRE(! events.empty());
+  CHECK(events.size() < expectedEvents.size());
+  CHECK(std::vector<std::string>(expectedEvents.end() - std::ptrdiff_t(events.size()), expectedEvents.end()) == events);
+
+  std::remove(g_recorderPath);
+}
+
+TEST_CASE("dump_on_severity")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512);
+
+  {
+    binlog::FlightRecorder recorder(4096, g_recorderPath, binlog::Severity::warning);
+
+    BINLOG_DEBUG_W(writer, "a");
+    session.consume(recorder);
+    CHECK(dumpedEvents("%m").empty());
+
+    BINLOG_DEBUG_W(writer, "b");
+    BINLOG_WARN_W(writer, "c");
+    BINLOG_DEBUG_W(writer, "d"); // consumed in the same batch as the trigger
+    session.consume(recorder);
+    CHECK(dumpedEvents("%m") == std::vector<std::string>{"a", "b", "c", "d"});
+
+    BINLOG_INFO_W(writer, "e");
+    session.consume(recorder);
+    CHECK(dumpedEvents("%m").size() == 4);
+
+    BINLOG_ERROR_W(writer, "f");
+    session.consume(recorder);
+    CHECK(dumpedEvents("%m") == std::vector<std::string>{"a", "b", "c", "d", "e", "f"});
+  }
+
+  std::remove(g_recorderPath);
+}
+
+TEST_CASE("redefined_trigger_source")
+{
+  const auto addSource = [](TestStream& out, binlog::Severity severity)
+  {
+    binlog::EventSource source;
+    source.id = 1;
+    source.severity = severity;
+    source.formatString = "x";
+    serializeSizePrefixedTagged(source, out);
+  };
+
+  const auto addEvent = [](TestStream& out)
+  {
+    const std::uint32_t size = 2 * sizeof(std::uint64_t);
+    mserialize::serialize(size, out);
+    mserialize::serialize(std::uint64_t(1), out); // source id
+    mserialize::serialize(std::uint64_t(0), out); // clock
+  };
+
+  {
+    binlog::FlightRecorder recorder(4096, g_recorderPath, binlog::Severity::warning);
+
+    // the id of a trigger source is redefined, with a lower severity
+    TestStream stream;
+    addSource(stream, binlog::Severity::error);
+    addSource(stream, binlog::Severity::info);
+    addEvent(stream);
+    recorder.write(stream.buffer.data(), std::streamsize(stream.buffer.size()));
+    CHECK(dumpedEvents("%m").empty());
+
+    TestStream stream2;
+    addSource(stream2, binlog::Severity::critical);
+    addEvent(stream2);
+    recorder.write(stream2.buffer.data(), std::streamsize(stream2.buffer.size()));
+    CHECK(dumpedEvents("%m") == std::vector<std::string>{"x", "x"});
+  }
+
+  std::remove(g_recorderPath);
+}
+
+TEST_CASE("entry_larger_than_capacity")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 4096);
+
+  {
+    binlog::FlightRecorder recorder(256, g_recorderPath);
+
+    BINLOG_INFO_W(writer, "small");
+    BINLOG_INFO_W(writer, "{}", std::string(512, 'x'));
+    BINLOG_INFO_W(writer, "small again");
+    session.consume(recorder);
+    recorder.dump();
+  }
+
+  CHECK(dumpedEvents("%m") == std::vector<std::string>{"small", "small again"});
+  std::remove(g_recorderPath);
+}
+
+TEST_CASE("flight_recorder_open_failure")
+{
+  CHECK_THROWS_AS(binlog::FlightRecorder(128, "/nonexistent/dir/file.blog"), std::runtime_error);
+}
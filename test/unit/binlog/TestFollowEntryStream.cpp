@@ -0,0 +1,149 @@
+#include <follow.hpp>
+
+#include <binlog/EventStream.hpp>
+#include <binlog/Session.hpp>
+#include <binlog/SessionWriter.hpp>
+#include <binlog/advanced_log_macros.hpp>
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void appendFile(const std::string& path, const std::string& data)
+{
+  std::ofstream file(path, std::ios_base::out | std::ios_base::binary | std::ios_base::app);
+  file.write(data.data(), std::streamsize(data.size()));
+}
+
+// The log call site in logInts registers its event source
+// only once, therefore every test uses the same session
+binlog::Session& session()
+{
+  static binlog::Session s;
+  return s;
+}
+
+std::string metadata()
+{
+  std::ostringstream stream;
+  session().reconsumeMetadata(stream);
+  return stream.str();
+}
+
+// Log the integers in [begin, end), return the binary log
+std::string logInts(int begin, int end)
+{
+  binlog::SessionWriter writer(session(), 512);
+  for (int i = begin; i < end; ++i)
+  {
+    BINLOG_INFO_W(writer, "{}", i);
+  }
+
+  std::ostringstream stream;
+  session().consume(stream);
+  return stream.str();
+}
+
+// Read every complete event from `input`, return their first argument
+std::vector<int> readInts(binlog::EventStream& eventStream, FollowEntryStream& input)
+{
+  std::vector<int> result;
+  while (const binlog::Event* event = eventStream.nextEvent(input))
+  {
+    binlog::Range args = event->arguments;
+    result.push_back(args.read<int>());
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("follow_growing_file")
+{
+  const std::string path = "binlog_test_follow_growing_file.blog";
+  (void)std::remove(path.data());
+  appendFile(path, "");
+
+  const std::string data = metadata() + logInts(0, 3);
+
+  FollowEntryStream input(path);
+  binlog::EventStream eventStream;
+  CHECK(readInts(eventStream, input).empty());
+
+  // write the log in small pieces, partial entries are not consumed
+  std::vector<int> ints;
+  for (std::size_t i = 0; i < data.size(); i += 7)
+  {
+    appendFile(path, data.substr(i, 7));
+    const std::vector<int> some = readInts(eventStream, input);
+    ints.insert(ints.end(), some.begin(), some.end());
+  }
+
+  CHECK(ints == std::vector<int>{0, 1, 2});
+  CHECK(input.droppedBytes() == 0);
+
+  (void)std::remove(path.data());
+}
+
+TEST_CASE("follow_rotated_file")
+{
+  const std::string path = "binlog_test_follow_rotated_file.blog";
+  const std::string rotatedPath = "binlog_test_follow_rotated_file.1.blog";
+  (void)std::remove(path.data());
+  (void)std::remove(rotatedPath.data());
+
+  appendFile(path, metadata() + logInts(0, 2));
+
+  FollowEntryStream input(path);
+  binlog::EventStream eventStream;
+  CHECK(readInts(eventStream, input) == std::vector<int>{0, 1});
+
+  // written before rotation, but not yet seen by the reader
+  appendFile(path, logInts(2, 3));
+
+  // rotate as in LogRotation.cpp
+  REQUIRE(std::rename(path.data(), rotatedPath.data()) == 0);
+  appendFile(path, metadata() + logInts(3, 5));
+
+  input.wait(std::chrono::milliseconds(1000)); // woken by the change
+  CHECK(readInts(eventStream, input) == std::vector<int>{2, 3, 4});
+
+  (void)std::remove(path.data());
+  (void)std::remove(rotatedPath.data());
+}
+
+TEST_CASE("follow_truncated_file")
+{
+  const std::string path = "binlog_test_follow_truncated_file.blog";
+  (void)std::remove(path.data());
+
+  appendFile(path, metadata() + logInts(0, 2));
+
+  FollowEntryStream input(path);
+  binlog::EventStream eventStream;
+  CHECK(readInts(eventStream, input) == std::vector<int>{0, 1});
+
+  // truncate, then write a shorter log, that relies on the already seen metadata
+  {
+    std::ofstream file(path, std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  }
+  CHECK(readInts(eventStream, input).empty());
+
+  appendFile(path, logInts(2, 3));
+  CHECK(readInts(eventStream, input) == std::vector<int>{2});
+
+  (void)std::remove(path.data());
+}
+
+TEST_CASE("follow_missing_file")
+{
+  CHECK_THROWS_AS(FollowEntryStream("binlog_test_follow_missing_file.blog"), std::runtime_error);
+}
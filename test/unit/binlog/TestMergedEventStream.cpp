@@ -0,0 +1,191 @@
+#include <binlog/MergedEventStream.hpp>
+
+#include <binlog/Entries.hpp>
+
+#include <mserialize/make_struct_serializable.hpp>
+#include <mserialize/serialize.hpp>
+
+#include "test_utils.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct TestEvent
+{
+  std::uint64_t eventSourceId;
+  std::uint64_t clockValue;
+};
+
+void addEvent(TestStream& out, std::uint64_t eventSourceId, std::uint64_t clockValue)
+{
+  const TestEvent event{eventSourceId, clockValue};
+  const std::uint32_t size = std::uint32_t(mserialize::serialized_size(event));
+  mserialize::serialize(size, out);
+  mserialize::serialize(event, out);
+}
+
+void addSource(TestStream& out, std::uint64_t id, std::string format)
+{
+  binlog::EventSource source;
+  source.id = id;
+  source.formatString = std::move(format);
+  serializeSizePrefixedTagged(source, out);
+}
+
+// Returns the format string of each event and the index of its input
+std::vector<std::pair<std::string, std::size_t>> mergeEvents(binlog::MergedEventStream& stream)
+{
+  std::vector<std::pair<std::string, std::size_t>> result;
+  while (const binlog::Event* event = stream.nextEvent())
+  {
+    result.emplace_back(event->source->formatString, stream.inputIndex());
+  }
+  return result;
+}
+
+using Result = std::vector<std::pair<std::string, std::size_t>>;
+
+} // namespace
+
+MSERIALIZE_MAKE_STRUCT_SERIALIZABLE(TestEvent, eventSourceId, clockValue)
+
+TEST_CASE("no_input")
+{
+  binlog::MergedEventStream stream;
+  CHECK(stream.inputCount() == 0);
+  CHECK(stream.nextEvent() == nullptr);
+}
+
+TEST_CASE("single_input")
+{
+  TestStream input;
+  addSource(input, 1, "a");
+  addSource(input, 2, "b");
+  addEvent(input, 1, 10);
+  addEvent(input, 2, 20);
+  addEvent(input, 1, 15);
+
+  binlog::MergedEventStream stream;
+  CHECK(stream.addInput(input) == 0);
+
+  // a single input is not reordered
+  const Result expected{{"a", 0}, {"b", 0}, {"a", 0}};
+  CHECK(mergeEvents(stream) == expected);
+}
+
+TEST_CASE("merge_by_raw_clock")
+{
+  TestStream input1;
+  addSource(input1, 1, "a");
+  addEvent(input1, 1, 10);
+  addEvent(input1, 1, 30);
+  addEvent(input1, 1, 50);
+
+  TestStream input2;
+  addSource(input2, 1, "b");
+  addEvent(input2, 1, 20);
+  addEvent(input2, 1, 30);
+  addEvent(input2, 1, 40);
+  addEvent(input2, 1, 60);
+
+  binlog::MergedEventStream stream;
+  CHECK(stream.addInput(input1) == 0);
+  CHECK(stream.addInput(input2) == 1);
+  CHECK(stream.inputCount() == 2);
+
+  const Result expected{
+    {"a", 0}, {"b", 1}, {"a", 0}, {"b", 1}, {"b", 1}, {"a", 0}, {"b", 1},
+  };
+  CHECK(mergeEvents(stream) == expected);
+}
+
+TEST_CASE("merge_by_clock_sync")
+{
+  // input1: 1 tick = 1 ns, clock 0 = 1000 ns since epoch
+  TestStream input1;
+  serializeSizePrefixedTagged(binlog::ClockSync{0, 1000000000, 1000, 0, "UTC"}, input1);
+  addSource(input1, 1, "a");
+  addEvent(input1, 1, 100); // 1100
+  addEvent(input1, 1, 300); // 1300
+
+  // input2: 1 tick = 10 ns, clock 0 = 0 ns since epoch
+  TestStream input2;
+  serializeSizePrefixedTagged(binlog::ClockSync{0, 100000000, 0, 0, "UTC"}, input2);
+  addSource(input2, 7, "b");
+  addEvent(input2, 7, 100); // 1000
+  addEvent(input2, 7, 120); // 1200
+  addEvent(input2, 7, 140); // 1400
+
+  binlog::MergedEventStream stream;
+  stream.addInput(input1);
+  stream.addInput(input2);
+
+  REQUIRE(stream.nextEvent() != nullptr);
+  CHECK(stream.inputIndex() == 1);
+  CHECK(stream.time() == 1000);
+  CHECK(stream.clockSync().clockFrequency == 100000000);
+
+  REQUIRE(stream.nextEvent() != nullptr);
+  CHECK(stream.inputIndex() == 0);
+  CHECK(stream.time() == 1100);
+  CHECK(stream.clockSync().clockFrequency == 1000000000);
+
+  const Result expected{{"b", 1}, {"a", 0}, {"b", 1}};
+  CHECK(mergeEvents(stream) == expected);
+}
+
+TEST_CASE("merge_writer_props")
+{
+  TestStream input1;
+  addSource(input1, 1, "a");
+  serializeSizePrefixedTagged(binlog::WriterProp{1, "w1", 0}, input1);
+  addEvent(input1, 1, 10);
+  addEvent(input1, 1, 30);
+
+  TestStream input2;
+  addSource(input2, 1, "b");
+  serializeSizePrefixedTagged(binlog::WriterProp{2, "w2", 0}, input2);
+  addEvent(input2, 1, 20);
+
+  binlog::MergedEventStream stream;
+  stream.addInput(input1);
+  stream.addInput(input2);
+
+  std::vector<std::string> writers;
+  while (stream.nextEvent() != nullptr)
+  {
+    writers.push_back(stream.writerProp().name);
+  }
+
+  CHECK(writers == std::vector<std::string>{"w1", "w2", "w1"});
+}
+
+TEST_CASE("continue_after_invalid_entry")
+{
+  TestStream input1;
+  addSource(input1, 1, "a");
+  addEvent(input1, 1, 10);
+  addEvent(input1, 2, 20); // invalid source id
+  addEvent(input1, 1, 30);
+
+  TestStream input2;
+  addSource(input2, 1, "b");
+  addEvent(input2, 1, 15);
+
+  binlog::MergedEventStream stream;
+  stream.addInput(input1);
+  stream.addInput(input2);
+
+  REQUIRE(stream.nextEvent() != nullptr);
+  CHECK(stream.time() == 10);
+  CHECK_THROWS_AS(stream.nextEvent(), std::runtime_error);
+
+  const Result expected{{"b", 1}, {"a", 0}};
+  CHECK(mergeEvents(stream) == expected);
+}
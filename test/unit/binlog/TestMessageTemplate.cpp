@@ -0,0 +1,86 @@
+#include <binlog/MessageTemplate.hpp>
+
+#include <binlog/Entries.hpp>
+
+#include <doctest/doctest.h>
+
+#include <string>
+
+namespace {
+
+// Render `mt` as: literal[tag]literal[tag]...
+std::string render(const binlog::MessageTemplate& mt)
+{
+  std::string result;
+  for (std::size_t i = 0; i < mt.size(); ++i)
+  {
+    const binlog::MessageTemplate::Segment segment = mt.segment(i);
+    result += segment.literal.to_string();
+    if (segment.hasArgument)
+    {
+      result += "[" + segment.argumentTag.to_string() + "]";
+    }
+  }
+  return result;
+}
+
+binlog::MessageTemplate makeTemplate(std::string formatString, std::string argumentTags)
+{
+  binlog::EventSource source;
+  source.formatString = std::move(formatString);
+  source.argumentTags = std::move(argumentTags);
+  return binlog::MessageTemplate(source);
+}
+
+} // namespace
+
+TEST_CASE("empty")
+{
+  const binlog::MessageTemplate mt;
+  CHECK(mt.size() == 0);
+  CHECK(render(mt) == "");
+
+  CHECK(makeTemplate("", "").size() == 0);
+}
+
+TEST_CASE("literal_only")
+{
+  const binlog::MessageTemplate mt = makeTemplate("Hello World", "");
+  REQUIRE(mt.size() == 1);
+  CHECK(mt.segment(0).literal == "Hello World");
+  CHECK(! mt.segment(0).hasArgument);
+}
+
+TEST_CASE("literals_and_arguments")
+{
+  const binlog::MessageTemplate mt = makeTemplate("a: {}, b: {}, c: {}!", "i[c(ib){Foo`x'i}");
+  REQUIRE(mt.size() == 4);
+  CHECK(render(mt) == "a: [i], b: [[c], c: [(ib)]!");
+  CHECK(mt.segment(3).literal == "!");
+  CHECK(! mt.segment(3).hasArgument);
+}
+
+TEST_CASE("adjacent_placeholders")
+{
+  const binlog::MessageTemplate mt = makeTemplate("{}{}{", "ic");
+  REQUIRE(mt.size() == 3);
+  CHECK(render(mt) == "[i][c]{");
+}
+
+TEST_CASE("more_placeholders_than_arguments")
+{
+  const binlog::MessageTemplate mt = makeTemplate("{} {} {}", "i");
+  REQUIRE(mt.size() == 3);
+  CHECK(render(mt) == "[i] [] []");
+  CHECK(mt.segment(2).hasArgument);
+}
+
+TEST_CASE("copy_is_independent")
+{
+  binlog::MessageTemplate mt = makeTemplate("x={}", "[c");
+  const binlog::MessageTemplate copy = mt;
+  mt = makeTemplate("y", "");
+
+  CHECK(render(copy) == "x=[[c]");
+  CHECK(render(mt) == "y");
+}
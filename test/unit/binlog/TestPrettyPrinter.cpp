@@ -228,3 +228,65 @@ TEST_CASE_FIXTURE(TestcaseBase, "inline_time_utc_if_u")
     "1970-01-01 00:00:00.000000789 +0000 UTC"  // %m
   );
 }
+
+TEST_CASE_FIXTURE(TestcaseBase, "print_to_reused_buffer")
+{
+  binlog::PrettyPrinter pp("%S %m %%%x%\n", "");
+
+  std::ostringstream str;
+  {
+    binlog::detail::OstreamBuffer out(str);
+    pp.printEvent(out, event, writerProp, clockSync);
+    pp.printEvent(out, event, writerProp, clockSync);
+    CHECK(str.str().empty()); // not yet flushed
+
+    out.flush();
+    CHECK(str.str() == "INFO a: 111, b: foo %%x%\nINFO a: 111, b: foo %%x%\n");
+
+    pp.printEvent(out, event, writerProp, clockSync);
+  }
+
+  CHECK(str.str() ==
+    "INFO a: 111, b: foo %%x%\n"
+    "INFO a: 111, b: foo %%x%\n"
+    "INFO a: 111, b: foo %%x%\n"
+  );
+}
+
+TEST_CASE_FIXTURE(TestcaseBase, "consecutive_timestamps")
+{
+  binlog::PrettyPrinter pp("%d %u", "%H:%M:%S.%N %Z %N");
+
+  clockSync = binlog::ClockSync{0, 1000000000, 1569939329000000000, 3600, "XYZ"};
+
+  event.clockValue = 5;
+  CHECK(print(pp) == "15:15:29.000000005 XYZ 000000005 14:15:29.000000005 UTC 000000005");
+
+  // same second
+  event.clockValue = 999999999;
+  CHECK(print(pp) == "15:15:29.999999999 XYZ 999999999 14:15:29.999999999 UTC 999999999");
+
+  // next second
+  event.clockValue = 1000000000;
+  CHECK(print(pp) == "15:15:30.000000000 XYZ 000000000 14:15:30.000000000 UTC 000000000");
+
+  // same second, different time zone
+  clockSync.tzOffset = 7200;
+  clockSync.tzName = "ABC";
+  event.clockValue = 1000000001;
+  CHECK(print(pp) == "16:15:30.000000001 ABC 000000001 14:15:30.000000001 UTC 000000001");
+
+  // same second, different time zone name
+  clockSync.tzName = "DEF";
+  CHECK(print(pp) == "16:15:30.000000001 DEF 000000001 14:15:30.000000001 UTC 000000001");
+}
+
+TEST_CASE_FIXTURE(TestcaseBase, "timestamp_before_epoch")
+{
+  binlog::PrettyPrinter pp("%u", "%Y-%m-%d %H:%M:%S.%N");
+
+  clockSync = binlog::ClockSync{0, 1000000000, 0, 0, "UTC"};
+  event.clockValue = std::uint64_t(-250000000);
+
+  CHECK(print(pp) == "1969-12-31 23:59:59.750000000");
+}
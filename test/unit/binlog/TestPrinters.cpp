@@ -3,9 +3,12 @@
 #include <binlog/Session.hpp>
 #include <binlog/SessionWriter.hpp>
 #include <binlog/advanced_log_macros.hpp>
+#include <binlog/detail/OstreamBuffer.hpp>
 
 #include <doctest/doctest.h>
 
+#include <cstdint>
+#include <limits>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -42,7 +45,10 @@ TEST_CASE("print_events")
   session.consume(binstream);
 
   std::stringstream txtstream;
-  printEvents(binstream, txtstream, "%S %m\n", "");
+  {
+    binlog::detail::OstreamBuffer out(txtstream);
+    printEvents(binstream, out, "%S %m\n", "");
+  }
 
   const std::vector<std::string> expected{
     "INFO Hello World",
@@ -70,10 +76,190 @@ TEST_CASE("print_sorted_events")
   session.consume(binstream);
 
   std::stringstream txtstream;
-  printSortedEvents(binstream, txtstream, "%m\n", "");
+  {
+    binlog::detail::OstreamBuffer out(txtstream);
+    printSortedEvents(binstream, out, "%m\n", "");
+  }
 
   const std::vector<std::string> expected{
     "1", "2", "3", "4", "5", "6", "7", "8", "9",
   };
   CHECK(streamToLines(txtstream) == expected);
 }
+
+TEST_CASE("print_merged_events")
+{
+  binlog::Session session1;
+  binlog::SessionWriter writer1(session1, 512);
+  const auto log1 = [&writer1](std::uint64_t clock) {
+    BINLOG_CREATE_SOURCE_AND_EVENT(writer1, binlog::Severity::info, main, clock, "{}", clock);
+  };
+  log1(1);
+  log1(4);
+  log1(5);
+
+  binlog::Session session2;
+  binlog::SessionWriter writer2(session2, 512);
+  const auto log2 = [&writer2](std::uint64_t clock) {
+    BINLOG_CREATE_SOURCE_AND_EVENT(writer2, binlog::Severity::info, main, clock, "{}", clock);
+  };
+  log2(2);
+  log2(3);
+  log2(6);
+
+  std::stringstream binstream1;
+  session1.consume(binstream1);
+  std::stringstream binstream2;
+  session2.consume(binstream2);
+
+  std::stringstream txtstream;
+  {
+    binlog::detail::OstreamBuffer out(txtstream);
+    printMergedEvents({&binstream1, &binstream2}, out, "%m\n", "");
+  }
+
+  const std::vector<std::string> expected{
+    "1", "2", "3", "4", "5", "6",
+  };
+  CHECK(streamToLines(txtstream) == expected);
+}
+
+TEST_CASE("print_sorted_merged_events")
+{
+  binlog::Session session1;
+  binlog::SessionWriter writer1(session1, 512);
+  const auto log1 = [&writer1](std::uint64_t clock) {
+    BINLOG_CREATE_SOURCE_AND_EVENT(writer1, binlog::Severity::info, main, clock, "{}", clock);
+  };
+  log1(5);
+  log1(1);
+  log1(4);
+
+  binlog::Session session2;
+  binlog::SessionWriter writer2(session2, 512);
+  const auto log2 = [&writer2](std::uint64_t clock) {
+    BINLOG_CREATE_SOURCE_AND_EVENT(writer2, binlog::Severity::info, main, clock, "{}", clock);
+  };
+  log2(6);
+  log2(3);
+  log2(2);
+
+  std::stringstream binstream1;
+  session1.consume(binstream1);
+  std::stringstream binstream2;
+  session2.consume(binstream2);
+
+  std::stringstream txtstream;
+  {
+    binlog::detail::OstreamBuffer out(txtstream);
+    printSortedMergedEvents({&binstream1, &binstream2}, out, "%m\n", "");
+  }
+
+  const std::vector<std::string> expected{
+    "1", "2", "3", "4", "5", "6",
+  };
+  CHECK(streamToLines(txtstream) == expected);
+}
+
+TEST_CASE("print_recovered_events")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512);
+
+  BINLOG_INFO_W(writer, "a {}", 1);
+  BINLOG_INFO_W(writer, "b {}", 2);
+  std::ostringstream binstream1;
+  session.consume(binstream1);
+
+  BINLOG_INFO_W(writer, "a {}", 3);
+  BINLOG_INFO_W(writer, "b {}", 4);
+  std::ostringstream binstream2;
+  session.consume(binstream2);
+
+  // garbage between valid entries, and a truncated entry at the end
+  const std::string garbage(13, '\xAB');
+  const std::string data2 = binstream2.str();
+  std::stringstream binstream(binstream1.str() + garbage + data2 + data2.substr(0, data2.size() - 5));
+
+  std::stringstream txtstream;
+  std::ostringstream report;
+  std::size_t skipCount = 0;
+  {
+    binlog::detail::OstreamBuffer out(txtstream);
+    skipCount = printRecoveredEvents(binstream, out, "%m\n", "", report);
+  }
+
+  const std::vector<std::string> expected{
+    "a 1", "b 2", "a 3", "b 4", "a 3",
+  };
+  CHECK(streamToLines(txtstream) == expected);
+
+  CHECK(skipCount == 2);
+  const std::string reportString = report.str();
+  CHECK(reportString.find("Skipped 13 bytes at offset " + std::to_string(binstream1.str().size())) != std::string::npos);
+}
+
+TEST_CASE("print_recovered_events_max_entry_size")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 4096);
+
+  BINLOG_INFO_W(writer, "a {}", 1);
+  BINLOG_INFO_W(writer, "long {}", std::string(1000, 'x'));
+  BINLOG_INFO_W(writer, "a {}", 2);
+  std::ostringstream binstream;
+  session.consume(binstream);
+
+  const auto recover = [&binstream](std::uint32_t maxEntrySize, std::ostream& report)
+  {
+    std::stringstream input(binstream.str());
+    std::stringstream txtstream;
+    {
+      binlog::detail::OstreamBuffer out(txtstream);
+      printRecoveredEvents(input, out, "%m\n", "", report, maxEntrySize);
+    }
+    return streamToLines(txtstream);
+  };
+
+  // the long event is skipped
+  std::ostringstream report;
+  CHECK(recover(500, report) == std::vector<std::string>{"a 1", "a 2"});
+  CHECK(report.str().find("larger than the allowed maximum: 500") != std::string::npos);
+
+  // the maximum allowed by the format
+  std::ostringstream report2;
+  const std::vector<std::string> all = recover(std::numeric_limits<std::uint32_t>::max(), report2);
+  REQUIRE(all.size() == 3);
+  CHECK(all[2] == "a 2");
+  CHECK(report2.str().empty());
+}
+
+TEST_CASE("print_recovered_events_without_size_limit")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512);
+
+  BINLOG_INFO_W(writer, "a {}", 1);
+  std::ostringstream binstream1;
+  session.consume(binstream1);
+
+  BINLOG_INFO_W(writer, "a {}", 2);
+  std::ostringstream binstream2;
+  session.consume(binstream2);
+
+  // garbage, including sizes above 16 MiB, between valid entries
+  const std::string garbage = std::string(13, '\xAB') + std::string(7, '\0') + "\x01\x02\x03\x04";
+  std::stringstream binstream(binstream1.str() + garbage + binstream2.str());
+
+  std::stringstream txtstream;
+  std::ostringstream report;
+  std::size_t skipCount = 0;
+  {
+    binlog::detail::OstreamBuffer out(txtstream);
+    skipCount = printRecoveredEvents(binstream, out, "%m\n", "", report, std::numeric_limits<std::uint32_t>::max());
+  }
+
+  CHECK(streamToLines(txtstream) == std::vector<std::string>{"a 1", "a 2"});
+  CHECK(skipCount == 1);
+  CHECK(report.str().find("Skipped " + std::to_string(garbage.size()) + " bytes") != std::string::npos);
+}
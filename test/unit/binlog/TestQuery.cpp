@@ -0,0 +1,255 @@
+#include <query.hpp>
+
+#include <binlog/Entries.hpp>
+#include <binlog/EntryStream.hpp>
+#include <binlog/EventStream.hpp>
+#include <binlog/Session.hpp>
+#include <binlog/SessionWriter.hpp>
+#include <binlog/advanced_log_macros.hpp>
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+void aggregate(binlog::Session& session, QueryAggregator& aggregator)
+{
+  std::stringstream stream;
+  session.consume(stream);
+
+  binlog::IstreamEntryStream entryStream(stream);
+  binlog::EventStream eventStream;
+  while (const binlog::Event* event = eventStream.nextEvent(entryStream))
+  {
+    aggregator.add(*event, eventStream.clockSync());
+  }
+}
+
+binlog::EventSource testEventSource(std::string file, std::uint64_t line, std::string formatString)
+{
+  binlog::EventSource source;
+  source.file = std::move(file);
+  source.line = line;
+  source.formatString = std::move(formatString);
+  return source;
+}
+
+} // namespace
+
+TEST_CASE("parse_query_group")
+{
+  Query q;
+  CHECK(q.parseGroup("30s"));
+  CHECK(q.bucketSeconds == 30);
+  CHECK(q.parseGroup("5m"));
+  CHECK(q.bucketSeconds == 300);
+  CHECK(q.parseGroup("2h"));
+  CHECK(q.bucketSeconds == 7200);
+  CHECK(! q.groupByArgument);
+
+  CHECK(q.parseGroup("arg:3"));
+  CHECK(q.groupByArgument);
+  CHECK(q.groupArgument == 3);
+
+  Query invalid;
+  CHECK(! invalid.parseGroup(""));
+  CHECK(! invalid.parseGroup("s"));
+  CHECK(! invalid.parseGroup("0s"));
+  CHECK(! invalid.parseGroup("10d"));
+  CHECK(! invalid.parseGroup("-1s"));
+  CHECK(! invalid.parseGroup("arg:"));
+  CHECK(! invalid.parseGroup("arg:x"));
+  CHECK(! invalid.parseGroup("999999999h")); // overflows in nanoseconds
+  CHECK(invalid.bucketSeconds == 0);
+  CHECK(! invalid.groupByArgument);
+}
+
+TEST_CASE("query_matches_source")
+{
+  const binlog::EventSource source = testEventSource("/src/app/order.cpp", 42, "Order {} filled, qty={}");
+
+  Query q;
+  q.source = "order.cpp:42";
+  CHECK(q.matches(source));
+  q.source = "/src/app/order.cpp:42";
+  CHECK(q.matches(source));
+  q.source = "order.cpp:43";
+  CHECK(! q.matches(source));
+  q.source = "border.cpp:42";
+  CHECK(! q.matches(source));
+
+  q.source = "qty=";
+  CHECK(q.matches(source));
+  q.source = "Order {}";
+  CHECK(q.matches(source));
+  q.source = "price";
+  CHECK(! q.matches(source));
+}
+
+TEST_CASE("aggregate_grouped_by_argument")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 1024);
+
+  const std::vector<std::string> symbols{"AAA", "BBB", "AAA", "AAA", "BBB"};
+  const std::vector<int> quantities{10, 20, 30, 40, 50};
+  for (std::size_t i = 0; i < symbols.size(); ++i)
+  {
+    BINLOG_INFO_W(writer, "Filled {} qty={} tags={}", symbols[i], quantities[i], std::vector<int>{1, 2, 3});
+  }
+  BINLOG_INFO_W(writer, "Unrelated qty {}", std::string("foo")); // not selected
+
+  Query query;
+  query.source = "Filled";
+  query.argument = 1;
+  REQUIRE(query.parseGroup("arg:0"));
+
+  QueryAggregator aggregator(query);
+  aggregate(session, aggregator);
+
+  const std::vector<QueryAggregator::Summary> summaries = aggregator.summaries();
+  REQUIRE(summaries.size() == 2);
+
+  const QueryAggregator::Summary& a = summaries[0];
+  CHECK(a.group == "AAA");
+  CHECK(a.count == 3);
+  CHECK(a.sum == 80);
+  CHECK(a.min == 10);
+  CHECK(a.max == 40);
+  CHECK(a.p50 == 30);
+  CHECK(a.p99 == 40);
+
+  const QueryAggregator::Summary& b = summaries[1];
+  CHECK(b.group == "BBB");
+  CHECK(b.count == 2);
+  CHECK(b.mean == 35);
+
+  std::ostringstream out;
+  aggregator.print(out);
+  CHECK(out.str().find("AAA") != std::string::npos);
+}
+
+TEST_CASE("aggregate_after_skipped_arguments")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 1024);
+
+  struct Latency { const char* name; double value; };
+  const Latency latencies[] = {{"a", 1.5}, {"bb", 2.5}, {"ccc", 0.5}};
+  for (const Latency& l : latencies)
+  {
+    BINLOG_INFO_W(writer, "{} {} {} latency={}", std::string(l.name), std::vector<std::string>{"x", l.name}, std::make_pair(1, 'c'), l.value);
+  }
+
+  Query query;
+  query.source = "latency=";
+  query.argument = 3;
+
+  QueryAggregator aggregator(query);
+  aggregate(session, aggregator);
+
+  const std::vector<QueryAggregator::Summary> summaries = aggregator.summaries();
+  REQUIRE(summaries.size() == 1);
+  CHECK(summaries[0].group == "");
+  CHECK(summaries[0].count == 3);
+  CHECK(summaries[0].min == 0.5);
+  CHECK(summaries[0].max == 2.5);
+  CHECK(summaries[0].sum == 4.5);
+}
+
+TEST_CASE("aggregate_grouped_by_time")
+{
+  binlog::EventSource source = testEventSource("a.cpp", 1, "latency={}");
+  source.argumentTags = "i";
+  const binlog::ClockSync clockSync{0, 1000, 1569939300000000000, 0, "UTC"}; // 1 tick = 1 ms, 2019-10-01 14:15:00
+
+  Query query;
+  query.source = "latency";
+  REQUIRE(query.parseGroup("1m"));
+  QueryAggregator aggregator(query);
+
+  const auto add = [&](std::uint64_t clock, std::int32_t value)
+  {
+    binlog::Event event;
+    event.source = &source;
+    event.clockValue = clock;
+    event.arguments = binlog::Range(reinterpret_cast<const char*>(&value), sizeof(value));
+    aggregator.add(event, clockSync);
+  };
+
+  add(0, 5);
+  add(59999, 7);
+  add(60000, 1);
+  add(180000, 2);
+  add(1000, 3);
+
+  const std::vector<QueryAggregator::Summary> summaries = aggregator.summaries();
+  REQUIRE(summaries.size() == 3);
+  CHECK(summaries[0].group == "2019-10-01 14:15:00");
+  CHECK(summaries[0].count == 3);
+  CHECK(summaries[0].max == 7);
+  CHECK(summaries[1].group == "2019-10-01 14:16:00");
+  CHECK(summaries[1].count == 1);
+  CHECK(summaries[2].group == "2019-10-01 14:18:00");
+  CHECK(summaries[2].sum == 2);
+}
+
+TEST_CASE("aggregate_not_a_number")
+{
+  binlog::EventSource source = testEventSource("a.cpp", 1, "name={}");
+  source.argumentTags = "[c";
+
+  Query query;
+  query.source = "name";
+  QueryAggregator aggregator(query);
+
+  // the source is skipped, not the whole query
+  binlog::Event event;
+  event.source = &source;
+  aggregator.add(event, {});
+  aggregator.add(event, {});
+  CHECK(aggregator.summaries().empty());
+  CHECK(aggregator.warnings() == std::vector<std::string>{
+    "Skipped event source a.cpp:1, its argument 0 is not a number, its tag is: [c"
+  });
+
+  std::ostringstream out;
+  aggregator.print(out);
+  CHECK(out.str().find("Warning: Skipped event source a.cpp:1") != std::string::npos);
+
+  query.argument = 1;
+  QueryAggregator aggregator2(query);
+  aggregator2.add(event, {});
+  CHECK(aggregator2.warnings() == std::vector<std::string>{"Skipped event source a.cpp:1, it has no argument 1"});
+}
+
+TEST_CASE("aggregate_redefined_source")
+{
+  binlog::EventSource source = testEventSource("a.cpp", 1, "name={}");
+  source.argumentTags = "[c";
+
+  Query query;
+  query.source = "a.cpp:1";
+  QueryAggregator aggregator(query);
+
+  binlog::Event event;
+  event.source = &source;
+  aggregator.add(event, {});
+
+  // the same id is redefined in place, now with a number argument
+  source.formatString = "value={}";
+  source.argumentTags = "i";
+  const std::int32_t value = 42;
+  event.arguments = binlog::Range(reinterpret_cast<const char*>(&value), sizeof(value));
+  aggregator.add(event, {});
+
+  const std::vector<QueryAggregator::Summary> summaries = aggregator.summaries();
+  REQUIRE(summaries.size() == 1);
+  CHECK(summaries[0].count == 1);
+  CHECK(summaries[0].sum == 42);
+  CHECK(aggregator.warnings().size() == 1);
+}
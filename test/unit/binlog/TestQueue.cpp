@@ -271,3 +271,213 @@ TEST_CASE("transmit_more")
     }
   }
 }
+
+namespace {
+
+// Write a record of `size` bytes (including the size prefix), identified by `seq`
+bool write_record(binlog::detail::QueueWriter& w, std::uint64_t seq, std::size_t size)
+{
+  if (! w.beginWrite(size)) { return false; }
+
+  const std::uint32_t payload_size = std::uint32_t(size - sizeof(std::uint32_t));
+  w.writeBuffer(&payload_size, sizeof(payload_size));
+  w.writeBuffer(&seq, sizeof(seq));
+  for (std::size_t i = sizeof(payload_size) + sizeof(seq); i < size; ++i)
+  {
+    const char c = char(seq + i);
+    w.writeBuffer(&c, 1);
+  }
+
+  w.endWrite();
+  return true;
+}
+
+// Copy the data returned by beginRead, return the part that remained valid
+std::vector<char> read_valid(binlog::detail::QueueReader& r)
+{
+  const auto rr = r.beginRead();
+  std::vector<char> result(rr.buffer1, rr.buffer1 + rr.size1);
+  result.insert(result.end(), rr.buffer2, rr.buffer2 + rr.size2);
+
+  const std::size_t evicted = r.endRead();
+  result.erase(result.begin(), result.begin() + std::ptrdiff_t(evicted));
+  return result;
+}
+
+// Parse records written by write_record, return their seq numbers,
+// or false, if a record is incomplete or corrupt
+bool parse_records(const std::vector<char>& data, std::vector<std::uint64_t>& seqs)
+{
+  std::size_t pos = 0;
+  while (pos != data.size())
+  {
+    std::uint32_t payload_size = 0;
+    std::uint64_t seq = 0;
+    if (data.size() - pos < sizeof(payload_size) + sizeof(seq)) { return false; }
+    memcpy(&payload_size, data.data() + pos, sizeof(payload_size));
+    memcpy(&seq, data.data() + pos + sizeof(payload_size), sizeof(seq));
+
+    const std::size_t size = sizeof(payload_size) + payload_size;
+    if (data.size() - pos < size) { return false; }
+    for (std::size_t i = sizeof(payload_size) + sizeof(seq); i < size; ++i)
+    {
+      if (data[pos + i] != char(seq + i)) { return false; }
+    }
+
+    seqs.push_back(seq);
+    pos += size;
+  }
+  return true;
+}
+
+std::vector<std::uint64_t> seq_range(std::uint64_t first, std::uint64_t end)
+{
+  std::vector<std::uint64_t> result;
+  for (std::uint64_t seq = first; seq < end; ++seq) { result.push_back(seq); }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("overwrite_oldest")
+{
+  char buffer[256];
+  binlog::detail::Queue q(buffer, sizeof(buffer), true);
+  binlog::detail::QueueWriter w(q);
+  binlog::detail::QueueReader r(q);
+  CHECK(w.overwrite());
+
+  for (std::uint64_t seq = 0; seq < 100; ++seq)
+  {
+    REQUIRE(write_record(w, seq, 20));
+  }
+
+  std::vector<std::uint64_t> seqs;
+  REQUIRE(parse_records(read_valid(r), seqs));
+  REQUIRE(seqs.size() >= 6); // at least half of the queue is used
+  CHECK(seqs == seq_range(100 - seqs.size(), 100));
+  CHECK(q.evictedBytes.load() == (100 - seqs.size()) * 20);
+
+  CHECK(r.beginRead().size() == 0);
+}
+
+TEST_CASE("overwrite_while_reading")
+{
+  char buffer[256];
+  binlog::detail::Queue q(buffer, sizeof(buffer), true);
+  binlog::detail::QueueWriter w(q);
+  binlog::detail::QueueReader r(q);
+
+  for (std::uint64_t seq = 0; seq < 10; ++seq) { REQUIRE(write_record(w, seq, 20)); }
+
+  // read, then overwrite some of the read records
+  const auto rr = r.beginRead();
+  CHECK(rr.size() == 200);
+  std::vector<char> data(rr.buffer1, rr.buffer1 + rr.size1);
+  data.insert(data.end(), rr.buffer2, rr.buffer2 + rr.size2);
+
+  for (std::uint64_t seq = 10; seq < 13; ++seq) { REQUIRE(write_record(w, seq, 20)); }
+
+  // the third record does not fit after the last one: wraps around,
+  // evicts the first two records
+  const std::size_t evicted = r.endRead();
+  CHECK(evicted == 40);
+
+  data.erase(data.begin(), data.begin() + std::ptrdiff_t(evicted));
+  std::vector<std::uint64_t> seqs;
+  REQUIRE(parse_records(data, seqs));
+  CHECK(seqs == seq_range(2, 10));
+
+  // the records written after beginRead remain
+  seqs.clear();
+  REQUIRE(parse_records(read_valid(r), seqs));
+  CHECK(seqs == seq_range(10, 13));
+}
+
+TEST_CASE("overwrite_everything_while_reading")
+{
+  char buffer[256];
+  binlog::detail::Queue q(buffer, sizeof(buffer), true);
+  binlog::detail::QueueWriter w(q);
+  binlog::detail::QueueReader r(q);
+
+  for (std::uint64_t seq = 0; seq < 10; ++seq) { REQUIRE(write_record(w, seq, 20)); }
+
+  const auto rr = r.beginRead();
+  CHECK(rr.size() == 200);
+
+  for (std::uint64_t seq = 10; seq < 40; ++seq) { REQUIRE(write_record(w, seq, 20)); }
+
+  CHECK(r.endRead() == 200);
+
+  std::vector<std::uint64_t> seqs;
+  REQUIRE(parse_records(read_valid(r), seqs));
+  REQUIRE(! seqs.empty());
+  CHECK(seqs == seq_range(40 - seqs.size(), 40));
+}
+
+TEST_CASE("overwrite_record_too_large")
+{
+  char buffer[256];
+  binlog::detail::Queue q(buffer, sizeof(buffer), true);
+  binlog::detail::QueueWriter w(q);
+  binlog::detail::QueueReader r(q);
+
+  REQUIRE(write_record(w, 0, 20));
+  REQUIRE(write_record(w, 1, 200)); // fits without eviction
+  CHECK(! write_record(w, 2, 200)); // does not evict in vain
+
+  std::vector<std::uint64_t> seqs;
+  REQUIRE(parse_records(read_valid(r), seqs));
+  CHECK(seqs == seq_range(0, 2));
+}
+
+TEST_CASE("overwrite_concurrently")
+{
+  for (const std::size_t queue_size : {1000U, 4096U})
+  {
+    std::vector<char> buffer(queue_size);
+    binlog::detail::Queue q(buffer.data(), queue_size, true);
+    binlog::detail::QueueWriter w(q);
+    binlog::detail::QueueReader r(q);
+
+    const std::uint64_t record_count = 1'000'000;
+    std::atomic<bool> done{false};
+
+    std::thread writer([&]()
+    {
+      std::minstd_rand prng(1); // NOLINT
+      for (std::uint64_t seq = 0; seq < record_count; ++seq)
+      {
+        const std::size_t size = 12 + prng() % 64;
+        if (! write_record(w, seq, size)) { break; }
+      }
+      done = true;
+    });
+
+    // read records, those still valid must be complete, and in order
+    bool valid = true;
+    std::uint64_t next_seq = 0;
+    std::size_t read_count = 0;
+    bool last_round = false;
+    while (valid && ! last_round)
+    {
+      last_round = done;
+
+      std::vector<std::uint64_t> seqs;
+      valid = parse_records(read_valid(r), seqs);
+      for (const std::uint64_t seq : seqs)
+      {
+        if (seq < next_seq) { valid = false; }
+        next_seq = seq + 1;
+      }
+      read_count += seqs.size();
+    }
+
+    writer.join();
+
+    CHECK(valid);
+    CHECK(next_seq == record_count); // the last record is never evicted
+    CHECK(read_count > 0);
+  }
+}
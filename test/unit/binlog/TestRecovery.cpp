@@ -0,0 +1,308 @@
+#include <recovery.hpp>
+
+#include <binlog/detail/Queue.hpp>
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+template <typename T>
+void append(std::string& out, const T& value)
+{
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+// `count` entries, each with a payload of `payload`
+std::string entries(std::size_t count, const std::string& payload)
+{
+  std::string result;
+  for (std::size_t i = 0; i < count; ++i)
+  {
+    append(result, std::uint32_t(payload.size()));
+    result += payload;
+  }
+  return result;
+}
+
+void appendMetadata(std::string& dump, std::uintptr_t session, const std::string& metadata)
+{
+  append(dump, g_metadataMagic);
+  append(dump, session);
+  append(dump, std::uint64_t(metadata.size()));
+  dump += metadata;
+}
+
+// `garbage` follows the unread data, it is not recovered
+void appendQueue(std::string& dump, std::uintptr_t session, std::size_t capacity, const std::string& unread, const std::string& garbage = {})
+{
+  append(dump, g_dataMagic);
+  append(dump, session);
+
+  binlog::detail::Queue queue(nullptr, capacity);
+  queue.writeIndex = unread.size();
+  dump.append(reinterpret_cast<const char*>(&queue), sizeof(queue));
+
+  dump += unread;
+  dump += garbage;
+  dump.append(capacity - unread.size() - garbage.size(), '\0');
+}
+
+void appendQueueHeader(std::string& dump, std::uintptr_t session, std::size_t capacity, std::size_t writeIndex, std::uintptr_t buffer)
+{
+  append(dump, g_dataMagic);
+  append(dump, session);
+
+  binlog::detail::Queue queue(reinterpret_cast<char*>(buffer), capacity);
+  queue.writeIndex = writeIndex;
+  dump.append(reinterpret_cast<const char*>(&queue), sizeof(queue));
+}
+
+struct TestSegment
+{
+  std::uint32_t type;
+  std::uint32_t flags;
+  std::uint64_t address;
+  std::string content;
+};
+
+// ELF64 core file of `segments`, in the given order
+std::string elfCore(const std::vector<TestSegment>& segments)
+{
+  const std::uint16_t one = 1;
+  const bool littleEndian = (*reinterpret_cast<const unsigned char*>(&one) == 1);
+
+  std::string result("\x7f" "ELF", 4);
+  result += char(2); // ELFCLASS64
+  result += char(littleEndian ? 1 : 2);
+  result += char(1); // version
+  result.append(9, '\0');
+  append(result, std::uint16_t(4)); // ET_CORE
+  append(result, std::uint16_t(62)); // machine
+  append(result, std::uint32_t(1)); // version
+  append(result, std::uint64_t(0)); // entry
+  append(result, std::uint64_t(64)); // phoff
+  append(result, std::uint64_t(0)); // shoff
+  append(result, std::uint32_t(0)); // flags
+  append(result, std::uint16_t(64)); // ehsize
+  append(result, std::uint16_t(56)); // phentsize
+  append(result, std::uint16_t(segments.size())); // phnum
+  append(result, std::uint16_t(0)); // shentsize
+  append(result, std::uint16_t(0)); // shnum
+  append(result, std::uint16_t(0)); // shstrndx
+
+  std::uint64_t offset = 64 + 56 * segments.size();
+  for (const TestSegment& segment : segments)
+  {
+    append(result, segment.type);
+    append(result, segment.flags);
+    append(result, offset);
+    append(result, segment.address); // vaddr
+    append(result, std::uint64_t(0)); // paddr
+    append(result, std::uint64_t(segment.content.size())); // filesz
+    append(result, std::uint64_t(segment.content.size())); // memsz
+    append(result, std::uint64_t(1)); // align
+    offset += segment.content.size();
+  }
+
+  for (const TestSegment& segment : segments)
+  {
+    result += segment.content;
+  }
+
+  return result;
+}
+
+std::string recoveredContent(const std::vector<RecoveryCandidate>& candidates)
+{
+  std::string result;
+  for (const RecoveryCandidate& candidate : candidates)
+  {
+    if (candidate.recovered)
+    {
+      result += std::to_string(candidate.offset) + ":" + std::to_string(candidate.result.session) + ":"
+        + std::string(candidate.result.buffer.begin(), candidate.result.buffer.end()) + ";";
+    }
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("find_magic_numbers")
+{
+  std::string dump(1000, 'x');
+  const std::vector<std::size_t> offsets{0, 9, 17, 33, 100, 243, 251, 499, 992};
+  for (const std::size_t offset : offsets)
+  {
+    const std::uint64_t magic = (offset % 2 == 0) ? g_dataMagic : g_metadataMagic;
+    memcpy(&dump[offset], &magic, sizeof(magic));
+  }
+
+  // near misses: first and last bytes match, but not the others
+  std::uint64_t nearMiss = g_dataMagic ^ 0x0000FF0000000000;
+  memcpy(&dump[600], &nearMiss, sizeof(nearMiss));
+
+  CHECK(findMagicNumbers(dump.data(), dump.size(), 0, dump.size()) == offsets);
+
+  // only magic numbers beginning in [begin, end) are found
+  CHECK(findMagicNumbers(dump.data(), dump.size(), 17, 251) == std::vector<std::size_t>{17, 33, 100, 243});
+  CHECK(findMagicNumbers(dump.data(), dump.size(), 18, 243) == std::vector<std::size_t>{33, 100});
+  CHECK(findMagicNumbers(dump.data(), dump.size(), 993, 1000).empty());
+
+  // truncated magic at the end is ignored
+  CHECK(findMagicNumbers(dump.data(), 998, 0, 998).back() == 499);
+}
+
+TEST_CASE("scan_for_buffers")
+{
+  std::string dump(100, 'x');
+  appendMetadata(dump, 1, entries(3, "meta"));
+  dump.append(37, 'y');
+  appendQueue(dump, 1, 256, entries(2, "data"));
+  appendMetadata(dump, 2, "invalid entry");
+  dump.append(11, 'z');
+
+  // magic number inside a recovered buffer is not recovered again
+  std::string nested;
+  appendMetadata(nested, 3, entries(1, "nested"));
+  appendQueue(dump, 2, 512, entries(1, "outer"), nested);
+
+  // queue with invalid state
+  std::string invalidQueue;
+  appendQueue(invalidQueue, 4, 64, "");
+  const std::size_t badIndex = 1000;
+  memcpy(&invalidQueue[16], &badIndex, sizeof(badIndex)); // writeIndex > capacity
+  dump += invalidQueue;
+  dump.append(100, 'x');
+
+  const MemoryDump memoryDump(dump.data(), dump.size());
+  CHECK(! memoryDump.isElfCore());
+
+  const std::vector<RecoveryCandidate> expected = scanForBuffers(memoryDump, 1, dump.size());
+  REQUIRE(expected.size() == 5);
+
+  CHECK(expected[0].recovered);
+  CHECK(expected[0].offset == 100);
+  CHECK(expected[0].result.type == BufferType::Metadata);
+  CHECK(expected[1].recovered);
+  CHECK(expected[1].result.type == BufferType::Data);
+  CHECK(expected[1].message.find("Queue state is valid") == 0);
+  CHECK(! expected[2].recovered);
+  CHECK(expected[2].message == "Buffer contains invalid entry");
+  CHECK(expected[3].recovered);
+  CHECK(expected[3].result.session == 2);
+  CHECK(! expected[4].recovered);
+  CHECK(expected[4].message.find("Queue invariant violated") == 0);
+
+  // result does not depend on the number of threads and the chunk size
+  const std::string expectedContent = recoveredContent(expected);
+  for (const std::size_t threads : {1u, 2u, 4u})
+  {
+    for (const std::size_t chunkSize : {1u, 7u, 64u, 100u, 4096u})
+    {
+      std::size_t lastProgress = 0;
+      const std::vector<RecoveryCandidate> actual = scanForBuffers(
+        memoryDump, threads, chunkSize,
+        [&lastProgress](std::size_t scanned) { lastProgress = scanned; }
+      );
+      CHECK(actual.size() == expected.size());
+      CHECK(recoveredContent(actual) == expectedContent);
+      CHECK(lastProgress == dump.size());
+    }
+  }
+}
+
+TEST_CASE("scan_elf_core")
+{
+  const std::uint32_t load = 1, note = 4, writable = 2, readable = 4;
+  const std::uint64_t addressA = 0x10000, addressB = 0x20000, addressC = 0x30000, addressD = 0x40000;
+
+  // A: writable, anonymous: queue header, with the buffer in C, and metadata
+  std::string a(8, 'a');
+  appendMetadata(a, addressA + 1, entries(1, "meta"));
+  appendMetadata(a, 0x99999, entries(1, "unmapped session"));
+  appendQueueHeader(a, addressA + 1, 64, 2 * (4 + 4), addressC + 8);
+  // the first half of a magic number, continued in C
+  a.append(reinterpret_cast<const char*>(&g_metadataMagic), 4);
+
+  // C: writable, anonymous: queue buffer
+  std::string c(reinterpret_cast<const char*>(&g_metadataMagic) + 4, 4);
+  c.append(4, 'c');
+  c += entries(2, "data");
+  c.append(64, '\0');
+
+  // B: writable, but file backed
+  std::string b;
+  appendMetadata(b, addressA, entries(1, "file backed"));
+
+  // D: read only
+  std::string d;
+  appendMetadata(d, addressA, entries(1, "read only"));
+
+  // NT_FILE note: B is mapped from a file
+  std::string fileNote;
+  append(fileNote, std::uint64_t(1)); // count
+  append(fileNote, std::uint64_t(4096)); // page size
+  append(fileNote, addressB);
+  append(fileNote, addressB + b.size());
+  append(fileNote, std::uint64_t(0)); // file offset
+  fileNote += std::string("lib.so\0\0", 8);
+
+  std::string notes;
+  append(notes, std::uint32_t(5)); // name size
+  append(notes, std::uint32_t(fileNote.size()));
+  append(notes, std::uint32_t(0x46494c45)); // NT_FILE
+  notes += std::string("CORE\0\0\0\0", 8);
+  notes += fileNote;
+
+  const std::string core = elfCore({
+    {note, 0, 0, notes},
+    {load, readable | writable, addressA, a},
+    {load, readable | writable, addressC, c},
+    {load, readable | writable, addressB, b},
+    {load, readable, addressD, d},
+  });
+
+  const MemoryDump dump(core.data(), core.size());
+  CHECK(dump.isElfCore());
+  CHECK(dump.segments().size() == 4);
+  REQUIRE(dump.scannedSegments().size() == 2);
+  CHECK(dump.scannedSegments()[0].address == addressA);
+  CHECK(dump.scannedSegments()[1].address == addressC);
+
+  std::size_t offset = 0;
+  CHECK(dump.translate(addressC + 8, 16, offset));
+  CHECK(core.substr(offset, 16) == entries(2, "data"));
+  CHECK(! dump.translate(addressC + 8, c.size(), offset));
+  CHECK(dump.isMapped(addressD + 1));
+  CHECK(! dump.isMapped(0x99999));
+
+  const std::vector<RecoveryCandidate> candidates = scanForBuffers(dump, 2, 16);
+  REQUIRE(candidates.size() == 3);
+
+  CHECK(candidates[0].recovered);
+  CHECK(candidates[0].result.session == addressA + 1);
+  CHECK(candidates[0].result.buffer == std::vector<char>{'\4', '\0', '\0', '\0', 'm', 'e', 't', 'a'});
+
+  CHECK(! candidates[1].recovered);
+  CHECK(candidates[1].message == "Session pointer 629145 is not mapped");
+
+  CHECK(candidates[2].recovered);
+  CHECK(candidates[2].result.type == BufferType::Data);
+  const std::string data = entries(2, "data");
+  CHECK(candidates[2].result.buffer == std::vector<char>(data.begin(), data.end()));
+
+  // a queue buffer outside of the core is not recovered
+  std::string e;
+  appendQueueHeader(e, addressA, 64, 8, 0x50000);
+  const std::string core2 = elfCore({{load, writable, addressA, e}});
+  const std::vector<RecoveryCandidate> candidates2 = scanForBuffers(MemoryDump(core2.data(), core2.size()), 1);
+  REQUIRE(candidates2.size() == 1);
+  CHECK(! candidates2[0].recovered);
+  CHECK(candidates2[0].message.find("Queue buffer at address") == 0);
+}
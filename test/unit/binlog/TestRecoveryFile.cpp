@@ -0,0 +1,192 @@
+#include <binlog/RecoveryFile.hpp>
+
+#include <binlog/Session.hpp>
+#include <binlog/SessionWriter.hpp>
+#include <binlog/detail/QueueReader.hpp>
+
+#include "test_utils.hpp"
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+
+namespace {
+
+const char* g_recoveryPath = "binlog_unittest.blogrec";
+
+std::string readFile(const std::string& path)
+{
+  std::ifstream file(path, std::ios_base::in | std::ios_base::binary);
+  return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+bool fileExists(const std::string& path)
+{
+  std::ifstream file(path);
+  return bool(file);
+}
+
+template <typename T>
+T readAt(const std::string& data, std::size_t pos)
+{
+  T result;
+  memcpy(&result, data.data() + pos, sizeof(T));
+  return result;
+}
+
+// Extract metadata and unread queue data from the content
+// of a recovery file, metadata first, like brecovery does
+TestStream recover(const std::string& file)
+{
+  std::string metadata;
+  std::string data;
+
+  for (std::size_t pos = 0; pos + 8 <= file.size(); pos += 8)
+  {
+    const std::uint64_t magic = readAt<std::uint64_t>(file, pos);
+    if (magic == 0xFE214F726E35BDBC)
+    {
+      const std::size_t sizePos = pos + 8 + sizeof(void*);
+      const std::uint64_t size = readAt<std::uint64_t>(file, sizePos);
+      metadata.append(file, sizePos + 8, std::size_t(size));
+    }
+    else if (magic == 0xFE213F716D34BCBC)
+    {
+      const std::size_t queuePos = pos + 8 + sizeof(void*);
+      binlog::detail::Queue queue(nullptr, 0);
+      memcpy(static_cast<void*>(&queue), file.data() + queuePos, sizeof(queue));
+
+      std::string buffer = file.substr(queuePos + sizeof(queue), queue.capacity);
+      queue.buffer = &buffer[0];
+      binlog::detail::QueueReader reader(queue);
+      const binlog::detail::QueueReader::ReadResult rr = reader.beginReadNoWait();
+      data.append(rr.buffer1, rr.size1);
+      data.append(rr.buffer2, rr.size2);
+    }
+  }
+
+  TestStream result;
+  result.write(metadata.data(), std::streamsize(metadata.size()));
+  result.write(data.data(), std::streamsize(data.size()));
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("recovery_file_allocate")
+{
+  {
+    binlog::RecoveryFile file(g_recoveryPath);
+    CHECK(file.path() == g_recoveryPath);
+    CHECK(file.fileSize() == 0);
+
+    char* a = file.allocate(100);
+    REQUIRE(a != nullptr);
+    a[0] = 'a';
+    a[99] = 'z';
+    const std::size_t pageSize = file.fileSize();
+    CHECK(pageSize >= 100);
+
+    char* b = file.allocate(pageSize + 1);
+    CHECK(b != a);
+    CHECK(file.fileSize() == 3 * pageSize);
+
+    // mapped memory is written to the file
+    const std::string content = readFile(g_recoveryPath);
+    REQUIRE(content.size() == 3 * pageSize);
+    CHECK(content[0] == 'a');
+    CHECK(content[99] == 'z');
+
+    // freed blocks of the same size are reused
+    file.deallocate(a, 100);
+    CHECK(file.allocate(pageSize) == a);
+    CHECK(file.fileSize() == 3 * pageSize);
+
+    file.deallocate(b, pageSize + 1);
+    CHECK(file.allocate(1) != b);
+    CHECK(file.fileSize() == 4 * pageSize);
+  }
+
+  // removed by the destructor
+  CHECK(! fileExists(g_recoveryPath));
+}
+
+TEST_CASE("recovery_file_open_failure")
+{
+  CHECK_THROWS_AS(binlog::RecoveryFile("no/such/dir/file.blogrec"), std::runtime_error);
+}
+
+TEST_CASE("recover_session_from_file")
+{
+  auto file = std::make_shared<binlog::RecoveryFile>(g_recoveryPath);
+  binlog::Session session(file);
+  binlog::SessionWriter writer(session, 4096);
+
+  binlog::EventSource eventSource{
+    0, binlog::Severity::info, "cat", "fun", "file", 123, "a={} b={}", "i[c"
+  };
+  eventSource.id = session.addEventSource(eventSource);
+
+  CHECK(writer.addEvent(eventSource.id, 0, 1, std::string("foo")));
+  CHECK(writer.addEvent(eventSource.id, 0, 2, std::string("bar")));
+
+  // unconsumed data is in the file
+  TestStream recovered = recover(readFile(g_recoveryPath));
+  CHECK(streamToEvents(recovered, "%m") == std::vector<std::string>{"a=1 b=foo", "a=2 b=bar"});
+
+  // consumed data is not recovered again, metadata is
+  CHECK(getEvents(session, "%m") == std::vector<std::string>{"a=1 b=foo", "a=2 b=bar"});
+  CHECK(writer.addEvent(eventSource.id, 0, 3, std::string("baz")));
+
+  TestStream recovered2 = recover(readFile(g_recoveryPath));
+  CHECK(streamToEvents(recovered2, "%m") == std::vector<std::string>{"a=3 b=baz"});
+
+  // add many sources to reallocate the metadata buffer: old buffer is not recovered
+  for (int i = 0; i < 100; ++i)
+  {
+    session.addEventSource(eventSource);
+  }
+
+  TestStream recovered3 = recover(readFile(g_recoveryPath));
+  CHECK(countTags(recovered3, binlog::EventSource::Tag) == 101);
+  recovered3.readPos = 0;
+  CHECK(streamToEvents(recovered3, "%m") == std::vector<std::string>{"a=3 b=baz"});
+}
+
+TEST_CASE("recover_overwrite_mode_session_from_file")
+{
+  auto file = std::make_shared<binlog::RecoveryFile>(g_recoveryPath);
+  binlog::Session session(file);
+  session.setOverwriteMode(true);
+  binlog::SessionWriter writer(session, 1024);
+
+  binlog::EventSource eventSource{
+    0, binlog::Severity::info, "cat", "fun", "file", 123, "a={}", "i"
+  };
+  eventSource.id = session.addEventSource(eventSource);
+
+  for (int i = 0; i < 1000; ++i)
+  {
+    CHECK(writer.addEvent(eventSource.id, 0, i));
+  }
+
+  // after many wrap arounds, the most recent, complete events are recovered
+  TestStream recovered = recover(readFile(g_recoveryPath));
+  const std::vector<std::string> events = streamToEvents(recovered, "%m");
+  REQUIRE(! events.empty());
+  for (std::size_t i = 0; i < events.size(); ++i)
+  {
+    CHECK(events[i] == "a=" + std::to_string(1000 - events.size() + i));
+  }
+}
+
+#endif // _WIN32
@@ -0,0 +1,131 @@
+#include <binlog/RequestScope.hpp>
+
+#include <binlog/Session.hpp>
+#include <binlog/SessionWriter.hpp>
+#include <binlog/advanced_log_macros.hpp>
+
+#include "test_utils.hpp"
+
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void handleRequest(binlog::SessionWriter& writer, const binlog::RequestScope::Predicate& keep, int id, bool fail)
+{
+  binlog::RequestScope scope(writer, keep);
+  BINLOG_DEBUG_W(writer, "Begin {}", id);
+  if (fail) { BINLOG_ERROR_W(writer, "Failed {}", id); }
+  BINLOG_DEBUG_W(writer, "End {}", id);
+}
+
+} // namespace
+
+TEST_CASE("keep_failed_requests")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512);
+
+  const binlog::RequestScope::Predicate keep =
+    binlog::RequestScope::severityAtLeast(binlog::Severity::warning);
+
+  for (int i = 0; i < 10; ++i)
+  {
+    handleRequest(writer, keep, i, i == 3 || i == 7);
+  }
+
+  CHECK(getEvents(session, "%S %m") == std::vector<std::string>{
+    "DEBG Begin 3", "ERRO Failed 3", "DEBG End 3",
+    "DEBG Begin 7", "ERRO Failed 7", "DEBG End 7",
+  });
+}
+
+TEST_CASE("keep_slow_requests")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512);
+
+  const binlog::RequestScope::Predicate keep =
+    binlog::RequestScope::slowerThan(std::chrono::milliseconds(10));
+
+  {
+    binlog::RequestScope scope(writer, keep);
+    BINLOG_INFO_W(writer, "fast");
+  }
+
+  {
+    binlog::RequestScope scope(writer, keep);
+    BINLOG_INFO_W(writer, "slow");
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+  CHECK(getEvents(session, "%m") == std::vector<std::string>{"slow"});
+}
+
+TEST_CASE("keep_explicitly")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512);
+
+  const binlog::RequestScope::Predicate never = [](const binlog::RequestScope::Summary&) { return false; };
+
+  {
+    binlog::RequestScope scope(writer, never);
+    BINLOG_INFO_W(writer, "a");
+  }
+
+  {
+    binlog::RequestScope scope(writer, never);
+    BINLOG_INFO_W(writer, "b");
+    scope.keep();
+  }
+
+  CHECK(getEvents(session, "%m") == std::vector<std::string>{"b"});
+}
+
+TEST_CASE("scope_summary")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512);
+
+  binlog::RequestScope::Summary summary{};
+  {
+    binlog::RequestScope scope(writer, [&summary](const binlog::RequestScope::Summary& s)
+    {
+      summary = s;
+      return false;
+    });
+
+    BINLOG_INFO_W(writer, "a");
+    BINLOG_WARN_W(writer, "b");
+    BINLOG_DEBUG_W(writer, "c");
+  }
+
+  CHECK(summary.maxSeverity == binlog::Severity::warning);
+  CHECK(summary.size == 3 * (4 + 8 + 8)); // size, source id, clock
+  CHECK(summary.elapsed >= binlog::RequestScope::Clock::duration::zero());
+  CHECK(! writer.inScope());
+}
+
+TEST_CASE("any_of")
+{
+  const binlog::RequestScope::Predicate p = binlog::RequestScope::anyOf({
+    binlog::RequestScope::slowerThan(std::chrono::seconds(1)),
+    binlog::RequestScope::severityAtLeast(binlog::Severity::error),
+  });
+
+  using Summary = binlog::RequestScope::Summary;
+  CHECK(! p(Summary{std::chrono::milliseconds(1), binlog::Severity::info, 0}));
+  CHECK(p(Summary{std::chrono::seconds(2), binlog::Severity::info, 0}));
+  CHECK(p(Summary{std::chrono::milliseconds(1), binlog::Severity::critical, 0}));
+}
+
+TEST_CASE("severity_at_least_trace")
+{
+  CHECK_THROWS_AS(binlog::RequestScope::severityAtLeast(binlog::Severity::trace), std::runtime_error);
+}
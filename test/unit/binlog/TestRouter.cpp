@@ -0,0 +1,144 @@
+#include <binlog/Router.hpp>
+
+#include <binlog/EventFilter.hpp>
+#include <binlog/Session.hpp>
+#include <binlog/SessionWriter.hpp>
+#include <binlog/advanced_log_macros.hpp>
+
+#include "test_utils.hpp"
+
+#include <doctest/doctest.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct CountingStream
+{
+  TestStream stream;
+  int writes = 0;
+
+  CountingStream& write(const char* buffer, std::streamsize size)
+  {
+    ++writes;
+    stream.write(buffer, size);
+    return *this;
+  }
+};
+
+std::string consume(binlog::Session& session)
+{
+  std::ostringstream str;
+  session.consume(str);
+  return str.str();
+}
+
+} // namespace
+
+TEST_CASE("route_to_sinks")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 4096);
+
+  CountingStream all;
+  CountingStream errors;
+  CountingStream orders;
+  CountingStream none;
+
+  binlog::Router router;
+  router.addSink(all);
+  router.addSink(errors, binlog::EventFilter::severityAtLeast(binlog::Severity::error));
+  router.addSink(orders, binlog::EventFilter::categoryIs("orders"));
+  router.addSink(none, [](const binlog::EventSource&) { return false; });
+  CHECK(router.sinkCount() == 4);
+
+  for (int i = 0; i < 2; ++i)
+  {
+    BINLOG_INFO_WC(writer, orders, "Order {}", i);
+    BINLOG_ERROR_WC(writer, orders, "Order {} failed", i);
+    BINLOG_ERROR_W(writer, "Error {}", i);
+  }
+
+  const std::string input = consume(session);
+  router.write(input.data(), std::streamsize(input.size()));
+
+  const std::vector<std::string> expectedAll{
+    "INFO Order 0", "ERRO Order 0 failed", "ERRO Error 0",
+    "INFO Order 1", "ERRO Order 1 failed", "ERRO Error 1",
+  };
+  CHECK(streamToEvents(all.stream, "%S %m") == expectedAll);
+  CHECK(all.writes == 1);
+
+  const std::vector<std::string> expectedErrors{
+    "ERRO Order 0 failed", "ERRO Error 0", "ERRO Order 1 failed", "ERRO Error 1",
+  };
+  CHECK(streamToEvents(errors.stream, "%S %m") == expectedErrors);
+
+  const std::vector<std::string> expectedOrders{
+    "INFO Order 0", "ERRO Order 0 failed", "INFO Order 1", "ERRO Order 1 failed",
+  };
+  CHECK(streamToEvents(orders.stream, "%S %m") == expectedOrders);
+
+  // sources are written only to the sinks that select them,
+  // other special entries to every sink
+  CHECK(streamToEvents(none.stream, "%S %m").empty());
+  none.stream.readPos = 0;
+  errors.stream.readPos = 0;
+  CHECK(countTags(none.stream, binlog::EventSource::Tag) == 0);
+  CHECK(countTags(none.stream, binlog::WriterProp::Tag) == 1);
+  CHECK(countTags(errors.stream, binlog::EventSource::Tag) == 2);
+}
+
+TEST_CASE("route_across_writes")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 4096);
+
+  CountingStream warnings;
+  binlog::Router router;
+  router.addSink(warnings, binlog::EventFilter::severityAtLeast(binlog::Severity::warning));
+
+  BINLOG_WARN_W(writer, "a");
+  BINLOG_DEBUG_W(writer, "b");
+  const std::string input1 = consume(session);
+  router.write(input1.data(), std::streamsize(input1.size()));
+
+  // sources are remembered between writes
+  BINLOG_WARN_W(writer, "a");
+  BINLOG_DEBUG_W(writer, "b");
+  const std::string input2 = consume(session);
+  router.write(input2.data(), std::streamsize(input2.size()));
+
+  CHECK(streamToEvents(warnings.stream, "%m") == std::vector<std::string>{"a", "a"});
+}
+
+TEST_CASE("route_invalid_input")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 4096);
+
+  TestStream all;
+  binlog::Router router;
+  router.addSink(all);
+
+  BINLOG_INFO_W(writer, "a");
+  std::string input = consume(session);
+  input += "\x20"; // truncated size of the next entry
+
+  CHECK_THROWS_AS(router.write(input.data(), std::streamsize(input.size())), std::runtime_error);
+  CHECK(streamToEvents(all, "%m") == std::vector<std::string>{"a"});
+}
+
+TEST_CASE("route_too_many_sinks")
+{
+  TestStream out;
+  binlog::Router router;
+  for (std::size_t i = 0; i < binlog::Router::maxSinkCount; ++i)
+  {
+    router.addSink(out);
+  }
+  CHECK_THROWS_AS(router.addSink(out), std::runtime_error);
+}
@@ -4,7 +4,12 @@
 
 #include <doctest/doctest.h>
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <ios> // streamsize
+#include <stdexcept>
+#include <vector>
 
 namespace {
 
@@ -13,6 +18,19 @@ struct NullOstream
   NullOstream& write(const char*, std::streamsize) { return *this; }
 };
 
+// Changes the minimum severity of the session while it is consumed
+struct SeveritySettingOstream
+{
+  binlog::Session& session;
+
+  SeveritySettingOstream& write(const char*, std::streamsize)
+  {
+    session.setMinSeverity(binlog::Severity::error);
+    session.setCategoryMinSeverity("category_c", binlog::Severity::warning);
+    return *this;
+  }
+};
+
 } // namespace
 
 TEST_CASE("channel_lifecycle")
@@ -70,6 +88,51 @@ TEST_CASE("min_severity")
   CHECK(session.minSeverity() == binlog::Severity::info);
 }
 
+TEST_CASE("set_min_severity_while_consuming")
+{
+  binlog::Session session;
+  SeveritySettingOstream out{session};
+
+  // would deadlock if setting the severity waited for consume
+  session.consume(out); // writes the clock sync entry
+  CHECK(session.minSeverity() == binlog::Severity::error);
+  CHECK(session.categoryMinSeverity(binlog::Session::categoryIndex("category_c")) == binlog::Severity::warning);
+}
+
+TEST_CASE("category_min_severity")
+{
+  const std::size_t a = binlog::Session::categoryIndex("category_a");
+  const std::size_t b = binlog::Session::categoryIndex("category_b");
+  CHECK(a != 0);
+  CHECK(b != 0);
+  CHECK(a != b);
+  CHECK(binlog::Session::categoryIndex("category_a") == a);
+
+  binlog::Session session;
+  CHECK(session.categoryMinSeverity(a) == binlog::Severity::trace);
+
+  session.setMinSeverity(binlog::Severity::info);
+  CHECK(session.categoryMinSeverity(a) == binlog::Severity::info);
+  CHECK(session.categoryMinSeverity(b) == binlog::Severity::info);
+  CHECK(session.categoryMinSeverity(0) == binlog::Severity::info);
+
+  session.setCategoryMinSeverity("category_a", binlog::Severity::debug);
+  CHECK(session.categoryMinSeverity(a) == binlog::Severity::debug);
+  CHECK(session.categoryMinSeverity(b) == binlog::Severity::info);
+
+  // category severity is not overridden by the session severity
+  session.setMinSeverity(binlog::Severity::error);
+  CHECK(session.categoryMinSeverity(a) == binlog::Severity::debug);
+  CHECK(session.categoryMinSeverity(b) == binlog::Severity::error);
+
+  session.resetCategoryMinSeverity("category_a");
+  CHECK(session.categoryMinSeverity(a) == binlog::Severity::error);
+
+  // other sessions are not affected
+  binlog::Session session2;
+  CHECK(session2.categoryMinSeverity(a) == binlog::Severity::trace);
+}
+
 TEST_CASE("sources_consumed_once")
 {
   binlog::Session session;
@@ -84,4 +147,85 @@ TEST_CASE("sources_consumed_once")
   CHECK(cr.bytesConsumed == 0);
 }
 
+TEST_CASE("tracepoints")
+{
+  binlog::Session session;
+
+  binlog::EventSource eventSource;
+  eventSource.file = "a.cpp";
+  std::atomic<bool> enabledA{true};
+  const std::uint64_t idA = session.addEventSource(eventSource, &enabledA);
+
+  eventSource.file = "b.cpp";
+  std::atomic<bool> enabledB{true};
+  session.addEventSource(eventSource, &enabledB);
+
+  // not switchable
+  const std::uint64_t idC = session.addEventSource(eventSource);
+
+  const auto isB = [](const binlog::EventSource& source) { return source.file == "b.cpp"; };
+  CHECK(session.setTracepointsEnabled(isB, false) == 2);
+  CHECK(enabledA.load());
+  CHECK(! enabledB.load());
+
+  // rules apply to sources added later, the last matching one wins
+  const auto isA = [idA](const binlog::EventSource& source) { return source.id == idA; };
+  CHECK(session.setTracepointsEnabled(isA, false) == 1);
+  CHECK(! enabledA.load());
+
+  std::atomic<bool> enabledD{true};
+  session.addEventSource(eventSource, &enabledD);
+  CHECK(! enabledD.load());
+
+  CHECK(session.setTracepointsEnabled(isB, true) == 3);
+  CHECK(enabledB.load());
+  CHECK(enabledD.load());
+
+  const std::vector<binlog::Session::Tracepoint> tracepoints = session.tracepoints();
+  REQUIRE(tracepoints.size() == 4);
+  CHECK(tracepoints[0].source.id == idA);
+  CHECK(! tracepoints[0].enabled);
+  CHECK(tracepoints[0].switchable);
+  CHECK(tracepoints[2].source.id == idC);
+  CHECK(tracepoints[2].enabled);
+  CHECK(! tracepoints[2].switchable);
+  CHECK(tracepoints[3].enabled);
+}
+
+TEST_CASE("tracepoint_rules")
+{
+  binlog::Session session;
+  const auto all = [](const binlog::EventSource&) { return true; };
+
+  // named rules are replaced, do not accumulate
+  for (std::size_t i = 0; i < 2 * binlog::Session::maxTracepointRules; ++i)
+  {
+    session.setTracepointsEnabled(all, i % 2 == 0, "toggle");
+  }
+
+  std::atomic<bool> enabledA{true};
+  session.addEventSource(binlog::EventSource{}, &enabledA);
+  CHECK(! enabledA.load()); // the last rule disabled every source
+
+  // unnamed rules are limited
+  for (std::size_t i = 1; i < binlog::Session::maxTracepointRules; ++i)
+  {
+    session.setTracepointsEnabled(all, true);
+  }
+  CHECK(enabledA.load());
+  CHECK_THROWS_AS(session.setTracepointsEnabled(all, false), std::runtime_error);
+  CHECK(enabledA.load()); // not applied
+  session.setTracepointsEnabled(all, false, "toggle"); // replace is allowed
+  CHECK(! enabledA.load());
+
+  // the state of existing sources is kept, new sources are enabled
+  session.clearTracepointRules();
+  CHECK(! enabledA.load());
+
+  std::atomic<bool> enabledB{false};
+  session.addEventSource(binlog::EventSource{}, &enabledB);
+  CHECK(enabledB.load());
+  session.setTracepointsEnabled(all, false);
+}
+
 // addEventSource and consume are further tested in TestSessionWriter.cpp
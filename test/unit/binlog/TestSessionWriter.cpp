@@ -306,6 +306,158 @@ TEST_CASE("queue_is_full")
   CHECK(streamToEvents(stream, "%t %n %m") == expectedEvents);
 }
 
+TEST_CASE("queue_is_full_overwrite_mode")
+{
+  binlog::Session session;
+  session.setOverwriteMode(true);
+  binlog::SessionWriter writer(session, 512, 7, "Seven");
+
+  binlog::EventSource eventSource{
+    0, binlog::Severity::info, "cat", "fun", "file", 123, "a={}", "i"
+  };
+  eventSource.id = session.addEventSource(eventSource);
+
+  // the oldest events are evicted, no new queue is allocated
+  std::vector<std::string> allEvents;
+  for (int i = 0; i < 256; ++i)
+  {
+    CHECK(writer.addEvent(eventSource.id, 0, i));
+    allEvents.push_back("7 Seven a=" + std::to_string(i));
+  }
+
+  // too large to fit
+  CHECK(! writer.addEvent(eventSource.id, 0, std::string(512, 'x')));
+
+  TestStream stream;
+  const binlog::Session::ConsumeResult cr = session.consume(stream);
+  CHECK(cr.channelsPolled == 1);
+
+  // the most recent events are consumed
+  const std::vector<std::string> events = streamToEvents(stream, "%t %n %m");
+  REQUIRE(events.size() > 1);
+  CHECK(events.size() < allEvents.size());
+  CHECK(events == std::vector<std::string>(allEvents.end() - std::ptrdiff_t(events.size()), allEvents.end()));
+
+  // events added after consume are consumed by the next call
+  CHECK(writer.addEvent(eventSource.id, 0, 256));
+  session.consume(stream);
+  stream.readPos = 0;
+  const std::vector<std::string> events2 = streamToEvents(stream, "%t %n %m");
+  REQUIRE(events2.size() == events.size() + 1);
+  CHECK(events2.back() == "7 Seven a=256");
+}
+
+TEST_CASE("scope_commit_and_discard")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512);
+
+  binlog::EventSource eventSource{
+    0, binlog::Severity::info, "cat", "fun", "file", 123, "a={}", "i"
+  };
+  eventSource.id = session.addEventSource(eventSource);
+
+  CHECK(writer.addEvent(eventSource.id, 0, 1));
+
+  writer.beginScope();
+  CHECK(writer.inScope());
+  CHECK(writer.addEvent(eventSource.id, 0, 2));
+  CHECK(writer.addEvent(eventSource.id, 0, 3));
+  CHECK(writer.scopeSize() != 0);
+
+  // scope is not visible until committed
+  TestStream stream;
+  session.consume(stream);
+  CHECK(streamToEvents(stream, "%m") == std::vector<std::string>{"a=1"});
+
+  CHECK(writer.endScope(false));
+  CHECK(! writer.inScope());
+  CHECK(writer.scopeSize() == 0);
+
+  writer.beginScope();
+  CHECK(writer.addEvent(eventSource.id, 0, 4));
+  CHECK(writer.endScope(true));
+
+  CHECK(writer.addEvent(eventSource.id, 0, 5));
+
+  session.consume(stream);
+  stream.readPos = 0;
+  CHECK(streamToEvents(stream, "%m") == std::vector<std::string>{"a=1", "a=4", "a=5"});
+}
+
+TEST_CASE("scope_severity")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 512);
+
+  binlog::EventSource eventSource{
+    0, binlog::Severity::info, "cat", "fun", "file", 123, "a={}", "i"
+  };
+  eventSource.id = session.addEventSource(eventSource);
+
+  writer.beginScope();
+  CHECK(writer.scopeSeverity() == binlog::Severity::trace);
+  CHECK(writer.addEvent(binlog::Severity::warning, eventSource.id, 0, 1));
+  CHECK(writer.addEvent(binlog::Severity::debug, eventSource.id, 0, 2));
+  CHECK(writer.scopeSeverity() == binlog::Severity::warning);
+  CHECK(writer.endScope(true));
+  CHECK(writer.scopeSeverity() == binlog::Severity::trace);
+
+  CHECK(getEvents(session, "%m") == std::vector<std::string>{"a=1", "a=2"});
+}
+
+TEST_CASE("scope_larger_than_queue")
+{
+  binlog::Session session;
+  binlog::SessionWriter writer(session, 128);
+
+  binlog::EventSource eventSource{
+    0, binlog::Severity::info, "cat", "fun", "file", 123, "a={}", "[i"
+  };
+  eventSource.id = session.addEventSource(eventSource);
+
+  // the scope buffer grows, then the channel is replaced at commit
+  std::vector<std::string> expectedEvents;
+  writer.beginScope();
+  for (int i = 0; i < 256; ++i)
+  {
+    CHECK(writer.addEvent(eventSource.id, 0, std::vector<int>{i,i+1,i+2}));
+    std::ostringstream s;
+    s << "a=[" << i << ", " << i+1 << ", " << i+2 << "]";
+    expectedEvents.push_back(s.str());
+  }
+  CHECK(writer.scopeSize() > 4096);
+  CHECK(writer.endScope(true));
+
+  CHECK(getEvents(session, "%m") == expectedEvents);
+}
+
+TEST_CASE("scope_overwrite_mode")
+{
+  binlog::Session session;
+  session.setOverwriteMode(true);
+  binlog::SessionWriter writer(session, 512);
+
+  binlog::EventSource eventSource{
+    0, binlog::Severity::info, "cat", "fun", "file", 123, "a={}", "i"
+  };
+  eventSource.id = session.addEventSource(eventSource);
+
+  // a scope that does not fit the channel is dropped
+  writer.beginScope();
+  for (int i = 0; i < 64; ++i)
+  {
+    CHECK(writer.addEvent(eventSource.id, 0, i));
+  }
+  CHECK(! writer.endScope(true));
+
+  writer.beginScope();
+  CHECK(writer.addEvent(eventSource.id, 0, 64));
+  CHECK(writer.endScope(true));
+
+  CHECK(getEvents(session, "%m") == std::vector<std::string>{"a=64"});
+}
+
 TEST_CASE("move_ctor")
 {
   binlog::Session session;
@@ -2,8 +2,16 @@
 
 #include <doctest/doctest.h>
 
+#include <cinttypes>
+#include <cmath>
 #include <cstdint>
+#include <cstdio>
+
+#include <stdio.h> // fileno
+#include <limits>
 #include <sstream>
+#include <string>
+#include <vector>
 
 namespace {
 
@@ -28,6 +36,14 @@ struct TestcaseBase
   }
 };
 
+template <typename T>
+std::string printfString(const char* format, T v)
+{
+  char buf[128];
+  const int size = snprintf(buf, sizeof(buf), format, v);
+  return std::string(buf, std::size_t(size));
+}
+
 } // namespace
 
 TEST_CASE_FIXTURE(TestcaseBase, "empty")
@@ -83,3 +99,115 @@ TEST_CASE_FIXTURE(TestcaseBase, "shift_op")
 
   CHECK(toString("foobar") == "foobar");
 }
+
+TEST_CASE_FIXTURE(TestcaseBase, "integers_like_printf")
+{
+  std::vector<std::uint64_t> values{0, 1, 9, 10, 99, 100, 999, 1000, 9999, 10000};
+  for (std::uint64_t p = 100000; p < std::uint64_t(1e19); p *= 10)
+  {
+    values.push_back(p - 1);
+    values.push_back(p);
+    values.push_back(p + 1);
+  }
+  values.push_back(std::numeric_limits<std::uint64_t>::max() - 1);
+  values.push_back(std::numeric_limits<std::uint64_t>::max());
+
+  for (const std::uint64_t u : values)
+  {
+    CHECK(toString(u) == printfString("%" PRIu64, u));
+
+    const std::int64_t i = std::int64_t(u);
+    CHECK(toString(i) == printfString("%" PRId64, i));
+    CHECK(toString(-i) == printfString("%" PRId64, -i));
+  }
+
+  CHECK(toString(std::numeric_limits<std::int64_t>::min()) == "-9223372036854775808");
+  CHECK(toString(std::numeric_limits<std::int8_t>::min()) == "-128");
+  CHECK(toString(std::numeric_limits<std::uint8_t>::max()) == "255");
+}
+
+TEST_CASE_FIXTURE(TestcaseBase, "doubles_like_printf")
+{
+  const std::vector<double> values{
+    0.0, -0.0, 1.0, -1.0, 0.1, 0.5, 99.95, -120.5625, 1.0/3, 2.0/3,
+    123456789.0, 999999999999999.0, 1e15, 1e15 + 1, 9007199254740993.0, 1e16, 1e17, -1e15,
+    1e-5, 1.5e-300, 4.9e-324, 1.7976931348623157e308, 3.141592653589793,
+    std::numeric_limits<double>::infinity(),
+    -std::numeric_limits<double>::infinity(),
+    std::numeric_limits<double>::quiet_NaN(),
+    std::nan("1"),
+  };
+
+  for (const double v : values)
+  {
+    CHECK(toString(v) == printfString("%.16g", v));
+    CHECK(toString(float(v)) == printfString("%.16g", double(float(v))));
+  }
+}
+
+#ifndef _WIN32
+
+namespace {
+
+std::string readFile(std::FILE* file)
+{
+  std::rewind(file);
+  std::string result;
+  char buf[4096];
+  std::size_t n = 0;
+  while ((n = std::fread(buf, 1, sizeof(buf), file)) != 0)
+  {
+    result.append(buf, n);
+  }
+  return result;
+}
+
+} // namespace
+
+TEST_CASE("write_fd")
+{
+  std::FILE* file = std::tmpfile();
+  REQUIRE(file != nullptr);
+
+  std::string expected;
+  {
+    binlog::detail::OstreamBuffer buf(fileno(file), 4096);
+
+    // small writes, buffered
+    for (int i = 0; i < 1000; ++i)
+    {
+      buf << "line " << i << ' ' << i * 0.5 << '\n';
+      expected += "line " + std::to_string(i) + ' ' + printfString("%.16g", i * 0.5) + '\n';
+    }
+
+    // large write, bypasses the buffer
+    const std::string large(10000, 'x');
+    buf.write(large.data(), large.size());
+    expected += large;
+
+    buf << "end";
+    expected += "end";
+
+    CHECK(buf.good());
+  } // flushed by the destructor
+
+  CHECK(readFile(file) == expected);
+  std::fclose(file);
+}
+
+TEST_CASE("write_fd_failure")
+{
+  binlog::detail::OstreamBuffer buf(-1, 4096);
+  CHECK(buf.good());
+
+  buf << "foo";
+  buf.flush();
+  CHECK(! buf.good());
+
+  // further writes are dropped
+  buf << "bar";
+  buf.flush();
+  CHECK(! buf.good());
+}
+
+#endif // _WIN32
@@ -0,0 +1,47 @@
+#include <binlog/detail/SourceIdMap.hpp>
+
+#include <doctest/doctest.h>
+
+#include <cstdint>
+
+using MaskMap = binlog::detail::SourceIdMap<std::uint64_t>;
+using FlagMap = binlog::detail::SourceIdMap<bool>;
+
+TEST_CASE("dense_and_sparse_ids")
+{
+  const std::uint64_t sparseId = MaskMap::maxDenseId + 123;
+
+  MaskMap m;
+  CHECK(m.get(0) == 0);
+  CHECK(m.get(7) == 0);
+  CHECK(m.get(sparseId) == 0);
+
+  m.set(7, 0x5);
+  m.set(sparseId, 0x6);
+  CHECK(m.get(7) == 0x5);
+  CHECK(m.get(6) == 0);
+  CHECK(m.get(8) == 0);
+  CHECK(m.get(sparseId) == 0x6);
+  CHECK(m.get(sparseId + 1) == 0);
+
+  m.set(7, 0x9);
+  m.set(sparseId, 0);
+  CHECK(m.get(7) == 0x9);
+  CHECK(m.get(sparseId) == 0);
+}
+
+TEST_CASE("flags")
+{
+  FlagMap m;
+  m.set(1, true);
+  m.set(100, false);
+  m.set(FlagMap::maxDenseId, true);
+
+  CHECK(m.get(1));
+  CHECK(! m.get(2));
+  CHECK(! m.get(100));
+  CHECK(m.get(FlagMap::maxDenseId));
+
+  m.set(1, false);
+  CHECK(! m.get(1));
+}
@@ -251,4 +251,33 @@ TEST_CASE("visit")
   CHECK(true);
 }
 
+TEST_CASE("visit_program")
+{
+  const std::string path = "mserialize_test_documentation_visit_program.data";
+
+  {
+    std::ofstream ostream(path);
+    mserialize::serialize(std::string("foo"), ostream);
+    mserialize::serialize(std::string("bar"), ostream);
+  }
+
+  {
+    std::ifstream istream(path);
+    istream.exceptions(std::ios_base::failbit);
+    Visitor visitor;
+
+    //[visit_program
+    // compile the tag once
+    const mserialize::VisitProgram program(mserialize::tag<std::string>());
+
+    // visit many objects of the same type
+    mserialize::visit(program, visitor, istream);
+    mserialize::visit(program, visitor, istream);
+    //]
+  }
+
+  (void)std::remove(path.data());
+  CHECK(true);
+}
+
 // NOLINTEND(readability-duplicate-include)
@@ -122,13 +122,25 @@ serialize_and_visit(const T& in)
   OutputStream ostream{stream};
   mserialize::serialize(in, ostream);
 
+  const std::string serialized = stream.str();
+
   // visit
   Visitor visitor;
   InputStream istream{stream};
   const auto tag = mserialize::tag<T>();
   mserialize::visit(tag, visitor, istream);
 
-  return visitor.value();
+  // visit the compiled tag, expect the same result
+  std::stringstream stream2(serialized);
+  stream2.exceptions(std::ios_base::failbit);
+  Visitor visitor2;
+  InputStream istream2{stream2};
+  const mserialize::VisitProgram program(tag);
+  mserialize::visit(program, visitor2, istream2);
+
+  auto result = visitor.value();
+  CHECK(visitor2.value() == result);
+  return result;
 }
 
 enum class OpaqueEnum : std::int32_t
@@ -609,6 +621,187 @@ TEST_CASE("empty_prefix_of_containing_struct")
   CHECK(visitor.value() == "StB(FooBar,`f'{Foo}) { f({Foo}): StB(Foo,) { } , } ");
 }
 
+// visit compiled tags
+
+namespace {
+
+// Visit `serialized` by `tag` and by the compiled tag, return both results
+template <typename Visitor = ToString>
+auto visit_tag_and_program(const std::string& tag, const std::string& serialized)
+{
+  std::stringstream stream1(serialized);
+  stream1.exceptions(std::ios_base::failbit);
+  Visitor visitor1;
+  mserialize::visit(tag, visitor1, stream1);
+
+  std::stringstream stream2(serialized);
+  stream2.exceptions(std::ios_base::failbit);
+  Visitor visitor2;
+  const mserialize::VisitProgram program(tag);
+  mserialize::visit(program, visitor2, stream2);
+
+  return std::make_pair(visitor1.value(), visitor2.value());
+}
+
+// Skips every tuple of two ints by consuming it
+class SkipIntPairs : public ToString
+{
+public:
+  using ToString::visit;
+
+  template <typename IS>
+  bool visit(mserialize::Visitor::TupleBegin tb, IS& istream)
+  {
+    if (tb.tag == "ii")
+    {
+      std::int32_t a = 0, b = 0;
+      mserialize::deserialize(a, istream);
+      mserialize::deserialize(b, istream);
+      ToString::visit(a + b);
+      return true;
+    }
+    return ToString::visit(tb, istream);
+  }
+};
+
+} // namespace
+
+TEST_CASE("visit_program_ops")
+{
+  using OpCode = mserialize::VisitProgram::OpCode;
+
+  const mserialize::VisitProgram program("{P`x'i`y'd}");
+  CHECK(program.tag() == "{P`x'i`y'd}");
+
+  const auto& ops = program.ops();
+  REQUIRE(ops.size() == 8);
+  CHECK(ops[0].code == OpCode::StructBegin);
+  CHECK(program.op_name(ops[0]) == "P");
+  CHECK(program.op_tag(ops[0]) == "`x'i`y'd");
+  CHECK(ops[0].next == 8);
+
+  CHECK(ops[1].code == OpCode::FieldBegin);
+  CHECK(program.op_name(ops[1]) == "x");
+  CHECK(ops[2].code == OpCode::Arithmetic);
+  CHECK(ops[2].block_size == 12);
+  CHECK(ops[2].block_offset == 0);
+  CHECK(ops[3].code == OpCode::FieldEnd);
+
+  CHECK(ops[4].code == OpCode::FieldBegin);
+  CHECK(ops[5].code == OpCode::Arithmetic);
+  CHECK(ops[5].block_size == 0);
+  CHECK(ops[5].block_offset == 4);
+  CHECK(ops[6].code == OpCode::FieldEnd);
+  CHECK(ops[7].code == OpCode::StructEnd);
+}
+
+TEST_CASE("visit_empty_program")
+{
+  CountingVisitor visitor;
+  std::stringstream stream;
+  mserialize::visit(mserialize::VisitProgram{}, visitor, stream);
+  mserialize::visit(mserialize::VisitProgram{""}, visitor, stream);
+  CHECK(visitor.value() == 0);
+}
+
+TEST_CASE("visit_program_mixed")
+{
+  std::stringstream stream;
+  mserialize::serialize(std::make_tuple(
+    std::int8_t(-1), std::string("foo"), 1.5, std::make_tuple(std::uint16_t(7), 'x'), true
+  ), stream);
+
+  const auto result = visit_tag_and_program("(b[cd(Sc)y)", stream.str());
+  CHECK(result.first == "TB(b[cd(Sc)y)( -1 SB(3,c)[ f o o ] 1.5 TB(Sc)( 7 x ) true ) ");
+  CHECK(result.second == result.first);
+}
+
+TEST_CASE("visit_program_skip")
+{
+  std::stringstream stream;
+  mserialize::serialize(std::make_tuple(1, std::make_tuple(2, 3), 4, std::make_tuple(5, 6)), stream);
+
+  const auto result = visit_tag_and_program<SkipIntPairs>("(i(ii)i(ii))", stream.str());
+  CHECK(result.first == "TB(i(ii)i(ii))( 1 5 4 11 ) ");
+  CHECK(result.second == result.first);
+}
+
+TEST_CASE("visit_program_large_block")
+{
+  std::stringstream stream;
+  std::string tag = "(";
+  for (std::int64_t i = 0; i < 100; ++i)
+  {
+    mserialize::serialize(i, stream);
+    tag += "l";
+  }
+  tag += ")";
+
+  const auto result = visit_tag_and_program(tag, stream.str());
+  CHECK(result.second == result.first);
+
+  const mserialize::VisitProgram program(tag);
+  const std::size_t max_block_size = mserialize::VisitProgram::max_block_size;
+  CHECK(program.ops()[1].block_size == max_block_size);
+}
+
+TEST_CASE("visit_program_recursive_struct")
+{
+  std::stringstream stream;
+  Tree leaf{2, nullptr, nullptr};
+  const Tree root{1, &leaf, nullptr};
+  mserialize::serialize(root, stream);
+
+  const std::string tag = "{Tree`value'i`left'<0{Tree}>`right'<0{Tree}>}";
+  const auto result = visit_tag_and_program(tag, stream.str());
+  CHECK(result.second == result.first);
+}
+
+TEST_CASE("visit_program_deeply_nested_tuple_tag")
+{
+  const int max_recursion = 2047;
+
+  std::stringstream stream;
+  mserialize::serialize(std::int32_t(1), stream);
+
+  // works
+  {
+    const std::string tag = std::string(max_recursion, '(') + "i" + std::string(max_recursion, ')');
+    const auto result = visit_tag_and_program<CountingVisitor>(tag, stream.str());
+    CHECK(result.first == max_recursion * 2 + 1);
+    CHECK(result.second == result.first);
+  }
+
+  // throws
+  {
+    const std::string tag = std::string(max_recursion + 1, '(') + "i" + std::string(max_recursion + 1, ')');
+    CountingVisitor visitor;
+    const mserialize::VisitProgram program(tag);
+    CHECK_THROWS_AS(mserialize::visit(program, visitor, stream), std::runtime_error);
+  }
+}
+
+TEST_CASE("visit_program_invalid_tag")
+{
+  CountingVisitor visitor;
+  std::stringstream stream;
+  mserialize::serialize(std::uint64_t(1), stream);
+
+  CHECK_THROWS_AS(mserialize::visit(mserialize::VisitProgram("X"), visitor, stream), std::runtime_error);
+  CHECK_THROWS_AS(mserialize::visit(mserialize::VisitProgram("0"), visitor, stream), std::runtime_error);
+}
+
+TEST_CASE("visit_program_truncated_input")
+{
+  std::stringstream stream;
+  stream.exceptions(std::ios_base::failbit);
+  mserialize::serialize(std::int32_t(1), stream);
+
+  CountingVisitor visitor;
+  const mserialize::VisitProgram program("(ii)");
+  CHECK_THROWS(mserialize::visit(program, visitor, stream));
+}
+
 // derived struct serialization and visitation
 
 #ifndef _WIN32